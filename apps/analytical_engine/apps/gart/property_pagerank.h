@@ -18,8 +18,11 @@ limitations under the License.
 
 #include <vector>
 
+#include "grape/utils/atomic_ops.h"
+
 #include "core/app/app_base.h"
 #include "core/context/gart_vertex_data_context.h"
+#include "core/parallel/gart_parallel.h"
 #include "core/utils/gart_vertex_array.h"
 
 namespace gs {
@@ -45,17 +48,19 @@ class PropertyPageRankContext
     result.resize(vertex_label_num);
     result_next.resize(vertex_label_num);
     degree.resize(vertex_label_num);
+    inner_chunks.resize(vertex_label_num);
     delta = delta_input;
     max_round = max_round_input;
     current_round = 0;
     total_vertex_num = 0;
 
+    // sized by the live vertices, not by the slots of the vertex table
     for (auto v_label = 0; v_label < vertex_label_num; v_label++) {
       auto vertices_iter = frag.Vertices(v_label);
-      result[v_label].Init(&frag, vertices_iter, 0);
-      result_next[v_label].Init(&frag, vertices_iter, 0);
+      result[v_label].InitDense(&frag, vertices_iter, 0);
+      result_next[v_label].InitDense(&frag, vertices_iter, 0);
       auto inner_vertices_iter = frag.InnerVertices(v_label);
-      degree[v_label].Init(&frag, inner_vertices_iter, 0);
+      degree[v_label].InitDense(&frag, inner_vertices_iter, 0);
     }
   }
 
@@ -76,6 +81,8 @@ class PropertyPageRankContext
   std::vector<gart::GartVertexArray<gart::vid_t, double>> result;
   std::vector<gart::GartVertexArray<gart::vid_t, double>> result_next;
   std::vector<gart::GartVertexArray<gart::vid_t, int>> degree;
+  // inner vertices split by degrees, for the rounds
+  std::vector<std::vector<gart::VertexIterator>> inner_chunks;
   int max_round;
   double delta;
   int current_round;
@@ -87,7 +94,8 @@ class PropertyPageRankContext
 template <typename FRAG_T>
 class PropertyPageRank
     : public AppBase<FRAG_T, PropertyPageRankContext<FRAG_T>>,
-      public grape::Communicator {
+      public grape::Communicator,
+      public gart::ParallelEngine {
  public:
   INSTALL_DEFAULT_WORKER(PropertyPageRank<FRAG_T>,
                          PropertyPageRankContext<FRAG_T>, FRAG_T)
@@ -100,6 +108,7 @@ class PropertyPageRank
       grape::MessageStrategy::kSyncOnOuterVertex;
   static constexpr grape::LoadStrategy load_strategy =
       grape::LoadStrategy::kBothOutIn;
+  static constexpr size_t kChunksPerThread = 16;
 
   void PEval(const fragment_t& frag, context_t& ctx,
              message_manager_t& messages) {
@@ -109,33 +118,30 @@ class PropertyPageRank
     int local_vertex_num = 0, local_edge_num = 0;
 
     for (auto v_label = 0; v_label < v_label_num; v_label++) {
-      auto inner_vertices_iter = frag.InnerVertices(v_label);
-      while (inner_vertices_iter.valid()) {
-        local_vertex_num++;
-        inner_vertices_iter.next();
-      }
+      local_vertex_num += frag.GetInnerVerticesNum(v_label);
     }
 
     Sum(local_vertex_num, ctx.total_vertex_num);
 
     double p = 1.0 / ctx.total_vertex_num;
 
+    uint32_t thread_num = GetThreadNum();
+    std::vector<int> edge_nums(thread_num, 0);
     for (auto v_label = 0; v_label < v_label_num; v_label++) {
-      auto inner_vertices_iter = frag.InnerVertices(v_label);
-      while (inner_vertices_iter.valid()) {
-        auto src = inner_vertices_iter.vertex();
+      ForEach(frag.InnerVertices(v_label), [&](uint32_t tid, vertex_t src) {
         int edge_num = 0;
         for (auto e_label = 0; e_label < e_label_num; e_label++) {
-          auto edge_iter = frag.GetOutgoingAdjList(src, e_label);
-          while (edge_iter.valid()) {
-            edge_num++;
-            local_edge_num++;
-            edge_iter.next();
-          }
+          edge_num += frag.GetLocalOutDegree(src, e_label);
         }
+        edge_nums[tid] += edge_num;
         ctx.degree[v_label][src] = edge_num;
-        inner_vertices_iter.next();
-      }
+      });
+      ctx.inner_chunks[v_label] = frag.InnerVertices(v_label).split(
+          thread_num * kChunksPerThread,
+          [&](vertex_t v) { return ctx.degree[v_label][v]; });
+    }
+    for (auto edge_num : edge_nums) {
+      local_edge_num += edge_num;
     }
 
     std::cout << "total_vertex_num: " << ctx.total_vertex_num
@@ -167,11 +173,10 @@ class PropertyPageRank
 #endif
 
     int dangling_vnum = 0;
+    std::vector<int> dangling_vnums(thread_num, 0);
 
     for (auto v_label = 0; v_label < v_label_num; v_label++) {
-      auto inner_vertices_iter = frag.InnerVertices(v_label);
-      while (inner_vertices_iter.valid()) {
-        auto src = inner_vertices_iter.vertex();
+      ForEach(ctx.inner_chunks[v_label], [&](uint32_t tid, vertex_t src) {
         ctx.result[v_label][src] = p;
         int edge_num = ctx.degree[v_label][src];
         if (edge_num > 0) {
@@ -180,15 +185,18 @@ class PropertyPageRank
             while (edge_iter.valid()) {
               auto dst = edge_iter.neighbor();
               auto dst_label = frag.vertex_label(dst);
-              ctx.result_next[dst_label][dst] += p / edge_num;
+              grape::atomic_add(ctx.result_next[dst_label][dst],
+                                p / edge_num);
               edge_iter.next();
             }
           }
         } else {
-          dangling_vnum++;
+          dangling_vnums[tid]++;
         }
-        inner_vertices_iter.next();
-      }
+      });
+    }
+    for (auto num : dangling_vnums) {
+      dangling_vnum += num;
     }
 
     Sum(dangling_vnum, ctx.total_dangling_vnum);
@@ -229,30 +237,22 @@ class PropertyPageRank
 
     if (ctx.current_round == ctx.max_round) {
       for (auto v_label = 0; v_label < v_label_num; v_label++) {
-        auto inner_vertices_iter = frag.InnerVertices(v_label);
-        while (inner_vertices_iter.valid()) {
-          auto src = inner_vertices_iter.vertex();
+        ForEach(ctx.inner_chunks[v_label], [&](uint32_t tid, vertex_t src) {
           ctx.result[v_label][src] =
               base + ctx.delta * ctx.result_next[v_label][src];
-          inner_vertices_iter.next();
-        }
+        });
       }
     } else {
       for (auto v_label = 0; v_label < v_label_num; v_label++) {
-        auto inner_vertices_iter = frag.InnerVertices(v_label);
-        while (inner_vertices_iter.valid()) {
-          auto src = inner_vertices_iter.vertex();
+        ForEach(ctx.inner_chunks[v_label], [&](uint32_t tid, vertex_t src) {
           ctx.result[v_label][src] =
               base + ctx.delta * ctx.result_next[v_label][src];
           ctx.result_next[v_label][src] = 0.0;
-          inner_vertices_iter.next();
-        }
+        });
       }
 
       for (auto v_label = 0; v_label < v_label_num; v_label++) {
-        auto inner_vertices_iter = frag.InnerVertices(v_label);
-        while (inner_vertices_iter.valid()) {
-          auto src = inner_vertices_iter.vertex();
+        ForEach(ctx.inner_chunks[v_label], [&](uint32_t tid, vertex_t src) {
           int edge_num = ctx.degree[v_label][src];
           if (edge_num > 0) {
             double msg = ctx.result[v_label][src] / edge_num;
@@ -261,13 +261,12 @@ class PropertyPageRank
               while (edge_iter.valid()) {
                 auto dst = edge_iter.neighbor();
                 auto dst_label = frag.vertex_label(dst);
-                ctx.result_next[dst_label][dst] += msg;
+                grape::atomic_add(ctx.result_next[dst_label][dst], msg);
                 edge_iter.next();
               }
             }
           }
-          inner_vertices_iter.next();
-        }
+        });
       }
       for (auto v_label = 0; v_label < v_label_num; v_label++) {
         auto outer_vertices_iter = frag.OuterVertices(v_label);
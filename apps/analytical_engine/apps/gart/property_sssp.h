@@ -17,14 +17,17 @@ limitations under the License.
 #define APPS_ANALYTICAL_ENGINE_APPS_GART_PROPERTY_SSSP_H_
 
 #include <algorithm>
+#include <atomic>
 #include <limits>
 #include <string>
 #include <vector>
 
+#include "grape/utils/atomic_ops.h"
 #include "vineyard/common/util/json.h"
 
 #include "core/app/app_base.h"
 #include "core/context/gart_vertex_data_context.h"
+#include "core/parallel/gart_parallel.h"
 #include "core/utils/gart_vertex_array.h"
 #include "interfaces/fragment/types.h"
 
@@ -54,13 +57,14 @@ class PropertySSSPContext : public gs::GartLabeledVertexDataContext<FRAG_T> {
     result.resize(vertex_label_num);
     updated.resize(vertex_label_num);
     updated_next.resize(vertex_label_num);
+    inner_chunks.resize(vertex_label_num);
 
     for (auto v_label = 0; v_label < vertex_label_num; v_label++) {
       auto vertices_iter = frag.Vertices(v_label);
-      updated[v_label].Init(&frag, vertices_iter, false);
-      updated_next[v_label].Init(&frag, vertices_iter, false);
-      result[v_label].Init(&frag, vertices_iter,
-                           std::numeric_limits<int>::max());
+      updated[v_label].InitDense(&frag, vertices_iter, false);
+      updated_next[v_label].InitDense(&frag, vertices_iter, false);
+      result[v_label].InitDense(&frag, vertices_iter,
+                                std::numeric_limits<int>::max());
     }
   }
 
@@ -102,13 +106,16 @@ class PropertySSSPContext : public gs::GartLabeledVertexDataContext<FRAG_T> {
   std::vector<gart::GartVertexArray<gart::vid_t, int>> result;
   std::vector<gart::GartVertexArray<gart::vid_t, int>> updated;
   std::vector<gart::GartVertexArray<gart::vid_t, int>> updated_next;
+  // inner vertices split by out degrees, for the rounds
+  std::vector<std::vector<gart::VertexIterator>> inner_chunks;
   label_id_t label_id;
   oid_t source_id;
   std::string weight_name;
 };
 
 template <typename FRAG_T>
-class PropertySSSP : public AppBase<FRAG_T, PropertySSSPContext<FRAG_T>> {
+class PropertySSSP : public AppBase<FRAG_T, PropertySSSPContext<FRAG_T>>,
+                     public gart::ParallelEngine {
  public:
   INSTALL_DEFAULT_WORKER(PropertySSSP<FRAG_T>, PropertySSSPContext<FRAG_T>,
                          FRAG_T)
@@ -120,10 +127,23 @@ class PropertySSSP : public AppBase<FRAG_T, PropertySSSPContext<FRAG_T>> {
       grape::MessageStrategy::kSyncOnOuterVertex;
   static constexpr grape::LoadStrategy load_strategy =
       grape::LoadStrategy::kBothOutIn;
+  static constexpr size_t kChunksPerThread = 16;
 
   void PEval(const fragment_t& frag, context_t& ctx,
              message_manager_t& messages) {
+    auto v_label_num = frag.vertex_label_num();
     auto e_label_num = frag.edge_label_num();
+    for (auto v_label = 0; v_label < v_label_num; v_label++) {
+      ctx.inner_chunks[v_label] = frag.InnerVertices(v_label).split(
+          GetThreadNum() * kChunksPerThread, [&](vertex_t v) {
+            int degree = 0;
+            for (auto e_label = 0; e_label < e_label_num; e_label++) {
+              degree += frag.GetLocalOutDegree(v, e_label);
+            }
+            return degree;
+          });
+    }
+
     bool is_native = false;
     vertex_t src_vertex;
     if (!frag.Oid2Gid(ctx.label_id, ctx.source_id, src_vertex)) {
@@ -166,7 +186,7 @@ class PropertySSSP : public AppBase<FRAG_T, PropertySSSPContext<FRAG_T>> {
     auto e_label_num = frag.edge_label_num();
     int val;
     vertex_t v;
-    bool require_force_continue = false;
+    std::atomic<bool> require_force_continue(false);
     while (messages.GetMessage<fragment_t, int>(frag, v, val)) {
       auto v_label = frag.vertex_label(v);
       if (ctx.result[v_label][v] > val) {
@@ -180,13 +200,12 @@ class PropertySSSP : public AppBase<FRAG_T, PropertySSSPContext<FRAG_T>> {
       ctx.updated[v_label].SetValue(false);
     }
 
+    // outer vertices relaxed are marked in updated, and sent after by the
+    // message manager, which is not thread-safe
     for (auto v_label = 0; v_label < v_label_num; v_label++) {
-      auto inner_vertices_iter = frag.InnerVertices(v_label);
-      while (inner_vertices_iter.valid()) {
-        auto src = inner_vertices_iter.vertex();
+      ForEach(ctx.inner_chunks[v_label], [&](uint32_t tid, vertex_t src) {
         if (ctx.updated_next[v_label][src] == false) {
-          inner_vertices_iter.next();
-          continue;
+          return;
         }
         int dist_src = ctx.result[v_label][src];
         for (auto e_label = 0; e_label < e_label_num; e_label++) {
@@ -200,19 +219,27 @@ class PropertySSSP : public AppBase<FRAG_T, PropertySSSPContext<FRAG_T>> {
               e_data = edge_iter.template get_data<int>(prop_id);
             }
             int new_dist_dst = dist_src + e_data;
-            if (new_dist_dst < ctx.result[dst_label][dst]) {
-              ctx.result[dst_label][dst] = new_dist_dst;
+            if (grape::atomic_min(ctx.result[dst_label][dst], new_dist_dst)) {
+              ctx.updated[dst_label][dst] = true;
               if (frag.IsInnerVertex(dst)) {
-                ctx.updated[dst_label][dst] = true;
                 require_force_continue = true;
-              } else {
-                messages.SyncStateOnOuterVertex(frag, dst, new_dist_dst);
               }
             }
             edge_iter.next();
           }
         }
-        inner_vertices_iter.next();
+      });
+    }
+
+    for (auto v_label = 0; v_label < v_label_num; v_label++) {
+      auto outer_vertices_iter = frag.OuterVertices(v_label);
+      while (outer_vertices_iter.valid()) {
+        auto dst = outer_vertices_iter.vertex();
+        if (ctx.updated[v_label][dst]) {
+          ctx.updated[v_label][dst] = false;
+          messages.SyncStateOnOuterVertex(frag, dst, ctx.result[v_label][dst]);
+        }
+        outer_vertices_iter.next();
       }
     }
 
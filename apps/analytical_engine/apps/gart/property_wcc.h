@@ -17,10 +17,12 @@ limitations under the License.
 #define APPS_ANALYTICAL_ENGINE_APPS_GART_PROPERTY_WCC_H_
 
 #include <limits>
+#include <utility>
 #include <vector>
 
 #include "core/app/app_base.h"
 #include "core/context/gart_vertex_data_context.h"
+#include "core/parallel/gart_parallel.h"
 #include "core/utils/gart_vertex_array.h"
 
 namespace gs {
@@ -42,11 +44,13 @@ class PropertyWCCContext : public gs::GartLabeledVertexDataContext<FRAG_T> {
     auto& frag = this->fragment();
     auto vertex_label_num = frag.vertex_label_num();
     result.resize(vertex_label_num);
+    inner_chunks.resize(vertex_label_num);
+    outer_chunks.resize(vertex_label_num);
 
     for (auto v_label = 0; v_label < vertex_label_num; v_label++) {
       auto vertices_iter = frag.Vertices(v_label);
-      result[v_label].Init(&frag, vertices_iter,
-                           std::numeric_limits<oid_t>::max());
+      result[v_label].InitDense(&frag, vertices_iter,
+                                std::numeric_limits<oid_t>::max());
     }
   }
 
@@ -65,10 +69,14 @@ class PropertyWCCContext : public gs::GartLabeledVertexDataContext<FRAG_T> {
   }
 
   std::vector<gart::GartVertexArray<gart::vid_t, oid_t>> result;
+  // vertices split by in degrees, for the rounds
+  std::vector<std::vector<gart::VertexIterator>> inner_chunks;
+  std::vector<std::vector<gart::VertexIterator>> outer_chunks;
 };
 
 template <typename FRAG_T>
-class PropertyWCC : public AppBase<FRAG_T, PropertyWCCContext<FRAG_T>> {
+class PropertyWCC : public AppBase<FRAG_T, PropertyWCCContext<FRAG_T>>,
+                    public gart::ParallelEngine {
  public:
   INSTALL_DEFAULT_WORKER(PropertyWCC<FRAG_T>, PropertyWCCContext<FRAG_T>,
                          FRAG_T)
@@ -81,77 +89,38 @@ class PropertyWCC : public AppBase<FRAG_T, PropertyWCCContext<FRAG_T>> {
       grape::MessageStrategy::kSyncOnOuterVertex;
   static constexpr grape::LoadStrategy load_strategy =
       grape::LoadStrategy::kBothOutIn;
+  static constexpr size_t kChunksPerThread = 16;
 
   void PEval(const fragment_t& frag, context_t& ctx,
              message_manager_t& messages) {
     auto v_label_num = frag.vertex_label_num();
     auto e_label_num = frag.edge_label_num();
+    auto in_degree = [&](vertex_t v) {
+      int degree = 0;
+      for (auto e_label = 0; e_label < e_label_num; e_label++) {
+        degree += frag.GetLocalInDegree(v, e_label);
+      }
+      return degree;
+    };
 
     for (auto v_label = 0; v_label < v_label_num; v_label++) {
-      auto vertices_iter = frag.Vertices(v_label);
-      while (vertices_iter.valid()) {
-        vertex_t src = vertices_iter.vertex();
+      ForEach(frag.Vertices(v_label), [&](uint32_t tid, vertex_t src) {
         ctx.result[v_label][src] = frag.GetId(src);
-        vertices_iter.next();
-      }
+      });
+      ctx.inner_chunks[v_label] = frag.InnerVertices(v_label).split(
+          GetThreadNum() * kChunksPerThread, in_degree);
+      ctx.outer_chunks[v_label] = frag.OuterVertices(v_label).split(
+          GetThreadNum() * kChunksPerThread, in_degree);
     }
 
-    for (auto v_label = 0; v_label < v_label_num; v_label++) {
-      auto inner_vertices_iter = frag.InnerVertices(v_label);
-      while (inner_vertices_iter.valid()) {
-        auto src = inner_vertices_iter.vertex();
-        for (auto e_label = 0; e_label < e_label_num; e_label++) {
-          auto edge_iter = frag.GetIncomingAdjList(src, e_label);
-          while (edge_iter.valid()) {
-            auto dst = edge_iter.neighbor();
-            if (frag.IsInnerVertex(dst)) {
-              auto dst_label = frag.vertex_label(dst);
-              oid_t dst_data = ctx.result[dst_label][dst];
-              if (dst_data < ctx.result[v_label][src]) {
-                ctx.result[v_label][src] = dst_data;
-              }
-            }
-            edge_iter.next();
-          }
-        }
-        inner_vertices_iter.next();
-      }
-    }
-
-    for (auto v_label = 0; v_label < v_label_num; v_label++) {
-      auto outer_vertices_iter = frag.OuterVertices(v_label);
-      while (outer_vertices_iter.valid()) {
-        auto src = outer_vertices_iter.vertex();
-        oid_t old_data = ctx.result[v_label][src];
-        oid_t new_data = old_data;
-        for (auto e_label = 0; e_label < e_label_num; e_label++) {
-          auto edge_iter = frag.GetIncomingAdjList(src, e_label);
-          while (edge_iter.valid()) {
-            auto dst = edge_iter.neighbor();
-            auto dst_label = frag.vertex_label(dst);
-            if (ctx.result[dst_label][dst] < new_data) {
-              new_data = ctx.result[dst_label][dst];
-            }
-            edge_iter.next();
-          }
-        }
-        if (new_data < old_data) {
-          ctx.result[v_label][src] = new_data;
-          messages.SyncStateOnOuterVertex<fragment_t, oid_t>(frag, src,
-                                                             new_data);
-        }
-        outer_vertices_iter.next();
-      }
-    }
+    PullInnerVertices(frag, ctx);
+    PullOuterVertices(frag, ctx, messages);
 
     messages.ForceContinue();
   }
 
   void IncEval(const fragment_t& frag, context_t& ctx,
                message_manager_t& messages) {
-    auto v_label_num = frag.vertex_label_num();
-    auto e_label_num = frag.edge_label_num();
-
     vertex_t v;
     oid_t val;
     while (messages.GetMessage<fragment_t, oid_t>(frag, v, val)) {
@@ -161,10 +130,19 @@ class PropertyWCC : public AppBase<FRAG_T, PropertyWCCContext<FRAG_T>> {
       }
     }
 
+    PullInnerVertices(frag, ctx);
+    PullOuterVertices(frag, ctx, messages);
+  }
+
+ private:
+  // each thread writes the vertices it iterates only
+  void PullInnerVertices(const fragment_t& frag, context_t& ctx) {
+    auto v_label_num = frag.vertex_label_num();
+    auto e_label_num = frag.edge_label_num();
+
     for (auto v_label = 0; v_label < v_label_num; v_label++) {
-      auto inner_vertices_iter = frag.InnerVertices(v_label);
-      while (inner_vertices_iter.valid()) {
-        auto src = inner_vertices_iter.vertex();
+      ForEach(ctx.inner_chunks[v_label], [&](uint32_t tid, vertex_t src) {
+        oid_t new_data = ctx.result[v_label][src];
         for (auto e_label = 0; e_label < e_label_num; e_label++) {
           auto edge_iter = frag.GetIncomingAdjList(src, e_label);
           while (edge_iter.valid()) {
@@ -172,21 +150,31 @@ class PropertyWCC : public AppBase<FRAG_T, PropertyWCCContext<FRAG_T>> {
             if (frag.IsInnerVertex(dst)) {
               auto dst_label = frag.vertex_label(dst);
               oid_t dst_data = ctx.result[dst_label][dst];
-              if (dst_data < ctx.result[v_label][src]) {
-                ctx.result[v_label][src] = dst_data;
+              if (dst_data < new_data) {
+                new_data = dst_data;
               }
             }
             edge_iter.next();
           }
         }
-        inner_vertices_iter.next();
-      }
+        if (new_data < ctx.result[v_label][src]) {
+          ctx.result[v_label][src] = new_data;
+        }
+      });
     }
+  }
+
+  // the message manager is not thread-safe, the updates of outer vertices
+  // are buffered by threads and sent after
+  void PullOuterVertices(const fragment_t& frag, context_t& ctx,
+                         message_manager_t& messages) {
+    auto v_label_num = frag.vertex_label_num();
+    auto e_label_num = frag.edge_label_num();
+    std::vector<std::vector<std::pair<vertex_t, oid_t>>> updates(
+        GetThreadNum());
 
     for (auto v_label = 0; v_label < v_label_num; v_label++) {
-      auto outer_vertices_iter = frag.OuterVertices(v_label);
-      while (outer_vertices_iter.valid()) {
-        auto src = outer_vertices_iter.vertex();
+      ForEach(ctx.outer_chunks[v_label], [&](uint32_t tid, vertex_t src) {
         oid_t old_data = ctx.result[v_label][src];
         oid_t new_data = old_data;
         for (auto e_label = 0; e_label < e_label_num; e_label++) {
@@ -202,10 +190,15 @@ class PropertyWCC : public AppBase<FRAG_T, PropertyWCCContext<FRAG_T>> {
         }
         if (new_data < old_data) {
           ctx.result[v_label][src] = new_data;
-          messages.SyncStateOnOuterVertex<fragment_t, oid_t>(frag, src,
-                                                             new_data);
+          updates[tid].emplace_back(src, new_data);
         }
-        outer_vertices_iter.next();
+      });
+    }
+
+    for (auto& thread_updates : updates) {
+      for (auto& update : thread_updates) {
+        messages.SyncStateOnOuterVertex<fragment_t, oid_t>(frag, update.first,
+                                                           update.second);
       }
     }
   }
@@ -18,49 +18,76 @@
 
 #include <algorithm>
 #include <atomic>
-#include <memory>
-#include <thread>
+#include <future>
 #include <vector>
 
+#include "grape/parallel/parallel_engine.h"
+
 #include "interfaces/fragment/iterator.h"
 
 namespace gart {
-template <typename ITER_FUNC_T>
-inline void ForEach(gart::VertexIterator& range, const ITER_FUNC_T& iter_func,
-                    int chunk_size = 10) {
-  int thread_num_ = 4;
-  std::vector<std::thread> threads(thread_num_);
-  int vertex_num = 0;
-  std::vector<vertex_t> vertices;
-  while (range.valid()) {
-    vertices.push_back(range.vertex());
-    vertex_num++;
-    range.next();
+
+/**
+ * Parallel iteration over the vertices of a GartFragment for apps, on the
+ * thread pool of grape::ParallelEngine (see InitParallelEngine of grape).
+ *
+ * The vertices are split into chunks of the vertex table (see
+ * VertexIterator::split), several per thread. Each thread takes the chunks
+ * of its own slice in order, then steals the chunks left in the slices of
+ * the other threads, so skewed chunks do not stall a round.
+ */
+class ParallelEngine : public grape::ParallelEngine {
+ public:
+  uint32_t GetThreadNum() { return std::max<uint32_t>(thread_num(), 1); }
+
+  // func(tid, v) for each vertex of the range
+  template <typename ITER_FUNC_T>
+  void ForEach(const VertexIterator& range, const ITER_FUNC_T& iter_func,
+               size_t chunks_per_thread = 16) {
+    ForEach(range.split(GetThreadNum() * chunks_per_thread), iter_func);
   }
 
-  std::atomic<int> cur(0);
-  int end = vertex_num;
-  for (auto i = 0; i < thread_num_; ++i) {
-    threads[i] = std::thread(
-        [&cur, chunk_size, &iter_func, end, vertices](uint32_t tid) {
+  // func(tid, v) for each vertex of the chunks, e.g., split by degrees once
+  // and reused in the rounds
+  template <typename ITER_FUNC_T>
+  void ForEach(const std::vector<VertexIterator>& chunks,
+               const ITER_FUNC_T& iter_func) {
+    uint32_t thread_num = GetThreadNum();
+    std::vector<Slice> slices(thread_num);
+    for (uint32_t tid = 0; tid < thread_num; tid++) {
+      slices[tid].next = chunks.size() * tid / thread_num;
+      slices[tid].end = chunks.size() * (tid + 1) / thread_num;
+    }
+
+    std::vector<std::future<void>> results(thread_num);
+    for (uint32_t tid = 0; tid < thread_num; tid++) {
+      results[tid] = GetThreadPool().enqueue([&, tid]() {
+        for (uint32_t i = 0; i < thread_num; i++) {
+          Slice& slice = slices[(tid + i) % thread_num];
           while (true) {
-            int cur_beg = std::min(cur.fetch_add(chunk_size), end);
-            int cur_end = std::min(cur_beg + chunk_size, end);
-            if (cur_beg == cur_end) {
+            size_t chunk = slice.next.fetch_add(1);
+            if (chunk >= slice.end) {
               break;
             }
-            for (int i = cur_beg; i < cur_end; ++i) {
-              iter_func(tid, vertices[i]);
+            VertexIterator iter = chunks[chunk];
+            while (iter.valid()) {
+              iter_func(tid, iter.vertex());
+              iter.next();
             }
           }
-        },
-        i);
-    // setThreadAffinity(threads[i], i);
-  }
-  for (auto& thrd : threads) {
-    thrd.join();
+        }
+      });
+    }
+    GetThreadPool().WaitEnd(results);
   }
-}
+
+ private:
+  struct alignas(64) Slice {
+    std::atomic<size_t> next{0};
+    size_t end = 0;
+  };
+};
+
 }  // namespace gart
 
 #endif  // ANALYTICAL_ENGINE_CORE_PARALLEL_GART_PARALLEL_H_
@@ -37,106 +37,133 @@ class GartVertexArray {
 
   ~GartVertexArray() = default;
 
+  // a value for each slot of the vertex table in the ranges of the iterator
   void Init(const gart::GartFragment<VID_T, VID_T>* frag,
             const gart::VertexIterator& iter) {
-    frag_ = frag;
-    size_t total_size = 0;
-    size_t iter_size = iter.addrs_.size();
-    for (size_t idx = 0; idx < iter_size; idx++) {
-      if (iter.high_to_low_flags_[idx] == true) {
-        total_size += frag_->GetMaxInnerVerticesNum(iter.vlabel_);
-        if (iter.addrs_[idx].first == nullptr || iter.addrs_[idx].second) {
-          inner_size_ = 0;
-        } else {
-          inner_size_ = iter.addrs_[idx].first - iter.addrs_[idx].second;
-        }
-      } else {
-        total_size += frag_->GetMaxOuterVerticesNum(iter.vlabel_);
-      }
-    }
-
-    data_.resize(total_size);
+    data_.resize(InitRange(frag, iter, false));
   }
 
   void Init(const gart::GartFragment<VID_T, VID_T>* frag,
             const gart::VertexIterator& iter, const T& value) {
-    frag_ = frag;
-    size_t total_size = 0;
-    size_t iter_size = iter.addrs_.size();
-    for (size_t idx = 0; idx < iter_size; idx++) {
-      if (iter.high_to_low_flags_[idx] == true) {
-        total_size += frag_->GetMaxInnerVerticesNum(iter.vlabel_);
-        if (iter.addrs_[idx].first == nullptr || iter.addrs_[idx].second) {
-          inner_size_ = 0;
-        } else {
-          inner_size_ = iter.addrs_[idx].first - iter.addrs_[idx].second;
-        }
-      } else {
-        total_size += frag_->GetMaxOuterVerticesNum(iter.vlabel_);
-      }
-    }
+    data_.assign(InitRange(frag, iter, false), value);
+  }
+
+  // a value for each live vertex in the ranges of the iterator only, in the
+  // order of the dense ids (see GartFragment::GetDenseIds), so the slots of
+  // deleted vertices take no memory and data() is a flat array
+  void InitDense(const gart::GartFragment<VID_T, VID_T>* frag,
+                 const gart::VertexIterator& iter) {
+    data_.resize(InitRange(frag, iter, true));
+  }
 
-    data_.assign(total_size, value);
+  void InitDense(const gart::GartFragment<VID_T, VID_T>* frag,
+                 const gart::VertexIterator& iter, const T& value) {
+    data_.assign(InitRange(frag, iter, true), value);
   }
 
   void SetValue(gart::VertexIterator& iter, const T& value) {
     LOG(FATAL) << "Not implemented yet!";
   }
   void SetValue(const grape::Vertex<VID_T>& loc, const T& value) {
-    auto offset = frag_->GetOffset(loc);
-    if (frag_->IsInnerVertex(loc)) {
-      data_[offset] = value;
-    } else if (frag_->IsOuterVertex(loc)) {
-      offset = offset + inner_size_;
-      data_[offset] = value;
-    }
+    data_[Index(loc)] = value;
   }
 
   void SetValue(const T& value) { data_.assign(data_.size(), value); }
 
   inline T& operator[](const grape::Vertex<VID_T>& loc) {
-    auto offset = frag_->GetOffset(loc);
-    if (frag_->IsOuterVertex(loc)) {
-      offset = offset + inner_size_;
-    }
-
-    if (unlikely(offset >= data_.size())) {
-      LOG(ERROR) << "offset: " << offset << " data size: " << data_.size()
-                 << " loc: " << loc.GetValue();
-    }
-    return data_[offset];
+    return data_[Index(loc)];
   }
   inline const T& operator[](const grape::Vertex<VID_T>& loc) const {
-    auto offset = frag_->GetOffset(loc);
-    if (frag_->IsOuterVertex(loc)) {
-      offset = offset + inner_size_;
-    }
-
-    if (unlikely(offset >= data_.size())) {
-      LOG(ERROR) << "offset: " << offset << " data size: " << data_.size()
-                 << "loc: " << loc.GetValue();
-    }
-    return data_[offset];
+    return data_[Index(loc)];
   }
 
+  // the values in the order of the slots, or of the dense ids after
+  // InitDense
+  T* data() { return data_.data(); }
+  const T* data() const { return data_.data(); }
+  size_t size() const { return data_.size(); }
+
   void Swap(GartVertexArray& rhs) {
     data_.swap(rhs.data_);
     std::swap(frag_, rhs.frag_);
-    std::swap(inner_size_, rhs.inner_size_);
+    std::swap(max_inner_offset_, rhs.max_inner_offset_);
+    std::swap(outer_base_, rhs.outer_base_);
+    std::swap(dense_ids_, rhs.dense_ids_);
+    std::swap(dense_base_, rhs.dense_base_);
   }
 
   void Clear() {
     data_.clear();
     frag_ = nullptr;
-    inner_size_ = 0;
+    max_inner_offset_ = -1;
+    outer_base_ = 0;
+    dense_ids_ = nullptr;
+    dense_base_ = 0;
   }
 
  private:
   void Resize() {}
 
+  // the number of values for the ranges of the iterator, and what Index
+  // needs of the fragment for the label of the iterator
+  size_t InitRange(const gart::GartFragment<VID_T, VID_T>* frag,
+                   const gart::VertexIterator& iter, bool dense) {
+    frag_ = frag;
+    auto vlabel = iter.vlabel_;
+    max_inner_offset_ =
+        static_cast<int64_t>(frag_->GetMaxInnerVerticesNum(vlabel)) - 1;
+    dense_ids_ = dense ? frag_->GetDenseIds(vlabel) : nullptr;
+    dense_base_ = 0;
+    size_t inner_size = 0;
+    size_t total_size = 0;
+    size_t iter_size = iter.addrs_.size();
+    for (size_t idx = 0; idx < iter_size; idx++) {
+      if (iter.high_to_low_flags_[idx] == true) {
+        inner_size = frag_->GetMaxInnerVerticesNum(vlabel);
+        total_size +=
+            dense ? frag_->GetDenseInnerVerticesNum(vlabel) : inner_size;
+      } else if (dense) {
+        size_t inner_num = frag_->GetDenseInnerVerticesNum(vlabel);
+        if (iter_size == 1) {
+          dense_base_ = inner_num;  // outer vertices only
+        }
+        total_size += frag_->GetDenseVerticesNum(vlabel) - inner_num;
+      } else {
+        total_size += frag_->GetMaxOuterVerticesNum(vlabel);
+      }
+    }
+    // the slots of outer vertices follow the inner ones, in the dense id
+    // table and in the values of the inner and outer vertices
+    if (dense) {
+      inner_size = frag_->GetMaxInnerVerticesNum(vlabel);
+    }
+    outer_base_ = frag_->GetMaxOuterIdOffset() + inner_size;
+    return total_size;
+  }
+
+  // the slot of an inner vertex is its offset, and the slot of an outer one
+  // counts from the largest outer offset (see GartFragment::GetOffset)
+  inline size_t Index(const grape::Vertex<VID_T>& loc) const {
+    int64_t v_offset = frag_->vertex_offset(loc);
+    size_t offset =
+        v_offset <= max_inner_offset_ ? v_offset : outer_base_ - v_offset;
+    if (dense_ids_ != nullptr) {
+      offset = dense_ids_[offset] - dense_base_;
+    }
+
+    if (unlikely(offset >= data_.size())) {
+      LOG(ERROR) << "offset: " << offset << " data size: " << data_.size()
+                 << " loc: " << loc.GetValue();
+    }
+    return offset;
+  }
+
   std::vector<T> data_;
   const gart::GartFragment<VID_T, VID_T>* frag_;
-  size_t inner_size_ = 0;
+  int64_t max_inner_offset_ = -1;
+  int64_t outer_base_ = 0;
+  const VID_T* dense_ids_ = nullptr;  // slot -> dense id, after InitDense
+  size_t dense_base_ = 0;             // the dense id of the first value
 };
 
 }  // namespace gart
@@ -25,3 +25,5 @@ DEFINE_string(app_name, "sssp", "gart app name.");
 DEFINE_string(sssp_source_label, "", "source label id for sssp.");
 DEFINE_int32(sssp_source_oid, 0, "source oid for sssp.");
 DEFINE_string(sssp_weight_name, "", "weight name for sssp.");
+DEFINE_int32(app_thread_num, 0,
+             "threads of each worker for gart apps, 0 for all the cores.");
@@ -25,5 +25,6 @@ DECLARE_string(app_name);
 DECLARE_string(sssp_source_label);
 DECLARE_int32(sssp_source_oid);
 DECLARE_string(sssp_weight_name);
+DECLARE_int32(app_thread_num);
 
 #endif  // ANALYTICAL_ENGINE_TEST_FLAGS_H_
\ No newline at end of file
@@ -22,6 +22,8 @@
 #include "apps/gart/property_sssp.h"
 #include "apps/gart/property_wcc.h"
 #include "flags.h"  // NOLINT(build/include_subdir)
+#include "fragment/blob_schema_etcd.h"
+#include "fragment/epoch_pin_etcd.h"
 
 namespace fs = std::filesystem;
 
@@ -48,6 +50,14 @@ inline void output_file_stream(std::ofstream& os, const std::string& dir,
     LOG(ERROR) << "Failed to open file " << output_path;
   }
 }
+
+inline grape::ParallelEngineSpec app_parallel_engine_spec() {
+  auto spec = grape::DefaultParallelEngineSpec();
+  if (FLAGS_app_thread_num > 0) {
+    spec.thread_num = FLAGS_app_thread_num;
+  }
+  return spec;
+}
 }  // namespace
 
 void RunPropertySSSP(std::shared_ptr<GraphType> fragment,
@@ -58,7 +68,7 @@ void RunPropertySSSP(std::shared_ptr<GraphType> fragment,
 
   auto worker = AppType::CreateWorker(app, fragment);
 
-  auto spec = grape::DefaultParallelEngineSpec();
+  auto spec = app_parallel_engine_spec();
 
   worker->Init(comm_spec, spec);
   MPI_Barrier(comm_spec.comm());
@@ -81,7 +91,7 @@ void RunPropertyWCC(std::shared_ptr<GraphType> fragment,
 
   auto worker = AppType::CreateWorker(app, fragment);
 
-  auto spec = grape::DefaultParallelEngineSpec();
+  auto spec = app_parallel_engine_spec();
 
   worker->Init(comm_spec, spec);
   MPI_Barrier(comm_spec.comm());
@@ -103,7 +113,7 @@ void RunPropertyPageRank(std::shared_ptr<GraphType> fragment,
 
   auto worker = AppType::CreateWorker(app, fragment);
 
-  auto spec = grape::DefaultParallelEngineSpec();
+  auto spec = app_parallel_engine_spec();
 
   worker->Init(comm_spec, spec);
   MPI_Barrier(comm_spec.comm());
@@ -152,8 +162,6 @@ int main(int argc, char** argv) {
     grape::CommSpec comm_spec;
     comm_spec.Init(MPI_COMM_WORLD);
 
-    std::shared_ptr<GraphType> fragment(
-        new gart::GartFragment<uint64_t, uint64_t>());
     grape::gflags::ParseCommandLineFlags(&argc, &argv, true);
     std::shared_ptr<etcd::Client> etcd_client =
         std::make_shared<etcd::Client>(FLAGS_etcd_endpoint);
@@ -162,18 +170,32 @@ int main(int argc, char** argv) {
     etcd::Response response = etcd_client->get(schema_key).get();
     assert(response.is_ok());
     std::string edge_config_str = response.value().as_string();
+    // pin every epoch before choosing the latest one, then narrow the pin
+    auto epoch_pin = std::make_shared<gart::EpochPin>(
+        etcd_client, FLAGS_meta_prefix,
+        std::vector<uint64_t>{static_cast<uint64_t>(comm_spec.fid())});
+    bool pinned = epoch_pin->Pin();
     uint64_t write_epoch = get_latest_epoch(comm_spec, etcd_client);
+    if (write_epoch != std::numeric_limits<uint64_t>::max()) {
+      pinned = pinned && epoch_pin->Narrow(write_epoch);
+    }
+    // all fragments read the epoch, or none does
+    int all_pinned = pinned;
+    MPI_Allreduce(MPI_IN_PLACE, &all_pinned, 1, MPI_INT, MPI_LAND,
+                  comm_spec.comm());
+    std::shared_ptr<GraphType> fragment =
+        gart::make_pinned_fragment<GraphType>(epoch_pin);
     if (write_epoch == std::numeric_limits<uint64_t>::max()) {
       std::cout << "No valid epoch to process" << std::endl;
       MPI_Barrier(comm_spec.comm());
+    } else if (!all_pinned) {
+      LOG(ERROR) << "Failed to pin epoch " << write_epoch;
+      MPI_Barrier(comm_spec.comm());
     } else {
-      schema_key = FLAGS_meta_prefix + "gart_blob_m" + std::to_string(0) +
-                   "_p" + std::to_string(comm_spec.fid()) + "_e" +
-                   std::to_string(write_epoch);
-      response = etcd_client->get(schema_key).get();
-      assert(response.is_ok());
-      std::string config_str = response.value().as_string();
-      json config = json::parse(config_str);
+      json config;
+      bool found = gart::get_blob_schema(*etcd_client, FLAGS_meta_prefix,
+                                         comm_spec.fid(), write_epoch, config);
+      assert(found);
       json edge_config = json::parse(edge_config_str);
 
       fragment->Init(config, edge_config);
@@ -16,6 +16,8 @@
 #include "etcd/Client.hpp"
 
 #include "flags.h"  // NOLINT(build/include_subdir)
+#include "fragment/blob_schema_etcd.h"
+#include "fragment/epoch_pin_etcd.h"
 #include "interfaces/fragment/gart_fragment.h"
 
 using GraphType = gart::GartFragment<uint64_t, uint64_t>;
@@ -56,8 +58,6 @@ int main(int argc, char** argv) {
     grape::CommSpec comm_spec;
     comm_spec.Init(MPI_COMM_WORLD);
 
-    std::shared_ptr<GraphType> fragment(
-        new gart::GartFragment<uint64_t, uint64_t>());
     grape::gflags::ParseCommandLineFlags(&argc, &argv, true);
     std::shared_ptr<etcd::Client> etcd_client =
         std::make_shared<etcd::Client>(FLAGS_etcd_endpoint);
@@ -66,49 +66,64 @@ int main(int argc, char** argv) {
     etcd::Response response = etcd_client->get(schema_key).get();
     assert(response.is_ok());
     std::string edge_config_str = response.value().as_string();
+    // pin every epoch before choosing the latest one, then narrow the pin
+    auto epoch_pin = std::make_shared<gart::EpochPin>(
+        etcd_client, FLAGS_meta_prefix,
+        std::vector<uint64_t>{static_cast<uint64_t>(comm_spec.fid())});
+    bool pinned = epoch_pin->Pin();
     uint64_t write_epoch = get_latest_epoch(comm_spec, etcd_client);
-    schema_key = FLAGS_meta_prefix + "gart_blob_m" + std::to_string(0) + "_p" +
-                 std::to_string(comm_spec.fid()) + "_e" +
-                 std::to_string(write_epoch);
-    response = etcd_client->get(schema_key).get();
-    assert(response.is_ok());
-    std::string config_str = response.value().as_string();
-    json config = json::parse(config_str);
-    json edge_config = json::parse(edge_config_str);
+    if (write_epoch != std::numeric_limits<uint64_t>::max()) {
+      pinned = pinned && epoch_pin->Narrow(write_epoch);
+    }
+    // all fragments read the epoch, or none does
+    int all_pinned = pinned;
+    MPI_Allreduce(MPI_IN_PLACE, &all_pinned, 1, MPI_INT, MPI_LAND,
+                  comm_spec.comm());
+    std::shared_ptr<GraphType> fragment =
+        gart::make_pinned_fragment<GraphType>(epoch_pin);
+    if (!all_pinned) {
+      LOG(ERROR) << "Failed to pin epoch " << write_epoch;
+    } else {
+      json config;
+      bool found = gart::get_blob_schema(*etcd_client, FLAGS_meta_prefix,
+                                         comm_spec.fid(), write_epoch, config);
+      assert(found);
+      json edge_config = json::parse(edge_config_str);
 
-    fragment->Init(config, edge_config);
+      fragment->Init(config, edge_config);
 
-    MPI_Barrier(comm_spec.comm());
+      MPI_Barrier(comm_spec.comm());
 
-    auto vertex_label_num = fragment->vertex_label_num();
-    auto edge_label_num = fragment->edge_label_num();
+      auto vertex_label_num = fragment->vertex_label_num();
+      auto edge_label_num = fragment->edge_label_num();
 
-    for (auto v_label = 0; v_label < vertex_label_num; v_label++) {
-      auto inner_vertices_iter = fragment->InnerVertices(v_label);
-      while (inner_vertices_iter.valid()) {
-        auto src = inner_vertices_iter.vertex();
-        std::cout << "fid = " << fragment->fid()
-                  << " src label = " << fragment->vertex_label(src)
-                  << " src offset = " << fragment->GetOffset(src)
-                  << " src data = "
-                  << fragment->template GetData<int64_t>(src, 0) << std::endl;
-        for (auto elabel = 0; elabel < edge_label_num; elabel++) {
-          auto edge_iter = fragment->GetOutgoingAdjList(src, elabel);
-          while (edge_iter.valid()) {
-            auto dst = edge_iter.neighbor();
-            std::cout << "fid = " << fragment->fid()
-                      << " src label = " << fragment->vertex_label(src)
-                      << " src offset = " << fragment->GetOffset(src)
-                      << " dst label = " << fragment->vertex_label(dst)
-                      << " dst offset = " << fragment->GetOffset(dst)
-                      << std::endl;
-            edge_iter.next();
+      for (auto v_label = 0; v_label < vertex_label_num; v_label++) {
+        auto inner_vertices_iter = fragment->InnerVertices(v_label);
+        while (inner_vertices_iter.valid()) {
+          auto src = inner_vertices_iter.vertex();
+          std::cout << "fid = " << fragment->fid()
+                    << " src label = " << fragment->vertex_label(src)
+                    << " src offset = " << fragment->GetOffset(src)
+                    << " src data = "
+                    << fragment->template GetData<int64_t>(src, 0) << std::endl;
+          for (auto elabel = 0; elabel < edge_label_num; elabel++) {
+            auto edge_iter = fragment->GetOutgoingAdjList(src, elabel);
+            while (edge_iter.valid()) {
+              auto dst = edge_iter.neighbor();
+              std::cout << "fid = " << fragment->fid()
+                        << " src label = " << fragment->vertex_label(src)
+                        << " src offset = " << fragment->GetOffset(src)
+                        << " dst label = " << fragment->vertex_label(dst)
+                        << " dst offset = " << fragment->GetOffset(dst)
+                        << std::endl;
+              edge_iter.next();
+            }
           }
+          inner_vertices_iter.next();
         }
-        inner_vertices_iter.next();
       }
+      MPI_Barrier(comm_spec.comm());
     }
-    MPI_Barrier(comm_spec.comm());
   }
   grape::FinalizeMPIComm();
 
@@ -15,6 +15,9 @@
 
 #include "python_bindings/fragment_builder.h"
 
+#include "fragment/blob_schema_etcd.h"
+#include "fragment/epoch_pin_etcd.h"
+
 FragmentBuilder::FragmentBuilder(std::string etcd_endpoint,
                                  std::string meta_prefix, int read_epoch) {
   etcd_endpoint_ = etcd_endpoint;
@@ -40,13 +43,18 @@ FragmentBuilder::FragmentBuilder(std::string etcd_endpoint,
     exit(-1);
   }
 
-  schema_key = meta_prefix_ + "gart_blob_m" + std::to_string(0) + "_p0" + "_e" +
-               std::to_string(read_epoch);
-  response = etcd_client_->get(schema_key).get();
-  assert(response.is_ok());
-  std::string blob_schema_str = response.value().as_string();
-  vineyard::json blob_schema = vineyard::json::parse(blob_schema_str);
-  fragment_ = std::make_shared<GraphType>();
+  // the fragment keeps read_epoch pinned until it is destroyed
+  auto epoch_pin =
+      gart::pin_read_epoch(etcd_client_, meta_prefix_, {0}, read_epoch);
+  if (epoch_pin == nullptr) {
+    std::cerr << "Failed to pin epoch " << read_epoch << std::endl;
+    exit(-1);
+  }
+  vineyard::json blob_schema;
+  bool found = gart::get_blob_schema(*etcd_client_, meta_prefix_, 0,
+                                     read_epoch, blob_schema);
+  assert(found);
+  fragment_ = gart::make_pinned_fragment<GraphType>(epoch_pin);
   fragment_->Init(blob_schema, graph_schema_);
 }
 
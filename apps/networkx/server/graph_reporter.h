@@ -15,10 +15,15 @@
 #ifndef APPS_NETWORKX_SERVER_GRAPH_REPORTER_H_
 #define APPS_NETWORKX_SERVER_GRAPH_REPORTER_H_
 
+#include <algorithm>
 #include <array>
 #include <cstddef>
 #include <iostream>
+#include <iterator>
+#include <list>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 
 #include "etcd/Client.hpp"
@@ -27,6 +32,8 @@
 #include "grpcpp/server.h"
 #include "grpcpp/server_builder.h"
 
+#include "fragment/blob_schema_etcd.h"
+#include "fragment/epoch_pin_etcd.h"
 #include "interfaces/fragment/types.h"
 #include "server/utils/dynamic.h"
 #include "server/utils/msgpack_utils.h"
@@ -56,9 +63,15 @@ using vertex_t = GraphType::vertex_t;
 
 class QueryGraphServiceImpl final : public QueryGraphService::Service {
  public:
-  QueryGraphServiceImpl(std::string etcd_endpoint, std::string meta_prefix) {
+  // at most cache_capacity fragments of recent epochs are cached, and less
+  // if they take more than cache_memory bytes
+  QueryGraphServiceImpl(std::string etcd_endpoint, std::string meta_prefix,
+                        size_t cache_capacity = 8,
+                        size_t cache_memory = 1ul << 30) {
     etcd_endpoint_ = etcd_endpoint;
     meta_prefix_ = meta_prefix;
+    cache_capacity_ = std::max<size_t>(cache_capacity, 1);
+    cache_memory_ = cache_memory;
     etcd_client_ = std::make_shared<etcd::Client>(etcd_endpoint);
     std::string schema_key = meta_prefix + "gart_schema_p0";
     etcd::Response response = etcd_client_->get(schema_key).get();
@@ -103,14 +116,11 @@ class QueryGraphServiceImpl final : public QueryGraphService::Service {
       msgpack::pack(&sbuf, ref_data);
       *in_archive << sbuf;
     } else {
-      std::shared_ptr<GraphType> fragment;
-      size_t version = request->version();
-      auto iter = fragments_.find(version);
-      if (iter == fragments_.end()) {
-        fragment = buildGartFragment(version);
-        fragments_.insert(std::make_pair(version, fragment));
-      } else {
-        fragment = iter->second;
+      std::shared_ptr<GraphType> fragment = getFragment(request->version());
+      if (fragment == nullptr) {
+        return Status(grpc::StatusCode::NOT_FOUND,
+                      "Graph version " + std::to_string(request->version()) +
+                          " is not available");
       }
       std::string args = request->args();
 
@@ -289,7 +299,22 @@ class QueryGraphServiceImpl final : public QueryGraphService::Service {
   }
 
  private:
-  std::map<size_t, std::shared_ptr<GraphType>> fragments_;
+  struct CachedFragment {
+    size_t version;
+    // keeps the epoch pinned while cached, see gart::make_pinned_fragment
+    std::shared_ptr<GraphType> fragment;
+    size_t memory;  // see GartFragment::GetMemoryUsage
+  };
+
+  // LRU cache of fragments, the most recently used first. The writer does
+  // not reclaim the blobs of a cached epoch, an evicted fragment unpins its
+  // epoch once the last request using it is done
+  std::list<CachedFragment> lru_fragments_;
+  std::map<size_t, std::list<CachedFragment>::iterator> fragments_;
+  size_t cache_capacity_;
+  size_t cache_memory_;
+  size_t cached_memory_ = 0;
+  std::mutex cache_mutex_;
   std::shared_ptr<etcd::Client> etcd_client_;
   json graph_schema_;
   std::string meta_prefix_;
@@ -302,15 +327,72 @@ class QueryGraphServiceImpl final : public QueryGraphService::Service {
     return std::stoull(response.value().as_string());
   }
 
-  std::shared_ptr<GraphType> buildGartFragment(const size_t& read_epoch) {
-    auto fragment = std::make_shared<GraphType>();
-    std::string schema_key = meta_prefix_ + "gart_blob_m" + std::to_string(0) +
-                             "_p0" + "_e" + std::to_string(read_epoch);
-    etcd::Response response = etcd_client_->get(schema_key).get();
-    assert(response.is_ok());
-    std::string blob_schema_str = response.value().as_string();
-    json blob_schema = json::parse(blob_schema_str);
-    fragment->Init(blob_schema, graph_schema_);
+  std::shared_ptr<GraphType> getFragment(size_t version) {
+    std::shared_ptr<GraphType> prev;
+    {
+      std::lock_guard<std::mutex> lock(cache_mutex_);
+      auto iter = fragments_.find(version);
+      if (iter != fragments_.end()) {
+        lru_fragments_.splice(lru_fragments_.begin(), lru_fragments_,
+                              iter->second);
+        return iter->second->fragment;
+      }
+      // the closest epoch before, whose blobs are mostly still there
+      iter = fragments_.lower_bound(version);
+      if (iter != fragments_.begin()) {
+        prev = std::prev(iter)->second->fragment;
+      } else if (iter != fragments_.end()) {
+        prev = iter->second->fragment;
+      }
+    }
+
+    // built without the lock, the latest epoch is polled constantly
+    auto fragment = buildGartFragment(version, prev.get());
+    if (fragment == nullptr) {
+      return nullptr;
+    }
+    size_t memory = fragment->GetMemoryUsage();
+
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    auto iter = fragments_.find(version);
+    if (iter != fragments_.end()) {
+      // built by another request meanwhile
+      lru_fragments_.splice(lru_fragments_.begin(), lru_fragments_,
+                            iter->second);
+      return iter->second->fragment;
+    }
+    lru_fragments_.push_front(CachedFragment{version, fragment, memory});
+    fragments_.emplace(version, lru_fragments_.begin());
+    cached_memory_ += memory;
+    // fragments evicted are released, and their epochs unpinned, by the
+    // requests still using them
+    while (lru_fragments_.size() > 1 &&
+           (lru_fragments_.size() > cache_capacity_ ||
+            cached_memory_ > cache_memory_)) {
+      const CachedFragment& victim = lru_fragments_.back();
+      cached_memory_ -= victim.memory;
+      fragments_.erase(victim.version);
+      lru_fragments_.pop_back();
+    }
+    return fragment;
+  }
+
+  // the fragment keeps read_epoch pinned until it is destroyed, return
+  // nullptr if the epoch is pruned or reclaimed
+  std::shared_ptr<GraphType> buildGartFragment(const size_t& read_epoch,
+                                               const GraphType* prev) {
+    auto epoch_pin =
+        gart::pin_read_epoch(etcd_client_, meta_prefix_, {0}, read_epoch);
+    if (epoch_pin == nullptr) {
+      return nullptr;
+    }
+    json blob_schema;
+    if (!gart::get_blob_schema(*etcd_client_, meta_prefix_, 0, read_epoch,
+                               blob_schema)) {
+      return nullptr;
+    }
+    auto fragment = gart::make_pinned_fragment<GraphType>(epoch_pin);
+    fragment->Init(blob_schema, graph_schema_, prev);
     return fragment;
   }
 
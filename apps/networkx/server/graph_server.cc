@@ -24,7 +24,9 @@ int main(int argc, char** argv) {
   google::InitGoogleLogging(argv[0]);
   gflags::ParseCommandLineFlags(&argc, &argv, true);
 
-  gart::QueryGraphServiceImpl service(FLAGS_etcd_endpoint, FLAGS_meta_prefix);
+  gart::QueryGraphServiceImpl service(FLAGS_etcd_endpoint, FLAGS_meta_prefix,
+                                      FLAGS_fragment_cache_size,
+                                      FLAGS_fragment_cache_memory);
 
   grpc::ServerBuilder builder;
   builder.AddListeningPort(FLAGS_server_addr,
@@ -19,3 +19,8 @@ DEFINE_string(etcd_endpoint, "http://127.0.0.1:23760",
               "etcd endpoint for schema.");
 DEFINE_string(meta_prefix, "gart_meta_", "meta prefix for etcd.");
 DEFINE_string(server_addr, "127.0.0.1:50051", "server address.");
+DEFINE_uint64(fragment_cache_size, 8,
+              "max number of fragments (epochs) cached by the server.");
+DEFINE_uint64(fragment_cache_memory, 1ul << 30,
+              "max bytes of the fragments cached by the server, excluding "
+              "the blobs in vineyard.");
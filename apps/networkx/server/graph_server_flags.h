@@ -22,5 +22,7 @@
 DECLARE_string(etcd_endpoint);
 DECLARE_string(meta_prefix);
 DECLARE_string(server_addr);
+DECLARE_uint64(fragment_cache_size);
+DECLARE_uint64(fragment_cache_memory);
 
 #endif  // APPS_NETWORKX_SERVER_GRAPH_SERVER_FLAGS_H_
@@ -14,6 +14,7 @@
  */
 
 #include <sys/types.h>
+#include <algorithm>
 #include <chrono>
 #include <fstream>
 #include <iostream>
@@ -33,6 +34,7 @@
 #include "converter/parser.h"
 #include "util/macros.h"
 
+using converter::FileProducer;
 using converter::KafkaConsumer;
 using converter::KafkaOutputStream;
 using converter::KafkaProducer;
@@ -64,12 +66,24 @@ std::vector<std::shared_ptr<moodycamel::ReaderWriterQueue<int>>>
 bool bulk_load_finished = false;
 bool enable_bulk_load = false;
 bool catch_up_mode = true;
+// the max binlog offset written to any partition before a restart
 int64_t last_processed_offset = 0;
 
+// the last unified log written to a partition before a restart, see
+// load_last_written_logs
+struct LastWrittenLog {
+  int64_t offset = 0;
+  bool epoch_begin = false;
+};
+std::vector<LastWrittenLog> last_written_logs;
+
 constexpr char NO_MESSAGE[] = "No message";
 
+// the lines are handed to the workers in turn, so the seq of a line (its
+// position among all of them) is known by its worker
 void process_binlog_step_1(int thread_id, TxnLogParser& parser) {
-  while (true) {
+  std::vector<LogEntry> log_entries;
+  for (int64_t seq = thread_id;; seq += FLAGS_num_threads) {
     std::string line;
     while (true) {
 #ifndef USE_TBB
@@ -83,6 +97,8 @@ void process_binlog_step_1(int thread_id, TxnLogParser& parser) {
     }
 
     if (line == NO_MESSAGE) {
+      log_entries.clear();
+      parser.assign_gids(log_entries, seq, false);
 #ifndef USE_TBB
       while (!unified_log_counts[thread_id]->try_enqueue(0)) {
         std::this_thread::yield();
@@ -93,36 +109,12 @@ void process_binlog_step_1(int thread_id, TxnLogParser& parser) {
       continue;
     }
 
-    LogEntry log_entry;
-    GART_CHECK_OK(parser.parse(log_entry, line));
-    if (!log_entry.valid()) {
-#ifndef USE_TBB
-      while (!unified_log_counts[thread_id]->try_enqueue(0)) {
-        std::this_thread::yield();
-      }
-#else
-      unified_log_counts[thread_id].push(0);
-#endif
-      continue;
-    }
-    int unified_log_count = 0;
-
-    while (log_entry.more_entires()) {
-      if (log_entry.complete()) {
-        unified_log_count++;
-#ifndef USE_TBB
-        while (!unified_log_queues[thread_id]->try_enqueue(log_entry)) {
-          std::this_thread::yield();
-        }
-#else
-        unified_log_queues[thread_id].push(log_entry);
-#endif
-      }
-      GART_CHECK_OK(parser.parse(log_entry, line));
-    }
-
-    if (log_entry.complete()) {
-      unified_log_count++;
+    GART_CHECK_OK(parser.parse(log_entries, line));
+    parser.assign_gids(log_entries, seq, true);
+    // entries whose gids are not found are counted as well, so the offsets of
+    // unified logs do not depend on the checkpoint
+    int unified_log_count = log_entries.size();
+    for (const LogEntry& log_entry : log_entries) {
 #ifndef USE_TBB
       while (!unified_log_queues[thread_id]->try_enqueue(log_entry)) {
         std::this_thread::yield();
@@ -141,19 +133,65 @@ void process_binlog_step_1(int thread_id, TxnLogParser& parser) {
   }
 }
 
+// unified logs are sharded by the owner vertex if there are multiple
+// partitions
+inline int32_t log_partition(int64_t owner_gid) {
+  if (FLAGS_write_kafka_partition_num == 1) {
+    return RdKafka::Topic::PARTITION_UA;
+  }
+  return owner_gid % FLAGS_write_kafka_partition_num;
+}
+
+// on restart, the logs of a partition up to its last written log are skipped.
+// Partitions are not flushed together, so the max offset of the partitions
+// may be ahead of some of them, and logs (and then epoch_begin markers) with
+// the same offset as the last written log may still be missing.
+inline bool written_before_restart(int32_t partition, int64_t binlog_offset,
+                                   bool epoch_begin) {
+  if (!catch_up_mode) {
+    return false;
+  }
+  const LastWrittenLog& last = last_written_logs[std::max(partition, 0)];
+  if (binlog_offset != last.offset) {
+    return binlog_offset < last.offset;
+  }
+  return !epoch_begin || last.epoch_begin;
+}
+
+inline void write_unified_log(KafkaOutputStream& ostream,
+                              const LogEntry& log_entry, int64_t binlog_offset,
+                              int32_t partition) {
+  if (written_before_restart(partition, binlog_offset,
+                             log_entry.get_op_type() ==
+                                 LogEntry::OpType::EPOCH_BEGIN)) {
+    return;
+  }
+  ostream.set_partition(partition);
+  if (FLAGS_binary_unified_log) {
+    ostream << log_entry.to_binary(binlog_offset) << flush;
+  } else {
+    ostream << log_entry.to_string(binlog_offset) << flush;
+  }
+}
+
 void process_binlog_step_2(KafkaOutputStream& ostream, TxnLogParser& parser) {
   int epoch = 0;
   uint64_t log_count = 0;
   int last_tx_id = -1;
   int last_log_count = 0;
+  // the latest epoch marked in all partitions
+  int marked_epoch = 0;
+  int reported_epoch = 0;
 
   int64_t processed_count = 0;
   auto start = std::chrono::steady_clock::now();
   auto interval = std::chrono::seconds(FLAGS_seconds_per_epoch);
   auto start_timer = std::chrono::steady_clock::now();
 
+  // the seq of the line, as the workers are visited in turn
+  int64_t seq = 0;
   while (true) {
-    for (auto idx = 0; idx < unified_log_counts.size(); idx++) {
+    for (auto idx = 0; idx < unified_log_counts.size(); idx++, seq++) {
       int unified_log_count = 0;
       while (true) {
 #ifndef USE_TBB
@@ -165,6 +203,14 @@ void process_binlog_step_2(KafkaOutputStream& ostream, TxnLogParser& parser) {
         }
         std::this_thread::yield();
       }
+#ifdef ENABLE_CHECKPOINT
+      // the state saved before this line is written once the emitted logs
+      // are delivered, so that they are not emitted again on restart
+      if (parser.pending_checkpoint_seq() == seq) {
+        ostream.flush_producer();
+        parser.write_checkpoint(FLAGS_checkpoint_dir);
+      }
+#endif  // ENABLE_CHECKPOINT
       if (unified_log_count == 0) {
         continue;
       }
@@ -187,9 +233,10 @@ void process_binlog_step_2(KafkaOutputStream& ostream, TxnLogParser& parser) {
           }
           std::this_thread::yield();
         }
-        GART_CHECK_OK(parser.parse_again(log_entry, epoch));
-        if (!catch_up_mode) {
-          ostream << log_entry.to_string(processed_count) << flush;
+        log_entry.set_epoch(epoch);
+        if (log_entry.complete()) {
+          write_unified_log(ostream, log_entry, processed_count,
+                            log_partition(log_entry.owner_gid()));
         }
       }
 
@@ -266,26 +313,100 @@ void process_binlog_step_2(KafkaOutputStream& ostream, TxnLogParser& parser) {
           }
         }
         processed_count++;
-        if (likely(!catch_up_mode)) {
-          ostream << LogEntry::bulk_load_end().to_string(processed_count)
-                  << flush;
-        }
+        write_unified_log(ostream, LogEntry::bulk_load_end(), processed_count,
+                          log_partition(0));
         start = std::chrono::steady_clock::now();
       }
+
+      // logs of the new epoch may be missing in some partitions, mark the
+      // epoch in all of them for the reader to merge partitions
+      if (FLAGS_write_kafka_partition_num > 1 && epoch != marked_epoch) {
+        marked_epoch = epoch;
+        for (int32_t partition = 0; partition < FLAGS_write_kafka_partition_num;
+             partition++) {
+          write_unified_log(ostream, LogEntry::epoch_begin(epoch),
+                            processed_count, partition);
+        }
+      }
+
+      if (FLAGS_report_partition_stats && epoch != reported_epoch) {
+        reported_epoch = epoch;
+        LOG(INFO) << "Partition stats before epoch " << epoch << ": "
+                  << parser.partition_stats();
+      }
     }
   }
 }
 
-#ifdef ENABLE_CHECKPOINT
-std::mutex checkpoint_mutex;
-#endif  // ENABLE_CHECKPOINT
+// load the last written log of each partition, return the max binlog offset
+// of them
+int64_t load_last_written_logs() {
+  int64_t last_offset = 0;
+  last_written_logs.assign(FLAGS_write_kafka_partition_num, LastWrittenLog());
+  for (int32_t partition = 0; partition < FLAGS_write_kafka_partition_num;
+       partition++) {
+    shared_ptr<KafkaConsumer> consumer_for_get_last_commit =
+        make_shared<KafkaConsumer>(FLAGS_write_kafka_broker_list,
+                                   FLAGS_write_kafka_topic, "gart_consumer",
+                                   partition, RdKafka::Topic::OFFSET_BEGINNING);
+    bool topic_exist = consumer_for_get_last_commit->topic_exist();
+
+    if (!topic_exist) {
+      consumer_for_get_last_commit->stop();
+      std::cout << "Empty partition " << partition << "." << std::endl;
+      continue;
+    }
+    std::pair<int64_t, int64_t> low_high_pair =
+        consumer_for_get_last_commit->query_watermark_offsets();
+    consumer_for_get_last_commit->stop();
+    int64_t high_offset = low_high_pair.second;
+    std::cout << "Partition " << partition
+              << ", Low offset: " << low_high_pair.first
+              << ", High offset: " << low_high_pair.second << std::endl;
+    if (high_offset == 0) {
+      continue;
+    }
+    consumer_for_get_last_commit->start(high_offset - 1);
+    RdKafka::Message* last_commit_msg =
+        consumer_for_get_last_commit->consume(nullptr, 1000);
+    string line(static_cast<const char*>(last_commit_msg->payload()),
+                last_commit_msg->len());
+    LastWrittenLog& last = last_written_logs[partition];
+    if (FLAGS_binary_unified_log) {
+      last.offset = LogEntry::binary_offset(line);
+      if (last.offset < 0) {
+        LOG(FATAL) << "Malformed binary unified log at offset "
+                   << high_offset - 1 << " of partition " << partition;
+      }
+      last.epoch_begin =
+          line[0] == static_cast<char>(gart::UnifiedLogOp::EPOCH_BEGIN);
+    } else {
+      std::cout << "Last message is " << line << std::endl;
+      char delimiter = '|';
+      size_t pos = line.find_last_of(delimiter);
+      last.offset = std::stoll(line.substr(pos + 1));
+      last.epoch_begin = line.compare(0, 12, "epoch_begin|") == 0;
+    }
+    last_offset = std::max(last_offset, last.offset);
+    consumer_for_get_last_commit->delete_message(last_commit_msg);
+    consumer_for_get_last_commit->stop();
+  }
+  return last_offset;
+}
 
 int main(int argc, char** argv) {
   google::InitGoogleLogging(argv[0]);
   gflags::ParseCommandLineFlags(&argc, &argv, true);
 
-  shared_ptr<KafkaProducer> producer = make_shared<KafkaProducer>(
-      FLAGS_write_kafka_broker_list, FLAGS_write_kafka_topic);
+  shared_ptr<KafkaProducer> producer;
+  if (FLAGS_write_unified_log_file.empty()) {
+    producer = make_shared<KafkaProducer>(FLAGS_write_kafka_broker_list,
+                                          FLAGS_write_kafka_topic);
+  } else {
+    producer = make_shared<FileProducer>(FLAGS_write_unified_log_file,
+                                         FLAGS_write_kafka_partition_num,
+                                         FLAGS_binary_unified_log);
+  }
   KafkaOutputStream ostream(producer);
 
   int num_threads = FLAGS_num_threads;
@@ -309,63 +430,39 @@ int main(int argc, char** argv) {
   }
 #endif
 
+  std::unique_ptr<converter::Partitioner> partitioner =
+      converter::Partitioner::create(
+          FLAGS_partitioner, FLAGS_subgraph_num, FLAGS_partition_range_size,
+          FLAGS_report_partition_stats);
+  if (partitioner == nullptr) {
+    LOG(ERROR) << "Unknown partitioner: " << FLAGS_partitioner;
+    return -1;
+  }
   TxnLogParser parser(FLAGS_etcd_endpoint, FLAGS_etcd_prefix,
-                      FLAGS_subgraph_num);
+                      FLAGS_subgraph_num, std::move(partitioner));
 #ifdef ENABLE_CHECKPOINT
-  std::thread checkpoint_thread([&]() {
+  int64_t checkpoint_txn_logs = parser.load_checkpoint(FLAGS_checkpoint_dir);
+  if (checkpoint_txn_logs > 0) {
+    std::cout << "Loaded the checkpoint of " << checkpoint_txn_logs
+              << " TxnLogs" << std::endl;
+  }
+  std::thread checkpoint_thread([&parser]() {
     while (1) {
       std::this_thread::sleep_for(
           std::chrono::minutes(FLAGS_checkpoint_interval));
-      {
-        std::lock_guard<std::mutex> guard(checkpoint_mutex);
-        parser.checkpoint_vertex_maps(FLAGS_checkpoint_dir);
-      }
+      parser.request_checkpoint();
     }
   });
   checkpoint_thread.detach();
-  {
-    std::lock_guard<std::mutex> guard(checkpoint_mutex);
-    parser.load_vertex_maps_checkpoint(FLAGS_checkpoint_dir);
-  }
 #endif  // ENABLE_CHECKPOINT
 
   bool is_timeout = false;
 
-  shared_ptr<KafkaConsumer> consumer_for_get_last_commit =
-      make_shared<KafkaConsumer>(FLAGS_write_kafka_broker_list,
-                                 FLAGS_write_kafka_topic, "gart_consumer", 0,
-                                 RdKafka::Topic::OFFSET_BEGINNING);
-  bool topic_exist = consumer_for_get_last_commit->topic_exist();
-
-  if (!topic_exist) {
-    consumer_for_get_last_commit->stop();
-    std::cout << "Empty...Will start to read topic messages from beginning."
-              << std::endl;
-  } else {
-    std::pair<int64_t, int64_t> low_high_pair =
-        consumer_for_get_last_commit->query_watermark_offsets();
-    consumer_for_get_last_commit->stop();
-    int64_t high_offset = low_high_pair.second;
-    std::cout << "Low offset: " << low_high_pair.first
-              << ", High offset: " << low_high_pair.second << std::endl;
-    if (high_offset == 0) {
-      std::cout << "Will start to read topic messages from beginning."
-                << std::endl;
-    } else {
-      consumer_for_get_last_commit->start(high_offset - 1);
-      RdKafka::Message* last_commit_msg =
-          consumer_for_get_last_commit->consume(nullptr, 1000);
-      string line(static_cast<const char*>(last_commit_msg->payload()),
-                  last_commit_msg->len());
-      std::cout << "Last message is " << line << std::endl;
-      char delimiter = '|';
-      size_t pos = line.find_last_of(delimiter);
-      last_processed_offset = std::stoll(line.substr(pos + 1));
-      std::cout << "Will start to read topic messages from "
-                << last_processed_offset << std::endl;
-      consumer_for_get_last_commit->delete_message(last_commit_msg);
-      consumer_for_get_last_commit->stop();
-    }
+  last_written_logs.assign(FLAGS_write_kafka_partition_num, LastWrittenLog());
+  if (FLAGS_write_unified_log_file.empty()) {
+    last_processed_offset = load_last_written_logs();
+    std::cout << "Will start to read topic messages from "
+              << last_processed_offset << std::endl;
   }
 
   shared_ptr<KafkaConsumer> consumer = make_shared<KafkaConsumer>(
@@ -22,6 +22,14 @@ DEFINE_string(write_kafka_broker_list, "127.0.0.1:9092",
 DEFINE_string(read_kafka_topic, "binlog", "Kafka topic for reading TxnLogs.");
 DEFINE_string(write_kafka_topic, "unified_log",
               "Kafka topic for writing UnifiedLogs.");
+DEFINE_int32(write_kafka_partition_num, 1,
+             "Number of partitions to shard UnifiedLogs by the source vertex, "
+             "the topic should have at least as many partitions.");
+DEFINE_string(write_unified_log_file, "",
+              "Write UnifiedLogs to this file (<file>.<partition> if there "
+              "are multiple partitions) instead of Kafka, for tests.");
+DEFINE_bool(binary_unified_log, false,
+            "Write UnifiedLogs in the binary format (util/unified_log.h).");
 
 DEFINE_int32(logs_per_epoch, 10000, "logs_per_epoch.");
 DEFINE_int32(seconds_per_epoch, 60, "seconds_per_epoch.");
@@ -31,6 +39,15 @@ DEFINE_string(etcd_endpoint, "127.0.0.1:2379", "etcd endpoint.");
 DEFINE_string(etcd_prefix, "", "etcd prefix.");
 
 DEFINE_int32(subgraph_num, 1, "Number of subgraphs.");
+DEFINE_string(partitioner, "round_robin",
+              "How vertices are partitioned into subgraphs: round_robin, "
+              "hash, range or greedy (see converter/partitioner.h).");
+DEFINE_int64(partition_range_size, 1 << 20,
+             "Number of integer external ids per subgraph of the range "
+             "partitioner.");
+DEFINE_bool(report_partition_stats, false,
+            "Log the vertex, edge and outer vertex counts of each subgraph "
+            "at every epoch.");
 
 DEFINE_int32(checkpoint_interval, 10, "Checkpoint interval in minutes.");
 DEFINE_string(checkpoint_dir, "/tmp/checkpoint", "Checkpoint directory.");
@@ -23,6 +23,9 @@ DECLARE_string(read_kafka_broker_list);
 DECLARE_string(write_kafka_broker_list);
 DECLARE_string(read_kafka_topic);
 DECLARE_string(write_kafka_topic);
+DECLARE_int32(write_kafka_partition_num);
+DECLARE_string(write_unified_log_file);  // for tests
+DECLARE_bool(binary_unified_log);
 
 DECLARE_int32(logs_per_epoch);
 DECLARE_int32(seconds_per_epoch);
@@ -32,6 +35,9 @@ DECLARE_string(etcd_endpoint);
 DECLARE_string(etcd_prefix);
 
 DECLARE_int32(subgraph_num);
+DECLARE_string(partitioner);
+DECLARE_int64(partition_range_size);
+DECLARE_bool(report_partition_stats);
 DECLARE_bool(enable_bulkload);
 
 DECLARE_int32(checkpoint_interval);  // in minutes
@@ -16,14 +16,18 @@
 #ifndef CONVERTER_KAFKA_HELPER_H_
 #define CONVERTER_KAFKA_HELPER_H_
 
+#include <fstream>
 #include <iostream>
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "glog/logging.h"
 #include "librdkafka/rdkafkacpp.h"
 
+#include "vegito/include/util/varint.h"
+
 namespace converter {
 
 /** Kafka producer class
@@ -60,14 +64,16 @@ class KafkaProducer {
     delete conf;  // release the memory resource
   }
 
-  ~KafkaProducer() = default;
+  virtual ~KafkaProducer() = default;
 
-  void add_message(const std::string& message) {
+  virtual void add_message(
+      const std::string& message,
+      int32_t partition = RdKafka::Topic::PARTITION_UA) {
     if (message.empty()) {
       return;
     }
     RdKafka::ErrorCode err = producer_->produce(
-        topic_, RdKafka::Topic::PARTITION_UA, RdKafka::Producer::RK_MSG_COPY,
+        topic_, partition, RdKafka::Producer::RK_MSG_COPY,
         static_cast<void*>(const_cast<char*>(message.c_str())) /* value */,
         message.size() /* size */, NULL, 0, 0 /* timestamp */,
         NULL /* delivery report */);
@@ -76,11 +82,16 @@ class KafkaProducer {
     }
     pending_count_ += 1;
     if (pending_count_ == 1024 * 128) {
-      producer_->flush(1000 * 60);  // 60s
-      pending_count_ = 0;
+      flush();
     }
   }
 
+  // wait until the messages are delivered
+  virtual void flush() {
+    producer_->flush(1000 * 60);  // 60s
+    pending_count_ = 0;
+  }
+
   inline std::string topic() const { return topic_; }
 
  private:
@@ -93,6 +104,53 @@ class KafkaProducer {
   std::unique_ptr<RdKafka::Producer> producer_;
 };
 
+/** File producer class
+ *
+ * A stand-in of KafkaProducer for tests. Messages of partition i are written
+ * to <path>.i, or to <path> if there is only one partition. Binary messages
+ * are prefixed by their varint length, text messages are one per line.
+ */
+class FileProducer : public KafkaProducer {
+ public:
+  FileProducer(const std::string& path, int num_partitions, bool binary)
+      : binary_(binary) {
+    for (int idx = 0; idx < num_partitions; idx++) {
+      std::string file_name =
+          num_partitions == 1 ? path : path + "." + std::to_string(idx);
+      files_.emplace_back(new std::ofstream(
+          file_name, std::ios::binary | std::ios::trunc));
+      if (!*files_.back()) {
+        LOG(ERROR) << "Failed to open unified log file " << file_name;
+      }
+    }
+  }
+
+  void add_message(const std::string& message,
+                   int32_t partition = RdKafka::Topic::PARTITION_UA) override {
+    if (message.empty()) {
+      return;
+    }
+    std::ofstream& file =
+        *files_[partition == RdKafka::Topic::PARTITION_UA ? 0 : partition];
+    if (binary_) {
+      uint8_t len[5];
+      uint8_t* end = write_uvint32(len, message.size());
+      file.write(reinterpret_cast<const char*>(len), end - len);
+      file.write(message.data(), message.size());
+    } else {
+      file << message << '\n';
+    }
+    file.flush();
+  }
+
+  // messages are flushed one by one
+  void flush() override {}
+
+ private:
+  bool binary_;
+  std::vector<std::unique_ptr<std::ofstream>> files_;
+};
+
 /**
  * A kafka output stream that can be used to flush messages into kafka prodcuer.
  */
@@ -105,6 +163,16 @@ class KafkaOutputStream : public std::ostream {
 
   void close() {}
 
+  // the partition of the following messages
+  void set_partition(int32_t partition) {
+    static_cast<KafkaBuffer*>(rdbuf())->set_partition(partition);
+  }
+
+  // wait until the flushed messages are delivered
+  void flush_producer() {
+    static_cast<KafkaBuffer*>(rdbuf())->flush_producer();
+  }
+
  private:
   class KafkaBuffer : public std::stringbuf {
    public:
@@ -112,13 +180,18 @@ class KafkaOutputStream : public std::ostream {
         : producer_(prodcuer) {}
 
     int sync() override {
-      producer_->add_message(this->str());
+      producer_->add_message(this->str(), partition_);
       this->str("");
       return 0;
     }
 
+    void set_partition(int32_t partition) { partition_ = partition; }
+
+    void flush_producer() { producer_->flush(); }
+
    private:
     std::shared_ptr<KafkaProducer> producer_;
+    int32_t partition_ = RdKafka::Topic::PARTITION_UA;
   };
 };
 
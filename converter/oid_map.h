@@ -0,0 +1,249 @@
+/** Copyright 2020-2023 Alibaba Group Holding Limited.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CONVERTER_OID_MAP_H_
+#define CONVERTER_OID_MAP_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace converter {
+
+// append-only storage of string keys, strings are never freed one by one
+class StringArena {
+ public:
+  const char* copy(const char* data, size_t size) {
+    if (size > kChunkSize / 4) {
+      // a large key takes its own chunk
+      chunks_.emplace_back(new char[size]);
+      memcpy(chunks_.back().get(), data, size);
+      return chunks_.back().get();
+    }
+    if (cur_ == nullptr || size > kChunkSize - used_) {
+      chunks_.emplace_back(new char[kChunkSize]);
+      cur_ = chunks_.back().get();
+      used_ = 0;
+    }
+    char* dst = cur_ + used_;
+    memcpy(dst, data, size);
+    used_ += size;
+    return dst;
+  }
+
+ private:
+  static constexpr size_t kChunkSize = 64 * 1024;
+
+  std::vector<std::unique_ptr<char[]>> chunks_;
+  char* cur_ = nullptr;
+  size_t used_ = 0;
+};
+
+template <typename OID_T>
+struct OidKeyTraits;
+
+template <>
+struct OidKeyTraits<int64_t> {
+  using stored_t = int64_t;
+
+  static uint64_t hash(int64_t oid) {
+    // finalizer of splitmix64
+    uint64_t x = static_cast<uint64_t>(oid);
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+  }
+
+  static bool equal(const stored_t& key, int64_t oid) { return key == oid; }
+
+  static stored_t store(int64_t oid, StringArena&) { return oid; }
+
+  static int64_t load(const stored_t& key) { return key; }
+};
+
+template <>
+struct OidKeyTraits<std::string> {
+  struct stored_t {
+    const char* data;
+    size_t size;
+  };
+
+  static uint64_t hash(const std::string& oid) {
+    return std::hash<std::string>()(oid);
+  }
+
+  static bool equal(const stored_t& key, const std::string& oid) {
+    return key.size == oid.size() &&
+           memcmp(key.data, oid.data(), key.size) == 0;
+  }
+
+  static stored_t store(const std::string& oid, StringArena& arena) {
+    return stored_t{arena.copy(oid.data(), oid.size()), oid.size()};
+  }
+
+  static std::string load(const stored_t& key) {
+    return std::string(key.data, key.size);
+  }
+};
+
+/**
+ * Concurrent map from external vertex ids (oids) of a vertex label to gids.
+ *
+ * Keys are spread over shards by the high bits of their hash, and each shard
+ * is an open-addressing table (linear probing on the low bits) guarded by its
+ * own lock, so threads sharing the map rarely contend. Hashes are
+ * kept in the slots to grow a shard without rehashing keys, and string keys
+ * are copied into a per-shard arena instead of being allocated one by one.
+ * Gids are never negative, a negative gid marks an empty slot.
+ *
+ * Each gid is tagged with the seq of the TxnLog that inserted it, so a
+ * lookup on behalf of a TxnLog ignores the oids inserted by later ones.
+ */
+template <typename OID_T>
+class ShardedOidMap {
+  using traits_t = OidKeyTraits<OID_T>;
+  using key_t = typename traits_t::stored_t;
+
+ public:
+  ShardedOidMap() : shards_(new Shard[kShardNum]) {}
+
+  // only the gids inserted by the TxnLogs up to max_seq are found
+  bool find(const OID_T& oid, int64_t max_seq, int64_t& gid) const {
+    uint64_t hash = traits_t::hash(oid);
+    const Shard& shard = shards_[shard_id(hash)];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (shard.slots.empty()) {
+      return false;
+    }
+    size_t mask = shard.slots.size() - 1;
+    for (size_t idx = hash & mask;; idx = (idx + 1) & mask) {
+      const Slot& slot = shard.slots[idx];
+      if (slot.gid < 0) {
+        return false;
+      }
+      if (slot.hash == hash && traits_t::equal(slot.key, oid)) {
+        if (slot.seq > max_seq) {
+          return false;
+        }
+        gid = slot.gid;
+        return true;
+      }
+    }
+  }
+
+  // insert a new oid or overwrite the gid of an existing one
+  void insert(const OID_T& oid, int64_t gid, int64_t seq) {
+    uint64_t hash = traits_t::hash(oid);
+    Shard& shard = shards_[shard_id(hash)];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if ((shard.size + 1) * kMaxLoadDen > shard.slots.size() * kMaxLoadNum) {
+      grow(shard);
+    }
+    size_t mask = shard.slots.size() - 1;
+    for (size_t idx = hash & mask;; idx = (idx + 1) & mask) {
+      Slot& slot = shard.slots[idx];
+      if (slot.gid < 0) {
+        slot.hash = hash;
+        slot.key = traits_t::store(oid, shard.arena);
+        slot.gid = gid;
+        slot.seq = seq;
+        shard.size++;
+        return;
+      }
+      if (slot.hash == hash && traits_t::equal(slot.key, oid)) {
+        slot.gid = gid;
+        slot.seq = seq;
+        return;
+      }
+    }
+  }
+
+  size_t size() const {
+    size_t total = 0;
+    for (size_t idx = 0; idx < kShardNum; idx++) {
+      std::lock_guard<std::mutex> lock(shards_[idx].mutex);
+      total += shards_[idx].size;
+    }
+    return total;
+  }
+
+  // call func(oid, gid) on every entry, one shard is locked at a time
+  template <typename FUNC_T>
+  void for_each(FUNC_T&& func) const {
+    for (size_t idx = 0; idx < kShardNum; idx++) {
+      const Shard& shard = shards_[idx];
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      for (const Slot& slot : shard.slots) {
+        if (slot.gid >= 0) {
+          func(traits_t::load(slot.key), slot.gid);
+        }
+      }
+    }
+  }
+
+ private:
+  static constexpr size_t kShardBits = 6;
+  static constexpr size_t kShardNum = 1 << kShardBits;
+  static constexpr size_t kInitSlotNum = 64;
+  // grow a shard when it is 7/10 full
+  static constexpr size_t kMaxLoadNum = 7;
+  static constexpr size_t kMaxLoadDen = 10;
+
+  struct Slot {
+    uint64_t hash;
+    key_t key;
+    int64_t gid = -1;
+    int64_t seq;
+  };
+
+  struct Shard {
+    mutable std::mutex mutex;
+    std::vector<Slot> slots;
+    size_t size = 0;
+    StringArena arena;
+  };
+
+  static size_t shard_id(uint64_t hash) { return hash >> (64 - kShardBits); }
+
+  static void grow(Shard& shard) {
+    size_t slot_num =
+        shard.slots.empty() ? kInitSlotNum : shard.slots.size() * 2;
+    std::vector<Slot> slots(slot_num);
+    size_t mask = slot_num - 1;
+    for (const Slot& slot : shard.slots) {
+      if (slot.gid < 0) {
+        continue;
+      }
+      size_t idx = slot.hash & mask;
+      while (slots[idx].gid >= 0) {
+        idx = (idx + 1) & mask;
+      }
+      slots[idx] = slot;
+    }
+    shard.slots.swap(slots);
+  }
+
+  std::unique_ptr<Shard[]> shards_;
+};
+
+}  // namespace converter
+
+#endif  // CONVERTER_OID_MAP_H_
@@ -15,10 +15,17 @@
 
 #include "converter/parser.h"
 
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
+#include <cstdio>
 #include <fstream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -27,6 +34,8 @@
 #include "vineyard/common/util/json.h"
 #include "yaml-cpp/yaml.h"
 
+#include "vegito/include/util/unified_log.h"
+
 using std::ifstream;
 using std::map;
 using std::string;
@@ -84,6 +93,36 @@ inline int extract_tx_id(const std::string& gtid_str) {
   return -1;
 }
 
+#ifndef USE_DEBEZIUM
+constexpr char kSourceField[] = "";  // Maxwell logs have no source field
+#else
+constexpr char kSourceField[] = "source";
+#endif
+
+// top-level fields of a TxnLog used by the parser
+inline const std::set<string>& top_level_fields() {
+#ifndef USE_DEBEZIUM
+  static const std::set<string> fields = {"table", "type", "data"};
+#else
+  static const std::set<string> fields = {"source", "op", "before", "after"};
+#endif
+  return fields;
+}
+
+// fields of the source of a Debezium log used by the parser
+inline const std::set<string>& source_fields() {
+  static const std::set<string> fields = {"table", "txId", "gtid",
+                                          "snapshot"};
+  return fields;
+}
+
+// a column of a row image, null if the column is absent
+inline const json& json_field(const json& data, const string& name) {
+  static const json null_value;
+  auto iter = data.find(name);
+  return iter == data.end() ? null_value : *iter;
+}
+
 }  // namespace
 
 namespace converter {
@@ -97,10 +136,19 @@ LogEntry LogEntry::bulk_load_end() {
   return entry;
 }
 
+LogEntry LogEntry::epoch_begin(int epoch) {
+  LogEntry entry;
+  entry.valid_ = true;
+  entry.complete_ = true;
+  entry.epoch = epoch;
+  entry.op_type = OpType::EPOCH_BEGIN;
+  return entry;
+}
+
 string LogEntry::to_string(int64_t binlog_offset) const {
   string base;
-  if (op_type == OpType::BULKLOAD_END) {
-    base = "bulkload_end";
+  if (op_type == OpType::BULKLOAD_END || op_type == OpType::EPOCH_BEGIN) {
+    base = op_type == OpType::BULKLOAD_END ? "bulkload_end" : "epoch_begin";
     append_str(base, epoch);
     append_str(base, binlog_offset);
     return base;
@@ -133,18 +181,100 @@ string LogEntry::to_string(int64_t binlog_offset) const {
     append_str(base, dst_external_id);
   }
 
-  for (const string& str : properties) {
-    append_str(base, str);
+  for (const Property& prop : properties) {
+    switch (prop.type) {
+    case gart::UnifiedLogValueType::INT:
+      append_str(base, prop.i);
+      break;
+    case gart::UnifiedLogValueType::DOUBLE:
+      append_str(base, static_cast<float>(prop.d));
+      break;
+    case gart::UnifiedLogValueType::TEXT:
+      append_str(base, prop.text);
+      break;
+    default:
+      append_str(base, string());  // null
+    }
   }
 
   append_str(base, binlog_offset);
   return base;
 }
 
+string LogEntry::to_binary(int64_t binlog_offset) const {
+  string base;
+  gart::UnifiedLogEncoder encoder(base);
+  if (op_type == OpType::BULKLOAD_END || op_type == OpType::EPOCH_BEGIN) {
+    encoder.put_op(op_type == OpType::BULKLOAD_END
+                       ? gart::UnifiedLogOp::BULKLOAD_END
+                       : gart::UnifiedLogOp::EPOCH_BEGIN);
+    encoder.put_uint(epoch);
+    encoder.put_uint(binlog_offset);
+    return base;
+  }
+
+  if (op_type == OpType::UNKNOWN) {
+    LOG(ERROR) << "Unknown operation type: " << static_cast<int>(op_type);
+    assert(false);
+  }
+  // updates of edges are split into delete + insert by the parser
+  gart::UnifiedLogOp op;
+  if (entity_type == EntityType::VERTEX) {
+    op = op_type == OpType::INSERT   ? gart::UnifiedLogOp::ADD_VERTEX
+         : op_type == OpType::UPDATE ? gart::UnifiedLogOp::UPDATE_VERTEX
+                                     : gart::UnifiedLogOp::DELETE_VERTEX;
+  } else {
+    op = op_type == OpType::INSERT ? gart::UnifiedLogOp::ADD_EDGE
+                                   : gart::UnifiedLogOp::DELETE_EDGE;
+  }
+
+  encoder.put_op(op);
+  encoder.put_uint(epoch);
+  encoder.put_uint(binlog_offset);
+
+  if (entity_type == EntityType::VERTEX) {
+    encoder.put_uint(vertex.gid);
+    encoder.put_bytes(external_id);
+  } else {
+    encoder.put_uint(edge.elabel);
+    encoder.put_uint(edge.src_gid);
+    encoder.put_uint(edge.dst_gid);
+    encoder.put_bytes(src_external_id);
+    encoder.put_bytes(dst_external_id);
+  }
+
+  encoder.put_uint(properties.size());
+  for (const Property& prop : properties) {
+    switch (prop.type) {
+    case gart::UnifiedLogValueType::INT:
+      encoder.put_int_value(prop.i);
+      break;
+    case gart::UnifiedLogValueType::DOUBLE:
+      encoder.put_double_value(prop.d);
+      break;
+    case gart::UnifiedLogValueType::TEXT:
+      encoder.put_text_value(prop.text);
+      break;
+    default:
+      encoder.put_null_value();
+    }
+  }
+  return base;
+}
+
+int64_t LogEntry::binary_offset(const string& log) {
+  gart::UnifiedLogDecoder decoder(log.data(), log.size());
+  gart::UnifiedLogOp op;
+  uint64_t epoch, binlog_offset;
+  if (!decoder.get_op(&op) || !decoder.get_uint(&epoch) ||
+      !decoder.get_uint(&binlog_offset)) {
+    return -1;
+  }
+  return static_cast<int64_t>(binlog_offset);
+}
+
 gart::Status TxnLogParser::init(const string& etcd_endpoint,
                                 const string& etcd_prefix, int subgraph_num) {
-  subgraph_num_ = subgraph_num;
-
   std::shared_ptr<etcd::Client> etcd_client =
       std::make_shared<etcd::Client>(etcd_endpoint);
 
@@ -154,7 +284,17 @@ gart::Status TxnLogParser::init(const string& etcd_endpoint,
     LOG(ERROR) << "RGMapping file get failed.";
     return gart::Status::GraphSchemaConfigError();
   }
-  std::string rg_mapping_str = response.value().as_string();
+  GART_RETURN_ON_ERROR(init_schema(response.value().as_string(), subgraph_num));
+
+  auto response_task =
+      etcd_client->put(etcd_prefix + "converter_is_up", "True").get();
+  assert(response_task.is_ok());
+  return gart::Status::OK();
+}
+
+gart::Status TxnLogParser::init_schema(const string& rg_mapping_str,
+                                       int subgraph_num) {
+  subgraph_num_ = subgraph_num;
 
   YAML::Node rg_mapping;
   try {
@@ -222,39 +362,53 @@ gart::Status TxnLogParser::init(const string& etcd_endpoint,
     required_properties_.emplace(label, required_prop_names);
   }
 
+  for (const auto& pair : vertex_id_columns_) {
+    useful_columns_.insert(pair.second);
+  }
+  for (const auto& pair : edge_label_columns_) {
+    useful_columns_.insert(pair.second.first);
+    useful_columns_.insert(pair.second.second);
+  }
+  for (const auto& pair : required_properties_) {
+    useful_columns_.insert(pair.second.begin(), pair.second.end());
+  }
+
   id_parser_.Init(subgraph_num_, vlabel_num_);
   string_oid2gid_maps_.resize(vlabel_num_);
   int64_oid2gid_maps_.resize(vlabel_num_);
-  vertex_nums_.resize(vlabel_num_, 0);
-  vertex_nums_per_fragment_.resize(vlabel_num_);
-  for (auto idx = 0; idx < vlabel_num_; ++idx) {
-    vertex_nums_per_fragment_[idx].resize(subgraph_num_, 0);
-  }
-
-  auto response_task =
-      etcd_client->put(etcd_prefix + "converter_is_up", "True").get();
-  assert(response_task.is_ok());
+  vertex_nums_per_fragment_.assign(vlabel_num_ * subgraph_num_, 0);
   return gart::Status::OK();
 }
 
-gart::Status TxnLogParser::parse(LogEntry& out, const string& log_str) {
-  out.properties.clear();
-  out.valid_ = false;
-  out.complete_ = true;
-  out.external_id = "";
-  out.src_external_id = "";
-  out.dst_external_id = "";
-  out.vlabel = -1;
-  out.src_vlabel = -1;
-  out.dst_vlabel = -1;
-  out.is_string_oid = false;
-  out.is_src_string_oid = false;
-  out.is_dst_string_oid = false;
-
-  // parse JSON
+gart::Status TxnLogParser::parse(vector<LogEntry>& out,
+                                 const string& log_str) {
+  out.clear();
+
+  // parse JSON, only the fields used below and the columns of the vertex and
+  // edge labels are kept in the DOM
+  string section;  // the current top-level field
+  json::parser_callback_t filter = [this, &section](int depth,
+                                                    json::parse_event_t event,
+                                                    json& parsed) {
+    if (event != json::parse_event_t::key) {
+      return true;
+    }
+    if (depth == 1) {
+      section = parsed.get<string>();
+      return top_level_fields().count(section) > 0;
+    } else if (depth == 2) {
+      const string& field = parsed.get_ref<const string&>();
+      if (section == kSourceField) {
+        return source_fields().count(field) > 0;
+      }
+      return useful_columns_.count(field) > 0;
+    }
+    return true;
+  };
+
   json log;
   try {
-    log = json::parse(log_str);
+    log = json::parse(log_str, filter);
   } catch (json::exception& e) {
     LOG(ERROR) << "TxnLog parse failed. Error message: " << e.what();
     return gart::Status::ParseJsonError();
@@ -269,47 +423,42 @@ gart::Status TxnLogParser::parse(LogEntry& out, const string& log_str) {
   auto useful_tables_it = useful_tables_.find(table_name);
   if (useful_tables_it == useful_tables_.end()) {
     // skip unused tables
-    if (unused_tables_.find(table_name) == unused_tables_.end()) {
+    std::lock_guard<std::mutex> lock(unused_tables_mutex_);
+    if (unused_tables_.insert(table_name).second) {
       LOG(INFO) << "Skip unused table: " << table_name;
-      unused_tables_.insert(table_name);
     }
     return gart::Status::OK();
   }
+
+  // fields shared by all the entries of the log
+  LogEntry header;
+  header.valid_ = true;
 #ifndef USE_DEBEZIUM
   type = log["type"].get<string>();
+  header.op_type = type == "insert"   ? LogEntry::OpType::INSERT
+                   : type == "update" ? LogEntry::OpType::UPDATE
+                   : type == "delete" ? LogEntry::OpType::DELETE
+                                      : LogEntry::OpType::UNKNOWN;
+  header.snapshot = LogEntry::Snapshot::FALSE;
 #else
   type = log["op"].get<string>();
-#endif
-  auto label_name = table2label_names_.find(table_name)->second[out.table_idx];
-  auto is_vlabel_name_it = vlable_names_.find(label_name);
-  if (is_vlabel_name_it != vlable_names_.end()) {
-    out.entity_type = LogEntry::EntityType::VERTEX;
-  } else {
-    out.entity_type = LogEntry::EntityType::EDGE;
-  }
-
-#ifndef USE_DEBEZIUM
-  out.op_type = type == "insert"   ? LogEntry::OpType::INSERT
-                : type == "update" ? LogEntry::OpType::UPDATE
-                : type == "delete" ? LogEntry::OpType::DELETE
-                                   : LogEntry::OpType::UNKNOWN;
-  out.snapshot = LogEntry::Snapshot::FALSE;
-#else
-  out.op_type = type == "c"   ? LogEntry::OpType::INSERT
-                : type == "u" ? LogEntry::OpType::UPDATE
-                : type == "d" ? LogEntry::OpType::DELETE
-                : type == "r" ? LogEntry::OpType::INSERT
-                              : LogEntry::OpType::UNKNOWN;
+  header.op_type = type == "c"   ? LogEntry::OpType::INSERT
+                   : type == "u" ? LogEntry::OpType::UPDATE
+                   : type == "d" ? LogEntry::OpType::DELETE
+                   : type == "r" ? LogEntry::OpType::INSERT
+                                 : LogEntry::OpType::UNKNOWN;
 
   // parse transaction id (tx_id)
   // default for PostgreSQL, -1 for MySQL
   // TODO(SSJ): Hardcode for PostgreSQL and MySQL
-  int tx_id = log["source"].value("txId", -1);
+  const json& source = log["source"];
+  int tx_id = source.value("txId", -1);
   if (tx_id == -1) {
     // MySQL
-    const json& gtid_json = log["source"]["gtid"];
-    const string& gtid_str =
-        gtid_json.is_null() ? string() : gtid_json.get<string>();
+    auto gtid_it = source.find("gtid");
+    const string& gtid_str = gtid_it == source.end() || gtid_it->is_null()
+                                 ? string()
+                                 : gtid_it->get<string>();
     if (!gtid_str.empty()) {
       // parse the format: GTID = source_id:transaction_id
       tx_id = extract_tx_id(gtid_str);
@@ -321,18 +470,18 @@ gart::Status TxnLogParser::parse(LogEntry& out, const string& log_str) {
     }
   }
 
-  out.tx_id = tx_id;
+  header.tx_id = tx_id;
 
   // Special snapshot status during snapshot:
   // first: firstRecordInTable && firstTable
   // last: lastRecordInTable && lastTable
   // first_in_data_collection: firstRecordInTable
   // last_in_data_collection: lastRecordInTable
-  string snapshot = log["source"]["snapshot"].get<string>();
-  out.snapshot = snapshot == "last"    ? LogEntry::Snapshot::LAST
-                 : snapshot == "true"  ? LogEntry::Snapshot::TRUE
-                 : snapshot == "false" ? LogEntry::Snapshot::FALSE
-                                       : LogEntry::Snapshot::OTHER;
+  string snapshot = source["snapshot"].get<string>();
+  header.snapshot = snapshot == "last"    ? LogEntry::Snapshot::LAST
+                    : snapshot == "true"  ? LogEntry::Snapshot::TRUE
+                    : snapshot == "false" ? LogEntry::Snapshot::FALSE
+                                          : LogEntry::Snapshot::OTHER;
 
   if (type == "r" && snapshot == "false") {
     LOG(ERROR) << "Invalid operation type " << type
@@ -340,304 +489,400 @@ gart::Status TxnLogParser::parse(LogEntry& out, const string& log_str) {
     return gart::Status::OperationError();
   }
 
-  if (out.snapshot == LogEntry::Snapshot::OTHER) {
+  if (header.snapshot == LogEntry::Snapshot::OTHER) {
     LOG(INFO) << "Other snapshot status: " << snapshot;
   }
 #endif
-  if (unlikely(out.op_type == LogEntry::OpType::UNKNOWN)) {
+  if (unlikely(header.op_type == LogEntry::OpType::UNKNOWN)) {
     LOG(ERROR) << "Unknown operation type: " << type;
     return gart::Status::OperationError();
   }
 
-  if (out.op_type == LogEntry::OpType::UPDATE &&
-      out.entity_type == LogEntry::EntityType::EDGE) {
-    if (out.update_has_finish_delete == false) {
-      out.update_has_finish_delete = true;
-      out.op_type = LogEntry::OpType::DELETE;
+  // one table may respond to multiple labels, and an update of an edge is
+  // split into a delete and an insert
+  for (const string& label_name : table2label_names_.find(table_name)->second) {
+    bool is_vertex = vlable_names_.find(label_name) != vlable_names_.end();
+    if (!is_vertex && header.op_type == LogEntry::OpType::UPDATE) {
+      out.push_back(header);
+      out.back().op_type = LogEntry::OpType::DELETE;
+      fill_entry(out.back(), log, label_name, is_vertex);
+      out.push_back(header);
+      out.back().op_type = LogEntry::OpType::INSERT;
+      fill_entry(out.back(), log, label_name, is_vertex);
     } else {
-      out.update_has_finish_delete = false;
-      out.op_type = LogEntry::OpType::INSERT;
+      out.push_back(header);
+      fill_entry(out.back(), log, label_name, is_vertex);
     }
   }
+  out.erase(std::remove_if(out.begin(), out.end(),
+                           [](const LogEntry& entry) {
+                             return !entry.complete();
+                           }),
+            out.end());
+  return gart::Status::OK();
+}
 
-  if (out.entity_type == LogEntry::EntityType::VERTEX) {
-    fill_vertex(out, log);
+void TxnLogParser::fill_entry(LogEntry& out, const json& log,
+                              const string& label_name, bool is_vertex) const {
+#ifndef USE_DEBEZIUM
+  const json& data = log["data"];
+#else
+  // the row image after an insert or update, or before a delete
+  const json& data = out.op_type == LogEntry::OpType::DELETE ? log["before"]
+                                                             : log["after"];
+#endif
+  if (is_vertex) {
+    out.entity_type = LogEntry::EntityType::VERTEX;
+    fill_vertex(out, data, label_name);
   } else {
-    fill_edge(out, log);
+    out.entity_type = LogEntry::EntityType::EDGE;
+    fill_edge(out, data, label_name);
   }
 
   if (out.op_type != LogEntry::OpType::DELETE && out.complete_ == true) {
-    fill_prop(out, log);
+    fill_prop(out, data, label_name);
   }
+}
 
-  if (out.update_has_finish_delete != true) {
-    out.table_idx++;
+void TxnLogParser::wait_turn(const std::atomic<int64_t>& turn, int64_t seq) {
+  while (turn.load(std::memory_order_acquire) < seq) {
+    std::this_thread::yield();
   }
-  if (out.table_idx < table2label_names_.find(table_name)->second.size()) {
-    out.all_labels_have_process = false;
-  } else {
-    out.all_labels_have_process = true;
-    out.table_idx = 0;
+}
+
+void TxnLogParser::assign_gids(vector<LogEntry>& entries, int64_t seq,
+                               bool is_txn_log) {
+  // reserve turn: the offsets (and the fids) of inserted vertices are taken
+  // in the order of logs, and the vertices are published to the lookups of
+  // the later logs
+  wait_turn(reserved_seq_, seq);
+  bool replayed = false;  // its entries were emitted before the checkpoint
+  if (is_txn_log) {
+    replayed = txn_log_num_ < checkpoint_txn_log_num_;
+#ifdef ENABLE_CHECKPOINT
+    if (!replayed && checkpoint_seq_.load(std::memory_order_acquire) < 0 &&
+        checkpoint_requested_.exchange(false)) {
+      save_checkpoint(seq);
+    }
+#endif  // ENABLE_CHECKPOINT
+    txn_log_num_++;
+  }
+  if (!replayed) {
+    reserve_gids(entries, seq);
+  }
+  reserved_seq_.store(seq + 1, std::memory_order_release);
+
+  // the lookups of the logs run concurrently: the vertices inserted by the
+  // later logs are ignored, and vertices inserted again wait for them
+  for (LogEntry& entry : entries) {
+    if (replayed) {
+      entry.complete_ = false;
+    } else if (!resolve_gids(entry, seq)) {
+      if (entry.get_entity_type() == LogEntry::EntityType::VERTEX) {
+        LOG(ERROR) << "Vertex id not found: " << entry.external_id << " "
+                   << entry.vlabel;
+      } else {
+        LOG(ERROR) << "Src or dst vertex id not found: "
+                   << entry.src_external_id << " " << entry.dst_external_id;
+      }
+      entry.complete_ = false;
+    }
   }
 
-  out.valid_ = true;
-  return gart::Status::OK();
+  // resolve turn: the stats in the order of logs
+  wait_turn(resolved_seq_, seq);
+  if (!replayed) {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    for (const LogEntry& entry : entries) {
+      if (entry.complete()) {
+        update_partition_stats(entry);
+      }
+    }
+  }
+  resolved_seq_.store(seq + 1, std::memory_order_release);
 }
 
-gart::Status TxnLogParser::parse_again(LogEntry& out, int epoch) {
-  out.epoch = epoch;
+void TxnLogParser::reserve_gids(vector<LogEntry>& entries, int64_t seq) {
+  for (LogEntry& out : entries) {
+    if (out.get_entity_type() != LogEntry::EntityType::VERTEX ||
+        out.get_op_type() != LogEntry::OpType::INSERT) {
+      continue;
+    }
+    int vertex_label_id = out.vlabel;
+    if (partitioner_->uses_stats()) {
+      wait_turn(resolved_seq_, seq);
+    }
+    int64_t fid;
+    {
+      std::lock_guard<std::mutex> lock(stats_mutex_);
+      fid = partitioner_->assign(vertex_label_id, out.external_id,
+                                 out.is_string_oid);
+    }
+    int64_t offset =
+        vertex_nums_per_fragment_[vertex_label_id * subgraph_num_ + fid]++;
+
+    int64_t gid = id_parser_.GenerateId(fid, vertex_label_id, offset);
+    if (get_gid(out.external_id, out.is_string_oid, vertex_label_id,
+                seq) != -1) {
+      // inserted again, the earlier logs may still look up the old gid
+      wait_turn(resolved_seq_, seq);
+    }
+    set_gid(out.external_id, out.is_string_oid, vertex_label_id, gid, seq);
+    out.vertex.gid = gid;
+  }
+}
 
+bool TxnLogParser::resolve_gids(LogEntry& out, int64_t seq) const {
   if (out.get_entity_type() == LogEntry::EntityType::VERTEX) {
-    int vertex_label_id = out.vlabel;
     if (out.get_op_type() == LogEntry::OpType::INSERT) {
-      // partition by round-robin
-      int64_t fid = vertex_nums_[vertex_label_id] % subgraph_num_;
-      int64_t offset = vertex_nums_per_fragment_[vertex_label_id][fid];
-      vertex_nums_[vertex_label_id]++;
-      vertex_nums_per_fragment_[vertex_label_id][fid]++;
-
-      int64_t gid = id_parser_.GenerateId(fid, vertex_label_id, offset);
-      set_gid(out.external_id, out.is_string_oid, vertex_label_id, gid);
-      out.vertex.gid = gid;
-    } else if (out.op_type == LogEntry::OpType::DELETE ||
-               out.op_type == LogEntry::OpType::UPDATE) {
-      int64_t gid =
-          get_gid(out.external_id, out.is_string_oid, vertex_label_id);
-      if (gid == -1) {
-        LOG(ERROR) << "Vertex id not found: " << out.external_id << " "
-                   << vertex_label_id;
-        out.complete_ = false;
-        return gart::Status::OK();
-      }
-      out.vertex.gid = gid;
+      return true;  // reserved
     }
-  } else {
-    int64_t src_gid =
-        get_gid(out.src_external_id, out.is_src_string_oid, out.src_vlabel);
-    int64_t dst_gid =
-        get_gid(out.dst_external_id, out.is_dst_string_oid, out.dst_vlabel);
-    if (src_gid == -1 || dst_gid == -1) {
-      LOG(ERROR) << "Src or dst vertex id not found: " << out.src_external_id
-                 << " " << out.dst_external_id;
-      out.complete_ = false;
-      return gart::Status::OK();
+    int64_t gid =
+        get_gid(out.external_id, out.is_string_oid, out.vlabel, seq);
+    if (gid == -1) {
+      return false;
     }
-    out.edge.src_gid = src_gid;
-    out.edge.dst_gid = dst_gid;
+    out.vertex.gid = gid;
+    return true;
   }
-  return gart::Status::OK();
+
+  int64_t src_gid = get_gid(out.src_external_id, out.is_src_string_oid,
+                            out.src_vlabel, seq);
+  int64_t dst_gid = get_gid(out.dst_external_id, out.is_dst_string_oid,
+                            out.dst_vlabel, seq);
+  if (src_gid == -1 || dst_gid == -1) {
+    return false;
+  }
+  out.edge.src_gid = src_gid;
+  out.edge.dst_gid = dst_gid;
+  return true;
 }
 
-int64_t TxnLogParser::get_gid(std::string& oid, bool is_string_oid,
-                              int vlabel) const {
-  int64_t gid = -1;
+void TxnLogParser::update_partition_stats(const LogEntry& out) {
+  PartitionStats& stats = partitioner_->stats();
+  if (out.get_entity_type() == LogEntry::EntityType::VERTEX) {
+    // inserted vertices are counted when they are assigned
+    if (out.get_op_type() == LogEntry::OpType::DELETE) {
+      stats.delete_vertex(id_parser_.GetFid(out.vertex.gid));
+    }
+    return;
+  }
 
+  int src_fid = id_parser_.GetFid(out.edge.src_gid);
+  int dst_fid = id_parser_.GetFid(out.edge.dst_gid);
+  if (out.get_op_type() == LogEntry::OpType::INSERT) {
+    stats.add_edge(src_fid, out.edge.src_gid, dst_fid, out.edge.dst_gid);
+  } else if (out.get_op_type() == LogEntry::OpType::DELETE) {
+    stats.delete_edge(src_fid, dst_fid);
+  }
+}
+
+string TxnLogParser::partition_stats() const {
+  std::lock_guard<std::mutex> lock(stats_mutex_);
+  return partitioner_->stats().to_string();
+}
+
+int64_t TxnLogParser::get_gid(const std::string& oid, bool is_string_oid,
+                              int vlabel, int64_t max_seq) const {
+  int64_t gid = -1;
   if (!is_string_oid) {
-    auto it = int64_oid2gid_maps_[vlabel].find(std::stoll(oid));
-    if (it == int64_oid2gid_maps_[vlabel].end()) {
-      LOG(ERROR) << "Vertex id not found: " << oid << " " << vlabel;
-    } else {
-      gid = it->second;
-    }
+    int64_oid2gid_maps_[vlabel].find(std::stoll(oid), max_seq, gid);
   } else {
-    auto it = string_oid2gid_maps_[vlabel].find(oid);
-    if (it == string_oid2gid_maps_[vlabel].end()) {
-      LOG(ERROR) << "Vertex id not found: " << oid << " " << vlabel;
-    } else {
-      gid = it->second;
-    }
+    string_oid2gid_maps_[vlabel].find(oid, max_seq, gid);
   }
   return gid;
 }
 
-void TxnLogParser::set_gid(std::string& oid, bool is_string_oid, int vlabel,
-                           int64_t gid) {
+void TxnLogParser::set_gid(const std::string& oid, bool is_string_oid,
+                           int vlabel, int64_t gid, int64_t seq) {
   if (!is_string_oid) {
-    int64_oid2gid_maps_[vlabel][std::stoll(oid)] = gid;
+    int64_oid2gid_maps_[vlabel].insert(std::stoll(oid), gid, seq);
   } else {
-    string_oid2gid_maps_[vlabel][oid] = gid;
+    string_oid2gid_maps_[vlabel].insert(oid, gid, seq);
   }
 }
 
-void TxnLogParser::fill_vertex(LogEntry& out, const json& log) {
-#ifndef USE_DEBEZIUM
-  const string& table_name(log["table"].get<string>());
-  const json& data = log["data"];
-#else
-  const string& table_name(log["source"]["table"].get<string>());
-  json data;
-  if (out.op_type == LogEntry::OpType::INSERT) {
-    data = log["after"];
-  } else if (out.op_type == LogEntry::OpType::DELETE) {
-    data = log["before"];
-  } else if (out.op_type == LogEntry::OpType::UPDATE) {
-    data = log["after"];
-  }
-#endif
-
-  string vlabel_name =
-      table2label_names_.find(table_name)->second[out.table_idx];
+void TxnLogParser::fill_vertex(LogEntry& out, const json& data,
+                               const string& vlabel_name) const {
   const string& vid_col = vertex_id_columns_.find(vlabel_name)->second;
   int vertex_label_id = vertex_label2ids_.find(vlabel_name)->second;
   out.vlabel = vertex_label_id;
 
+  const json& vid = json_field(data, vid_col);
   string external_id;
   // TODO(wanglei): now only vertex has external id
-  if (data[vid_col].is_number_integer()) {
-    external_id = std::to_string(data[vid_col].get<int64_t>());
+  if (vid.is_number_integer()) {
+    external_id = std::to_string(vid.get<int64_t>());
     out.is_string_oid = false;
-  } else if (data[vid_col].is_string()) {
-    external_id = data[vid_col].get<string>();
+  } else if (vid.is_string()) {
+    external_id = vid.get<string>();
     out.is_string_oid = true;
   } else {
-    LOG(ERROR) << "Unknown vertex id type: " << data[vid_col].type_name();
+    LOG(ERROR) << "Unknown vertex id type: " << vid.type_name();
   }
   if (external_id.empty()) {
     LOG(ERROR) << "Empty external id for vertex: " << vlabel_name;
     assert(false);
   }
-  out.external_id = external_id;
+  out.external_id = std::move(external_id);
 }
 
-void TxnLogParser::fill_edge(LogEntry& out, const json& log) const {
-#ifndef USE_DEBEZIUM
-  const string& table_name(log["table"].get<string>());
-  const json& data = log["data"];
-#else
-  const string& table_name(log["source"]["table"].get<string>());
-  json data;
-  if (out.op_type == LogEntry::OpType::INSERT) {
-    data = log["after"];
-  } else if (out.op_type == LogEntry::OpType::DELETE) {
-    data = log["before"];
-  } else if (out.op_type == LogEntry::OpType::UPDATE) {
-    data = log["after"];
-  }
-#endif
-
-  string elable_name =
-      table2label_names_.find(table_name)->second[out.table_idx];
-  out.edge.elabel = elabel_names2elabel_.find(elable_name)->second;
+void TxnLogParser::fill_edge(LogEntry& out, const json& data,
+                             const string& elabel_name) const {
+  out.edge.elabel = elabel_names2elabel_.find(elabel_name)->second;
 
-  auto edge_col = edge_label_columns_.find(elable_name)->second;
-  string src_name = edge_col.first;
-  string dst_name = edge_col.second;
-  auto edge_label_id = elabel_names2elabel_.find(elable_name)->second;
+  const auto& edge_col = edge_label_columns_.find(elabel_name)->second;
+  auto edge_label_id = out.edge.elabel;
   int src_label_id = edge_label2src_dst_labels_[edge_label_id].first;
   int dst_label_id = edge_label2src_dst_labels_[edge_label_id].second;
   out.src_vlabel = src_label_id;
   out.dst_vlabel = dst_label_id;
 
-  // check if the data[src_name] and data[dst_name] are null
-  if (data[src_name].is_null() || data[dst_name].is_null()) {
+  const json& src = json_field(data, edge_col.first);
+  const json& dst = json_field(data, edge_col.second);
+  // check if the src and dst are null
+  if (src.is_null() || dst.is_null()) {
     out.complete_ = false;
     return;
   }
 
-  if (data[src_name].is_number_integer()) {
-    out.src_external_id = std::to_string(data[src_name].get<int64_t>());
+  if (src.is_number_integer()) {
+    out.src_external_id = std::to_string(src.get<int64_t>());
     out.is_src_string_oid = false;
-  } else if (data[src_name].is_string()) {
-    out.src_external_id = data[src_name].get<string>();
+  } else if (src.is_string()) {
+    out.src_external_id = src.get<string>();
     out.is_src_string_oid = true;
   }
 
-  if (data[dst_name].is_number_integer()) {
-    out.dst_external_id = std::to_string(data[dst_name].get<int64_t>());
+  if (dst.is_number_integer()) {
+    out.dst_external_id = std::to_string(dst.get<int64_t>());
     out.is_dst_string_oid = false;
-  } else if (data[dst_name].is_string()) {
-    out.dst_external_id = data[dst_name].get<string>();
+  } else if (dst.is_string()) {
+    out.dst_external_id = dst.get<string>();
     out.is_dst_string_oid = true;
   }
 }
 
-void TxnLogParser::fill_prop(LogEntry& out, const json& log) const {
-#ifndef USE_DEBEZIUM
-  const string& table_name(log["table"].get<string>());
-  const json& data = log["data"];
-#else
-  const string& table_name(log["source"]["table"].get<string>());
-  json data;
-  if (out.op_type == LogEntry::OpType::INSERT) {
-    data = log["after"];
-  } else if (out.op_type == LogEntry::OpType::DELETE) {
-    data = log["before"];
-  } else if (out.op_type == LogEntry::OpType::UPDATE) {
-    data = log["after"];
-  }
-#endif
-  auto label_name = table2label_names_.find(table_name)->second[out.table_idx];
+void TxnLogParser::fill_prop(LogEntry& out, const json& data,
+                             const string& label_name) const {
   auto iter = required_properties_.find(label_name);
   const vector<string>& required_prop_names = iter->second;
 
+  out.properties.reserve(required_prop_names.size());
   for (size_t prop_id = 0; prop_id < required_prop_names.size(); prop_id++) {
-    const string& prop_name = required_prop_names[prop_id];
-    json prop_value;
-    prop_value = data[prop_name];
-    string prop_str;
+    const json& prop_value = json_field(data, required_prop_names[prop_id]);
+    LogEntry::Property prop;
     if (prop_value.is_string()) {
-      prop_str = prop_value.get<string>();
+      prop.type = gart::UnifiedLogValueType::TEXT;
+      prop.text = prop_value.get<string>();
     } else if (prop_value.is_number_integer()) {
-      prop_str = to_string(prop_value.get<int64_t>());
+      prop.type = gart::UnifiedLogValueType::INT;
+      prop.i = prop_value.get<int64_t>();
     } else if (prop_value.is_number_float()) {
-      prop_str = to_string(prop_value.get<float>());
+      prop.type = gart::UnifiedLogValueType::DOUBLE;
+      prop.d = prop_value.get<double>();
     } else if (prop_value.is_null()) {
-      prop_str = "";
+      prop.type = gart::UnifiedLogValueType::NULL_VALUE;
+    } else if (prop_value.is_array() || prop_value.is_object()) {
+      // lists and JSON documents, decoded by the type of the property
+      prop.type = gart::UnifiedLogValueType::TEXT;
+      prop.text = prop_value.dump();
     } else {
       LOG(ERROR) << "Unsupported property type: " << prop_value.type_name();
       assert(false);
       continue;
     }
-    out.properties.push_back(prop_str);
+    out.properties.push_back(std::move(prop));
   }
 }
 
 #ifdef ENABLE_CHECKPOINT
-void TxnLogParser::checkpoint_vertex_maps(const string& folder_path) {
-  // file format: vlabel_id_string_vertex_map.bin or
-  // vlabel_id_int_vertex_map.bin
-  for (auto v_label = 0; v_label < vlabel_num_; v_label++) {
-    if (!string_oid2gid_maps_.empty()) {
-      std::string file_name = folder_path + "/vlabel_" +
-                              std::to_string(v_label) +
-                              "_string_vertex_map.bin";
-      std::ofstream ofs(file_name);
-      boost::archive::binary_oarchive oa(ofs);
-      oa << string_oid2gid_maps_[v_label];
-    } else {
-      std::string file_name = folder_path + "/vlabel_" +
-                              std::to_string(v_label) + "_int_vertex_map.bin";
-      std::ofstream ofs(file_name);
-      boost::archive::binary_oarchive oa(ofs);
-      oa << int64_oid2gid_maps_[v_label];
+namespace {
+
+// one file, so that a checkpoint is replaced at once by rename()
+string checkpoint_file(const string& folder_path) {
+  return folder_path + "/converter_checkpoint.bin";
+}
+
+}  // namespace
+
+void TxnLogParser::save_checkpoint(int64_t seq) {
+  // the stats of the earlier logs are part of the partitioner state
+  wait_turn(resolved_seq_, seq);
+  std::ostringstream oss;
+  {
+    boost::archive::binary_oarchive oa(oss);
+    oa << txn_log_num_ << vertex_nums_per_fragment_
+       << partitioner_->get_state();
+    // a label may have both string and int oids
+    for (auto v_label = 0; v_label < vlabel_num_; v_label++) {
+      std::map<std::string, int64_t> string_oid2gid;
+      string_oid2gid_maps_[v_label].for_each(
+          [&string_oid2gid](const std::string& oid, int64_t gid) {
+            string_oid2gid.emplace(oid, gid);
+          });
+      std::map<int64_t, int64_t> int_oid2gid;
+      int64_oid2gid_maps_[v_label].for_each(
+          [&int_oid2gid](int64_t oid, int64_t gid) {
+            int_oid2gid.emplace(oid, gid);
+          });
+      oa << string_oid2gid << int_oid2gid;
     }
   }
-  // write the values of vertex_nums_ and vertex_nums_per_fragment_ into files
-  std::string file_name = folder_path + "/vertex_nums.bin";
-  std::ofstream ofs(file_name);
+  checkpoint_data_ = oss.str();
+  checkpoint_seq_.store(seq, std::memory_order_release);
 }
 
-void TxnLogParser::load_vertex_maps_checkpoint(const string& folder_path) {
+void TxnLogParser::write_checkpoint(const string& folder_path) {
+  string file_name = checkpoint_file(folder_path);
+  string tmp_file_name = file_name + ".tmp";
+  bool written;
+  {
+    std::ofstream ofs(tmp_file_name, std::ios::binary | std::ios::trunc);
+    ofs.write(checkpoint_data_.data(), checkpoint_data_.size());
+    ofs.flush();
+    written = static_cast<bool>(ofs);
+  }
+  if (!written) {
+    LOG(ERROR) << "Failed to write checkpoint file " << tmp_file_name;
+  } else if (std::rename(tmp_file_name.c_str(), file_name.c_str()) != 0) {
+    LOG(ERROR) << "Failed to rename checkpoint file " << tmp_file_name;
+  }
+  checkpoint_data_.clear();
+  checkpoint_seq_.store(-1, std::memory_order_release);
+}
+
+int64_t TxnLogParser::load_checkpoint(const string& folder_path) {
+  std::ifstream ifs(checkpoint_file(folder_path), std::ios::binary);
+  if (!ifs.good()) {
+    return 0;
+  }
+  boost::archive::binary_iarchive ia(ifs);
+  int64_t txn_log_num;
+  std::vector<uint64_t> vertex_nums_per_fragment;
+  std::vector<int64_t> partitioner_state;
+  ia >> txn_log_num >> vertex_nums_per_fragment >> partitioner_state;
+  if (vertex_nums_per_fragment.size() != vertex_nums_per_fragment_.size() ||
+      !partitioner_->set_state(partitioner_state)) {
+    LOG(ERROR) << "The checkpoint in " << folder_path
+               << " is taken with another schema or partitioner, ignored";
+    return 0;
+  }
+  vertex_nums_per_fragment_ = std::move(vertex_nums_per_fragment);
+  // the gids are inserted before any log
   for (auto v_label = 0; v_label < vlabel_num_; v_label++) {
-    std::string file_name = folder_path + "/vlabel_" + std::to_string(v_label) +
-                            "_string_vertex_map.bin";
-    // check if file exists
-    std::ifstream ifs(file_name, std::ios::binary);
-    if (ifs.good()) {
-      boost::archive::binary_iarchive ia(ifs);
-      ia >> string_oid2gid_maps_[v_label];
-      continue;
+    std::map<std::string, int64_t> string_oid2gid;
+    std::map<int64_t, int64_t> int_oid2gid;
+    ia >> string_oid2gid >> int_oid2gid;
+    for (const auto& pair : string_oid2gid) {
+      string_oid2gid_maps_[v_label].insert(pair.first, pair.second, -1);
     }
-
-    file_name = folder_path + "/vlabel_" + std::to_string(v_label) +
-                "_int_vertex_map.bin";
-    ifs.open(file_name, std::ios::binary);
-    if (ifs.good()) {
-      boost::archive::binary_iarchive ia(ifs);
-      ia >> int64_oid2gid_maps_[v_label];
-      continue;
+    for (const auto& pair : int_oid2gid) {
+      int64_oid2gid_maps_[v_label].insert(pair.first, pair.second, -1);
     }
   }
+  checkpoint_txn_log_num_ = txn_log_num;
+  return txn_log_num;
 }
 #endif  // ENABLE_CHECKPOINT
 
@@ -16,7 +16,10 @@
 #ifndef CONVERTER_PARSER_H_
 #define CONVERTER_PARSER_H_
 
+#include <atomic>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <set>
 #include <string>
 #include <utility>
@@ -26,38 +29,61 @@
 #include <boost/archive/binary_oarchive.hpp>
 #include <boost/serialization/map.hpp>
 #include <boost/serialization/string.hpp>
+#include <boost/serialization/vector.hpp>
 #endif  // ENABLE_CHECKPOINT
 
-#ifdef USE_FLAT_HASH_MAP
-#include "absl/container/flat_hash_map.h"
-#endif
-
 #include "vineyard/common/util/json.h"
 
+#include "converter/oid_map.h"
+#include "converter/partitioner.h"
 #include "vegito/include/fragment/id_parser.h"
 #include "vegito/include/util/status.h"
+#include "vegito/include/util/unified_log.h"
 
 namespace converter {
 
 class LogEntry {
  public:
   LogEntry()
-      : valid_(false),
-        update_has_finish_delete(false),
-        all_labels_have_process(false),
+      : vlabel(-1),
+        src_vlabel(-1),
+        dst_vlabel(-1),
+        is_string_oid(false),
+        is_src_string_oid(false),
+        is_dst_string_oid(false),
+        valid_(false),
         complete_(true),
-        table_idx(0) {}
+        tx_id(-1),
+        snapshot(Snapshot::FALSE) {}
 
   enum class EntityType { VERTEX, EDGE };
-  enum class OpType { INSERT, UPDATE, DELETE, BULKLOAD_END, UNKNOWN };
+  enum class OpType {
+    INSERT,
+    UPDATE,
+    DELETE,
+    BULKLOAD_END,
+    EPOCH_BEGIN,
+    UNKNOWN
+  };
   enum class Snapshot { FALSE, TRUE, LAST, OTHER };
 
   static LogEntry bulk_load_end();
 
+  // marks the start of an epoch in every partition of the unified log topic
+  static LogEntry epoch_begin(int epoch);
+
   std::string to_string(int64_t binlog_offset) const;
 
+  // the binary format of unified logs, see vegito/include/util/unified_log.h
+  std::string to_binary(int64_t binlog_offset) const;
+
+  // the binlog offset recorded in a binary unified log, -1 if malformed
+  static int64_t binary_offset(const std::string& log);
+
   int get_tx_id() const { return tx_id; }
 
+  void set_epoch(int epoch) { this->epoch = epoch; }
+
   bool valid() const { return valid_; }
 
   bool complete() const { return complete_; }
@@ -68,10 +94,9 @@ class LogEntry {
 
   OpType get_op_type() const { return op_type; }
 
-  // One log may produce multiple log entries
-  // Now it is only used for update edges (delete + insert)
-  bool more_entires() const {
-    return update_has_finish_delete || !all_labels_have_process;
+  // the vertex, or the source vertex of an edge, used to shard unified logs
+  int64_t owner_gid() const {
+    return entity_type == EntityType::VERTEX ? vertex.gid : edge.src_gid;
   }
 
  private:
@@ -100,15 +125,21 @@ class LogEntry {
   bool is_string_oid;
   bool is_src_string_oid, is_dst_string_oid;
 
-  std::vector<std::string> properties;
+  // a property as its JSON type in the binlog, numbers are written as they
+  // are by to_binary and as text by to_string
+  struct Property {
+    gart::UnifiedLogValueType type = gart::UnifiedLogValueType::NULL_VALUE;
+    int64_t i = 0;
+    double d = 0;
+    std::string text;  // TEXT values
+  };
+
+  std::vector<Property> properties;
 
   // log status (meta-data)
   bool valid_;
-  bool update_has_finish_delete;
-  bool all_labels_have_process;
-  bool complete_;  // incomplete log entry (column maybe null)
+  bool complete_;      // incomplete log entry (column maybe null)
   int tx_id;
-  size_t table_idx;
   Snapshot snapshot;
 
   friend class TxnLogParser;
@@ -117,18 +148,55 @@ class LogEntry {
 class TxnLogParser {
  public:
   TxnLogParser(const std::string& etcd_endpoint, const std::string& etcd_prefix,
-               int subgraph_num) {
+               int subgraph_num, std::unique_ptr<Partitioner> partitioner)
+      : partitioner_(std::move(partitioner)) {
     GART_CHECK_OK(init(etcd_endpoint, etcd_prefix, subgraph_num));
   }
 
-  gart::Status parse(LogEntry& out, const std::string& log_str);
+  // the RGMapping is given instead of read from etcd, for tests
+  TxnLogParser(const std::string& rg_mapping_yaml, int subgraph_num,
+               std::unique_ptr<Partitioner> partitioner)
+      : partitioner_(std::move(partitioner)) {
+    GART_CHECK_OK(init_schema(rg_mapping_yaml, subgraph_num));
+  }
 
-  gart::Status parse_again(LogEntry& out, int epoch);
+  // parse a TxnLog into log entries, one log may produce multiple entries:
+  // one for each label of the table, and an update of an edge is split into
+  // a delete and an insert. Entries missing the src or dst of an edge are
+  // dropped.
+  // It is called by the step-1 workers concurrently.
+  gart::Status parse(std::vector<LogEntry>& out, const std::string& log_str);
+
+  // assign the gids of the vertices inserted by a TxnLog and look up the
+  // gids of its other entries, the entries whose gids are not found are
+  // marked incomplete. It is called by the step-1 workers concurrently, after
+  // parse(), for every line handed to them: seq is the position of the line,
+  // and is_txn_log is false for the lines marking a timeout.
+  // Gids and fids are reserved in the order of seq, so they only depend on
+  // the logs, and are the same when the logs are replayed.
+  void assign_gids(std::vector<LogEntry>& entries, int64_t seq,
+                   bool is_txn_log);
+
+  std::string partition_stats() const;
 
 #ifdef ENABLE_CHECKPOINT
-  void checkpoint_vertex_maps(const std::string& folder_path);
+  // the vertex maps, the gid counters and the partitioner are saved by the
+  // next call of assign_gids, before its TxnLog
+  void request_checkpoint() { checkpoint_requested_ = true; }
+
+  // the seq of the TxnLog before which the saved state is pending, -1 if
+  // there is none
+  int64_t pending_checkpoint_seq() const {
+    return checkpoint_seq_.load(std::memory_order_acquire);
+  }
+
+  // write the pending state, after the unified logs of the TxnLogs before
+  // pending_checkpoint_seq() are delivered, as they are not emitted again
+  void write_checkpoint(const std::string& folder_path);
 
-  void load_vertex_maps_checkpoint(const std::string& folder_path);
+  // return the number of TxnLogs in the checkpoint, whose entries are marked
+  // incomplete by assign_gids after a restart, 0 if there is no checkpoint
+  int64_t load_checkpoint(const std::string& folder_path);
 #endif  // ENABLE_CHECKPOINT
 
   ~TxnLogParser() = default;
@@ -136,18 +204,48 @@ class TxnLogParser {
  private:
   TxnLogParser() = default;
 
-  int64_t get_gid(std::string& oid, bool is_string_oid, int vlabel) const;
+  // -1 if the oid is not found in the TxnLogs up to max_seq
+  int64_t get_gid(const std::string& oid, bool is_string_oid, int vlabel,
+                  int64_t max_seq) const;
+
+  void set_gid(const std::string& oid, bool is_string_oid, int vlabel,
+               int64_t gid, int64_t seq);
+
+  // the gids of the vertices inserted by the TxnLog, in its turn
+  void reserve_gids(std::vector<LogEntry>& entries, int64_t seq);
+
+  // look up the gids of the vertex or edge, return false if some of them
+  // are not found
+  bool resolve_gids(LogEntry& out, int64_t seq) const;
 
-  void set_gid(std::string& oid, bool is_string_oid, int vlabel, int64_t gid);
+  // called in the order of logs, after the gids are resolved
+  void update_partition_stats(const LogEntry& out);
+
+  // wait until the TxnLogs before seq have passed the turn
+  static void wait_turn(const std::atomic<int64_t>& turn, int64_t seq);
+
+#ifdef ENABLE_CHECKPOINT
+  // save the state before the TxnLog seq, in its turn
+  void save_checkpoint(int64_t seq);
+#endif  // ENABLE_CHECKPOINT
 
   gart::Status init(const std::string& etcd_endpoint,
                     const std::string& etcd_prefix, int subgraph_num);
 
-  void fill_vertex(LogEntry& out, const vineyard::json& log);
+  gart::Status init_schema(const std::string& rg_mapping_yaml,
+                           int subgraph_num);
 
-  void fill_edge(LogEntry& out, const vineyard::json& log) const;
+  void fill_entry(LogEntry& out, const vineyard::json& log,
+                  const std::string& label_name, bool is_vertex) const;
 
-  void fill_prop(LogEntry& out, const vineyard::json& log) const;
+  void fill_vertex(LogEntry& out, const vineyard::json& data,
+                   const std::string& vlabel_name) const;
+
+  void fill_edge(LogEntry& out, const vineyard::json& data,
+                 const std::string& elabel_name) const;
+
+  void fill_prop(LogEntry& out, const vineyard::json& data,
+                 const std::string& label_name) const;
 
   // used for schema mapping (unchanged after init)
   int vlabel_num_;
@@ -169,18 +267,39 @@ class TxnLogParser {
       edge_label_columns_;  // edge_label name -> (src column name, dst column
                             // name)
   std::vector<std::pair<int, int>> edge_label2src_dst_labels_;
+  // all the columns used by any label, other columns are skipped when
+  // parsing TxnLogs
+  std::set<std::string> useful_columns_;
   gart::IdParser<int64_t> id_parser_;
 
-// used for log parsing
-#ifndef USE_FLAT_HASH_MAP
-  std::vector<std::map<std::string, int64_t>> string_oid2gid_maps_;
-  std::vector<std::map<int64_t, int64_t>> int64_oid2gid_maps_;
-#else
-  std::vector<absl::flat_hash_map<std::string, int64_t>> string_oid2gid_maps_;
-  std::vector<absl::flat_hash_map<int64_t, int64_t>> int64_oid2gid_maps_;
-#endif
-  std::vector<uint64_t> vertex_nums_;
-  std::vector<std::vector<uint64_t>> vertex_nums_per_fragment_;
+  // used for log parsing, shared by the step-1 workers
+  std::mutex unused_tables_mutex_;
+
+  std::vector<ShardedOidMap<std::string>> string_oid2gid_maps_;
+  std::vector<ShardedOidMap<int64_t>> int64_oid2gid_maps_;
+
+  // the seq of the next TxnLog to reserve its gids, and of the next one to
+  // update the stats after its lookups
+  std::atomic<int64_t> reserved_seq_{0};
+  std::atomic<int64_t> resolved_seq_{0};
+
+  // used in the reserve turn, in the order of logs
+  std::unique_ptr<Partitioner> partitioner_;
+  // indexed by vlabel * subgraph_num_ + fid
+  std::vector<uint64_t> vertex_nums_per_fragment_;
+  int64_t txn_log_num_ = 0;
+  // the TxnLogs before it are in the loaded checkpoint
+  int64_t checkpoint_txn_log_num_ = 0;
+
+  // the partitioner updates its stats in the reserve turn, and the stats of
+  // deleted vertices and edges are updated in the resolve turn
+  mutable std::mutex stats_mutex_;
+
+#ifdef ENABLE_CHECKPOINT
+  std::atomic<bool> checkpoint_requested_{false};
+  std::atomic<int64_t> checkpoint_seq_{-1};
+  std::string checkpoint_data_;
+#endif  // ENABLE_CHECKPOINT
 };
 
 }  // namespace converter
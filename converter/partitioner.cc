@@ -0,0 +1,269 @@
+/** Copyright 2020-2023 Alibaba Group Holding Limited.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "converter/partitioner.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "vegito/include/fragment/id_parser.h"
+
+using std::string;
+
+namespace converter {
+
+PartitionStats::PartitionStats(int subgraph_num, bool track_outer_vertices)
+    : subgraph_num_(subgraph_num),
+      vertex_nums_(subgraph_num, 0),
+      edge_nums_(subgraph_num, 0),
+      track_outer_vertices_(track_outer_vertices) {
+  if (track_outer_vertices_) {
+    outer_vertices_.resize(subgraph_num_);
+  }
+}
+
+void PartitionStats::add_edge(int src_fid, int64_t src_gid, int dst_fid,
+                              int64_t dst_gid) {
+  edge_nums_[src_fid]++;
+  if (src_fid == dst_fid) {
+    return;
+  }
+  edge_nums_[dst_fid]++;
+  if (track_outer_vertices_) {
+    outer_vertices_[src_fid].insert(dst_gid);
+    outer_vertices_[dst_fid].insert(src_gid);
+  }
+}
+
+void PartitionStats::delete_edge(int src_fid, int dst_fid) {
+  edge_nums_[src_fid]--;
+  if (src_fid != dst_fid) {
+    edge_nums_[dst_fid]--;
+  }
+}
+
+string PartitionStats::to_string() const {
+  std::stringstream ss;
+  int64_t total_edges = 0, max_edges = 0;
+  for (int fid = 0; fid < subgraph_num_; fid++) {
+    ss << "fid " << fid << ": " << vertex_num(fid) << " vertices, "
+       << edge_num(fid) << " edges";
+    if (track_outer_vertices_) {
+      ss << ", " << outer_vertex_num(fid) << " outer vertices";
+    }
+    ss << "; ";
+    total_edges += edge_num(fid);
+    max_edges = std::max(max_edges, edge_num(fid));
+  }
+  // the slowest fragment bounds a multi-subgraph deployment
+  if (total_edges > 0) {
+    ss << "edge imbalance (max / avg): "
+       << static_cast<double>(max_edges) * subgraph_num_ / total_edges;
+  }
+  return ss.str();
+}
+
+// vertex and edge numbers, then the size and the gids of each set of outer
+// vertices
+void PartitionStats::get_state(std::vector<int64_t>& state) const {
+  state.insert(state.end(), vertex_nums_.begin(), vertex_nums_.end());
+  state.insert(state.end(), edge_nums_.begin(), edge_nums_.end());
+  for (const auto& outer_vertices : outer_vertices_) {
+    state.push_back(outer_vertices.size());
+    state.insert(state.end(), outer_vertices.begin(), outer_vertices.end());
+  }
+}
+
+const int64_t* PartitionStats::set_state(const int64_t* begin,
+                                         const int64_t* end) {
+  if (end - begin < 2 * subgraph_num_) {
+    return nullptr;
+  }
+  vertex_nums_.assign(begin, begin + subgraph_num_);
+  begin += subgraph_num_;
+  edge_nums_.assign(begin, begin + subgraph_num_);
+  begin += subgraph_num_;
+  for (auto& outer_vertices : outer_vertices_) {
+    if (begin == end || *begin < 0 || end - begin - 1 < *begin) {
+      return nullptr;
+    }
+    int64_t size = *begin++;
+    outer_vertices.clear();
+    outer_vertices.insert(begin, begin + size);
+    begin += size;
+  }
+  return begin;
+}
+
+std::vector<int64_t> Partitioner::get_state() const {
+  std::vector<int64_t> state;
+  stats_.get_state(state);
+  get_choice_state(state);
+  return state;
+}
+
+bool Partitioner::set_state(const std::vector<int64_t>& state) {
+  const int64_t* end = state.data() + state.size();
+  const int64_t* choice_state = stats_.set_state(state.data(), end);
+  return choice_state != nullptr && set_choice_state(choice_state, end);
+}
+
+namespace {
+
+class RoundRobinPartitioner : public Partitioner {
+ public:
+  RoundRobinPartitioner(int subgraph_num, bool track_outer_vertices)
+      : Partitioner(subgraph_num, track_outer_vertices),
+        vertex_nums_(gart::MAX_VLABELS, 0) {}
+
+ protected:
+  int choose(int vlabel, const string& external_id,
+             bool is_string_oid) override {
+    return vertex_nums_[vlabel]++ % subgraph_num_;
+  }
+
+  void get_choice_state(std::vector<int64_t>& state) const override {
+    state.insert(state.end(), vertex_nums_.begin(), vertex_nums_.end());
+  }
+
+  bool set_choice_state(const int64_t* begin, const int64_t* end) override {
+    if (end - begin != gart::MAX_VLABELS) {
+      return false;
+    }
+    vertex_nums_.assign(begin, end);
+    return true;
+  }
+
+ private:
+  std::vector<int64_t> vertex_nums_;
+};
+
+class HashPartitioner : public Partitioner {
+ public:
+  using Partitioner::Partitioner;
+
+ protected:
+  // FNV-1a rather than std::hash, which may change with the toolchain, so
+  // checkpoints are replayed to the same fragments after an upgrade
+  int choose(int vlabel, const string& external_id,
+             bool is_string_oid) override {
+    uint64_t hash = 14695981039346656037ul;
+    for (char c : external_id) {
+      hash = (hash ^ static_cast<uint8_t>(c)) * 1099511628211ul;
+    }
+    return hash % subgraph_num_;
+  }
+};
+
+class RangePartitioner : public HashPartitioner {
+ public:
+  RangePartitioner(int subgraph_num, int64_t range_size,
+                   bool track_outer_vertices)
+      : HashPartitioner(subgraph_num, track_outer_vertices),
+        range_size_(range_size) {}
+
+ protected:
+  int choose(int vlabel, const string& external_id,
+             bool is_string_oid) override {
+    if (is_string_oid) {
+      return HashPartitioner::choose(vlabel, external_id, is_string_oid);
+    }
+    int64_t oid = std::stoll(external_id);
+    if (oid < 0) {
+      return HashPartitioner::choose(vlabel, external_id, is_string_oid);
+    }
+    return std::min<int64_t>(oid / range_size_, subgraph_num_ - 1);
+  }
+
+ private:
+  int64_t range_size_;
+};
+
+/**
+ * The balance term of Fennel, with the load of a fragment measured by its
+ * vertices and edges, so fragments holding high-degree vertices receive
+ * fewer new vertices. Fennel's neighbor term is left out: a vertex is logged
+ * before any of its edges, so no neighbor is known when it is placed.
+ */
+class GreedyPartitioner : public Partitioner {
+ public:
+  using Partitioner::Partitioner;
+
+  bool uses_stats() const override { return true; }
+
+ protected:
+  int choose(int vlabel, const string& external_id,
+             bool is_string_oid) override {
+    // start from a rotating fragment to spread ties
+    int start = next_++ % subgraph_num_;
+    int best_fid = start;
+    int64_t best_load = load(start);
+    for (int idx = 1; idx < subgraph_num_; idx++) {
+      int fid = (start + idx) % subgraph_num_;
+      int64_t fid_load = load(fid);
+      if (fid_load < best_load) {
+        best_fid = fid;
+        best_load = fid_load;
+      }
+    }
+    return best_fid;
+  }
+
+  void get_choice_state(std::vector<int64_t>& state) const override {
+    state.push_back(next_);
+  }
+
+  bool set_choice_state(const int64_t* begin, const int64_t* end) override {
+    if (end - begin != 1) {
+      return false;
+    }
+    next_ = *begin;
+    return true;
+  }
+
+ private:
+  int64_t load(int fid) const {
+    return stats_.vertex_num(fid) + stats_.edge_num(fid);
+  }
+
+  int64_t next_ = 0;
+};
+
+}  // namespace
+
+std::unique_ptr<Partitioner> Partitioner::create(const string& type,
+                                                 int subgraph_num,
+                                                 int64_t range_size,
+                                                 bool track_outer_vertices) {
+  if (type == "round_robin") {
+    return std::unique_ptr<Partitioner>(
+        new RoundRobinPartitioner(subgraph_num, track_outer_vertices));
+  } else if (type == "hash") {
+    return std::unique_ptr<Partitioner>(
+        new HashPartitioner(subgraph_num, track_outer_vertices));
+  } else if (type == "range" && range_size > 0) {
+    return std::unique_ptr<Partitioner>(
+        new RangePartitioner(subgraph_num, range_size, track_outer_vertices));
+  } else if (type == "greedy") {
+    return std::unique_ptr<Partitioner>(
+        new GreedyPartitioner(subgraph_num, track_outer_vertices));
+  }
+  return nullptr;
+}
+
+}  // namespace converter
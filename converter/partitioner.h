@@ -0,0 +1,135 @@
+/** Copyright 2020-2023 Alibaba Group Holding Limited.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CONVERTER_PARTITIONER_H_
+#define CONVERTER_PARTITIONER_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace converter {
+
+/**
+ * Per-fragment counters used to compare partitioners. An edge is counted in
+ * the fragments of both of its endpoints, as both of them store it, and the
+ * other endpoint is an outer vertex of the fragment.
+ */
+class PartitionStats {
+ public:
+  PartitionStats(int subgraph_num, bool track_outer_vertices);
+
+  // called in the order of logs, see TxnLogParser::assign_gids
+  void add_vertex(int fid) { vertex_nums_[fid]++; }
+
+  void delete_vertex(int fid) { vertex_nums_[fid]--; }
+
+  void add_edge(int src_fid, int64_t src_gid, int dst_fid, int64_t dst_gid);
+
+  void delete_edge(int src_fid, int dst_fid);
+
+  int64_t vertex_num(int fid) const { return vertex_nums_[fid]; }
+
+  int64_t edge_num(int fid) const { return edge_nums_[fid]; }
+
+  // 0 if outer vertices are not tracked, and not decreased by deletions
+  int64_t outer_vertex_num(int fid) const {
+    return track_outer_vertices_ ? outer_vertices_[fid].size() : 0;
+  }
+
+  std::string to_string() const;
+
+  // for checkpoints, see Partitioner::get_state
+  void get_state(std::vector<int64_t>& state) const;
+
+  // return the end of the stats in state, nullptr if they are malformed
+  const int64_t* set_state(const int64_t* begin, const int64_t* end);
+
+ private:
+  int subgraph_num_;
+  std::vector<int64_t> vertex_nums_;
+  std::vector<int64_t> edge_nums_;
+  bool track_outer_vertices_;
+  std::vector<std::unordered_set<int64_t>> outer_vertices_;
+};
+
+/**
+ * Choose the fragment (subgraph) of each inserted vertex.
+ *
+ * Supported types:
+ *   round_robin: by the arrival order of the vertices of each label
+ *   hash:        by the hash of the external id
+ *   range:       by ranges of partition_range_size integer external ids,
+ *                the last fragment takes the rest (string ids are hashed)
+ *   greedy:      to the least loaded fragment, by vertices plus edges seen so
+ *                far (streaming greedy)
+ */
+class Partitioner {
+ public:
+  Partitioner(int subgraph_num, bool track_outer_vertices)
+      : subgraph_num_(subgraph_num),
+        stats_(subgraph_num, track_outer_vertices) {}
+
+  virtual ~Partitioner() = default;
+
+  // nullptr if the type is unknown
+  static std::unique_ptr<Partitioner> create(const std::string& type,
+                                             int subgraph_num,
+                                             int64_t range_size,
+                                             bool track_outer_vertices);
+
+  // called in the order of logs (by TxnLogParser::assign_gids), so the fid
+  // only depends on the vertices and edges logged before
+  int assign(int vlabel, const std::string& external_id, bool is_string_oid) {
+    int fid = choose(vlabel, external_id, is_string_oid);
+    stats_.add_vertex(fid);
+    return fid;
+  }
+
+  // whether choose() reads the stats, which then must include the edges of
+  // all the earlier logs
+  virtual bool uses_stats() const { return false; }
+
+  PartitionStats& stats() { return stats_; }
+
+  const PartitionStats& stats() const { return stats_; }
+
+  // the state of the partitioner and its stats, saved by checkpoints so that
+  // the logs after a checkpoint are assigned as before the restart
+  std::vector<int64_t> get_state() const;
+
+  // return false if the state is malformed or of another partitioner
+  bool set_state(const std::vector<int64_t>& state);
+
+ protected:
+  virtual int choose(int vlabel, const std::string& external_id,
+                     bool is_string_oid) = 0;
+
+  // the state used by choose() besides the stats
+  virtual void get_choice_state(std::vector<int64_t>& state) const {}
+
+  virtual bool set_choice_state(const int64_t* begin, const int64_t* end) {
+    return begin == end;
+  }
+
+  int subgraph_num_;
+  PartitionStats stats_;
+};
+
+}  // namespace converter
+
+#endif  // CONVERTER_PARTITIONER_H_
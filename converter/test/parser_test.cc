@@ -0,0 +1,218 @@
+/** Copyright 2020-2023 Alibaba Group Holding Limited.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// The unified logs emitted by the converter (and so the gids and fids of the
+// vertices) must only depend on the order of the TxnLogs, not on how the
+// step-1 workers interleave, and must be the same when the logs are replayed
+// after a checkpoint is loaded.
+
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+
+#include "converter/flags.h"
+#include "converter/parser.h"
+
+using converter::LogEntry;
+using converter::Partitioner;
+using converter::TxnLogParser;
+
+namespace {
+
+constexpr int kSubgraphNum = 4;
+constexpr int kVertexNum = 64;
+constexpr int kWorkerNum = 4;
+
+const char kRGMapping[] = R"(
+vertexMappings:
+  vertex_types:
+  - type_name: person
+    dataSourceName: person
+    idFieldName: id
+    mappings:
+    - property: name
+      dataField:
+        name: name
+edgeMappings:
+  edge_types:
+  - type_pair:
+      edge: knows
+      source_vertex: person
+      destination_vertex: person
+    dataSourceName: knows
+    sourceVertexMappings:
+    - dataField:
+        name: src
+    destinationVertexMappings:
+    - dataField:
+        name: dst
+    dataFieldMappings:
+    - dataField:
+        name: weight
+)";
+
+std::string vertex_log(const std::string& type, int id) {
+  return "{\"table\": \"person\", \"type\": \"" + type +
+         "\", \"data\": {\"id\": " + std::to_string(id) + ", \"name\": \"p" +
+         std::to_string(id) + "\"}}";
+}
+
+std::string edge_log(int src, int dst) {
+  return "{\"table\": \"knows\", \"type\": \"insert\", \"data\": {\"src\": " +
+         std::to_string(src) + ", \"dst\": " + std::to_string(dst) +
+         ", \"weight\": 0.5}}";
+}
+
+// inserts, a power-law-ish set of edges, and vertices deleted and inserted
+// again (they get new gids)
+std::vector<std::string> make_txn_logs() {
+  std::vector<std::string> logs;
+  for (int v = 0; v < kVertexNum; v++) {
+    logs.push_back(vertex_log("insert", v));
+    for (int u = 0; u < v; u += 1 + u) {
+      logs.push_back(edge_log(v, u));
+    }
+  }
+  for (int v = 0; v < kVertexNum; v += 8) {
+    logs.push_back(vertex_log("delete", v));
+    logs.push_back(vertex_log("insert", v));
+    logs.push_back(edge_log(v + 1, v));
+  }
+  return logs;
+}
+
+std::unique_ptr<TxnLogParser> make_parser(const std::string& partitioner) {
+  return std::make_unique<TxnLogParser>(
+      kRGMapping, kSubgraphNum,
+      Partitioner::create(partitioner, kSubgraphNum, 16, false));
+}
+
+// what the step-1 workers do: parse and assign_gids the logs in [begin,
+// end), each worker on every worker_num-th log, as the lines are handed to
+// the workers in turn
+void run_workers(TxnLogParser& parser, const std::vector<std::string>& logs,
+                 std::vector<std::vector<LogEntry>>& entries, size_t begin,
+                 size_t end, int worker_num) {
+  std::vector<std::thread> workers;
+  for (int w = 0; w < worker_num; w++) {
+    workers.emplace_back([&, w]() {
+      // random pauses, so workers are not in step
+      std::minstd_rand rand(w);
+      for (size_t idx = begin + w; idx < end; idx += worker_num) {
+        GART_CHECK_OK(parser.parse(entries[idx], logs[idx]));
+        for (unsigned pause = rand() % 4; pause > 0; pause--) {
+          std::this_thread::yield();
+        }
+        parser.assign_gids(entries[idx], idx, true);
+      }
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+}
+
+// what step 2 does: emit the complete entries in the order of logs, from
+// log begin
+std::vector<std::string> emit(std::vector<std::vector<LogEntry>>& entries,
+                              size_t begin = 0) {
+  std::vector<std::string> unified_logs;
+  for (size_t idx = begin; idx < entries.size(); idx++) {
+    for (LogEntry& entry : entries[idx]) {
+      CHECK(entry.complete()) << "log " << idx;
+      entry.set_epoch(0);
+      unified_logs.push_back(entry.to_string(idx));
+    }
+  }
+  return unified_logs;
+}
+
+void test_deterministic(const std::string& partitioner) {
+  auto logs = make_txn_logs();
+
+  auto sequential_parser = make_parser(partitioner);
+  std::vector<std::vector<LogEntry>> entries(logs.size());
+  run_workers(*sequential_parser, logs, entries, 0, logs.size(), 1);
+  auto expected = emit(entries);
+
+  for (int round = 0; round < 4; round++) {
+    auto parser = make_parser(partitioner);
+    std::vector<std::vector<LogEntry>> parallel_entries(logs.size());
+    run_workers(*parser, logs, parallel_entries, 0, logs.size(), kWorkerNum);
+    CHECK(emit(parallel_entries) == expected)
+        << partitioner << " partitioner, round " << round;
+  }
+}
+
+// the fids of the hash partitioner must not depend on the toolchain, as
+// checkpoints are replayed after upgrades
+void test_stable_hash() {
+  auto partitioner = Partitioner::create("hash", 7, 16, false);
+  CHECK_EQ(partitioner->assign(0, "0", false), 4);
+  CHECK_EQ(partitioner->assign(0, "42", false), 5);
+  CHECK_EQ(partitioner->assign(0, "alice", true), 1);
+  CHECK_EQ(partitioner->assign(0, "1000000", false), 4);
+}
+
+#ifdef ENABLE_CHECKPOINT
+void test_checkpoint(const std::string& partitioner,
+                     const std::string& folder) {
+  auto logs = make_txn_logs();
+  size_t half = logs.size() / 2;
+
+  auto parser = make_parser(partitioner);
+  std::vector<std::vector<LogEntry>> entries(logs.size());
+  run_workers(*parser, logs, entries, 0, half, kWorkerNum);
+  parser->request_checkpoint();
+  run_workers(*parser, logs, entries, half, logs.size(), kWorkerNum);
+  CHECK_EQ(parser->pending_checkpoint_seq(), static_cast<int64_t>(half));
+  parser->write_checkpoint(folder);
+  CHECK_EQ(parser->pending_checkpoint_seq(), -1);
+  auto expected = emit(entries, half);
+
+  auto restarted = make_parser(partitioner);
+  CHECK_EQ(restarted->load_checkpoint(folder), static_cast<int64_t>(half));
+  std::vector<std::vector<LogEntry>> replayed(logs.size());
+  run_workers(*restarted, logs, replayed, 0, logs.size(), kWorkerNum);
+  for (size_t idx = 0; idx < half; idx++) {
+    for (const LogEntry& entry : replayed[idx]) {
+      CHECK(!entry.complete()) << "log " << idx << " is emitted again";
+    }
+  }
+  CHECK(emit(replayed, half) == expected) << partitioner << " partitioner";
+}
+#endif  // ENABLE_CHECKPOINT
+
+}  // anonymous namespace
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+
+  test_stable_hash();
+  for (const char* partitioner : {"round_robin", "hash", "range", "greedy"}) {
+    test_deterministic(partitioner);
+#ifdef ENABLE_CHECKPOINT
+    test_checkpoint(partitioner, FLAGS_checkpoint_dir);
+#endif  // ENABLE_CHECKPOINT
+  }
+
+  LOG(INFO) << "parser_test passed";
+  return 0;
+}
@@ -19,16 +19,26 @@
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
 
 #include "grape/fragment/fragment_base.h"
 #include "vineyard/basic/ds/hashmap_mvcc.h"
 
+#include "fragment/dest_fid_list.h"
 #include "fragment/id_parser.h"
 #include "interfaces/fragment/iterator.h"
 #include "interfaces/fragment/property_util.h"
 #include "types.h"
 #include "util/bitset.h"
+#include "util/property_index.h"
+#include "util/string_chunks.h"
 
 namespace gart {
 
@@ -50,6 +60,9 @@ class GartFragment {
   using dir_t = seggraph::dir_t;
   using hashmap_t = vineyard::HashmapMVCC<int64_t, int64_t>;
 
+  static_assert(std::is_same<fid_t, DestFidList::fid_t>::value,
+                "DestFidList must hold grape::fid_t");
+
   static constexpr grape::LoadStrategy load_strategy =
       grape::LoadStrategy::kBothOutIn;
 
@@ -59,21 +72,51 @@ class GartFragment {
   ~GartFragment() = default;
 
  public:
-  void Init(json& config, json& edge_config) {
+  // prev is an optional fragment of an earlier epoch, whose connection to
+  // vineyard and blobs are reused, so only blobs created since are fetched
+  void Init(json& config, json& edge_config,
+            const GartFragment* prev = nullptr) {
     ipc_socket_ = config["ipc_socket"].get<std::string>();
-    VINEYARD_CHECK_OK(client_.Connect(ipc_socket_));
-    LOG(INFO) << "Connected to IPCServer: " << ipc_socket_;
+    if (prev != nullptr && prev->ipc_socket_ == ipc_socket_) {
+      client_ = prev->client_;
+      prev_blobs_ = &prev->blobs_;
+    } else {
+      client_ = std::make_shared<vineyard::Client>();
+      VINEYARD_CHECK_OK(client_->Connect(ipc_socket_));
+      LOG(INFO) << "Connected to IPCServer: " << ipc_socket_;
+    }
 
     fnum_ = config["fnum"].get<fid_t>();
     fid_ = config["fid"].get<fid_t>();
     vertex_label_num_ = config["vertex_label_num"].get<int>();
     read_epoch_number_ = config["epoch"].get<size_t>();
-    auto string_buffer_object_id =
-        config["string_buffer_object_id"].get<uint64_t>();
-    std::shared_ptr<vineyard::Blob> string_buffer_blob;
-    VINEYARD_CHECK_OK(
-        client_.GetBlob(string_buffer_object_id, true, string_buffer_blob));
-    string_buffer_ = (char*) string_buffer_blob->data();
+    // the chunks of the string heap existing at the epoch
+    std::vector<uint64_t> string_buffer_object_ids;
+    if (config.contains("string_buffer_object_ids")) {
+      string_buffer_object_ids =
+          config["string_buffer_object_ids"].get<std::vector<uint64_t>>();
+      string_chunks_.set_chunk_bits(
+          config["string_buffer_chunk_bits"].get<int>());
+    } else {
+      string_buffer_object_ids.push_back(
+          config["string_buffer_object_id"].get<uint64_t>());
+    }
+    // a blob of a large value takes consecutive chunks, and chunks of freed
+    // large values (object id 0) are not read any more
+    uint64_t chunk_size = 1ul << string_chunks_.get_chunk_bits();
+    char* prev_chunk = nullptr;
+    for (size_t idx = 0; idx < string_buffer_object_ids.size(); idx++) {
+      auto string_buffer_object_id = string_buffer_object_ids[idx];
+      if (string_buffer_object_id == 0) {
+        prev_chunk = nullptr;
+      } else if (idx > 0 &&
+                 string_buffer_object_id == string_buffer_object_ids[idx - 1]) {
+        prev_chunk += chunk_size;
+      } else {
+        prev_chunk = (char*) get_blob_(string_buffer_object_id)->data();
+      }
+      string_chunks_.add_chunk(prev_chunk);
+    }
 
     vertex_tables_.resize(vertex_label_num_, nullptr);
     ovl2g_.resize(vertex_label_num_);
@@ -83,13 +126,15 @@ class GartFragment {
     inner_offsets_.resize(vertex_label_num_, -1);
     outer_offsets_.resize(vertex_label_num_, -1);
     max_inner_offsets_.resize(vertex_label_num_, -1);
+    inner_delete_nums_.resize(vertex_label_num_, 0);
+    outer_delete_nums_.resize(vertex_label_num_, 0);
     vertex_table_lens_.resize(vertex_label_num_);
     ivnums_.resize(vertex_label_num_);
     ovnums_.resize(vertex_label_num_);
     tvnums_.resize(vertex_label_num_);
 
-    inner_edge_blob_ptrs_.resize(vertex_label_num_, nullptr);
-    outer_edge_blob_ptrs_.resize(vertex_label_num_, nullptr);
+    inner_block_arenas_.resize(vertex_label_num_);
+    outer_block_arenas_.resize(vertex_label_num_);
     inner_edge_label_ptrs_.resize(vertex_label_num_, nullptr);
     outer_edge_label_ptrs_.resize(vertex_label_num_, nullptr);
 
@@ -100,9 +145,11 @@ class GartFragment {
     idoffset_.resize(vertex_label_num_);
     odoffset_.resize(vertex_label_num_);
     iodoffset_.resize(vertex_label_num_);
+    dest_fid_lists_.resize(vertex_label_num_);
 
     prop_cols_meta.resize(vertex_label_num_);
     vertex_prop_blob_ptrs_.resize(vertex_label_num_);
+    vertex_prop_indexes_.resize(vertex_label_num_);
     vertex_prop_column_family_id_.resize(vertex_label_num_);
     vertex_prop_column_family_offset_.resize(vertex_label_num_);
     vertex_prop_num_per_column_family_.resize(vertex_label_num_);
@@ -175,7 +222,9 @@ class GartFragment {
           } else if (dtype == "CHAR") {
             column_family_data_length_[v_label_id][column_family_id] +=
                 sizeof(char);
-          } else if (dtype == "STRING") {
+          } else if (dtype == "STRING" || dtype == "BYTES" ||
+                     dtype.find("_LIST") != std::string::npos) {
+            // the key of the value in the string heap
             column_family_data_length_[v_label_id][column_family_id] +=
                 sizeof(uint64_t);
           } else if (dtype == "DATE") {
@@ -240,6 +289,24 @@ class GartFragment {
         } else if (dtype == "STRING") {
           edge_prop_offset.push_back(accum_offset + sizeof(uint64_t));
           edge_prop_dtype.push_back(STRING);
+        } else if (dtype == "BYTES") {
+          edge_prop_offset.push_back(accum_offset + sizeof(uint64_t));
+          edge_prop_dtype.push_back(BYTES);
+        } else if (dtype == "INT_LIST") {
+          edge_prop_offset.push_back(accum_offset + sizeof(uint64_t));
+          edge_prop_dtype.push_back(INT_LIST);
+        } else if (dtype == "LONG_LIST") {
+          edge_prop_offset.push_back(accum_offset + sizeof(uint64_t));
+          edge_prop_dtype.push_back(LONG_LIST);
+        } else if (dtype == "FLOAT_LIST") {
+          edge_prop_offset.push_back(accum_offset + sizeof(uint64_t));
+          edge_prop_dtype.push_back(FLOAT_LIST);
+        } else if (dtype == "DOUBLE_LIST") {
+          edge_prop_offset.push_back(accum_offset + sizeof(uint64_t));
+          edge_prop_dtype.push_back(DOUBLE_LIST);
+        } else if (dtype == "STRING_LIST") {
+          edge_prop_offset.push_back(accum_offset + sizeof(uint64_t));
+          edge_prop_dtype.push_back(STRING_LIST);
         } else if (dtype == "DATE") {
           edge_prop_offset.push_back(accum_offset + sizeof(gart::Date));
           edge_prop_dtype.push_back(DATE);
@@ -277,14 +344,26 @@ class GartFragment {
     }
 
     auto blob_info = config["blob"];
+    // vertex and edge numbers published by the writer, or counted on demand
+    // (see computeVertexNum and computeEdgeNum) for older schemas
+    vertex_mata_known_ =
+        blob_info.size() == static_cast<size_t>(vertex_label_num_);
+    // and the destination fid lists, or built by initDestFidList
+    dest_fid_lists_known_ = vertex_mata_known_;
     for (size_t i = 0; i < blob_info.size(); i++) {
       int vlabel = blob_info[i]["vlabel"].get<int>();
+      if (blob_info[i].contains("inner_vertex_num")) {
+        ivnums_[vlabel] = blob_info[i]["inner_vertex_num"].get<size_t>();
+        ovnums_[vlabel] = blob_info[i]["outer_vertex_num"].get<size_t>();
+        tvnums_[vlabel] = ivnums_[vlabel] + ovnums_[vlabel];
+      } else {
+        vertex_mata_known_ = false;
+      }
       // init vertex table
       uint64_t vertex_table_obj_id =
           blob_info[i]["vertex_table"]["object_id"].get<uint64_t>();
-      std::shared_ptr<vineyard::Blob> vertex_table_blob;
-      VINEYARD_CHECK_OK(
-          client_.GetBlob(vertex_table_obj_id, true, vertex_table_blob));
+      std::shared_ptr<vineyard::Blob> vertex_table_blob =
+          get_blob_(vertex_table_obj_id);
       vertex_tables_[vlabel] = (vid_t*) vertex_table_blob->data();
 
       inner_offsets_[vlabel] =
@@ -296,6 +375,12 @@ class GartFragment {
           blob_info[i]["vertex_table"]["min_outer_location"].get<int64_t>();
       min_outer_offsets_[vlabel] =
           blob_info[i]["vertex_table"]["min_outer"].get<int64_t>();
+      // each delete marker takes a slot but is not counted in max_inner or
+      // min_outer
+      inner_delete_nums_[vlabel] =
+          inner_offsets_[vlabel] - max_inner_offsets_[vlabel];
+      outer_delete_nums_[vlabel] =
+          min_outer_offsets_[vlabel] - outer_offsets_[vlabel];
       min_outer_offsets_[vlabel] =
           max_outer_id_offset_ + 1 -
           (blob_info[i]["vertex_table"]["max"].get<int64_t>() -
@@ -305,27 +390,21 @@ class GartFragment {
           vertex_table_blob->allocated_size() / sizeof(vid_t);
 
       auto ovg2l_blob_id = blob_info[i]["ovg2l_blob"].get<uint64_t>();
-      std::shared_ptr<vineyard::Blob> ovg2l_blob;
-      VINEYARD_CHECK_OK(client_.GetBlob(ovg2l_blob_id, true, ovg2l_blob));
       std::shared_ptr<const hashmap_t> hmapview;
-      VINEYARD_CHECK_OK(hashmap_t::View(client_, ovg2l_blob, hmapview));
+      VINEYARD_CHECK_OK(
+          hashmap_t::View(*client_, get_blob_(ovg2l_blob_id), hmapview));
       ovg2l_maps_[vlabel] = hmapview;
 
       auto vertex_map_blob_id = blob_info[i]["vertex_map_oid"].get<uint64_t>();
-      std::shared_ptr<vineyard::Blob> vertex_map_blob;
-      VINEYARD_CHECK_OK(
-          client_.GetBlob(vertex_map_blob_id, true, vertex_map_blob));
       std::shared_ptr<const hashmap_t> vertex_map_hmapview;
-      VINEYARD_CHECK_OK(
-          hashmap_t::View(client_, vertex_map_blob, vertex_map_hmapview));
+      VINEYARD_CHECK_OK(hashmap_t::View(
+          *client_, get_blob_(vertex_map_blob_id), vertex_map_hmapview));
       vertex_maps_[vlabel] = vertex_map_hmapview;
 
       // init ovl2g
       uint64_t ovl2g_obj_id =
           blob_info[i]["ovl2g"]["object_id"].get<uint64_t>();
-      std::shared_ptr<vineyard::Blob> ovl2g_blob;
-      VINEYARD_CHECK_OK(client_.GetBlob(ovl2g_obj_id, true, ovl2g_blob));
-      ovl2g_[vlabel] = (vid_t*) ovl2g_blob->data();
+      ovl2g_[vlabel] = (vid_t*) get_blob_(ovl2g_obj_id)->data();
 
       valid_ovl2g_element_[vlabel] =
           blob_info[i]["ovl2g"]["len_ele"].get<uint64_t>();
@@ -333,33 +412,22 @@ class GartFragment {
       // init edge blobs
       uint64_t inner_edge_label_obj_id =
           blob_info[i]["elabel2seg"]["object_id"].get<uint64_t>();
-      std::shared_ptr<vineyard::Blob> inner_edge_label_blob;
-      VINEYARD_CHECK_OK(client_.GetBlob(inner_edge_label_obj_id, true,
-                                        inner_edge_label_blob));
       inner_edge_label_ptrs_[vlabel] =
-          (uint64_t*) inner_edge_label_blob->data();
+          (uint64_t*) get_blob_(inner_edge_label_obj_id)->data();
 
       uint64_t outer_edge_label_obj_id =
           blob_info[i]["ov_elabel2seg"]["object_id"].get<uint64_t>();
-      std::shared_ptr<vineyard::Blob> outer_edge_label_blob;
-      VINEYARD_CHECK_OK(client_.GetBlob(outer_edge_label_obj_id, true,
-                                        outer_edge_label_blob));
       outer_edge_label_ptrs_[vlabel] =
-          (uint64_t*) outer_edge_label_blob->data();
+          (uint64_t*) get_blob_(outer_edge_label_obj_id)->data();
 
-      uint64_t inner_edge_blob_obj_id =
-          blob_info[i]["block_oid"].get<uint64_t>();
-      std::shared_ptr<vineyard::Blob> inner_edge_blob;
-      VINEYARD_CHECK_OK(
-          client_.GetBlob(inner_edge_blob_obj_id, true, inner_edge_blob));
-      inner_edge_blob_ptrs_[vlabel] = (char*) inner_edge_blob->data();
-
-      uint64_t outer_edge_blob_obj_id =
-          blob_info[i]["ov_block_oid"].get<uint64_t>();
-      std::shared_ptr<vineyard::Blob> outer_edge_blob;
-      VINEYARD_CHECK_OK(
-          client_.GetBlob(outer_edge_blob_obj_id, true, outer_edge_blob));
-      outer_edge_blob_ptrs_[vlabel] = (char*) outer_edge_blob->data();
+      load_block_arenas_(
+          blob_info[i]["block_oids"].get<std::vector<uint64_t>>(),
+          blob_info[i]["block_arena_bits"].get<int>(),
+          inner_block_arenas_[vlabel]);
+      load_block_arenas_(
+          blob_info[i]["ov_block_oids"].get<std::vector<uint64_t>>(),
+          blob_info[i]["ov_block_arena_bits"].get<int>(),
+          outer_block_arenas_[vlabel]);
 
       // init I(O)EDst
       idst_[vlabel].resize(edge_label_num_);
@@ -370,6 +438,25 @@ class GartFragment {
       odoffset_[vlabel].resize(edge_label_num_);
       iodoffset_[vlabel].resize(edge_label_num_);
 
+      dest_fid_lists_[vlabel].resize(edge_label_num_);
+      if (blob_info[i].contains("dest_fid_lists")) {
+        for (auto& list_config : blob_info[i]["dest_fid_lists"]) {
+          auto e_label = list_config["elabel"].get<int>();
+          DestFidChunks& lists = dest_fid_lists_[vlabel][e_label];
+          lists.chunk_bits = list_config["chunk_bits"].get<int>();
+          // unchanged chunks are mapped by the previous fragment already
+          for (auto oid :
+               list_config["object_ids"].get<std::vector<uint64_t>>()) {
+            lists.chunks.push_back(
+                oid == 0 ? nullptr
+                         : reinterpret_cast<const DestFidList*>(
+                               get_blob_(oid)->data()));
+          }
+        }
+      } else {
+        dest_fid_lists_known_ = false;
+      }
+
       // init vertex property
       int vertex_prop_column_family_num = blob_info[i]["num_vprops"].get<int>();
       auto vertex_prop_config = blob_info[i]["vprops"];
@@ -378,18 +465,13 @@ class GartFragment {
 
       uint64_t vertex_external_id_oid =
           blob_info[i]["external_id_oid"].get<uint64_t>();
-      std::shared_ptr<vineyard::Blob> vertex_external_id_blob;
-      VINEYARD_CHECK_OK(client_.GetBlob(vertex_external_id_oid, true,
-                                        vertex_external_id_blob));
-      vertex_ext_id_ptrs_[vlabel] = (int64_t*) vertex_external_id_blob->data();
+      vertex_ext_id_ptrs_[vlabel] =
+          (int64_t*) get_blob_(vertex_external_id_oid)->data();
 
       uint64_t outer_vertex_external_id_oid =
           blob_info[i]["outer_external_id_oid"].get<uint64_t>();
-      std::shared_ptr<vineyard::Blob> outer_vertex_external_id_blob;
-      VINEYARD_CHECK_OK(client_.GetBlob(outer_vertex_external_id_oid, true,
-                                        outer_vertex_external_id_blob));
       outer_vertex_ext_id_ptrs_[vlabel] =
-          (int64_t*) outer_vertex_external_id_blob->data();
+          (int64_t*) get_blob_(outer_vertex_external_id_oid)->data();
 
       vertex_ext_id_dtypes_[vlabel] =
           blob_info[i]["external_id_dtype"].get<std::string>();
@@ -398,11 +480,8 @@ class GartFragment {
         auto prop_id = vertex_prop_config[idx]["prop_id"].get<int>();
         auto v_prop_obj_id =
             vertex_prop_config[idx]["object_id"].get<uint64_t>();
-        std::shared_ptr<vineyard::Blob> vertex_prop_blob;
-        VINEYARD_CHECK_OK(
-            client_.GetBlob(v_prop_obj_id, true, vertex_prop_blob));
         vertex_prop_blob_ptrs_[vlabel][prop_id] =
-            (char*) vertex_prop_blob->data();
+            (char*) get_blob_(v_prop_obj_id)->data();
         VertexPropMeta prop_meta;
         prop_meta.prop_id = prop_id;
         prop_meta.updatable = vertex_prop_config[idx]["updatable"].get<bool>();
@@ -410,6 +489,27 @@ class GartFragment {
         prop_meta.object_id = v_prop_obj_id;
         prop_cols_meta[vlabel][prop_id] = prop_meta;
       }
+
+      // secondary indexes of vertex properties
+      if (blob_info[i].contains("vprop_indexes")) {
+        for (auto& index_config : blob_info[i]["vprop_indexes"]) {
+          auto prop_id = index_config["prop_id"].get<int>();
+          auto reader = std::make_unique<PropertyIndexReader>();
+          if (reader->init(client_.get(),
+                           index_config["object_id"].get<uint64_t>())) {
+            vertex_prop_indexes_[vlabel][prop_id] = std::move(reader);
+          } else {
+            LOG(ERROR) << "Failed to load the index of property " << prop_id
+                       << " of vertex label " << vlabel;
+          }
+        }
+      }
+    }
+    prev_blobs_ = nullptr;
+    if (config.contains("edge_nums") &&
+        config["edge_nums"].size() == static_cast<size_t>(edge_label_num_)) {
+      tenums_ = config["edge_nums"].get<std::vector<size_t>>();
+      edge_mata_known_ = true;
     }
 #ifdef USE_INTERNAL_ID
     vertex_internal_id_null_bitmap_.resize(vertex_label_num_);
@@ -507,9 +607,12 @@ class GartFragment {
     std::vector<bool> high_to_low_vec;
     high_to_low_vec.push_back(true);
     high_to_low_vec.push_back(false);
+    std::vector<int64_t> delete_num_vec;
+    delete_num_vec.push_back(inner_delete_nums_[label_id]);
+    delete_num_vec.push_back(outer_delete_nums_[label_id]);
 
     return gart::VertexIterator(addr_vec, high_to_low_vec, table_addr,
-                                label_id);
+                                label_id, delete_num_vec);
   }
 
   gart::VertexIterator InnerVertices(label_id_t label_id) const {
@@ -526,8 +629,10 @@ class GartFragment {
     addr_vec.push_back(addr);
     std::vector<bool> high_to_low_vec;
     high_to_low_vec.push_back(true);
+    std::vector<int64_t> delete_num_vec;
+    delete_num_vec.push_back(inner_delete_nums_[label_id]);
     return gart::VertexIterator(addr_vec, high_to_low_vec, table_addr,
-                                label_id);
+                                label_id, delete_num_vec);
   }
 
   gart::VertexIterator OuterVertices(label_id_t label_id) const {
@@ -544,8 +649,10 @@ class GartFragment {
     addr_vec.push_back(addr);
     std::vector<bool> high_to_low_vec;
     high_to_low_vec.push_back(false);
+    std::vector<int64_t> delete_num_vec;
+    delete_num_vec.push_back(outer_delete_nums_[label_id]);
     return gart::VertexIterator(addr_vec, high_to_low_vec, table_addr,
-                                label_id);
+                                label_id, delete_num_vec);
   }
 
   inline size_t GetVerticesNum(label_id_t label_id) {
@@ -592,6 +699,41 @@ class GartFragment {
     return vid_parser.GetFid(gid);
   }
 
+  // bytes allocated by the fragment, excluding the blobs in vineyard
+  size_t GetMemoryUsage() const {
+    size_t bytes = sizeof(*this);
+    // nodes of the map, roughly
+    bytes += blobs_.size() * (sizeof(uint64_t) +
+                              sizeof(std::shared_ptr<vineyard::Blob>) +
+                              2 * sizeof(void*));
+    bytes += string_chunks_.get_chunk_num() * sizeof(char*);
+    for (int label = 0; label < vertex_label_num_; label++) {
+      bytes += (inner_block_arenas_[label].get_max_arena_num() +
+                outer_block_arenas_[label].get_max_arena_num()) *
+               sizeof(char*);
+      for (size_t e_label = 0; e_label < idst_[label].size(); e_label++) {
+        bytes += (idst_[label][e_label].capacity() +
+                  odst_[label][e_label].capacity() +
+                  iodst_[label][e_label].capacity()) *
+                     sizeof(fid_t) +
+                 (idoffset_[label][e_label].capacity() +
+                  odoffset_[label][e_label].capacity() +
+                  iodoffset_[label][e_label].capacity()) *
+                     sizeof(fid_t*);
+      }
+      {
+        std::lock_guard<std::mutex> lock(dense_ids_mutex_);
+        if (!dense_ids_.empty()) {
+          bytes += dense_ids_[label].capacity() * sizeof(vid_t);
+        }
+      }
+#ifdef USE_INTERNAL_ID
+      bytes += vertex_internal_id_null_bitmap_[label].capacity();
+#endif
+    }
+    return bytes;
+  }
+
   size_t GetVerticesNum() {
     if (vertex_mata_known_ == false) {
       computeVertexNum();
@@ -812,16 +954,14 @@ class GartFragment {
                                 column_family_data_length_[label_id]
                                                           [column_family_id] +
                             column_family_offset));
-          int64_t str_offset = value >> 16;
-          return string_buffer_ + str_offset;
+          return string_chunks_.get_data(value);
         }
       }
     } else {
       char* data =
           (char*) (vertex_prop_blob_ptrs_[label_id][prop_id] + header_offset);
       int64_t value = *(((int64_t*) data) + v_offset);
-      int64_t str_offset = value >> 16;
-      return string_buffer_ + str_offset;
+      return string_chunks_.get_data(value);
     }
     return nullptr;
   }
@@ -861,12 +1001,90 @@ class GartFragment {
     return column_family_data_length_[label_id][column_family_id];
   }
 
+  // secondary indexes of vertex properties, see util/property_index.h
+  PropertyIndexType GetPropertyIndexType(label_id_t label_id,
+                                         prop_id_t prop_id) const {
+    const PropertyIndexReader* index = get_prop_index_(label_id, prop_id);
+    return index == nullptr ? NO_INDEX : index->type();
+  }
+
+  // inner vertices whose property equals value at the epoch of the
+  // fragment, return false if the property has no index. TIMESTAMP values
+  // are given as text or as integers (see parse_timestamp_micros)
+  template <typename T>
+  bool GetVerticesByProperty(label_id_t label_id, prop_id_t prop_id,
+                             const T& value,
+                             std::vector<vertex_t>& vertices) const {
+    const PropertyIndexReader* index = get_prop_index_(label_id, prop_id);
+    if (index == nullptr) {
+      return false;
+    }
+    std::string dtype = GetVertexPropDataType(label_id, prop_id);
+    uint64_t key;
+    if (!prop_index_key_(dtype, value, key)) {
+      return true;  // not a timestamp, matches no vertex
+    }
+    bool is_string = dtype == "STRING";
+    index->find(key, read_epoch_number_, [&](uint64_t offset) {
+      vertex_t v(vid_parser.GenerateId(0, label_id, offset));
+      // strings are hashed
+      if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+        if (is_string &&
+            GetData<std::string_view>(v, prop_id) != std::string_view(value)) {
+          return;
+        }
+      }
+      vertices.push_back(v);
+    });
+    return true;
+  }
+
+  // inner vertices whose property is in [lo, hi] at the epoch of the
+  // fragment, in the order of values, return false if the property has no
+  // ordered index, or if lo or hi is text that is not a timestamp
+  template <typename T>
+  bool GetVerticesByPropertyRange(label_id_t label_id, prop_id_t prop_id,
+                                  const T& lo, const T& hi,
+                                  std::vector<vertex_t>& vertices) const {
+    const PropertyIndexReader* index = get_prop_index_(label_id, prop_id);
+    if (index == nullptr || index->type() != ORDERED_INDEX) {
+      return false;
+    }
+    std::string dtype = GetVertexPropDataType(label_id, prop_id);
+    uint64_t lo_key, hi_key;
+    if (!prop_index_key_(dtype, lo, lo_key) ||
+        !prop_index_key_(dtype, hi, hi_key)) {
+      return false;
+    }
+    index->find_range(lo_key, hi_key, read_epoch_number_,
+                      [&](uint64_t offset) {
+                        vertices.push_back(
+                            vertex_t(vid_parser.GenerateId(0, label_id,
+                                                           offset)));
+                      });
+    return true;
+  }
+
   template <typename T>
   T GetData(const vertex_t& v, prop_id_t prop_id) const {
     T t{};
     GetDataImpl(t, v, prop_id);
     return t;
   }
+  // INT_LIST, LONG_LIST, FLOAT_LIST and DOUBLE_LIST properties
+  template <typename T>
+  ListView<T> GetList(const vertex_t& v, prop_id_t prop_id) const {
+    std::string_view bytes;
+    GetDataImpl(bytes, v, prop_id);
+    return ListView<T>(bytes);
+  }
+
+  StringListView GetStringList(const vertex_t& v, prop_id_t prop_id) const {
+    std::string_view bytes;
+    GetDataImpl(bytes, v, prop_id);
+    return StringListView(bytes);
+  }
+
 
   template <typename T>
   void GetDataImpl(T& t, const vertex_t& v, prop_id_t prop_id) const {
@@ -944,9 +1162,7 @@ class GartFragment {
                                 column_family_data_length_[label_id]
                                                           [column_family_id] +
                             column_family_offset));
-          int64_t str_offset = value >> 16;
-          int64_t str_len = value & 0xffff;
-          t = std::string_view(string_buffer_ + str_offset, str_len);
+          t = string_chunks_.get_view(value);
           return;
         }
       }
@@ -954,9 +1170,7 @@ class GartFragment {
       char* data =
           (char*) (vertex_prop_blob_ptrs_[label_id][prop_id] + header_offset);
       int64_t value = *(((int64_t*) data) + v_offset);
-      int64_t str_offset = value >> 16;
-      int64_t str_len = value & 0xffff;
-      t = std::string_view(string_buffer_ + str_offset, str_len);
+      t = string_chunks_.get_view(value);
       return;
     }
     return;
@@ -980,19 +1194,15 @@ class GartFragment {
     } else {
       faka_value = outer_vertex_ext_id_ptrs_[label_id][offset];
     }
-    int64_t str_offset = faka_value >> 16;
-    int64_t str_len = faka_value & 0xffff;
-    return std::string_view(string_buffer_ + str_offset, str_len);
+    return string_chunks_.get_view(faka_value);
   }
 
   int GetLocalOutDegree(const vertex_t& v, label_id_t e_label) const {
-    // TODO(wanglei):not implemented
-    return 0;
+    return get_degree_in_seg_(locate_segment_(v, e_label, seggraph::EOUT), v);
   }
 
   int GetLocalInDegree(const vertex_t& v, label_id_t e_label) const {
-    // TODO(wanglei):not implemented
-    return 0;
+    return get_degree_in_seg_(locate_segment_(v, e_label, seggraph::EIN), v);
   }
 
   bool Gid2Vertex(const vid_t& gid, vertex_t& v) const {
@@ -1161,27 +1371,15 @@ class GartFragment {
   }
 
   inline grape::DestList IEDests(const vertex_t& v, label_id_t e_label) const {
-    int64_t offset = vid_parser.GetOffset(v.GetValue());
-    auto v_label = vertex_label(v);
-
-    return grape::DestList(idoffset_[v_label][e_label][offset],
-                           idoffset_[v_label][e_label][offset + 1]);
+    return get_dests_(v, e_label, true, false, idoffset_);
   }
 
   inline grape::DestList OEDests(const vertex_t& v, label_id_t e_label) const {
-    int64_t offset = vid_parser.GetOffset(v.GetValue());
-    auto v_label = vertex_label(v);
-
-    return grape::DestList(odoffset_[v_label][e_label][offset],
-                           odoffset_[v_label][e_label][offset + 1]);
+    return get_dests_(v, e_label, false, true, odoffset_);
   }
 
   inline grape::DestList IOEDests(const vertex_t& v, label_id_t e_label) const {
-    int64_t offset = vid_parser.GetOffset(v.GetValue());
-    auto v_label = vertex_label(v);
-
-    return grape::DestList(iodoffset_[v_label][e_label][offset],
-                           iodoffset_[v_label][e_label][offset + 1]);
+    return get_dests_(v, e_label, true, true, iodoffset_);
   }
 
   inline size_t GetOffset(const vertex_t& v) const {
@@ -1203,12 +1401,55 @@ class GartFragment {
 
   inline vid_t GetMaxOuterIdOffset() const { return max_outer_id_offset_; }
 
-  inline char* GetStringBuffer() const { return string_buffer_; }
+  // slot -> dense id of the vertices of a label alive at the epoch, in the
+  // order of InnerVertices and then OuterVertices, to index flat arrays of
+  // apps (see GartVertexArray::InitDense) instead of the slots of the vertex
+  // table, which are kept by deleted vertices. The slots of outer vertices
+  // follow the GetMaxInnerVerticesNum slots of inner vertices. Built at the
+  // first call for the label, only for the apps asking for them.
+  const vid_t* GetDenseIds(label_id_t label_id) const {
+    std::lock_guard<std::mutex> lock(dense_ids_mutex_);
+    if (dense_ids_.empty()) {
+      dense_ids_.resize(vertex_label_num_);
+      dense_inner_nums_.resize(vertex_label_num_, 0);
+      dense_nums_.resize(vertex_label_num_, 0);
+      dense_ids_known_.resize(vertex_label_num_, false);
+    }
+    if (!dense_ids_known_[label_id]) {
+      initDenseIds(label_id);
+      dense_ids_known_[label_id] = true;
+    }
+    return dense_ids_[label_id].data();
+  }
+
+  // inner vertices take dense ids in [0, GetDenseInnerVerticesNum)
+  inline vid_t GetDenseInnerVerticesNum(label_id_t label_id) const {
+    GetDenseIds(label_id);
+    return dense_inner_nums_[label_id];
+  }
+
+  inline vid_t GetDenseVerticesNum(label_id_t label_id) const {
+    GetDenseIds(label_id);
+    return dense_nums_[label_id];
+  }
+
+  // the address of a string by its offset in the string heap, only for
+  // strings shorter than StringChunks::LONG_STR_LEN
+  inline char* GetStringAddr(int64_t str_offset) const {
+    return string_chunks_.get(str_offset);
+  }
+
+  // the address of a string (ended by '\0') by its key
+  inline const char* GetStringData(int64_t str_key) const {
+    return string_chunks_.get_data(str_key);
+  }
 
   void PrepareToRunApp(const grape::CommSpec& comm_spec,
                        grape::PrepareConf conf) {
-    if (conf.message_strategy ==
-        grape::MessageStrategy::kAlongEdgeToOuterVertex) {
+    if (dest_fid_lists_known_) {
+      // published by the writer, nothing to build
+    } else if (conf.message_strategy ==
+               grape::MessageStrategy::kAlongEdgeToOuterVertex) {
       initDestFidList(true, true, iodst_, iodoffset_);
     } else if (conf.message_strategy ==
                grape::MessageStrategy::kAlongIncomingEdgeToOuterVertex) {
@@ -1217,22 +1458,8 @@ class GartFragment {
                grape::MessageStrategy::kAlongOutgoingEdgeToOuterVertex) {
       initDestFidList(false, true, odst_, odoffset_);
     }
-    for (auto vlabel = 0; vlabel < vertex_label_num_; vlabel++) {
-      size_t ivnum = 0;
-      size_t ovnum = 0;
-      auto inner_vertex_iter = InnerVertices(vlabel);
-      while (inner_vertex_iter.valid()) {
-        ivnum++;
-        inner_vertex_iter.next();
-      }
-      ivnums_[vlabel] = ivnum;
-      auto outer_vertex_iter = OuterVertices(vlabel);
-      while (outer_vertex_iter.valid()) {
-        ovnum++;
-        outer_vertex_iter.next();
-      }
-      ovnums_[vlabel] = ovnum;
-      tvnums_[vlabel] = ivnum + ovnum;
+    if (vertex_mata_known_ == false) {
+      computeVertexNum();
     }
   }
   std::pair<vid_t*, vid_t*> get_inner_vertices_addr(int label_id) const {
@@ -1242,28 +1469,94 @@ class GartFragment {
   }
 
  private:
+  const PropertyIndexReader* get_prop_index_(label_id_t label_id,
+                                             prop_id_t prop_id) const {
+    const auto& indexes = vertex_prop_indexes_[label_id];
+    auto iter = indexes.find(prop_id);
+    return iter == indexes.end() ? nullptr : iter->second.get();
+  }
+
+  // the key of a value of a property of dtype, text of a TIMESTAMP is keyed
+  // by its epoch micros, false if it cannot be parsed
+  template <typename T>
+  static bool prop_index_key_(const std::string& dtype, const T& value,
+                              uint64_t& key) {
+    if constexpr (std::is_integral_v<T>) {
+      key = property_index_key(static_cast<int64_t>(value));
+    } else if constexpr (std::is_floating_point_v<T>) {
+      key = property_index_key(static_cast<double>(value));
+    } else if (dtype == "TIMESTAMP") {
+      int64_t micros;
+      if (!parse_timestamp_micros(std::string_view(value), micros)) {
+        return false;
+      }
+      key = property_index_key(micros);
+    } else {
+      key = property_index_key(std::string_view(value));
+    }
+    return true;
+  }
+
+  // fetch a blob from vineyard, unless it is mapped by the previous fragment
+  std::shared_ptr<vineyard::Blob> get_blob_(uint64_t oid) {
+    auto iter = blobs_.find(oid);
+    if (iter != blobs_.end()) {
+      return iter->second;
+    }
+    std::shared_ptr<vineyard::Blob> blob;
+    if (prev_blobs_ != nullptr) {
+      auto prev_iter = prev_blobs_->find(oid);
+      if (prev_iter != prev_blobs_->end()) {
+        blob = prev_iter->second;
+      }
+    }
+    if (blob == nullptr) {
+      VINEYARD_CHECK_OK(client_->GetBlob(oid, true, blob));
+    }
+    blobs_.emplace(oid, blob);
+    return blob;
+  }
+
+  // the arenas of blocks existing at the epoch, a blob of a large block takes
+  // consecutive arenas (see seggraph::BlockArenas)
+  void load_block_arenas_(const std::vector<uint64_t>& oids, int arena_bits,
+                          seggraph::BlockArenas& arenas) {
+    arenas.init(arena_bits, oids.size());
+    char* prev_arena = nullptr;
+    for (size_t idx = 0; idx < oids.size(); idx++) {
+      if (oids[idx] == 0) {
+        prev_arena = nullptr;
+      } else if (idx > 0 && oids[idx] == oids[idx - 1]) {
+        prev_arena += arenas.get_arena_size();
+      } else {
+        prev_arena = (char*) get_blob_(oids[idx])->data();
+      }
+      arenas.set_arena(idx, prev_arena);
+    }
+  }
+
   inline seggraph::VegitoSegmentHeader* locate_segment_(const vertex_t& v,
                                                         label_id_t e_label,
                                                         dir_t dir) const {
     uint64_t header_offset = 0;
     label_id_t label_id = vid_parser.GetLabelId(v.GetValue());
-    char* edge_blob_ptr = nullptr;
+    const seggraph::BlockArenas* arenas = nullptr;
     if (IsInnerVertex(v)) {
       auto seg_id = vid_parser.GetOffset(v.GetValue()) / VERTEX_PER_SEG;
       header_offset = inner_edge_label_ptrs_[label_id][seg_id];
-      edge_blob_ptr = inner_edge_blob_ptrs_[label_id];
+      arenas = &inner_block_arenas_[label_id];
     } else {
       auto seg_id =
           (max_outer_id_offset_ - vid_parser.GetOffset(v.GetValue())) /
           VERTEX_PER_SEG;
       header_offset = outer_edge_label_ptrs_[label_id][seg_id];
-      edge_blob_ptr = outer_edge_blob_ptrs_[label_id];
+      arenas = &outer_block_arenas_[label_id];
     }
     if (header_offset == 0) {
       return nullptr;
     }
     auto edge_label_block =
-        (EdgeLabelBlockHeader*) (edge_blob_ptr + header_offset);
+        arenas->convert<EdgeLabelBlockHeader>(header_offset);
     for (size_t i = 0; i < edge_label_block->get_num_entries(); i++) {
       auto label_entry = edge_label_block->get_entries()[i];
 
@@ -1271,84 +1564,130 @@ class GartFragment {
         if (label_entry.get_pointer(dir) == 0) {
           return nullptr;
         }
-        return (VegitoSegmentHeader*) (edge_blob_ptr +
-                                       label_entry.get_pointer(dir));
+        return arenas->convert<VegitoSegmentHeader>(
+            label_entry.get_pointer(dir));
       }
     }
 
     return nullptr;
   }
 
-  inline gart::EdgeIterator get_edges_in_seg_(VegitoSegmentHeader* segment,
-                                              const vertex_t& v,
-                                              size_t edge_prop_size,
-                                              int* prop_offsets,
-                                              size_t bitmap_size) const {
+  // the arenas, epoch table and latest edge block of the vertex in the
+  // segment, return false if the vertex has no edges in it
+  inline bool locate_edges_in_seg_(VegitoSegmentHeader* segment,
+                                   const vertex_t& v,
+                                   const seggraph::BlockArenas*& arenas,
+                                   EpochBlockHeader*& epoch_table,
+                                   VegitoEdgeBlockHeader*& edge_block) const {
     if (!segment) {
-      return gart::EdgeIterator(nullptr, nullptr, nullptr, nullptr, 0, 0,
-                                read_epoch_number_, nullptr, string_buffer_,
-                                bitmap_size);
+      return false;
     }
     label_id_t label_id = vid_parser.GetLabelId(v.GetValue());
-    char* edge_blob_ptr = nullptr;
     uint64_t seg_idx = 0;
     if (IsInnerVertex(v)) {
       seg_idx = vid_parser.GetOffset(v.GetValue()) % VERTEX_PER_SEG;
-      edge_blob_ptr = inner_edge_blob_ptrs_[label_id];
+      arenas = &inner_block_arenas_[label_id];
     } else {
       seg_idx = (max_outer_id_offset_ - vid_parser.GetOffset(v.GetValue())) %
                 VERTEX_PER_SEG;
-      edge_blob_ptr = outer_edge_blob_ptrs_[label_id];
+      arenas = &outer_block_arenas_[label_id];
     }
     auto epoch_table_offset = segment->get_epoch_table(seg_idx);
-    EpochBlockHeader* epoch_table =
-        (EpochBlockHeader*) (edge_blob_ptr + epoch_table_offset);
-
     auto edge_block_offset = segment->get_region_ptr(seg_idx);
-    VegitoEdgeBlockHeader* edge_block =
-        (VegitoEdgeBlockHeader*) (edge_blob_ptr + edge_block_offset);
-    if (!epoch_table || !edge_block || epoch_table_offset == 0 ||
-        edge_block_offset == 0) {
+    if (epoch_table_offset == 0 || edge_block_offset == 0) {
+      return false;
+    }
+    epoch_table = arenas->convert<EpochBlockHeader>(epoch_table_offset);
+    edge_block = arenas->convert<VegitoEdgeBlockHeader>(edge_block_offset);
+    return true;
+  }
+
+  inline gart::EdgeIterator get_edges_in_seg_(VegitoSegmentHeader* segment,
+                                              const vertex_t& v,
+                                              size_t edge_prop_size,
+                                              int* prop_offsets,
+                                              size_t bitmap_size) const {
+    const seggraph::BlockArenas* arenas = nullptr;
+    EpochBlockHeader* epoch_table = nullptr;
+    VegitoEdgeBlockHeader* edge_block = nullptr;
+    if (!locate_edges_in_seg_(segment, v, arenas, epoch_table, edge_block)) {
       return gart::EdgeIterator(nullptr, nullptr, nullptr, nullptr, 0, 0,
-                                read_epoch_number_, nullptr, string_buffer_,
+                                read_epoch_number_, nullptr, &string_chunks_,
                                 bitmap_size);
     }
 
     auto num_entries = edge_block->get_num_entries();
     if (num_entries == 0) {  // no edges to read
       return gart::EdgeIterator(nullptr, nullptr, nullptr, nullptr, 0, 0,
-                                read_epoch_number_, nullptr, string_buffer_,
+                                read_epoch_number_, nullptr, &string_chunks_,
                                 bitmap_size);
     }
 
-    return gart::EdgeIterator(segment, edge_block, epoch_table, edge_blob_ptr,
+    return gart::EdgeIterator(segment, edge_block, epoch_table, arenas,
                               num_entries, edge_prop_size, read_epoch_number_,
-                              prop_offsets, string_buffer_, bitmap_size);
+                              prop_offsets, &string_chunks_, bitmap_size);
+  }
+
+  // the number of edges of the vertex at the read epoch, from the epoch table
+  // instead of iterating the edges, as EdgeIterator::size()
+  inline size_t get_degree_in_seg_(VegitoSegmentHeader* segment,
+                                   const vertex_t& v) const {
+    const seggraph::BlockArenas* arenas = nullptr;
+    EpochBlockHeader* epoch_table = nullptr;
+    VegitoEdgeBlockHeader* edge_block = nullptr;
+    if (!locate_edges_in_seg_(segment, v, arenas, epoch_table, edge_block)) {
+      return 0;
+    }
+    // loaded before searching the epoch table, edges of a later epoch are
+    // appended after its epoch entry
+    size_t latest_degree = edge_block->get_degree();
+    auto epoch_table_cursor = epoch_table->search(read_epoch_number_);
+    if (epoch_table_cursor == nullptr) {
+      return 0;
+    } else if (epoch_table_cursor == epoch_table->get_entries() -
+                                         epoch_table->get_num_entries()) {
+      return latest_degree;
+    }
+    return (epoch_table_cursor - 1)->get_degree();
   }
 
+  inline grape::DestList get_dests_(
+      const vertex_t& v, label_id_t e_label, bool in_edge, bool out_edge,
+      const std::vector<std::vector<std::vector<fid_t*>>>& fid_lists_offset)
+      const {
+    uint64_t offset = vid_parser.GetOffset(v.GetValue());
+    auto v_label = vertex_label(v);
+    if (!dest_fid_lists_known_) {
+      return grape::DestList(fid_lists_offset[v_label][e_label][offset],
+                             fid_lists_offset[v_label][e_label][offset + 1]);
+    }
+    uint64_t idx;
+    const DestFidList* list =
+        dest_fid_lists_[v_label][e_label].get(offset, idx);
+    if (list == nullptr) {
+      return grape::DestList(nullptr, nullptr);
+    }
+    return grape::DestList(list->begin(idx, in_edge), list->end(idx, out_edge));
+  }
+
+  // for schemas without the destination fid lists of the writer (see
+  // DestFidTable), indexed by the offsets of inner vertices
   void initDestFidList(
       bool in_edge, bool out_edge,
       std::vector<std::vector<std::vector<fid_t>>>& fid_lists,
       std::vector<std::vector<std::vector<fid_t*>>>& fid_lists_offset) {
     for (auto v_label_id = 0; v_label_id < vertex_label_num_; v_label_id++) {
-      auto inner_vertices_iter = InnerVertices(v_label_id);
-      int ivnum = 0;
-      while (inner_vertices_iter.valid()) {
-        ivnum++;
-        inner_vertices_iter.next();
-      }
+      size_t vnum = GetMaxInnerVerticesNum(v_label_id);
       for (auto e_label_id = 0; e_label_id < edge_label_num_; e_label_id++) {
-        std::set<fid_t> dstset;
-        std::vector<int> id_num(ivnum, 0);
+        std::vector<std::set<fid_t>> dstsets(vnum);
         auto& fid_list = fid_lists[v_label_id][e_label_id];
         auto& fid_list_offset = fid_lists_offset[v_label_id][e_label_id];
         assert(fid_list_offset.empty());
-        fid_list_offset.resize(ivnum + 1);
+        fid_list_offset.resize(vnum + 1);
         auto vertices_iter = InnerVertices(v_label_id);
-        int idx = 0;
         while (vertices_iter.valid()) {
-          dstset.clear();
           auto v = vertices_iter.vertex();
+          auto& dstset = dstsets[vid_parser.GetOffset(v.GetValue())];
           if (in_edge) {
             auto edge_iter = GetIncomingAdjList(v, e_label_id);
             while (edge_iter.valid()) {
@@ -1371,24 +1710,43 @@ class GartFragment {
               }
               edge_iter.next();
             }
-
-            id_num[idx] = dstset.size();
-            for (auto fid : dstset) {
-              fid_list.push_back(fid);
-            }
           }
           vertices_iter.next();
-          idx++;
+        }
+        for (const auto& dstset : dstsets) {
+          fid_list.insert(fid_list.end(), dstset.begin(), dstset.end());
         }
         fid_list.shrink_to_fit();
         fid_list_offset[0] = fid_list.data();
-        for (auto i = 0; i < ivnum; i++) {
-          fid_list_offset[i + 1] = fid_list_offset[i] + id_num[i];
+        for (size_t i = 0; i < vnum; i++) {
+          fid_list_offset[i + 1] = fid_list_offset[i] + dstsets[i].size();
         }
       }
     }
   }
 
+  // consecutive ids for the vertices in a chunk of the iterators (see
+  // VertexIterator::split), for the locality of apps iterating in parallel
+  void initDenseIds(label_id_t v_label_id) const {
+    auto max_inner_num = GetMaxInnerVerticesNum(v_label_id);
+    auto& ids = dense_ids_[v_label_id];
+    ids.assign(max_inner_num + GetMaxOuterVerticesNum(v_label_id),
+               std::numeric_limits<vid_t>::max());
+    vid_t id = 0;
+    auto inner_vertices_iter = InnerVertices(v_label_id);
+    while (inner_vertices_iter.valid()) {
+      ids[GetOffset(inner_vertices_iter.vertex())] = id++;
+      inner_vertices_iter.next();
+    }
+    dense_inner_nums_[v_label_id] = id;
+    auto outer_vertices_iter = OuterVertices(v_label_id);
+    while (outer_vertices_iter.valid()) {
+      ids[GetOffset(outer_vertices_iter.vertex()) + max_inner_num] = id++;
+      outer_vertices_iter.next();
+    }
+    dense_nums_[v_label_id] = id;
+  }
+
   void computeVertexNum() {
     for (auto v_label_id = 0; v_label_id < vertex_label_num_; v_label_id++) {
       auto inner_vertices_iter = InnerVertices(v_label_id);
@@ -1430,16 +1788,23 @@ class GartFragment {
   }
 
  private:
-  vineyard::Client client_;
+  // shared with the fragments initialized from this fragment
+  std::shared_ptr<vineyard::Client> client_;
   std::string ipc_socket_;
+  // object id -> blob, of the blobs mapped at the epoch
+  std::unordered_map<uint64_t, std::shared_ptr<vineyard::Blob>> blobs_;
+  // blobs of the fragment this fragment is initialized from, during Init
+  const std::unordered_map<uint64_t, std::shared_ptr<vineyard::Blob>>*
+      prev_blobs_ = nullptr;
 
   size_t read_epoch_number_;
   std::vector<int64_t> inner_offsets_, outer_offsets_;
   std::vector<vid_t*> vertex_tables_;
   std::vector<int64_t> vertex_table_lens_;
   std::vector<int64_t> max_inner_offsets_, min_outer_offsets_;
+  std::vector<int64_t> inner_delete_nums_, outer_delete_nums_;
   vid_t max_outer_id_offset_;
-  char* string_buffer_;
+  StringChunks string_chunks_;
 
   std::vector<size_t> ivnums_, ovnums_, tvnums_;
   std::vector<size_t> tenums_;
@@ -1450,11 +1815,20 @@ class GartFragment {
 
   std::vector<uint64_t*> inner_edge_label_ptrs_;
   std::vector<uint64_t*> outer_edge_label_ptrs_;
-  std::vector<char*> inner_edge_blob_ptrs_, outer_edge_blob_ptrs_;
+  std::vector<seggraph::BlockArenas> inner_block_arenas_, outer_block_arenas_;
 
   std::vector<std::vector<std::vector<fid_t>>> idst_, odst_, iodst_;
   std::vector<std::vector<std::vector<fid_t*>>> idoffset_, odoffset_,
       iodoffset_;
+  // vlabel -> elabel -> destination fid lists of the writer, nullptr if the
+  // inner vertices of the label have no edges to outer vertices
+  std::vector<std::vector<DestFidChunks>> dest_fid_lists_;
+  bool dest_fid_lists_known_ = false;
+  // vlabel -> slot of the vertex table -> dense id (see GetDenseIds)
+  mutable std::mutex dense_ids_mutex_;
+  mutable std::vector<std::vector<vid_t>> dense_ids_;
+  mutable std::vector<vid_t> dense_inner_nums_, dense_nums_;
+  mutable std::vector<bool> dense_ids_known_;
 
   // for edge property
   std::vector<int> edge_prop_nums_;
@@ -1462,6 +1836,9 @@ class GartFragment {
   // for vertex property
   std::vector<int> vertex_prop_nums_;
   std::vector<std::vector<char*>> vertex_prop_blob_ptrs_;
+  // label -> prop id -> secondary index
+  std::vector<std::map<prop_id_t, std::unique_ptr<PropertyIndexReader>>>
+      vertex_prop_indexes_;
   std::vector<std::vector<int>> vertex_prop_column_family_id_;
   std::vector<std::vector<int>> vertex_prop_column_family_offset_;
   std::vector<std::vector<int>> vertex_prop_num_per_column_family_;
@@ -16,12 +16,18 @@
 #ifndef INTERFACES_FRAGMENT_ITERATOR_H_
 #define INTERFACES_FRAGMENT_ITERATOR_H_
 
+#include <algorithm>
 #include <cstdint>
+#include <functional>
 #include <string_view>
+#include <utility>
+#include <vector>
 
 #include "interfaces/fragment/types.h"
+#include "seggraph/block_arenas.hpp"
 #include "seggraph/blocks.hpp"
 #include "util/bitset.h"
+#include "util/string_chunks.h"
 
 namespace gart {
 template <typename VID_T, typename VDATA_T>
@@ -39,17 +45,21 @@ class VertexIterator {
   }
   VertexIterator(std::vector<std::pair<vid_t*, vid_t*>> addrs,
                  std::vector<bool> high_to_low_flags, vid_t* vertex_table_addr,
-                 int vlabel) {
+                 int vlabel, std::vector<int64_t> delete_nums = {}) {
     vertex_table_addr_ = vertex_table_addr;
     vlabel_ = vlabel;
     for (size_t i = 0; i < addrs.size(); i++) {
       addrs_.push_back(std::make_pair(addrs[i].first, addrs[i].second));
       high_to_low_flags_.push_back(high_to_low_flags[i]);
+      // be conservative if the caller does not know
+      delete_nums_.push_back(i < delete_nums.size() ? delete_nums[i] : -1);
+      has_deletes_.push_back(delete_nums_.back() != 0);
     }
     cur_ = addrs_[0].first;
     begin_ = addrs_[0].first;
     end_ = addrs_[0].second;
     high_to_low_flag_ = high_to_low_flags_[0];
+    has_delete_ = has_deletes_[0];
     loc_ = 0;
     find_next_valid_cursor();
   }
@@ -67,49 +77,10 @@ class VertexIterator {
   void next() {
     if (!high_to_low_flag_) {
       cur_++;
-      while (cur_ != end_) {
-        vid_t v = *cur_;
-        auto delete_flag = v >> (sizeof(vid_t) * 8 - 1);
-        if (delete_flag == 1) {
-          auto delete_offset_mask =
-              (((vid_t) 1) << (sizeof(vid_t) * 8 - 1)) - (vid_t) 1;
-          auto delete_offset = v & delete_offset_mask;
-          outer_delete_offset_.push(delete_offset);
-        } else if (delete_flag == 0) {
-          if (outer_delete_offset_.empty()) {
-            break;
-          }
-          if (cur_ - vertex_table_addr_ != outer_delete_offset_.top()) {
-            break;
-          } else {
-            outer_delete_offset_.pop();
-          }
-        }
-        cur_++;
-      }
     } else {
       cur_--;
-      while (cur_ != end_) {
-        vid_t v = *cur_;
-        auto delete_flag = v >> (sizeof(vid_t) * 8 - 1);
-        if (delete_flag == 1) {
-          auto delete_offset_mask =
-              (((vid_t) 1) << (sizeof(vid_t) * 8 - 1)) - (vid_t) 1;
-          auto delete_offset = v & delete_offset_mask;
-          inner_delete_offset_.push(delete_offset);
-        } else if (delete_flag == 0) {
-          if (inner_delete_offset_.empty()) {
-            break;
-          }
-          if (cur_ - vertex_table_addr_ != inner_delete_offset_.top()) {
-            break;
-          } else {
-            inner_delete_offset_.pop();
-          }
-        }
-        cur_--;
-      }
     }
+    find_next_valid_cursor();
   }
 
   bool switch_next_range() {
@@ -121,6 +92,8 @@ class VertexIterator {
       begin_ = addrs_[loc_].first;
       end_ = addrs_[loc_].second;
       high_to_low_flag_ = high_to_low_flags_[loc_];
+      has_delete_ = has_deletes_[loc_];
+      delete_offsets_.clear();
 
       find_next_valid_cursor();
 
@@ -133,47 +106,30 @@ class VertexIterator {
   }
 
   void find_next_valid_cursor() {
-    if (!high_to_low_flag_) {
-      while (cur_ != end_) {
-        vid_t v = *cur_;
-        auto delete_flag = v >> (sizeof(vid_t) * 8 - 1);
-        if (delete_flag == 1) {
-          auto delete_offset_mask =
-              (((vid_t) 1) << (sizeof(vid_t) * 8 - 1)) - (vid_t) 1;
-          auto delete_offset = v & delete_offset_mask;
-          outer_delete_offset_.push(delete_offset);
-        } else if (delete_flag == 0) {
-          if (outer_delete_offset_.empty()) {
-            break;
-          }
-          if (cur_ - vertex_table_addr_ != outer_delete_offset_.top()) {
-            break;
-          } else {
-            outer_delete_offset_.pop();
-          }
-        }
-        cur_++;
-      }
-    } else {
-      while (cur_ != end_) {
-        vid_t v = *cur_;
-        auto delete_flag = v >> (sizeof(vid_t) * 8 - 1);
-        if (delete_flag == 1) {
-          auto delete_offset_mask =
-              (((vid_t) 1) << (sizeof(vid_t) * 8 - 1)) - (vid_t) 1;
-          auto delete_offset = v & delete_offset_mask;
-          inner_delete_offset_.push(delete_offset);
+    if (!has_delete_) {
+      return;
+    }
+    while (cur_ != end_) {
+      vid_t v = *cur_;
+      auto delete_flag = v >> (sizeof(vid_t) * 8 - 1);
+      if (delete_flag == 1) {
+        auto delete_offset_mask =
+            (((vid_t) 1) << (sizeof(vid_t) * 8 - 1)) - (vid_t) 1;
+        auto delete_offset = v & delete_offset_mask;
+        push_delete_offset(delete_offset);
+      } else if (delete_flag == 0) {
+        if (delete_offsets_.empty()) {
+          break;
         }
-        if (delete_flag == 0) {
-          if (inner_delete_offset_.empty()) {
-            break;
-          }
-          if (cur_ - vertex_table_addr_ != inner_delete_offset_.top()) {
-            break;
-          } else {
-            inner_delete_offset_.pop();
-          }
+        if (cur_ - vertex_table_addr_ != delete_offsets_.front()) {
+          break;
+        } else {
+          pop_delete_offset();
         }
+      }
+      if (!high_to_low_flag_) {
+        cur_++;
+      } else {
         cur_--;
       }
     }
@@ -194,7 +150,173 @@ class VertexIterator {
     return flag;
   }
 
+  // split the vertices into about chunk_num chunks of consecutive slots of
+  // the vertex table, with the same number of slots in each, to be iterated
+  // independently (see gart::ParallelEngine)
+  std::vector<VertexIterator> split(size_t chunk_num) const {
+    size_t total_len = 0;
+    for (size_t r = 0; r < addrs_.size(); r++) {
+      total_len += range_len_(r);
+    }
+    std::vector<VertexIterator> chunks;
+    for (size_t r = 0; r < addrs_.size() && total_len > 0; r++) {
+      size_t len = range_len_(r);
+      if (len == 0) {
+        continue;
+      }
+      size_t num = (std::max<size_t>(chunk_num, 1) * len + total_len - 1) /
+                   total_len;
+      num = std::min(num, len);
+      std::vector<size_t> cuts(num + 1);
+      for (size_t i = 0; i <= num; i++) {
+        cuts[i] = len * i / num;
+      }
+      add_chunks_(r, cuts, chunks);
+    }
+    return chunks;
+  }
+
+  // as split, with about the same sum of weight(v) + 1 of the vertices in
+  // each chunk, e.g., the degrees for apps iterating edges of power-law
+  // graphs
+  template <typename WEIGHT_FUNC_T>
+  std::vector<VertexIterator> split(size_t chunk_num,
+                                    const WEIGHT_FUNC_T& weight) const {
+    size_t total_weight = 0;
+    for (VertexIterator iter = *this; iter.valid(); iter.next()) {
+      total_weight += weight(iter.vertex()) + 1;
+    }
+    size_t chunk_weight =
+        std::max<size_t>(total_weight / std::max<size_t>(chunk_num, 1), 1);
+
+    // distances of the cuts from the beginning of each range
+    std::vector<std::vector<size_t>> cuts(addrs_.size());
+    size_t acc = 0;
+    for (VertexIterator iter = *this; iter.valid(); iter.next()) {
+      auto& range_cuts = cuts[iter.loc_];
+      if (range_cuts.empty()) {
+        range_cuts.push_back(0);
+        acc = 0;
+      }
+      acc += weight(iter.vertex()) + 1;
+      if (acc >= chunk_weight) {
+        range_cuts.push_back(iter.high_to_low_flag_
+                                 ? iter.begin_ - iter.cur_ + 1
+                                 : iter.cur_ - iter.begin_ + 1);
+        acc = 0;
+      }
+    }
+
+    std::vector<VertexIterator> chunks;
+    for (size_t r = 0; r < addrs_.size(); r++) {
+      if (cuts[r].empty()) {
+        continue;
+      }
+      size_t len = range_len_(r);
+      if (cuts[r].back() != len) {
+        cuts[r].push_back(len);
+      }
+      add_chunks_(r, cuts[r], chunks);
+    }
+    return chunks;
+  }
+
  private:
+  // a chunk of a range, skipping the victims of delete markers before it
+  VertexIterator(vid_t* vertex_table_addr, int vlabel, vid_t* begin,
+                 vid_t* end, bool high_to_low, bool has_delete,
+                 std::vector<int64_t>&& victims) {
+    vertex_table_addr_ = vertex_table_addr;
+    vlabel_ = vlabel;
+    addrs_.push_back(std::make_pair(begin, end));
+    high_to_low_flags_.push_back(high_to_low);
+    delete_nums_.push_back(has_delete ? -1 : 0);
+    has_deletes_.push_back(has_delete);
+    cur_ = begin;
+    begin_ = begin;
+    end_ = end;
+    high_to_low_flag_ = high_to_low;
+    has_delete_ = has_delete;
+    loc_ = 0;
+    delete_offsets_ = std::move(victims);
+    if (high_to_low_flag_) {
+      std::make_heap(delete_offsets_.begin(), delete_offsets_.end());
+    } else {
+      std::make_heap(delete_offsets_.begin(), delete_offsets_.end(),
+                     std::greater<int64_t>());
+    }
+    find_next_valid_cursor();
+  }
+
+  size_t range_len_(size_t r) const {
+    vid_t* begin = addrs_[r].first;
+    vid_t* end = addrs_[r].second;
+    if (begin == nullptr) {
+      return 0;
+    }
+    if (high_to_low_flags_[r]) {
+      return begin > end ? begin - end : 0;
+    }
+    return end > begin ? end - begin : 0;
+  }
+
+  // chunks of range r between the cuts (distances from the beginning of the
+  // range, from 0 to its length). A delete marker is appended after its
+  // victim, so it is scanned first, and the victims of markers in earlier
+  // chunks are handed to the chunks holding them. The markers of the last
+  // chunk hide nothing in the others, and the scan stops at the last marker
+  // if the number of markers is known.
+  void add_chunks_(size_t r, const std::vector<size_t>& cuts,
+                   std::vector<VertexIterator>& chunks) const {
+    vid_t* begin = addrs_[r].first;
+    bool high_to_low = high_to_low_flags_[r];
+    auto slot = [&](size_t dist) {
+      return high_to_low ? begin - dist : begin + dist;
+    };
+    size_t chunk_num = cuts.size() - 1;
+    std::vector<std::vector<int64_t>> victims(chunk_num);
+    if (has_deletes_[r] && chunk_num > 1) {
+      auto delete_offset_mask =
+          (((vid_t) 1) << (sizeof(vid_t) * 8 - 1)) - (vid_t) 1;
+      int64_t begin_offset = begin - vertex_table_addr_;
+      int64_t markers_left = delete_nums_[r];  // -1 if unknown
+      size_t c = 0;
+      for (size_t dist = 0; dist < cuts[chunk_num - 1] && markers_left != 0;
+           dist++) {
+        while (dist >= cuts[c + 1]) {
+          c++;
+        }
+        vid_t v = *slot(dist);
+        if ((v >> (sizeof(vid_t) * 8 - 1)) == 0) {
+          continue;
+        }
+        if (markers_left > 0) {
+          markers_left--;
+        }
+        int64_t victim = v & delete_offset_mask;
+        int64_t victim_dist =
+            high_to_low ? begin_offset - victim : victim - begin_offset;
+        if (victim_dist < static_cast<int64_t>(cuts[c + 1]) ||
+            victim_dist >= static_cast<int64_t>(cuts.back())) {
+          continue;  // in this chunk, or out of the range
+        }
+        size_t victim_chunk =
+            std::upper_bound(cuts.begin(), cuts.end(), victim_dist) -
+            cuts.begin() - 1;
+        victims[victim_chunk].push_back(victim);
+      }
+    }
+    for (size_t c = 0; c < chunk_num; c++) {
+      if (cuts[c] == cuts[c + 1]) {
+        continue;
+      }
+      chunks.push_back(VertexIterator(vertex_table_addr_, vlabel_,
+                                      slot(cuts[c]), slot(cuts[c + 1]),
+                                      high_to_low, has_deletes_[r],
+                                      std::move(victims[c])));
+    }
+  }
+
   vid_t* vertex_table_addr_;
   std::vector<std::pair<vid_t*, vid_t*>> addrs_;
   std::vector<bool> high_to_low_flags_;
@@ -203,10 +325,35 @@ class VertexIterator {
   vid_t* end_;
   int loc_;
   bool high_to_low_flag_;
-  std::priority_queue<int64_t> inner_delete_offset_;
-  std::priority_queue<int64_t, std::vector<int64_t>, std::greater<int64_t>>
-      outer_delete_offset_;
+  std::vector<bool> has_deletes_;
+  // number of delete markers in each range, -1 if unknown
+  std::vector<int64_t> delete_nums_;
+  bool has_delete_ = true;
+  // pending victims of delete markers, kept as a heap whose top is the next
+  // location in the scan direction
+  std::vector<int64_t> delete_offsets_;
   int vlabel_;
+
+  void push_delete_offset(int64_t offset) {
+    delete_offsets_.push_back(offset);
+    if (high_to_low_flag_) {
+      std::push_heap(delete_offsets_.begin(), delete_offsets_.end());
+    } else {
+      std::push_heap(delete_offsets_.begin(), delete_offsets_.end(),
+                     std::greater<int64_t>());
+    }
+  }
+
+  void pop_delete_offset() {
+    if (high_to_low_flag_) {
+      std::pop_heap(delete_offsets_.begin(), delete_offsets_.end());
+    } else {
+      std::pop_heap(delete_offsets_.begin(), delete_offsets_.end(),
+                    std::greater<int64_t>());
+    }
+    delete_offsets_.pop_back();
+  }
+
   template <typename VID_T, typename VDATA_T>
   friend class GartVertexArray;
 };
@@ -221,9 +368,11 @@ class EdgeIterator {
 
   EdgeIterator(VegitoSegmentHeader* seg_header,
                VegitoEdgeBlockHeader* edge_block_header,
-               EpochBlockHeader* epoch_table_header, char* edge_blob_ptr,
+               EpochBlockHeader* epoch_table_header,
+               const seggraph::BlockArenas* edge_arenas,
                size_t num_entries, size_t edge_prop_size,
-               size_t read_epoch_number, int* prop_offsets, char* string_buffer,
+               size_t read_epoch_number, int* prop_offsets,
+               const StringChunks* string_chunks,
                size_t bitmap_size) {
     prop_offsets_ = prop_offsets;
     seg_header_ = seg_header;
@@ -232,10 +381,12 @@ class EdgeIterator {
     num_entries_ = num_entries;
     edge_prop_size_ = edge_prop_size;
     read_epoch_number_ = read_epoch_number;
-    string_buffer_ = string_buffer;
-    edge_blob_ptr_ = edge_blob_ptr;
+    string_chunks_ = string_chunks;
+    edge_arenas_ = edge_arenas;
     bitmap_size_ = bitmap_size;
     if (edge_block_header && epoch_table_header) {
+      // the counter of the latest block covers all its previous blocks
+      num_tombstones_ = edge_block_header->get_num_tombstones();
       init();
       find_next_valid_cursor();
       seg_block_size_ = seg_header->get_block_size();
@@ -253,20 +404,19 @@ class EdgeIterator {
     auto epoch_table_entries = epoch_table_header_->get_entries();
     auto num_epoches = epoch_table_header_->get_num_entries();
     int64_t read_end_offset = -1;
-    for (size_t idx = 0; idx < num_epoches; idx++) {
-      auto epoch_table_cursor = epoch_table_entries - num_epoches + idx;
-
-      if (read_epoch_number_ >= epoch_table_cursor->get_epoch()) {
-        if (idx == 0) {
-          entries_ = edge_block_header_->get_entries();
-          entries_cursor_ = entries_ - num_entries_;
-          return;
-        } else {
-          auto last_cursor = (epoch_table_cursor - 1);
-          read_end_offset = last_cursor->get_offset();
-          break;
-        }
-      }
+    auto epoch_table_cursor = epoch_table_header_->search(read_epoch_number_);
+    if (epoch_table_cursor == epoch_table_entries - num_epoches) {
+      entries_ = edge_block_header_->get_entries();
+      entries_cursor_ = entries_ - num_entries_;
+      size_ = VegitoEdgeBlockHeader::get_degree(
+          edge_block_header_->get_prev_num_entries() + num_entries_,
+          num_tombstones_);
+      return;
+    } else if (epoch_table_cursor != nullptr) {
+      // the next epoch keeps where the read epoch ends, and its degree
+      auto last_cursor = (epoch_table_cursor - 1);
+      read_end_offset = last_cursor->get_offset();
+      size_ = last_cursor->get_degree();
     }
 
     if (read_end_offset == -1) {
@@ -276,9 +426,8 @@ class EdgeIterator {
     } else {
       while (edge_block_header_->get_prev_num_entries() >=
              (uint64_t) read_end_offset) {
-        edge_block_header_ =
-            (VegitoEdgeBlockHeader*) (edge_block_header_->get_prev_pointer() +
-                                      edge_blob_ptr_);
+        edge_block_header_ = edge_arenas_->convert<VegitoEdgeBlockHeader>(
+            edge_block_header_->get_prev_pointer());
       }
 
       auto offset =
@@ -330,6 +479,16 @@ class EdgeIterator {
     return t;
   }
 
+  // INT_LIST, LONG_LIST, FLOAT_LIST and DOUBLE_LIST properties
+  template <typename T>
+  ListView<T> get_list(int prop_id) {
+    return ListView<T>(get_data<std::string_view>(prop_id));
+  }
+
+  StringListView get_string_list(int prop_id) {
+    return StringListView(get_data<std::string_view>(prop_id));
+  }
+
   template <typename EDATA_T>
   void get_data_impl(EDATA_T& t, int prop_id) {
     char* data = (char*) ((uintptr_t) seg_header_ + seg_block_size_ -
@@ -356,9 +515,7 @@ class EdgeIterator {
     } else {
       value = *(int64_t*) (data + prop_offsets_[prop_id - 1]);
     }
-    int64_t str_offset = value >> 16;
-    int64_t str_len = value & 0xffff;
-    t = std::string_view(string_buffer_ + str_offset, str_len);
+    t = string_chunks_->get_view(value);
   }
 
   uintptr_t get_edge_property_offset() {
@@ -372,25 +529,34 @@ class EdgeIterator {
     }
     bool is_founded = false;
     while (true) {
-      while (entries_cursor_ != entries_) {
+      if (num_tombstones_ == 0) {
+        // no delete markers, every entry is valid
+        is_founded = (entries_cursor_ != entries_);
+      }
+      while (!is_founded && entries_cursor_ != entries_) {
         vid_t vid = entries_cursor_->get_dst();
         auto delete_flag = vid >> (sizeof(vid_t) * 8 - 1);
         if (delete_flag == 1) {
           auto delete_offset_mask =
               (((vid_t) 1) << (sizeof(vid_t) * 8 - 1)) - (vid_t) 1;
           auto delete_offset = vid & delete_offset_mask;
-          delete_offsets_.push(delete_offset);
+          if (delete_offsets_.empty()) {
+            delete_offsets_.reserve(num_tombstones_);
+          }
+          delete_offsets_.push_back(delete_offset);
+          std::push_heap(delete_offsets_.begin(), delete_offsets_.end());
         } else if (delete_flag == 0) {
           if (delete_offsets_.empty()) {
             is_founded = true;
             break;
-          } else if (delete_offsets_.top() !=
+          } else if (delete_offsets_.front() !=
                      ((entries_ - entries_cursor_ - 1) +
                       edge_block_header_->get_prev_num_entries())) {
             is_founded = true;
             break;
           } else {
-            delete_offsets_.pop();
+            std::pop_heap(delete_offsets_.begin(), delete_offsets_.end());
+            delete_offsets_.pop_back();
           }
         }
         entries_cursor_++;
@@ -401,9 +567,8 @@ class EdgeIterator {
       if (!edge_block_header_->get_prev_pointer()) {
         break;
       }
-      edge_block_header_ =
-          (VegitoEdgeBlockHeader*) (edge_block_header_->get_prev_pointer() +
-                                    edge_blob_ptr_);
+      edge_block_header_ = edge_arenas_->convert<VegitoEdgeBlockHeader>(
+          edge_block_header_->get_prev_pointer());
       if (!edge_block_header_) {
         break;
       } else {
@@ -416,21 +581,17 @@ class EdgeIterator {
     }
   }
 
-  size_t size() {
-    // TODO(wanglei): not implemented
-    return 0;
-  }
+  // the number of edges at the read epoch, regardless of the position of
+  // the iterator
+  size_t size() const { return size_; }
 
-  bool empty() {
-    // TODO(wanglei): not implemented
-    return false;
-  }
+  bool empty() const { return size_ == 0; }
 
  private:
   VegitoSegmentHeader* seg_header_;
   VegitoEdgeBlockHeader* edge_block_header_;
   EpochBlockHeader* epoch_table_header_;
-  char* edge_blob_ptr_;  // for switch block
+  const seggraph::BlockArenas* edge_arenas_;  // for switch block
 
   VegitoEdgeEntry* entries_cursor_ = nullptr;
   VegitoEdgeEntry* entries_ = nullptr;
@@ -440,12 +601,16 @@ class EdgeIterator {
 
   int64_t read_epoch_number_;
 
-  std::priority_queue<size_t> delete_offsets_;
+  // pending victims of delete markers, kept as a max-heap since entries are
+  // scanned from the newest to the oldest
+  size_t num_tombstones_ = 0;
+  std::vector<size_t> delete_offsets_;
+  size_t size_ = 0;
   // for edge property
   size_t seg_block_size_;
   size_t edge_prop_offset_;
   int* prop_offsets_;
-  char* string_buffer_;
+  const StringChunks* string_chunks_;
   size_t bitmap_size_;
 };
 }  // namespace gart
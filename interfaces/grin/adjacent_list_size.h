@@ -0,0 +1,47 @@
+/** Copyright 2020 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ * @file adjacent_list_size.h
+ * @brief GART extension of GRIN: the size (degree) of an adjacent list in
+ * O(1), kept by the storage for each epoch, without the random access of
+ * GRIN_ENABLE_ADJACENT_LIST_ARRAY.
+ */
+
+#ifndef INTERFACES_GRIN_ADJACENT_LIST_SIZE_H_
+#define INTERFACES_GRIN_ADJACENT_LIST_SIZE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "grin/predefine.h"
+
+#ifdef GRIN_ENABLE_ADJACENT_LIST_SIZE
+/**
+ * @brief Get the number of edges in the adjacent list, i.e., the local
+ * in-degree, out-degree or both (for BOTH) of the vertex by the edge type.
+ * @param GRIN_GRAPH The graph
+ * @param GRIN_ADJACENT_LIST The adjacent list
+ * @return The number of edges
+ */
+size_t grin_get_adjacent_list_size(GRIN_GRAPH, GRIN_ADJACENT_LIST);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // INTERFACES_GRIN_ADJACENT_LIST_SIZE_H_
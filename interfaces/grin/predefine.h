@@ -45,6 +45,8 @@ extern "C" {
 #define GRIN_ENABLE_VERTEX_LIST_ITERATOR
 #define GRIN_ENABLE_ADJACENT_LIST
 #define GRIN_ENABLE_ADJACENT_LIST_ITERATOR
+// GART extension, see adjacent_list_size.h
+#define GRIN_ENABLE_ADJACENT_LIST_SIZE
 // Partition
 #define GRIN_ENABLE_GRAPH_PARTITION
 #define GRIN_ASSUME_EDGE_CUT_PARTITION
@@ -62,6 +64,8 @@ extern "C" {
 // Index
 #define GRIN_ENABLE_VERTEX_INTERNAL_ID_INDEX
 #define GRIN_ENABLE_VERTEX_EXTERNAL_ID_OF_INT64
+// GART extension, see property_index.h
+#define GRIN_ENABLE_VERTEX_PROPERTY_INDEX
 
 /* Define the handles using typedef */
 typedef void* GRIN_GRAPH;
@@ -0,0 +1,90 @@
+/** Copyright 2020 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/**
+ * @file property_index.h
+ * @brief GART extension of GRIN: look up vertices by the values of indexed
+ * vertex properties (declared by "index: hash|ordered" in the RGMapping),
+ * instead of scanning the vertex list.
+ */
+
+#ifndef INTERFACES_GRIN_PROPERTY_INDEX_H_
+#define INTERFACES_GRIN_PROPERTY_INDEX_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "grin/predefine.h"
+
+#ifdef GRIN_ENABLE_VERTEX_PROPERTY_INDEX
+/**
+ * @brief Whether the vertex property has an index.
+ * @param GRIN_GRAPH The graph
+ * @param GRIN_VERTEX_PROPERTY The vertex property
+ * @return 0 for no index, 1 for a hash index and 2 for an ordered index
+ */
+int grin_get_vertex_property_index_type(GRIN_GRAPH, GRIN_VERTEX_PROPERTY);
+
+/**
+ * @brief Get the master vertices whose property equals the value. The
+ * vertices are returned in an array to destroy by grin_destroy_vertex_array.
+ * @param GRIN_GRAPH The graph
+ * @param GRIN_VERTEX_PROPERTY The indexed vertex property
+ * @param value The value
+ * @param size The number of vertices, GRIN_NULL_SIZE if the property has no
+ * index
+ * @return The vertices
+ */
+GRIN_VERTEX* grin_get_vertices_by_property_value_of_int64(
+    GRIN_GRAPH, GRIN_VERTEX_PROPERTY, long long int value, size_t* size);
+
+GRIN_VERTEX* grin_get_vertices_by_property_value_of_double(
+    GRIN_GRAPH, GRIN_VERTEX_PROPERTY, double value, size_t* size);
+
+GRIN_VERTEX* grin_get_vertices_by_property_value_of_string(
+    GRIN_GRAPH, GRIN_VERTEX_PROPERTY, const char* value, size_t* size);
+
+/**
+ * @brief Get the master vertices whose property is in [lo, hi], in the order
+ * of values. Only properties with ordered indexes have ranges, and bounds
+ * of strings are only taken by TIMESTAMP properties.
+ * @param GRIN_GRAPH The graph
+ * @param GRIN_VERTEX_PROPERTY The indexed vertex property
+ * @param lo The lower bound
+ * @param hi The upper bound
+ * @param size The number of vertices, GRIN_NULL_SIZE if the property has no
+ * ordered index
+ * @return The vertices
+ */
+GRIN_VERTEX* grin_get_vertices_by_property_range_of_int64(
+    GRIN_GRAPH, GRIN_VERTEX_PROPERTY, long long int lo, long long int hi,
+    size_t* size);
+
+GRIN_VERTEX* grin_get_vertices_by_property_range_of_double(
+    GRIN_GRAPH, GRIN_VERTEX_PROPERTY, double lo, double hi, size_t* size);
+
+GRIN_VERTEX* grin_get_vertices_by_property_range_of_string(
+    GRIN_GRAPH, GRIN_VERTEX_PROPERTY, const char* lo, const char* hi,
+    size_t* size);
+
+void grin_destroy_vertex_array(GRIN_GRAPH, GRIN_VERTEX*);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // INTERFACES_GRIN_PROPERTY_INDEX_H_
@@ -0,0 +1,108 @@
+/** Copyright 2020 Alibaba Group Holding Limited.
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "grin/src/predefine.h"
+
+#include "grin/property_index.h"
+
+#ifdef GRIN_ENABLE_VERTEX_PROPERTY_INDEX
+namespace {
+
+GRIN_VERTEX* _grin_to_vertex_array(
+    const std::vector<_GRIN_VERTEX_T>& vertices, size_t* size) {
+  *size = vertices.size();
+  auto array = new GRIN_VERTEX[vertices.size()];
+  for (size_t idx = 0; idx < vertices.size(); idx++) {
+    array[idx] = vertices[idx].GetValue();
+  }
+  return array;
+}
+
+template <typename T>
+GRIN_VERTEX* _grin_get_vertices_by_value(GRIN_GRAPH g,
+                                         GRIN_VERTEX_PROPERTY vp,
+                                         const T& value, size_t* size) {
+  auto _g = static_cast<GRIN_GRAPH_T*>(g)->frag;
+  std::vector<_GRIN_VERTEX_T> vertices;
+  if (!_g->GetVerticesByProperty(_grin_get_type_from_property(vp),
+                                 _grin_get_prop_from_property(vp), value,
+                                 vertices)) {
+    *size = GRIN_NULL_SIZE;
+    return nullptr;
+  }
+  return _grin_to_vertex_array(vertices, size);
+}
+
+template <typename T>
+GRIN_VERTEX* _grin_get_vertices_by_range(GRIN_GRAPH g,
+                                         GRIN_VERTEX_PROPERTY vp, T lo, T hi,
+                                         size_t* size) {
+  auto _g = static_cast<GRIN_GRAPH_T*>(g)->frag;
+  std::vector<_GRIN_VERTEX_T> vertices;
+  if (!_g->GetVerticesByPropertyRange(_grin_get_type_from_property(vp),
+                                      _grin_get_prop_from_property(vp), lo,
+                                      hi, vertices)) {
+    *size = GRIN_NULL_SIZE;
+    return nullptr;
+  }
+  return _grin_to_vertex_array(vertices, size);
+}
+
+}  // namespace
+
+int grin_get_vertex_property_index_type(GRIN_GRAPH g,
+                                        GRIN_VERTEX_PROPERTY vp) {
+  auto _g = static_cast<GRIN_GRAPH_T*>(g)->frag;
+  return _g->GetPropertyIndexType(_grin_get_type_from_property(vp),
+                                  _grin_get_prop_from_property(vp));
+}
+
+GRIN_VERTEX* grin_get_vertices_by_property_value_of_int64(
+    GRIN_GRAPH g, GRIN_VERTEX_PROPERTY vp, long long int value,
+    size_t* size) {
+  return _grin_get_vertices_by_value(g, vp, static_cast<int64_t>(value), size);
+}
+
+GRIN_VERTEX* grin_get_vertices_by_property_value_of_double(
+    GRIN_GRAPH g, GRIN_VERTEX_PROPERTY vp, double value, size_t* size) {
+  return _grin_get_vertices_by_value(g, vp, value, size);
+}
+
+GRIN_VERTEX* grin_get_vertices_by_property_value_of_string(
+    GRIN_GRAPH g, GRIN_VERTEX_PROPERTY vp, const char* value, size_t* size) {
+  return _grin_get_vertices_by_value(g, vp, std::string_view(value), size);
+}
+
+GRIN_VERTEX* grin_get_vertices_by_property_range_of_int64(
+    GRIN_GRAPH g, GRIN_VERTEX_PROPERTY vp, long long int lo, long long int hi,
+    size_t* size) {
+  return _grin_get_vertices_by_range(g, vp, static_cast<int64_t>(lo),
+                                     static_cast<int64_t>(hi), size);
+}
+
+GRIN_VERTEX* grin_get_vertices_by_property_range_of_double(
+    GRIN_GRAPH g, GRIN_VERTEX_PROPERTY vp, double lo, double hi,
+    size_t* size) {
+  return _grin_get_vertices_by_range(g, vp, lo, hi, size);
+}
+
+GRIN_VERTEX* grin_get_vertices_by_property_range_of_string(
+    GRIN_GRAPH g, GRIN_VERTEX_PROPERTY vp, const char* lo, const char* hi,
+    size_t* size) {
+  return _grin_get_vertices_by_range(g, vp, std::string_view(lo),
+                                     std::string_view(hi), size);
+}
+
+void grin_destroy_vertex_array(GRIN_GRAPH g, GRIN_VERTEX* vertices) {
+  delete[] vertices;
+}
+#endif
@@ -19,6 +19,9 @@ limitations under the License.
 #include "vineyard/client/ds/blob.h"
 #include "vineyard/common/util/json.h"
 
+#include "fragment/blob_schema_etcd.h"
+#include "fragment/epoch_pin_etcd.h"
+
 #include "grin/src/predefine.h"
 
 #include "grin/include/include/partition/partition.h"
@@ -43,15 +46,10 @@ GRIN_PARTITIONED_GRAPH grin_get_partitioned_graph_from_storage(
   std::shared_ptr<etcd::Client> etcd_client =
       std::make_shared<etcd::Client>(etcd_endpoint);
 
-  std::string schema_key = pg->meta_prefix + "gart_blob_m" + std::to_string(0) +
-                           "_p" + std::to_string(0) + "_e" +
-                           std::to_string(pg->read_epoch);
-  etcd::Response response = etcd_client->get(schema_key).get();
-  assert(response.is_ok());
-  std::string graph_blob_config_str = response.value().as_string();
-
-  vineyard::json graph_blob_config =
-      vineyard::json::parse(graph_blob_config_str);
+  vineyard::json graph_blob_config;
+  bool found = gart::get_blob_schema(*etcd_client, pg->meta_prefix, 0,
+                                     pg->read_epoch, graph_blob_config);
+  assert(found);
   pg->total_partition_num = graph_blob_config["fnum"].get<uint64_t>();
 
   std::string v6d_socket = graph_blob_config["ipc_socket"].get<std::string>();
@@ -60,12 +58,9 @@ GRIN_PARTITIONED_GRAPH grin_get_partitioned_graph_from_storage(
   VINEYARD_CHECK_OK(v6d_client.Connect(v6d_socket));
 
   for (size_t idx = 0; idx < pg->total_partition_num; idx++) {
-    schema_key = pg->meta_prefix + "gart_blob_m" + std::to_string(0) + "_p" +
-                 std::to_string(idx) + "_e" + std::to_string(pg->read_epoch);
-    response = etcd_client->get(schema_key).get();
-    assert(response.is_ok());
-    graph_blob_config_str = response.value().as_string();
-    graph_blob_config = vineyard::json::parse(graph_blob_config_str);
+    found = gart::get_blob_schema(*etcd_client, pg->meta_prefix, idx,
+                                  pg->read_epoch, graph_blob_config);
+    assert(found);
 
     vineyard::InstanceID instance_id =
         graph_blob_config["instance_id"].get<uint64_t>();
@@ -76,6 +71,18 @@ GRIN_PARTITIONED_GRAPH grin_get_partitioned_graph_from_storage(
     pg->local_partition_list.push_back(idx);
   }
 
+  // pin the read epoch until the partitioned graph is destroyed
+  pg->epoch_pin = gart::pin_read_epoch(
+      etcd_client, pg->meta_prefix,
+      std::vector<uint64_t>(pg->local_partition_list.begin(),
+                            pg->local_partition_list.end()),
+      pg->read_epoch);
+  if (pg->epoch_pin == nullptr) {
+    // the epoch is (being) reclaimed
+    delete pg;
+    return GRIN_NULL_PARTITIONED_GRAPH;
+  }
+
   return pg;
 }
 
@@ -153,16 +160,12 @@ GRIN_GRAPH grin_get_local_graph_by_partition(GRIN_PARTITIONED_GRAPH pg,
   assert(response.is_ok());
   std::string graph_schema_config_str = response.value().as_string();
 
-  schema_key = _pg->meta_prefix + "gart_blob_m" + std::to_string(0) + "_p" +
-               std::to_string(p) + "_e" + std::to_string(_pg->read_epoch);
-  response = etcd_client->get(schema_key).get();
-  assert(response.is_ok());
-  std::string graph_blob_config_str = response.value().as_string();
-
   vineyard::json graph_schema_config =
       vineyard::json::parse(graph_schema_config_str);
-  vineyard::json graph_blob_config =
-      vineyard::json::parse(graph_blob_config_str);
+  vineyard::json graph_blob_config;
+  bool found = gart::get_blob_schema(*etcd_client, _pg->meta_prefix, p,
+                                     _pg->read_epoch, graph_blob_config);
+  assert(found);
 
   fragment->Init(graph_blob_config, graph_schema_config);
 
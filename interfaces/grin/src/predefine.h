@@ -17,7 +17,9 @@ limitations under the License.
 #define INTERFACES_GRIN_SRC_PREDEFINE_H_
 
 #include <map>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "etcd/Client.hpp"
 #include "etcd/Response.hpp"
@@ -25,6 +27,7 @@ limitations under the License.
 #include "vineyard/client/ds/blob.h"
 #include "vineyard/common/util/json.h"
 
+#include "fragment/epoch_pin_etcd.h"
 #include "fragment/gart_fragment.h"
 #include "fragment/iterator.h"
 #include "grin/predefine.h"
@@ -129,6 +132,9 @@ struct GRIN_PARTITIONED_GRAPH_T {
   std::vector<size_t> local_partition_list;
   int read_epoch;
   std::string meta_prefix;
+  // pin of read_epoch on the local partitions, so that the writers keep the
+  // blocks
+  std::shared_ptr<gart::EpochPin> epoch_pin;
 };
 
 typedef std::vector<size_t> GRIN_PARTITION_LIST_T;
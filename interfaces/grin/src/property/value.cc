@@ -262,8 +262,7 @@ const char* grin_get_edge_property_value_of_string(GRIN_GRAPH g, GRIN_EDGE e,
     auto offset = _g->edge_prop_offsets[e_type_id][prop_id - 1];
     fake_edata = *reinterpret_cast<int64_t*>(base_addr + offset);
   }
-  int64_t edata_offset = fake_edata >> 16;
-  return _g->GetStringBuffer() + edata_offset;
+  return _g->GetStringData(fake_edata);
 }
 
 int grin_get_edge_property_value_of_date32(GRIN_GRAPH g, GRIN_EDGE e,
@@ -323,8 +322,7 @@ const void* grin_get_edge_property_value(GRIN_GRAPH g, GRIN_EDGE e,
       return base_addr;
     } else {
       int64_t fake_edata = *reinterpret_cast<int64_t*>(base_addr);
-      int64_t edata_offset = fake_edata >> 16;
-      return _g->GetStringBuffer() + edata_offset;
+      return _g->GetStringData(fake_edata);
     }
   } else {
     auto offset = _g->edge_prop_offsets[e_type_id][prop_id - 1];
@@ -332,8 +330,7 @@ const void* grin_get_edge_property_value(GRIN_GRAPH g, GRIN_EDGE e,
       return base_addr + offset;
     } else {
       int64_t fake_edata = *reinterpret_cast<int64_t*>(base_addr + offset);
-      int64_t edata_offset = fake_edata >> 16;
-      return _g->GetStringBuffer() + edata_offset;
+      return _g->GetStringData(fake_edata);
     }
   }
 }
@@ -16,6 +16,7 @@ limitations under the License.
 #include "grin/src/predefine.h"
 
 #include "grin/include/include/topology/adjacentlist.h"
+#include "grin/adjacent_list_size.h"
 
 #if defined(GRIN_ENABLE_ADJACENT_LIST) && !defined(GRIN_ENABLE_SCHEMA)
 GRIN_ADJACENT_LIST grin_get_adjacent_list(GRIN_GRAPH, GRIN_DIRECTION,
@@ -26,6 +27,21 @@ GRIN_ADJACENT_LIST grin_get_adjacent_list(GRIN_GRAPH, GRIN_DIRECTION,
 void grin_destroy_adjacent_list(GRIN_GRAPH g, GRIN_ADJACENT_LIST adj_list) {}
 #endif
 
+#ifdef GRIN_ENABLE_ADJACENT_LIST_SIZE
+size_t grin_get_adjacent_list_size(GRIN_GRAPH g, GRIN_ADJACENT_LIST adj_list) {
+  auto _g = static_cast<GRIN_GRAPH_T*>(g)->frag;
+  auto v = _GRIN_VERTEX_T(adj_list.v);
+  size_t size = 0;
+  if (adj_list.dir != GRIN_DIRECTION::OUT) {
+    size += _g->GetLocalInDegree(v, adj_list.etype);
+  }
+  if (adj_list.dir != GRIN_DIRECTION::IN) {
+    size += _g->GetLocalOutDegree(v, adj_list.etype);
+  }
+  return size;
+}
+#endif
+
 #ifdef GRIN_ENABLE_ADJACENT_LIST_ITERATOR
 GRIN_ADJACENT_LIST_ITERATOR grin_get_adjacent_list_begin(
     GRIN_GRAPH g, GRIN_ADJACENT_LIST adj_list) {
@@ -369,7 +369,7 @@ def get_read_epoch_by_timestamp():
             )
             formatted_time = converted_time.strftime("%Y-%m-%d %H:%M:%S")
             previous_formatted_time = "-"
-            if epoch != 0:
+            if previous_unix_time_epoch != "-":
                 converted_time = datetime.fromtimestamp(previous_unix_time_epoch)
                 # convert time into local time zone
                 converted_time = converted_time.replace(tzinfo=timezone.utc).astimezone(
@@ -464,12 +464,14 @@ def change_read_epoch():
             while True:
                 try:
                     schema_str, _ = etcd_client.get(schema_key)
-                    if schema_str is not None:
-                        break
-                    time.sleep(5)
+                    break
                 except Exception as e:
                     time.sleep(5)
+            # the epoch is published, old epochs are pruned by the writers
+            if schema_str is None:
+                return "Read epoch has been pruned", 400
 
+        for idx in range(int(num_fragment)):
             cmd = f"curl -X POST http://{pod_base_name}-{idx}.{pod_service_name}:{pod_service_port}/start-gie-executor -d 'read_epoch={read_epoch}&etcd_prefix={etcd_prefix}&etcd_endpoint={etcd_server}'"
 
             launch_gie_executor_result = subprocess.run(
@@ -618,15 +620,23 @@ def get_all_available_read_epochs_internal():
         previous_timestamp = "-"
         num_vertices = 0
         num_edges = 0
+        pruned = False
         for frag_id in range(int(num_fragment)):
             schema_key = etcd_prefix + "gart_blob_m0" + f"_p{frag_id}" + f"_e{epoch}"
             schema_str, _ = etcd_client.get(schema_key)
+            # old epochs are pruned by the writers
+            if schema_str is None:
+                pruned = True
+                break
+            # deltas keep the scalar fields of full schemas
             schema = json.loads(schema_str)
             unix_timestamp = schema["timestamp"]
             num_vertices += schema["total_vertex_num"]
             num_edges += schema["total_edge_num"]
             if latest_timestamp is None or unix_timestamp > latest_timestamp:
                 latest_timestamp = unix_timestamp
+        if pruned:
+            continue
         converted_time = datetime.fromtimestamp(latest_timestamp)
         # convert time into local time zone
         converted_time = converted_time.replace(tzinfo=timezone.utc).astimezone(tz=None)
@@ -638,9 +648,9 @@ def get_all_available_read_epochs_internal():
             [epoch, previous_timestamp, latest_timestamp, num_vertices, num_edges]
         )
 
-    for epoch in range(latest_read_epoch, 0, -1):
-        available_epochs[epoch][1] = available_epochs[epoch - 1][2]
-        available_epochs_internal[epoch][1] = available_epochs_internal[epoch - 1][2]
+    for idx in range(len(available_epochs) - 1, 0, -1):
+        available_epochs[idx][1] = available_epochs[idx - 1][2]
+        available_epochs_internal[idx][1] = available_epochs_internal[idx - 1][2]
 
     return [available_epochs, available_epochs_internal]
 
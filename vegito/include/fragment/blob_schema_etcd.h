@@ -0,0 +1,96 @@
+/** Copyright 2020-2023 Alibaba Group Holding Limited.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef VEGITO_INCLUDE_FRAGMENT_BLOB_SCHEMA_ETCD_H_
+#define VEGITO_INCLUDE_FRAGMENT_BLOB_SCHEMA_ETCD_H_
+
+#include <cstdint>
+#include <string>
+#include <utility>
+
+#include "etcd/Client.hpp"
+#include "etcd/Response.hpp"
+#include "vineyard/common/util/json.h"
+
+namespace gart {
+
+/**
+ * Blob schemas published to etcd, one per fragment and epoch.
+ *
+ * The writer publishes the full schema (a checkpoint) every few epochs, and
+ * a delta at the other epochs. A delta keeps the scalar fields of the
+ * schema (epoch, fnum, instance_id, timestamp, ...), and a JSON patch
+ * (RFC 6902) from the checkpoint at "checkpoint_epoch" to the schema, so a
+ * reader needs at most two gets. Old epochs are pruned by the writer, except
+ * those pinned by readers (see EpochPin).
+ */
+inline std::string get_blob_schema_key(const std::string& meta_prefix,
+                                       uint64_t fid, uint64_t epoch) {
+  return meta_prefix + "gart_blob_m" + std::to_string(0) + "_p" +
+         std::to_string(fid) + "_e" + std::to_string(epoch);
+}
+
+inline bool is_blob_schema_delta(const vineyard::json& schema) {
+  return schema.contains("checkpoint_epoch");
+}
+
+// the patch is built by the writer from the fields changed since the
+// checkpoint (see BlobSchema::append_patch), the scalar fields are taken
+// from schema
+inline vineyard::json make_blob_schema_delta(const vineyard::json& schema,
+                                             uint64_t checkpoint_epoch,
+                                             vineyard::json patch) {
+  vineyard::json delta;
+  for (auto iter = schema.begin(); iter != schema.end(); ++iter) {
+    if (iter.value().is_primitive()) {
+      delta[iter.key()] = iter.value();
+    }
+  }
+  delta["checkpoint_epoch"] = checkpoint_epoch;
+  delta["patch"] = std::move(patch);
+  return delta;
+}
+
+// the full blob schema of the fragment at the epoch, return false if the
+// epoch is not published yet or has been pruned
+inline bool get_blob_schema(etcd::Client& etcd_client,
+                            const std::string& meta_prefix, uint64_t fid,
+                            uint64_t epoch, vineyard::json& schema) {
+  etcd::Response response =
+      etcd_client.get(get_blob_schema_key(meta_prefix, fid, epoch)).get();
+  if (!response.is_ok()) {
+    return false;
+  }
+  schema = vineyard::json::parse(response.value().as_string());
+  if (!is_blob_schema_delta(schema)) {
+    return true;
+  }
+
+  uint64_t checkpoint_epoch = schema["checkpoint_epoch"].get<uint64_t>();
+  response = etcd_client
+                 .get(get_blob_schema_key(meta_prefix, fid, checkpoint_epoch))
+                 .get();
+  if (!response.is_ok()) {
+    return false;
+  }
+  vineyard::json checkpoint =
+      vineyard::json::parse(response.value().as_string());
+  schema = checkpoint.patch(schema["patch"]);
+  return true;
+}
+
+}  // namespace gart
+
+#endif  // VEGITO_INCLUDE_FRAGMENT_BLOB_SCHEMA_ETCD_H_
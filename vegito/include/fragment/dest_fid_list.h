@@ -0,0 +1,85 @@
+/** Copyright 2020-2023 Alibaba Group Holding Limited.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef VEGITO_INCLUDE_FRAGMENT_DEST_FID_LIST_H_
+#define VEGITO_INCLUDE_FRAGMENT_DEST_FID_LIST_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace gart {
+
+// Remote fragments adjacent to the inner vertices of a chunk (see
+// DestFidChunks) along an edge label, for the messages to outer vertices
+// (DestList of grape), in CSR form. The fids of vertex i of the chunk are
+// grouped as [in-only, in and out, out-only], starting at
+// offsets[3 * i], offsets[3 * i + 1] and offsets[3 * i + 2], and ending at
+// offsets[3 * (i + 1)], so the fids along incoming, outgoing or both
+// directions are contiguous. Vertices at or beyond vertex_num have none.
+struct DestFidList {
+  using fid_t = uint32_t;  // as grape::fid_t
+
+  static size_t size_of(uint64_t vertex_num, uint64_t fid_num) {
+    return sizeof(DestFidList) + (3 * vertex_num + 1) * sizeof(uint64_t) +
+           fid_num * sizeof(fid_t);
+  }
+
+  const fid_t* get_fids() const {
+    return reinterpret_cast<const fid_t*>(offsets + 3 * vertex_num + 1);
+  }
+
+  fid_t* get_fids() {
+    return reinterpret_cast<fid_t*>(offsets + 3 * vertex_num + 1);
+  }
+
+  // [begin, end) of the fids of vertex i along incoming edges (in_edge),
+  // outgoing edges (out_edge), or both
+  const fid_t* begin(uint64_t i, bool in_edge) const {
+    return get_fids() + offsets[3 * i + (in_edge ? 0 : 1)];
+  }
+
+  const fid_t* end(uint64_t i, bool out_edge) const {
+    return get_fids() + offsets[3 * i + (out_edge ? 3 : 2)];
+  }
+
+  uint64_t vertex_num;
+  uint64_t fid_num;
+  uint64_t offsets[0];
+};
+
+// The lists of an edge label, one per chunk of 1 << chunk_bits inner
+// vertices, so that the writer only rebuilds the chunks changed during an
+// epoch and the other chunks are shared by the snapshots. A chunk without
+// fids has no list.
+struct DestFidChunks {
+  // the list of the chunk of inner vertex offset, and the index of the
+  // vertex in it, nullptr if the vertex has no fids
+  const DestFidList* get(uint64_t offset, uint64_t& idx) const {
+    uint64_t chunk = offset >> chunk_bits;
+    if (chunk >= chunks.size() || chunks[chunk] == nullptr) {
+      return nullptr;
+    }
+    idx = offset & ((1ul << chunk_bits) - 1);
+    return idx < chunks[chunk]->vertex_num ? chunks[chunk] : nullptr;
+  }
+
+  int chunk_bits = 0;
+  std::vector<const DestFidList*> chunks;
+};
+
+}  // namespace gart
+
+#endif  // VEGITO_INCLUDE_FRAGMENT_DEST_FID_LIST_H_
@@ -0,0 +1,180 @@
+/** Copyright 2020-2023 Alibaba Group Holding Limited.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef VEGITO_INCLUDE_FRAGMENT_EPOCH_PIN_ETCD_H_
+#define VEGITO_INCLUDE_FRAGMENT_EPOCH_PIN_ETCD_H_
+
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "etcd/Client.hpp"
+#include "etcd/KeepAlive.hpp"
+#include "etcd/Response.hpp"
+
+namespace gart {
+
+// readers of fragment fid put their pinned epochs under this prefix
+inline std::string get_pinned_epoch_prefix(const std::string& meta_prefix,
+                                           uint64_t fid) {
+  return meta_prefix + "gart_pinned_epoch_p" + std::to_string(fid) + "_";
+}
+
+// the writer of fragment fid may reclaim what readers of epochs before the
+// floor need, see EpochPin
+inline std::string get_reclaim_floor_key(const std::string& meta_prefix,
+                                         uint64_t fid) {
+  return meta_prefix + "gart_reclaim_floor_p" + std::to_string(fid);
+}
+
+// parse an epoch put by GART, return false if the value is malformed
+inline bool parse_epoch(const std::string& value, int64_t& epoch) {
+  if (value.empty()) {
+    return false;
+  }
+  char* end = nullptr;
+  epoch = std::strtoll(value.c_str(), &end, 10);
+  return *end == '\0';
+}
+
+/**
+ * The pin of the read epoch of a reader on some fragments. The writer of a
+ * fragment keeps the blocks, strings, index nodes and blob schemas that
+ * readers of pinned epochs need (see GraphStore::advance_safe_epoch).
+ *
+ * Pin() pins every epoch (or the read epoch if it is known), before the
+ * reader chooses its read epoch, and Narrow() then checks the read epoch
+ * against the floor published by the writers and moves the pin to it. A
+ * writer publishes a higher floor before it lists the pins again, so it
+ * either sees the pin or the reader sees the floor.
+ *
+ * The pin keys are attached to a lease kept alive by the pin, so the pins of
+ * crashed readers expire after ttl seconds.
+ */
+class EpochPin {
+ public:
+  static constexpr int DEFAULT_TTL = 30;  // in seconds
+
+  EpochPin(std::shared_ptr<etcd::Client> etcd_client, std::string meta_prefix,
+           std::vector<uint64_t> fids, int ttl = DEFAULT_TTL)
+      : etcd_client_(std::move(etcd_client)),
+        meta_prefix_(std::move(meta_prefix)),
+        fids_(std::move(fids)),
+        ttl_(ttl) {}
+
+  EpochPin(const EpochPin&) = delete;
+  EpochPin& operator=(const EpochPin&) = delete;
+
+  ~EpochPin() { Unpin(); }
+
+  // pin the epochs from epoch on, return false if etcd fails
+  bool Pin(uint64_t epoch = 0) {
+    Unpin();
+    try {
+      keep_alive_ = std::make_unique<etcd::KeepAlive>(*etcd_client_, ttl_);
+    } catch (const std::exception& e) {
+      keep_alive_.reset();
+      return false;
+    }
+    lease_id_ = keep_alive_->Lease();
+    return put_pins(epoch);
+  }
+
+  // pin epoch only, return false if it may be reclaimed by some writer
+  bool Narrow(uint64_t epoch) {
+    if (!keep_alive_) {
+      return false;
+    }
+    for (auto fid : fids_) {
+      auto response =
+          etcd_client_->get(get_reclaim_floor_key(meta_prefix_, fid)).get();
+      if (!response.is_ok()) {
+        // nothing has been reclaimed yet
+        if (response.error_code() == etcd::ERROR_KEY_NOT_FOUND) {
+          continue;
+        }
+        return false;
+      }
+      int64_t floor;
+      if (!parse_epoch(response.value().as_string(), floor) ||
+          static_cast<int64_t>(epoch) < floor) {
+        return false;
+      }
+    }
+    return epoch == pinned_epoch_ || put_pins(epoch);
+  }
+
+  void Unpin() {
+    if (!keep_alive_) {
+      return;
+    }
+    keep_alive_->Cancel();
+    keep_alive_.reset();
+    // the pin keys are deleted with the lease
+    etcd_client_->leaserevoke(lease_id_).wait();
+  }
+
+ private:
+  bool put_pins(uint64_t epoch) {
+    for (auto fid : fids_) {
+      std::string key = get_pinned_epoch_prefix(meta_prefix_, fid) +
+                        std::to_string(lease_id_);
+      auto response =
+          etcd_client_->set(key, std::to_string(epoch), lease_id_).get();
+      if (!response.is_ok()) {
+        return false;
+      }
+    }
+    pinned_epoch_ = epoch;
+    return true;
+  }
+
+  std::shared_ptr<etcd::Client> etcd_client_;
+  const std::string meta_prefix_;
+  const std::vector<uint64_t> fids_;
+  const int ttl_;
+  std::unique_ptr<etcd::KeepAlive> keep_alive_;
+  int64_t lease_id_ = 0;
+  uint64_t pinned_epoch_ = 0;
+};
+
+// pin epoch of the fragments, return nullptr if the epoch may be reclaimed
+inline std::shared_ptr<EpochPin> pin_read_epoch(
+    std::shared_ptr<etcd::Client> etcd_client, const std::string& meta_prefix,
+    std::vector<uint64_t> fids, uint64_t epoch) {
+  auto pin = std::make_shared<EpochPin>(std::move(etcd_client), meta_prefix,
+                                        std::move(fids));
+  if (!pin->Pin(epoch) || !pin->Narrow(epoch)) {
+    return nullptr;
+  }
+  return pin;
+}
+
+// a fragment that keeps its read epoch pinned until it is destroyed: the pin
+// is owned by the deleter, so that the epoch stays pinned as long as any
+// copy of the pointer is held, e.g., by a cache and by the requests using a
+// fragment evicted from it
+template <typename FRAG_T>
+std::shared_ptr<FRAG_T> make_pinned_fragment(std::shared_ptr<EpochPin> pin) {
+  return std::shared_ptr<FRAG_T>(
+      new FRAG_T(), [pin](FRAG_T* fragment) { delete fragment; });
+}
+
+}  // namespace gart
+
+#endif  // VEGITO_INCLUDE_FRAGMENT_EPOCH_PIN_ETCD_H_
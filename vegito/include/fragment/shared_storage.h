@@ -17,6 +17,8 @@
 #define VEGITO_INCLUDE_FRAGMENT_SHARED_STORAGE_H_
 
 #include <algorithm>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include "vineyard/common/util/json.h"
@@ -127,6 +129,13 @@ struct VTableMeta {
     min_outer_location = max - outer_loc;
   }
 
+  bool operator==(const VTableMeta& other) const {
+    return object_id == other.object_id && max == other.max &&
+           max_inner == other.max_inner && min_outer == other.min_outer &&
+           max_inner_location == other.max_inner_location &&
+           min_outer_location == other.min_outer_location;
+  }
+
  private:
   // object id for Blob
   oid_t object_id;
@@ -163,6 +172,10 @@ struct ArrayMeta {
     return res;
   }
 
+  bool operator==(const ArrayMeta& other) const {
+    return object_id == other.object_id && len_ele == other.len_ele;
+  }
+
  private:
   oid_t object_id;   // Blob of the ELabel2Seg
   uint64_t len_ele;  // size of array in number of elements
@@ -199,46 +212,161 @@ struct VPropMeta {
   bool updatable;
 };
 
+// Meta for each secondary index of a vertex property, see
+// util/property_index.h
+struct VPropIndexMeta {
+  VPropIndexMeta() {}
+
+  VPropIndexMeta(int prop_id, int type, oid_t object_id)
+      : prop_id(prop_id), type(type), object_id(object_id) {}
+
+  vineyard::json json() const {
+    using json = vineyard::json;
+    json res;
+    res["prop_id"] = prop_id;
+    res["type"] = type;
+    res["object_id"] = object_id;
+    return res;
+  }
+
+ private:
+  int prop_id;
+  int type;         // PropertyIndexType
+  oid_t object_id;  // the first chunk, with the header of the index
+};
+
+// Meta for the DestFidChunks (see fragment/dest_fid_list.h) of an edge
+// label, only for edge labels with edges to outer vertices. object_ids are
+// the lists of the chunks, 0 for chunks without fids
+struct DestFidListMeta {
+  DestFidListMeta() {}
+
+  DestFidListMeta(int elabel, int chunk_bits, std::vector<oid_t> object_ids)
+      : elabel(elabel),
+        chunk_bits(chunk_bits),
+        object_ids(std::move(object_ids)) {}
+
+  vineyard::json json() const {
+    using json = vineyard::json;
+    json res;
+    res["elabel"] = elabel;
+    res["chunk_bits"] = chunk_bits;
+    res["object_ids"] = object_ids;
+    return res;
+  }
+
+  bool operator==(const DestFidListMeta& other) const {
+    return elabel == other.elabel && chunk_bits == other.chunk_bits &&
+           object_ids == other.object_ids;
+  }
+
+ private:
+  int elabel;
+  int chunk_bits;
+  std::vector<oid_t> object_ids;
+};
+
 // Schema for each vertex label
 class BlobSchema {
  public:
+  // groups of fields in json(), the setters mark those changed as dirty
+  enum Field : uint32_t {
+    BLOCK_OIDS = 1 << 0,
+    ELABEL2SEG = 1 << 1,
+    VPROPS = 1 << 2,
+    VPROP_INDEXES = 1 << 3,
+    EXTERNAL_ID = 1 << 4,
+    OVG2L = 1 << 5,
+    VERTEX_MAP = 1 << 6,
+    DEST_FID_LISTS = 1 << 7,
+    OV_BLOCK_OIDS = 1 << 8,
+    OV_ELABEL2SEG = 1 << 9,
+    VERTEX_TABLE = 1 << 10,
+    OVL2G = 1 << 11,
+    VERTEX_NUMS = 1 << 12,
+    ALL_FIELDS = (1 << 13) - 1,
+  };
+
   BlobSchema() {}
 
   void set_vlabel(uint64_t v) { vlabel = v; }
 
-  void set_block_oid(oid_t oid) { block_oid = oid; }
+  void set_block_oids(const std::vector<oid_t>& oids, int arena_bits) {
+    set_(block_oids, oids, BLOCK_OIDS);
+    set_(block_arena_bits, arena_bits, BLOCK_OIDS);
+  }
 
-  void set_elabel2segs(const ArrayMeta& meta) { elabel2seg = meta; }
+  void set_elabel2segs(const ArrayMeta& meta) {
+    set_(elabel2seg, meta, ELABEL2SEG);
+  }
 
-  void set_ov_block_oid(oid_t oid) { ov_block_oid = oid; }
+  void set_ov_block_oids(const std::vector<oid_t>& oids, int arena_bits) {
+    set_(ov_block_oids, oids, OV_BLOCK_OIDS);
+    set_(ov_block_arena_bits, arena_bits, OV_BLOCK_OIDS);
+  }
 
-  void set_ov_elabel2segs(const ArrayMeta& meta) { ov_elabel2seg = meta; }
+  void set_ov_elabel2segs(const ArrayMeta& meta) {
+    set_(ov_elabel2seg, meta, OV_ELABEL2SEG);
+  }
 
-  void set_vtable_meta(const VTableMeta& meta) { vertex_table = meta; }
+  void set_vtable_meta(const VTableMeta& meta) {
+    set_(vertex_table, meta, VERTEX_TABLE);
+  }
 
-  void set_ovl2g_meta(const ArrayMeta& meta) { ovl2g = meta; }
+  void set_ovl2g_meta(const ArrayMeta& meta) { set_(ovl2g, meta, OVL2G); }
 
   void set_vtable_bound(uint64_t num_inner, uint64_t num_outer) {
-    vertex_table.set_boundary(num_inner, num_outer);
+    VTableMeta meta = vertex_table;
+    meta.set_boundary(num_inner, num_outer);
+    set_(vertex_table, meta, VERTEX_TABLE);
   }
 
   void set_vtable_location(uint64_t loc_inner, uint64_t loc_outer) {
-    vertex_table.set_loc(loc_inner, loc_outer);
+    VTableMeta meta = vertex_table;
+    meta.set_loc(loc_inner, loc_outer);
+    set_(vertex_table, meta, VERTEX_TABLE);
+  }
+
+  void set_vertex_nums(uint64_t num_inner, uint64_t num_outer) {
+    set_(inner_vertex_num, num_inner, VERTEX_NUMS);
+    set_(outer_vertex_num, num_outer, VERTEX_NUMS);
   }
 
-  void set_prop_meta(const std::vector<VPropMeta>& meta) { vprops = meta; }
+  void set_prop_meta(const std::vector<VPropMeta>& meta) {
+    vprops = meta;
+    dirty_ |= VPROPS;
+  }
+
+  void add_prop_index_meta(const VPropIndexMeta& meta) {
+    vprop_indexes.push_back(meta);
+    dirty_ |= VPROP_INDEXES;
+  }
+
+  void set_dest_fid_list_meta(const std::vector<DestFidListMeta>& meta) {
+    set_(dest_fid_lists, meta, DEST_FID_LISTS);
+  }
 
-  void set_external_id_oid(oid_t oid) { external_id_oid = oid; }
+  void set_external_id_oid(oid_t oid) {
+    set_(external_id_oid, oid, EXTERNAL_ID);
+  }
 
-  void set_outer_external_id_oid(oid_t oid) { outer_external_id_oid = oid; }
+  void set_outer_external_id_oid(oid_t oid) {
+    set_(outer_external_id_oid, oid, EXTERNAL_ID);
+  }
 
-  void set_external_id_dtype(int dtype) { external_id_dtype = dtype; }
+  void set_external_id_dtype(int dtype) {
+    set_(external_id_dtype, dtype, EXTERNAL_ID);
+  }
 
-  void set_ovg2l_oid(oid_t oid) { ov_g2l_blob_oid = oid; }
+  void set_ovg2l_oid(oid_t oid) { set_(ov_g2l_blob_oid, oid, OVG2L); }
+
+  void set_vertex_map_oid(oid_t oid) {
+    set_(vertex_map_oid_, oid, VERTEX_MAP);
+  }
 
-  void set_vertex_map_oid(oid_t oid) { vertex_map_oid_ = oid; }
+  const std::vector<oid_t>& get_block_oids() const { return block_oids; }
 
-  oid_t get_block_oid() const { return block_oid; }
+  int get_block_arena_bits() const { return block_arena_bits; }
 
   oid_t get_vertex_table_oid() const { return vertex_table.get_object_id(); }
 
@@ -247,43 +375,110 @@ class BlobSchema {
   const ArrayMeta& get_elabel2segs() const { return elabel2seg; }
 
   vineyard::json json() const {
-    using json = vineyard::json;
-
-    json single_blob_schema;
+    vineyard::json single_blob_schema;
     single_blob_schema["vlabel"] = vlabel;
-    single_blob_schema["block_oid"] = block_oid;
-    single_blob_schema["elabel2seg"] = elabel2seg.json();
-    single_blob_schema["num_vprops"] = vprops.size();
-    single_blob_schema["ovg2l_blob"] = ov_g2l_blob_oid;
-    single_blob_schema["external_id_oid"] = external_id_oid;
-    single_blob_schema["outer_external_id_oid"] = outer_external_id_oid;
-
-    if (external_id_dtype == 8) {
-      single_blob_schema["external_id_dtype"] = "STRING";
-    } else {
-      single_blob_schema["external_id_dtype"] = "INT64";
+    fill_json_(ALL_FIELDS, single_blob_schema);
+    return single_blob_schema;
+  }
+
+  // JSON patch (RFC 6902) ops replacing the fields changed since the last
+  // clear_dirty(), with the schema at path, see fragment/blob_schema_etcd.h
+  void append_patch(const std::string& path, vineyard::json& patch) const {
+    vineyard::json fields;
+    fill_json_(dirty_, fields);
+    for (auto iter = fields.begin(); iter != fields.end(); ++iter) {
+      patch.push_back({{"op", "replace"},
+                       {"path", path + "/" + iter.key()},
+                       {"value", iter.value()}});
     }
-    single_blob_schema["vertex_map_oid"] = vertex_map_oid_;
+  }
 
-    json vprop_schema = json::array();
+  // after a full schema is published
+  void clear_dirty() { dirty_ = 0; }
 
-    for (const auto& vprop : vprops) {
-      vprop_schema.push_back(vprop.json());
+ private:
+  template <typename T>
+  void set_(T& field, const T& value, uint32_t mask) {
+    if (!(field == value)) {
+      field = value;
+      dirty_ |= mask;
     }
+  }
 
-    single_blob_schema["vprops"] = vprop_schema;
-    single_blob_schema["ov_block_oid"] = ov_block_oid;
-    single_blob_schema["ov_elabel2seg"] = ov_elabel2seg.json();
-    single_blob_schema["vertex_table"] = vertex_table.json();
-    single_blob_schema["ovl2g"] = ovl2g.json();
+  void fill_json_(uint32_t fields, vineyard::json& res) const {
+    using json = vineyard::json;
 
-    return single_blob_schema;
+    if (fields & BLOCK_OIDS) {
+      res["block_oids"] = block_oids;
+      res["block_arena_bits"] = block_arena_bits;
+    }
+    if (fields & ELABEL2SEG) {
+      res["elabel2seg"] = elabel2seg.json();
+    }
+    if (fields & OVG2L) {
+      res["ovg2l_blob"] = ov_g2l_blob_oid;
+    }
+    if (fields & EXTERNAL_ID) {
+      res["external_id_oid"] = external_id_oid;
+      res["outer_external_id_oid"] = outer_external_id_oid;
+      if (external_id_dtype == 8) {
+        res["external_id_dtype"] = "STRING";
+      } else {
+        res["external_id_dtype"] = "INT64";
+      }
+    }
+    if (fields & VERTEX_MAP) {
+      res["vertex_map_oid"] = vertex_map_oid_;
+    }
+
+    if (fields & VPROPS) {
+      res["num_vprops"] = vprops.size();
+      json vprop_schema = json::array();
+      for (const auto& vprop : vprops) {
+        vprop_schema.push_back(vprop.json());
+      }
+      res["vprops"] = vprop_schema;
+    }
+
+    if (fields & VPROP_INDEXES) {
+      json vprop_index_schema = json::array();
+      for (const auto& vprop_index : vprop_indexes) {
+        vprop_index_schema.push_back(vprop_index.json());
+      }
+      res["vprop_indexes"] = vprop_index_schema;
+    }
+
+    if (fields & DEST_FID_LISTS) {
+      json dest_fid_list_schema = json::array();
+      for (const auto& dest_fid_list : dest_fid_lists) {
+        dest_fid_list_schema.push_back(dest_fid_list.json());
+      }
+      res["dest_fid_lists"] = dest_fid_list_schema;
+    }
+    if (fields & OV_BLOCK_OIDS) {
+      res["ov_block_oids"] = ov_block_oids;
+      res["ov_block_arena_bits"] = ov_block_arena_bits;
+    }
+    if (fields & OV_ELABEL2SEG) {
+      res["ov_elabel2seg"] = ov_elabel2seg.json();
+    }
+    if (fields & VERTEX_TABLE) {
+      res["vertex_table"] = vertex_table.json();
+    }
+    if (fields & OVL2G) {
+      res["ovl2g"] = ovl2g.json();
+    }
+    if (fields & VERTEX_NUMS) {
+      res["inner_vertex_num"] = inner_vertex_num;
+      res["outer_vertex_num"] = outer_vertex_num;
+    }
   }
 
- private:
   uint64_t vlabel;
 
-  oid_t block_oid;       // Blob of blocks created by BlockManger
+  // arenas of blocks created by BlockManager, see seggraph::BlockArenas
+  std::vector<oid_t> block_oids;
+  int block_arena_bits;
   ArrayMeta elabel2seg;  // indexed by vertex label
   oid_t ov_g2l_blob_oid;
 
@@ -295,12 +490,21 @@ class BlobSchema {
   oid_t vertex_map_oid_;
 
   std::vector<VPropMeta> vprops;
+  std::vector<VPropIndexMeta> vprop_indexes;
+  std::vector<DestFidListMeta> dest_fid_lists;
 
-  oid_t ov_block_oid;
+  std::vector<oid_t> ov_block_oids;
+  int ov_block_arena_bits;
   ArrayMeta ov_elabel2seg;
 
   VTableMeta vertex_table;  // indexed by vertex label
   ArrayMeta ovl2g;          // indexed by vertex label, array
+
+  // live vertices at the epoch
+  uint64_t inner_vertex_num = 0;
+  uint64_t outer_vertex_num = 0;
+
+  uint32_t dirty_ = ALL_FIELDS;  // Field
 };
 
 }  // namespace gart
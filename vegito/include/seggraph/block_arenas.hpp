@@ -0,0 +1,100 @@
+/** Copyright 2020-2023 Alibaba Group Holding Limited.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace seggraph {
+
+/**
+ * Address the blocks of a SegGraph, shared by the writer (BlockManager) and
+ * the readers (GartFragment, gart::EdgeIterator).
+ *
+ * Blocks are referred to by offsets in a single offset space, which is
+ * backed by arenas (vineyard blobs) of 2^arena_bits bytes allocated on
+ * demand: the arena of an offset is offset >> arena_bits. A block never
+ * crosses arenas, except a block larger than an arena, which has a blob of
+ * its own taking consecutive arena indexes, so the bytes of every block are
+ * contiguous.
+ *
+ * Arenas are published with release semantics, so a writer may add arenas
+ * while other writers are converting offsets.
+ */
+class BlockArenas {
+ public:
+  BlockArenas() = default;
+
+  BlockArenas(const BlockArenas& other) { *this = other; }
+
+  BlockArenas(BlockArenas&&) = default;
+
+  BlockArenas& operator=(const BlockArenas& other) {
+    if (this != &other) {
+      init(other.arena_bits_, other.max_arena_num_);
+      for (size_t idx = 0; idx < max_arena_num_; idx++) {
+        set_arena(idx, other.get_arena(idx));
+      }
+    }
+    return *this;
+  }
+
+  BlockArenas& operator=(BlockArenas&&) = default;
+
+  void init(int arena_bits, size_t max_arena_num) {
+    arena_bits_ = arena_bits;
+    arena_mask_ = (1ul << arena_bits) - 1;
+    max_arena_num_ = max_arena_num;
+    arenas_.reset(new std::atomic<char*>[max_arena_num]);
+    for (size_t idx = 0; idx < max_arena_num; idx++) {
+      arenas_[idx].store(nullptr, std::memory_order_relaxed);
+    }
+  }
+
+  int get_arena_bits() const { return arena_bits_; }
+
+  size_t get_arena_size() const { return 1ul << arena_bits_; }
+
+  size_t get_max_arena_num() const { return max_arena_num_; }
+
+  size_t get_arena_idx(uintptr_t offset) const { return offset >> arena_bits_; }
+
+  char* get_arena(size_t idx) const {
+    return arenas_[idx].load(std::memory_order_acquire);
+  }
+
+  void set_arena(size_t idx, char* arena) {
+    arenas_[idx].store(arena, std::memory_order_release);
+  }
+
+  char* get(uintptr_t offset) const {
+    return get_arena(offset >> arena_bits_) + (offset & arena_mask_);
+  }
+
+  template <typename T>
+  T* convert(uintptr_t offset) const {
+    return reinterpret_cast<T*>(get(offset));
+  }
+
+ private:
+  int arena_bits_ = 0;
+  uint64_t arena_mask_ = 0;
+  size_t max_arena_num_ = 0;
+  std::unique_ptr<std::atomic<char*>[]> arenas_;
+};
+
+}  // namespace seggraph
@@ -24,14 +24,19 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <iostream>
+#include <mutex>
 #include <vector>
 
 #include "common/util/likely.h"
 #include "glog/logging.h"
 #include "tbb/enumerable_thread_specific.h"
 
+#include "seggraph/block_arenas.hpp"
 #include "seggraph/types.hpp"
+#include "util/allocator.hpp"
 
 namespace seggraph {
 class BlockManager {
@@ -48,20 +53,70 @@ class BlockManager {
         used_size(0),
         fd(EMPTY_FD),
         file_size(FILE_TRUNC_SIZE),
-        data(nullptr),
+        allocator(nullptr),
         enough(false),
         free_blocks(std::vector<std::vector<uintptr_t>>(
             LARGE_BLOCK_THRESHOLD, std::vector<uintptr_t>())),
-        large_free_blocks(MAX_ORDER, std::vector<uintptr_t>()) {
-    null_holder = alloc(LARGE_BLOCK_THRESHOLD);
-  }
+        large_free_blocks(MAX_ORDER, std::vector<uintptr_t>()),
+        recycled_blocks(LARGE_BLOCK_THRESHOLD, std::vector<uintptr_t>()),
+        free_size(0),
+        num_recycled_blocks(0),
+        null_holder(NULLPOINTER) {}
 
   ~BlockManager() {
-    free(null_holder, LARGE_BLOCK_THRESHOLD);
     if (fd != EMPTY_FD)
       close(fd);
   }
 
+  // Blocks are stored in arenas of arena_size (rounded up to a power of 2)
+  // bytes, allocated from vineyard by _allocator when the blocks reach them,
+  // up to the capacity. The first arena is allocated here.
+  void init_arenas(SparseArrayAllocator* _allocator, size_t arena_size) {
+    allocator = _allocator;
+    int arena_bits = 0;
+    while ((1ul << arena_bits) < std::min(arena_size, capacity)) {
+      arena_bits++;
+    }
+    size_t max_arena_num = (capacity + (1ul << arena_bits) - 1) >> arena_bits;
+    arenas.init(arena_bits, max_arena_num);
+    arena_oids.assign(max_arena_num, EMPTY_ARENA);
+    if (!alloc_arenas(0, 1)) {
+      LOG(FATAL) << "BlockManager: failed to allocate the first arena."
+                 << " VertexLabel: " << vlabel;
+    }
+    // offset 0 is NULLPOINTER
+    null_holder = alloc(LARGE_BLOCK_THRESHOLD);
+  }
+
+  // delete the arenas, called by the owner of the allocator
+  void release_arenas() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (size_t idx = 0; idx < arena_oids.size(); idx++) {
+      if (arena_oids[idx] != EMPTY_ARENA &&
+          (idx == 0 || arena_oids[idx] != arena_oids[idx - 1])) {
+        allocator->deallocate_v6d(arena_oids[idx]);
+      }
+    }
+    arena_oids.assign(arena_oids.size(), EMPTY_ARENA);
+  }
+
+  // object ids of the arenas up to the last allocated one (EMPTY_ARENA for
+  // holes), a block larger than an arena repeats its object id, see
+  // BlockArenas
+  std::vector<vineyard::ObjectID> get_arena_oids() {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t num = arena_oids.size();
+    while (num > 0 && arena_oids[num - 1] == EMPTY_ARENA) {
+      num--;
+    }
+    return std::vector<vineyard::ObjectID>(arena_oids.begin(),
+                                           arena_oids.begin() + num);
+  }
+
+  int get_arena_bits() const { return arenas.get_arena_bits(); }
+
+  const BlockArenas& get_arenas() const { return arenas; }
+
   void print_free_blocks_info() {
     std::cout << "Free blocks info: " << std::endl;
     for (int i = 0; i < LARGE_BLOCK_THRESHOLD; i++) {
@@ -72,43 +127,66 @@ class BlockManager {
       std::cout << "  number of free blocks whose order = " << i << " : "
                 << large_free_blocks[i].size() << std::endl;
     }
+    std::cout << "  number of recycled blocks: " << num_recycled_blocks
+              << std::endl;
   }
 
-  size_t getUsedMemory() {
-    size_t ret = used_size;
-    for (int i = 0; i < LARGE_BLOCK_THRESHOLD; i++) {
-      ret -= free_blocks.local()[i].size() * (1ul << i);
-    }
-    for (int i = LARGE_BLOCK_THRESHOLD; i < LARGE_BLOCK_THRESHOLD + 20; i++) {
-      ret -= large_free_blocks[i].size() * (1ul << i);
-    }
-    return ret;
-  }
+  // bytes handed out and not freed, including blocks in all free lists
+  size_t getUsedMemory() { return used_size - free_size; }
 
-  void init_buffer(char* ptr) { data = ptr; }
+  size_t getCapacity() const { return capacity; }
+
+  // bytes of the arenas allocated from vineyard
+  size_t getAllocatedMemory() const { return allocated_size; }
 
   uintptr_t alloc(order_t order) {
     uintptr_t pointer = NULLPOINTER;
     if (order < LARGE_BLOCK_THRESHOLD) {
       pointer = pop(free_blocks.local(), order);
+      if (pointer == NULLPOINTER && num_recycled_blocks > 0) {
+        std::lock_guard<std::mutex> lock(mutex);
+        pointer = pop(recycled_blocks, order);
+        if (pointer != NULLPOINTER)
+          num_recycled_blocks--;
+      }
     } else {
       std::lock_guard<std::mutex> lock(mutex);
       pointer = pop(large_free_blocks, order);
     }
 
-    if (pointer == NULLPOINTER) {
+    if (pointer != NULLPOINTER) {
+      free_size -= 1ul << order;
+    } else {
       size_t block_size = 1ul << order;
-      pointer = used_size.fetch_add(block_size);
-      size_t used_memory = getUsedMemory();
-
-      if (unlikely(used_memory > capacity)) {
-        if (!enough) {
-          LOG(ERROR) << "BlockManager: out of memory."
-                     << " VertexLabel: " << vlabel << " Capacity: " << capacity
-                     << " Used: " << used_memory << " Order: " << int(order);
-          enough = true;
+      size_t cur = used_size.load();
+      do {
+        pointer = place(cur, block_size);
+        // freed blocks are reused above, so the bump pointer must stay in
+        // the capacity even if the used memory is below it
+        if (unlikely(pointer + block_size > capacity)) {
+          if (!enough) {
+            LOG(ERROR) << "BlockManager: out of memory."
+                       << " VertexLabel: " << vlabel
+                       << " Capacity: " << capacity
+                       << " Used: " << getUsedMemory()
+                       << " Order: " << int(order);
+            enough = true;
+          }
+          return NULLPOINTER;
+        }
+      } while (!used_size.compare_exchange_weak(cur, pointer + block_size));
+
+      if (pointer != cur) {
+        // the rest of the last arena, skipped by a block crossing arenas
+        recycle_range(cur, pointer);
+      }
+      if (unlikely(arenas.get_arena(arenas.get_arena_idx(pointer)) ==
+                   nullptr)) {
+        size_t arena_num = (block_size + arenas.get_arena_size() - 1) >>
+                           arenas.get_arena_bits();
+        if (!alloc_arenas(arenas.get_arena_idx(pointer), arena_num)) {
+          return NULLPOINTER;
         }
-        return NULLPOINTER;
       }
 
       if (pointer + block_size >= file_size) {
@@ -129,6 +207,7 @@ class BlockManager {
   }
 
   void free(uintptr_t block, order_t order) {
+    free_size += 1ul << order;
     if (order < LARGE_BLOCK_THRESHOLD) {
       push(free_blocks.local(), order, block);
     } else {
@@ -137,32 +216,94 @@ class BlockManager {
     }
   }
 
+  // free a block retired by another thread, small blocks go to a shared list
+  // (instead of the thread-local one) so that any writer can reuse them
+  void recycle(uintptr_t block, order_t order) {
+    free_size += 1ul << order;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (order < LARGE_BLOCK_THRESHOLD) {
+      push(recycled_blocks, order, block);
+      num_recycled_blocks++;
+    } else {
+      push(large_free_blocks, order, block);
+    }
+  }
+
   template <typename T>
   inline T* convert(uintptr_t block) const {
     if (__builtin_expect((block == NULLPOINTER), 0))
       return nullptr;
-    return reinterpret_cast<T*>(reinterpret_cast<char*>(data) + block);
+    return arenas.convert<T>(block);
   }
 
-  inline uintptr_t revert(uintptr_t block) const {
-    return block - (uintptr_t) data;
+ private:
+  // the start of a block of block_size bytes bumped from cur, a block does
+  // not cross arenas unless it is larger than an arena
+  uintptr_t place(uintptr_t cur, size_t block_size) const {
+    size_t arena_size = arenas.get_arena_size();
+    if (block_size >= arena_size) {
+      return (cur + arena_size - 1) & ~(arena_size - 1);
+    }
+    if (arenas.get_arena_idx(cur) !=
+        arenas.get_arena_idx(cur + block_size - 1)) {
+      return arenas.get_arena_idx(cur + block_size - 1)
+             << arenas.get_arena_bits();
+    }
+    return cur;
   }
 
-  inline uintptr_t revert(void* ptr) const {
-    return reinterpret_cast<char*>(ptr) - reinterpret_cast<char*>(data);
+  // free [begin, end) as blocks of decreasing sizes, the range is dropped if
+  // its arena cannot be allocated
+  void recycle_range(uintptr_t begin, uintptr_t end) {
+    if (arenas.get_arena(arenas.get_arena_idx(begin)) == nullptr &&
+        !alloc_arenas(arenas.get_arena_idx(begin), 1)) {
+      return;
+    }
+    while (begin < end) {
+      order_t order = 63 - __builtin_clzl(end - begin);
+      recycle(begin, order);
+      begin += 1ul << order;
+    }
+  }
+
+  // allocate a blob of arena_num arenas from the idx-th arena
+  bool alloc_arenas(size_t idx, size_t arena_num) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (arenas.get_arena(idx) != nullptr) {
+      return true;  // by another writer
+    }
+    vineyard::ObjectID oid;
+    char* blob = allocator->allocate_v6d(
+        arena_num << arenas.get_arena_bits(), oid);
+    if (blob == nullptr) {
+      LOG(ERROR) << "BlockManager: failed to allocate " << arena_num
+                 << " arenas. VertexLabel: " << vlabel
+                 << " Allocated: " << allocated_size;
+      return false;
+    }
+    for (size_t i = 0; i < arena_num; i++) {
+      arena_oids[idx + i] = oid;
+      arenas.set_arena(idx + i, blob + (i << arenas.get_arena_bits()));
+    }
+    allocated_size += arena_num << arenas.get_arena_bits();
+    return true;
   }
 
- private:
   const int vlabel;
   const size_t capacity;
   int fd;
-  void* data;
+  SparseArrayAllocator* allocator;
+  BlockArenas arenas;
+  std::vector<vineyard::ObjectID> arena_oids;  // guarded by mutex
+  std::atomic<size_t> allocated_size{0};
   bool enough;
   std::mutex mutex;
   tbb::enumerable_thread_specific<std::vector<std::vector<uintptr_t>>>
       free_blocks;
   std::vector<std::vector<uintptr_t>> large_free_blocks;
-  std::atomic<size_t> used_size, file_size;
+  std::vector<std::vector<uintptr_t>> recycled_blocks;  // guarded by mutex
+  std::atomic<size_t> used_size, file_size, free_size;
+  std::atomic<size_t> num_recycled_blocks;
   uintptr_t null_holder;
 
   uintptr_t pop(std::vector<std::vector<uintptr_t>>& free_block,
@@ -181,6 +322,7 @@ class BlockManager {
   }
 
   constexpr static int EMPTY_FD = -1;
+  constexpr static vineyard::ObjectID EMPTY_ARENA = 0;
   constexpr static order_t MAX_ORDER = 64;
   constexpr static order_t LARGE_BLOCK_THRESHOLD = 20;
   constexpr static size_t FILE_TRUNC_SIZE = 1ul << 30;  // 1GB
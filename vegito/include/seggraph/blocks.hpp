@@ -313,9 +313,15 @@ class VegitoEpochEntry {
 
   void set_offset(size_t offset) { this->offset = offset; }
 
+  // the number of edges not deleted before the epoch
+  size_t get_degree() const { return this->degree; }
+
+  void set_degree(size_t degree) { this->degree = degree; }
+
  private:
   timestamp_t epoch;
   size_t offset;
+  size_t degree;
 };
 
 class EdgeBlockHeader : public N2OBlockHeader {
@@ -502,6 +508,27 @@ class VegitoEdgeBlockHeader : public BlockHeader {
     this->prev_pointer = prev_pointer;
   }
 
+  // number of delete markers in this block and all its previous blocks,
+  // readers can skip tombstone filtering if it is zero
+  size_t get_num_tombstones() const { return this->num_tombstones; }
+
+  void set_num_tombstones(size_t num_tombstones) {
+    this->num_tombstones = num_tombstones;
+  }
+
+  // the number of edges not deleted in num_entries entries with
+  // num_tombstones delete markers, each delete marker hides one edge
+  static size_t get_degree(size_t num_entries, size_t num_tombstones) {
+    return num_entries > 2 * num_tombstones ? num_entries - 2 * num_tombstones
+                                            : 0;
+  }
+
+  // in this block and all its previous blocks
+  size_t get_degree() const {
+    return get_degree(get_prev_num_entries() + get_num_entries(),
+                      get_num_tombstones());
+  }
+
   size_t get_vegito_block_size() const {
     return sizeof(*this) + get_block_size() * sizeof(VegitoEdgeEntry);
   }
@@ -531,6 +558,9 @@ class VegitoEdgeBlockHeader : public BlockHeader {
     if (!has_space())
       return nullptr;
     *(get_entries() - num - 1) = entry;
+    if (entry.get_dst() >> (sizeof(vertex_t) * 8 - 1)) {
+      set_num_tombstones(get_num_tombstones() + 1);
+    }
 
     compiler_fence();
     set_num_entries(num + 1);
@@ -543,20 +573,26 @@ class VegitoEdgeBlockHeader : public BlockHeader {
     if (!has_space())
       return nullptr;
     *(get_entries() - num - 1) = entry;
+    if (entry.get_dst() >> (sizeof(vertex_t) * 8 - 1)) {
+      set_num_tombstones(get_num_tombstones() + 1);
+    }
 
     return get_entries() - num - 1;
   }
 
-  void fill(order_t order, uintptr_t prev_pointer, size_t prev_num_entries) {
+  void fill(order_t order, uintptr_t prev_pointer, size_t prev_num_entries,
+            size_t prev_num_tombstones = 0) {
     BlockHeader::fill(order, Type::EDGE);
     set_prev_pointer(prev_pointer);
     set_prev_num_entries(prev_num_entries);
+    set_num_tombstones(prev_num_tombstones);
     set_num_entries(0);
   }
 
  private:
   uint32_t num_entries;
   uint32_t prev_num_entries;
+  uint32_t num_tombstones;
   uintptr_t prev_pointer;
 };
 
@@ -598,6 +634,32 @@ class EpochBlockHeader : public BlockHeader {
       return true;
   }
 
+  // Entries are stored from the newest (get_entries() - num_entries) to the
+  // oldest (get_entries() - 1), so epochs decrease along the address space.
+  // Returns the newest entry whose epoch is not larger than read_epoch, or
+  // nullptr if all entries are newer than read_epoch.
+  const VegitoEpochEntry* search(timestamp_t read_epoch) const {
+    size_t num = get_num_entries();
+    const VegitoEpochEntry* newest = get_entries() - num;
+    if (num == 0) {
+      return nullptr;
+    }
+    // fast path: most readers read the latest epoch
+    if (read_epoch >= newest->get_epoch()) {
+      return newest;
+    }
+    size_t low = 1, high = num;
+    while (low < high) {
+      size_t mid = low + (high - low) / 2;
+      if (read_epoch >= newest[mid].get_epoch()) {
+        high = mid;
+      } else {
+        low = mid + 1;
+      }
+    }
+    return low == num ? nullptr : newest + low;
+  }
+
   VegitoEpochEntry* append(VegitoEpochEntry entry) {
     auto num = get_num_entries();
     if (!has_space())
@@ -641,6 +703,8 @@ class VegitoSegmentHeader : public BlockHeader {
     segid_low = segid & UINT32_MAX;
   }
 
+  uintptr_t get_head() const { return head; }
+
   uintptr_t get_region_ptr(uint32_t idx) const { return region_ptrs[idx]; }
 
   uintptr_t* get_region_ptr_pointer(uint32_t idx) {
@@ -15,13 +15,23 @@
 
 #pragma once
 
+#include <algorithm>
+#include <string_view>
 #include <utility>
+#include <vector>
 
 #include "seggraph/segment_graph.hpp"
 
 namespace seggraph {
 class EpochGraphWriter {
  public:
+  // an edge of put_edges
+  struct EdgeToPut {
+    vertex_t src;
+    vertex_t dst;
+    std::string_view edge_data;
+  };
+
   EpochGraphWriter(SegGraph& _graph, timestamp_t _write_epoch_id)
       : graph(_graph),
         read_epoch_id(_write_epoch_id),
@@ -48,10 +58,22 @@ class EpochGraphWriter {
   }
   void put_edge(vertex_t src, label_t label, dir_t dir, vertex_t dst,
                 std::string_view edge_data = "");
+  // put edges of the same label and direction, grouped by source vertex (the
+  // order of edges is kept for each source), so that each vertex and its
+  // segment are locked and located once, and its edges are appended in one
+  // pass. edges is sorted in place.
+  void put_edges(label_t label, dir_t dir, std::vector<EdgeToPut>& edges);
 
   // segment compact
   void merge_segments(label_t label, dir_t dir = EOUT);
 
+  // tombstone compaction: rewrite the segment if the ratio of delete markers
+  // and deleted edges exceeds tombstone_ratio, dropping the pairs whose delete
+  // marker is not newer than horizon. Return true if the segment is rewritten.
+  bool compact_segment(segid_t segid, label_t label, dir_t dir,
+                       timestamp_t horizon, double tombstone_ratio,
+                       size_t edge_prop_size);
+
   ~EpochGraphWriter() {}
 
   void lock_vertex(vertex_t vertex_id) {
@@ -80,11 +102,20 @@ class EpochGraphWriter {
     }
   }
 
+  void put_vertex_edges(vertex_t src, label_t label, dir_t dir,
+                        const EdgeToPut* edges, size_t num);
+
   void update_edge_label_block(vertex_t src, label_t label, dir_t dir,
                                uintptr_t edge_block_pointer);
 
   void merge_segment(VegitoSegmentHeader* old_seg, VegitoSegmentHeader* new_seg,
                      vertex_t segidx, uintptr_t* pointer,
                      VegitoEdgeBlockHeader** edge_block, size_t edge_prop_size);
+
+  bool compact_edges(VegitoSegmentHeader* old_seg, VegitoSegmentHeader* new_seg,
+                     vertex_t segidx, timestamp_t horizon,
+                     size_t edge_prop_size,
+                     std::vector<std::pair<uintptr_t, order_t>>& new_tables,
+                     std::vector<std::pair<uintptr_t, order_t>>& old_tables);
 };
 }  // namespace seggraph
@@ -45,13 +45,15 @@ class EpochGraphReader;
 class SegGraph {
  public:
   // _max_block_size:
-  //   the maximum size (capacity) in bytes of the `block_manager`
+  //   the maximum size (capacity) in bytes of the `block_manager`, blocks
+  //   are allocated from vineyard in arenas of _arena_size bytes on demand
   // _max_vertex_id:
   //   the maximum vertex id in the graph, decides the size of the
   //   vertex table and the rows of properties
   SegGraph(gart::graph::RGMapping* rg_map, int _vlabel,
            size_t _max_block_size = 10 * (1ul << 30),
-           vertex_t _max_vertex_id = 1 * (1ul << 26))
+           vertex_t _max_vertex_id = 1 * (1ul << 26),
+           size_t _arena_size = 1ul << 26)
       : epoch_id(0),
         transaction_id(0),
         vertex_id(0),
@@ -75,18 +77,17 @@ class SegGraph {
     seg_mutexes =
         array_allocator.allocate<std::shared_timed_mutex*>(max_seg_id + 1);
 
-    char* block_manager_ptr =
-        array_allocator.allocate_v6d(_max_block_size, block_manager_oid);
-    block_manager.init_buffer(block_manager_ptr);
+    array_allocator.set_accounting(gart::MemoryComponent::BLOCKS, vlabel);
+    block_manager.init_arenas(&array_allocator, _arena_size);
 
     vertex_ptrs = array_allocator.allocate<uintptr_t>(max_vertex_id + 1);
 
-    edge_label_ptrs = array_allocator.allocate_v6d<uintptr_t>(
+    edge_label_ptrs = array_allocator.allocate_v6d_or_die<uintptr_t>(
         max_seg_id, edge_label_ptrs_oid);
 
     gart::ArrayMeta meta(edge_label_ptrs_oid, max_seg_id);
-    blob_schema.set_block_oid(block_manager_oid);
     blob_schema.set_elabel2segs(meta);
+    update_block_oids();
 
     // tricky method: avoid corner case in segment lock
     seg_mutexes[0] = new std::shared_timed_mutex();
@@ -118,7 +119,7 @@ class SegGraph {
 
     array_allocator.deallocate_v6d(edge_label_ptrs_oid);
 
-    array_allocator.deallocate_v6d(block_manager_oid);
+    block_manager.release_arenas();
   }
 
   vertex_t get_max_vertex_id() const { return vertex_id; }
@@ -127,6 +128,19 @@ class SegGraph {
 
   uint64_t get_block_usage() { return block_manager.getUsedMemory(); }
 
+  uint64_t get_block_capacity() const { return block_manager.getCapacity(); }
+
+  uint64_t get_block_allocated() const {
+    return block_manager.getAllocatedMemory();
+  }
+
+  // publish the arenas allocated so far in the blob schema, called at epoch
+  // boundaries
+  void update_block_oids() {
+    blob_schema.set_block_oids(block_manager.get_arena_oids(),
+                               block_manager.get_arena_bits());
+  }
+
   void get_v6d_usage(size_t& usage, size_t& limit) const {
     array_allocator.v6d_usage_limit(usage, limit);
   }
@@ -200,8 +214,37 @@ class SegGraph {
 
   gart::BlobSchema& get_blob_schema() { return blob_schema; }
 
+  // Rewrite at most max_segments segments whose tombstone ratio exceeds
+  // tombstone_ratio, starting from where the last call stopped. Deleted edges
+  // are dropped physically if their delete markers are not newer than
+  // horizon, so snapshots older than horizon are no longer exact.
+  // edge_prop_sizes[label] is the size of edge properties in bytes.
+  // Return the number of rewritten segments.
+  size_t compact_segments(timestamp_t write_epoch, timestamp_t horizon,
+                          double tombstone_ratio, size_t max_segments,
+                          const std::vector<size_t>& edge_prop_sizes);
+
+  // Return the blocks (segments, epoch tables and edge label blocks) retired
+  // before safe_epoch to the block manager. A block retired at epoch e is
+  // freed once no reader pins an epoch before e and e + LAG_EPOCH_NUMBER <
+  // write_epoch. Must be called when no writer is running, i.e., at the
+  // epoch boundary, since it drains the retired lists of all threads.
+  void recycle_segments(timestamp_t write_epoch,
+                        timestamp_t safe_epoch = INT64_MAX);
+
+  // bytes of retired blocks waiting for readers to move on
+  size_t get_reclaimable_bytes() const { return reclaimable_bytes; }
+
+  // bytes of retired blocks returned to the block manager so far
+  size_t get_reclaimed_bytes() const { return reclaimed_bytes; }
+
  private:
-  void recycle_segments(timestamp_t epoch_id);
+  // the block is still visible to readers of epochs before retire_epoch
+  void retire_block(uintptr_t block, order_t order, timestamp_t retire_epoch) {
+    segments_to_recycle.local().push_back(
+        std::make_tuple(block, order, retire_epoch));
+    reclaimable_bytes += 1ul << order;
+  }
 
   using cacheline_padding_t = char[64];
 
@@ -209,6 +252,9 @@ class SegGraph {
   std::atomic<timestamp_t> transaction_id;
   std::atomic<vertex_t> vertex_id;
   std::atomic<segid_t> seg_id;
+  segid_t compact_cursor = 0;
+  std::atomic<size_t> reclaimable_bytes{0};
+  std::atomic<size_t> reclaimed_bytes{0};
 
   tbb::enumerable_thread_specific<timestamp_t> read_epoch_table;
   tbb::enumerable_thread_specific<
@@ -235,7 +281,6 @@ class SegGraph {
   vertex_t* vertex_table;
   vertex_t* ovl2g;
 
-  vineyard::ObjectID block_manager_oid;
   vineyard::ObjectID edge_label_ptrs_oid;
   vineyard::ObjectID ovl2g_oid;
   vineyard::ObjectID ovg2l_map;
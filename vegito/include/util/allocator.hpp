@@ -20,25 +20,30 @@
 
 #include <limits>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 
 #include "glog/logging.h"
 #include "vineyard/client/client.h"
 #include "vineyard/client/ds/blob.h"
 
 #include "framework/config.h"  // NOLINT(build/include_subdir)
+#include "util/memory_accounting.h"
 
+// vineyard blobs are counted by gart::MemoryAccounting, under the component
+// (and vertex label) set by set_accounting
 struct SparseArrayAllocator {
   SparseArrayAllocator() : client_(new vineyard::Client), init_client_(true) {
     std::string ipc_socket = gart::framework::config.getIPCScoket();
     VINEYARD_CHECK_OK(client_->Connect(ipc_socket));
 
-    VINEYARD_CHECK_OK(client_->InstanceStatus(v6d_status_));
+    gart::MemoryAccounting::instance().refresh(client_);
   }
 
   explicit SparseArrayAllocator(vineyard::Client* client)
       : client_(client), init_client_(false) {
-    VINEYARD_CHECK_OK(client_->InstanceStatus(v6d_status_));
+    gart::MemoryAccounting::instance().refresh(client_);
   }
 
   ~SparseArrayAllocator() {
@@ -52,41 +57,84 @@ struct SparseArrayAllocator {
 
   vineyard::Client* get_client() { return client_; }
 
+  void set_accounting(gart::MemoryComponent component,
+                      int label = gart::MemoryAccounting::NO_LABEL) {
+    component_ = component;
+    label_ = label;
+  }
+
   void v6d_usage_limit(size_t& usage, size_t& limit) const {
-    usage = v6d_status_->memory_usage;
-    limit = v6d_status_->memory_limit;
+    auto& accounting = gart::MemoryAccounting::instance();
+    accounting.refresh(client_);
+    usage = accounting.v6d_usage();
+    limit = accounting.v6d_limit();
   }
 
+  // return nullptr if the blob would exceed the memory limit of vineyard
   template <typename T = char>
   T* allocate_v6d(size_t n, vineyard::ObjectID& oid) {
     size_t size = n * sizeof(T);
     if (n > std::numeric_limits<std::size_t>::max() / sizeof(T))
       throw std::bad_alloc();
 
-    size_t usage = v6d_status_->memory_usage;
-    size_t limit = v6d_status_->memory_limit;
-    // printf("Vineyard memory usage %.2f + %.2f = %.2f MB\n",
-    //        usage / 1.0 / (1 << 20), size / 1.0 / (1 << 20),
-    //        (usage + size) / 1.0 / (1 << 20));
-    if (usage + size > limit) {
-      LOG(ERROR) << "Vineyard memory usage " << usage << " + " << size
-                 << " exceeds limit " << limit;
-      assert(false);
-      exit(-1);
-      return nullptr;
+    auto& accounting = gart::MemoryAccounting::instance();
+    accounting.refresh(client_);
+    // the limit is unknown (0) if vineyard has never answered
+    if (accounting.v6d_limit() > 0 &&
+        accounting.v6d_usage() + size > accounting.v6d_limit()) {
+      // the usage may be stale, e.g., other processes have deleted blobs
+      accounting.refresh(client_, true);
+      if (accounting.v6d_usage() + size > accounting.v6d_limit()) {
+        LOG(ERROR) << "Vineyard memory usage " << accounting.v6d_usage()
+                   << " + " << size << " exceeds limit "
+                   << accounting.v6d_limit() << ", "
+                   << accounting.to_string();
+        return nullptr;
+      }
     }
 
     std::unique_ptr<vineyard::BlobWriter> blob_writer;
     std::shared_ptr<vineyard::Blob> blob;
-    VINEYARD_CHECK_OK(client_->CreateBlob(size, blob_writer));
+    auto status = client_->CreateBlob(size, blob_writer);
+    if (!status.ok()) {
+      LOG(ERROR) << "Failed to create a blob of " << size
+                 << " bytes: " << status.ToString();
+      return nullptr;
+    }
     VINEYARD_CHECK_OK(client_->GetBlob(blob_writer->id(), true, blob));
     auto data = reinterpret_cast<void*>(blob_writer->data());
     oid = blob_writer->id();
+
+    accounting.add(component_, label_, size);
+    {
+      std::lock_guard<std::mutex> lock(blobs_mutex_);
+      blobs_[oid] = BlobAccount{size, component_, label_};
+    }
     return static_cast<T*>(data);
   }
 
+  // for buffers allocated at startup, without which the store cannot run
+  template <typename T = char>
+  T* allocate_v6d_or_die(size_t n, vineyard::ObjectID& oid) {
+    T* data = allocate_v6d<T>(n, oid);
+    if (data == nullptr) {
+      LOG(FATAL) << "Failed to allocate " << n * sizeof(T)
+                 << " bytes from vineyard at startup";
+    }
+    return data;
+  }
+
   void deallocate_v6d(vineyard::ObjectID oid) {
     VINEYARD_CHECK_OK(client_->DelData(oid));
+    std::lock_guard<std::mutex> lock(blobs_mutex_);
+    auto iter = blobs_.find(oid);
+    if (iter != blobs_.end()) {
+      const BlobAccount& account = iter->second;
+      gart::MemoryAccounting::instance().add(
+          account.component, account.label,
+          -static_cast<int64_t>(account.size));
+      blobs_.erase(iter);
+    }
   }
 
   template <typename T = char>
@@ -108,10 +156,19 @@ struct SparseArrayAllocator {
   }
 
  private:
+  struct BlobAccount {
+    size_t size;
+    gart::MemoryComponent component;
+    int label;
+  };
+
   const bool init_client_;
   vineyard::Client* client_;
 
-  std::shared_ptr<struct vineyard::InstanceStatus> v6d_status_;
+  gart::MemoryComponent component_ = gart::MemoryComponent::OTHERS;
+  int label_ = gart::MemoryAccounting::NO_LABEL;
+  std::mutex blobs_mutex_;
+  std::unordered_map<vineyard::ObjectID, BlobAccount> blobs_;
 };
 
 #endif  // VEGITO_INCLUDE_UTIL_ALLOCATOR_HPP_
@@ -0,0 +1,216 @@
+/** Copyright 2020-2023 Alibaba Group Holding Limited.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef VEGITO_INCLUDE_UTIL_MEMORY_ACCOUNTING_H_
+#define VEGITO_INCLUDE_UTIL_MEMORY_ACCOUNTING_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+
+#include "glog/logging.h"
+#include "vineyard/client/client.h"
+
+#include "fragment/id_parser.h"
+
+namespace gart {
+
+enum class MemoryComponent {
+  BLOCKS = 0,         // block buffers of SegGraph (allocated)
+  BLOCKS_USED,        // blocks handed out by BlockManager (gauge)
+  PROPERTIES,         // buffers of BufferManager (vertex properties)
+  STRINGS,            // chunks of the string heap
+  VERTEX_TABLES,      // vertex tables and external ids of GraphStore
+  INDEXES,            // property indexes
+  OTHERS,             // other vineyard blobs
+  NUM_COMPONENTS
+};
+
+/**
+ * Process-wide accounting of the memory of the graph store.
+ *
+ * Every vineyard blob allocated by a SparseArrayAllocator is counted by its
+ * component and vertex label. The usage of vineyard (shared with other
+ * processes) is refreshed from the instance status at most once per refresh
+ * interval, and blobs allocated since the last refresh are added on top, so
+ * the usage is never older than the interval.
+ *
+ * The store is under pressure when the usage of vineyard exceeds the soft
+ * limit, or when the used blocks of a vertex label exceed the same ratio of
+ * its block buffer. The runner then slows down the consumption of logs (see
+ * Runner::relieve_memory_pressure_) and compacts at the next epoch boundary,
+ * and the writers back off when vineyard runs out of memory (see
+ * GraphStore::put_cstring), instead of running into the hard limit in the
+ * middle of an epoch.
+ */
+class MemoryAccounting {
+ public:
+  static constexpr int NO_LABEL = -1;
+
+  static MemoryAccounting& instance() {
+    static MemoryAccounting accounting;
+    return accounting;
+  }
+
+  void set_soft_limit_ratio(double ratio) { soft_limit_ratio_ = ratio; }
+
+  void set_refresh_interval_ms(int64_t interval_ms) {
+    refresh_interval_ms_ = interval_ms;
+  }
+
+  // blobs allocated (bytes > 0) or deleted (bytes < 0)
+  void add(MemoryComponent component, int label, int64_t bytes) {
+    totals_[idx(component)] += bytes;
+    if (label >= 0 && label < MAX_VLABELS) {
+      labels_[idx(component)][label] += bytes;
+    }
+    unrefreshed_bytes_ += bytes;
+  }
+
+  // for gauges, e.g., BLOCKS_USED
+  void set(MemoryComponent component, int label, int64_t bytes) {
+    if (label >= 0 && label < MAX_VLABELS) {
+      int64_t old = labels_[idx(component)][label].exchange(bytes);
+      totals_[idx(component)] += bytes - old;
+    }
+  }
+
+  int64_t get(MemoryComponent component) const {
+    return totals_[idx(component)];
+  }
+
+  int64_t get(MemoryComponent component, int label) const {
+    return labels_[idx(component)][label];
+  }
+
+  // capacity of the block buffer of a label, for the pressure of blocks
+  void set_block_capacity(int label, int64_t capacity) {
+    if (label >= 0 && label < MAX_VLABELS) {
+      block_capacities_[label] = capacity;
+    }
+  }
+
+  // query the instance status of vineyard, if it is older than the refresh
+  // interval (or force is set), return false if the query fails. A fresh
+  // status is checked without locking, and callers do not wait for a
+  // refresh in progress unless it is forced
+  bool refresh(vineyard::Client* client, bool force = false) {
+    int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(
+                      std::chrono::steady_clock::now().time_since_epoch())
+                      .count();
+    if (!force && now - last_refresh_ms_ < refresh_interval_ms_) {
+      return true;
+    }
+    std::unique_lock<std::mutex> lock(mutex_, std::defer_lock);
+    if (force) {
+      lock.lock();
+    } else if (!lock.try_lock()) {
+      return true;
+    }
+    std::shared_ptr<struct vineyard::InstanceStatus> status;
+    auto s = client->InstanceStatus(status);
+    if (!s.ok() || !status) {
+      LOG(ERROR) << "Failed to refresh the status of vineyard";
+      return false;
+    }
+    v6d_status_ = status;
+    v6d_usage_ = status->memory_usage;
+    v6d_limit_ = status->memory_limit;
+    unrefreshed_bytes_ = 0;
+    last_refresh_ms_ = now;
+    return true;
+  }
+
+  // the latest usage of vineyard with blobs allocated since
+  size_t v6d_usage() const {
+    int64_t usage = static_cast<int64_t>(v6d_usage_) + unrefreshed_bytes_;
+    return usage > 0 ? usage : 0;
+  }
+
+  size_t v6d_limit() const { return v6d_limit_; }
+
+  size_t v6d_soft_limit() const { return v6d_limit_ * soft_limit_ratio_; }
+
+  bool under_pressure() const {
+    if (v6d_limit_ > 0 && v6d_usage() > v6d_soft_limit()) {
+      return true;
+    }
+    for (int label = 0; label < MAX_VLABELS; label++) {
+      int64_t capacity = block_capacities_[label];
+      if (capacity > 0 && get(MemoryComponent::BLOCKS_USED, label) >
+                              capacity * soft_limit_ratio_) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  std::string to_string() const {
+    static const char* names[] = {"blocks",        "blocks_used",
+                                  "properties",    "strings",
+                                  "vertex_tables", "indexes",
+                                  "others"};
+    std::stringstream ss;
+    ss << "vineyard usage " << v6d_usage() << " / " << v6d_limit()
+       << " (soft limit " << v6d_soft_limit() << ")";
+    for (int c = 0; c < idx(MemoryComponent::NUM_COMPONENTS); c++) {
+      ss << ", " << names[c] << " " << totals_[c];
+    }
+    return ss.str();
+  }
+
+ private:
+  MemoryAccounting() {
+    for (int c = 0; c < idx(MemoryComponent::NUM_COMPONENTS); c++) {
+      totals_[c] = 0;
+      for (int label = 0; label < MAX_VLABELS; label++) {
+        labels_[c][label] = 0;
+      }
+    }
+    for (int label = 0; label < MAX_VLABELS; label++) {
+      block_capacities_[label] = 0;
+    }
+  }
+
+  static constexpr int idx(MemoryComponent component) {
+    return static_cast<int>(component);
+  }
+
+  static constexpr int NUM = static_cast<int>(MemoryComponent::NUM_COMPONENTS);
+
+  std::atomic<int64_t> totals_[NUM];
+  std::atomic<int64_t> labels_[NUM][MAX_VLABELS];
+  std::atomic<int64_t> block_capacities_[MAX_VLABELS];
+
+  std::atomic<double> soft_limit_ratio_{0.9};
+  std::atomic<int64_t> refresh_interval_ms_{1000};
+
+  std::mutex mutex_;  // for refreshing
+  std::shared_ptr<struct vineyard::InstanceStatus> v6d_status_;
+  std::atomic<size_t> v6d_usage_{0};
+  std::atomic<size_t> v6d_limit_{0};
+  // allocated (or deleted) since the last refresh
+  std::atomic<int64_t> unrefreshed_bytes_{0};
+  // in milliseconds of the steady clock, never refreshed at first
+  std::atomic<int64_t> last_refresh_ms_{INT64_MIN / 2};
+};
+
+}  // namespace gart
+
+#endif  // VEGITO_INCLUDE_UTIL_MEMORY_ACCOUNTING_H_
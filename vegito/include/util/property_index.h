@@ -0,0 +1,362 @@
+/** Copyright 2020-2023 Alibaba Group Holding Limited.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef VEGITO_INCLUDE_UTIL_PROPERTY_INDEX_H_
+#define VEGITO_INCLUDE_UTIL_PROPERTY_INDEX_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+#include "vineyard/client/client.h"
+#include "vineyard/client/ds/blob.h"
+
+#include "seggraph/block_arenas.hpp"
+
+namespace gart {
+
+enum PropertyIndexType {
+  NO_INDEX = 0,
+  HASH_INDEX = 1,     // equality
+  ORDERED_INDEX = 2,  // equality and ranges
+};
+
+// "hash" or "ordered", as declared in the RGMapping
+inline PropertyIndexType parse_property_index_type(const std::string& name) {
+  if (name == "hash") {
+    return HASH_INDEX;
+  } else if (name == "ordered") {
+    return ORDERED_INDEX;
+  }
+  return NO_INDEX;
+}
+
+/**
+ * Keys of property indexes. Integers and floating points are mapped to
+ * uint64_t preserving their order, and strings are hashed, so only hash
+ * indexes take strings and readers compare the values of the vertices found.
+ * Timestamps are keyed by their microseconds since the epoch (see
+ * parse_timestamp_micros), so they are ordered as well.
+ */
+inline uint64_t property_index_key(int64_t value) {
+  return static_cast<uint64_t>(value) ^ (1ul << 63);
+}
+
+inline uint64_t property_index_key(double value) {
+  if (value == 0) {
+    value = 0;  // -0.0 equals 0.0
+  }
+  uint64_t bits;
+  memcpy(&bits, &value, sizeof(uint64_t));
+  return (bits >> 63) ? ~bits : bits | (1ul << 63);
+}
+
+inline uint64_t property_index_key(std::string_view value) {
+  // FNV-1a, stable across the writer and the readers
+  uint64_t hash = 14695981039346656037ul;
+  for (char c : value) {
+    hash = (hash ^ static_cast<uint8_t>(c)) * 1099511628211ul;
+  }
+  return hash;
+}
+
+namespace property_index_impl {
+
+inline bool parse_digits(std::string_view text, size_t& pos, int num,
+                         int64_t& value) {
+  value = 0;
+  for (int idx = 0; idx < num; idx++, pos++) {
+    if (pos >= text.size() || text[pos] < '0' || text[pos] > '9') {
+      return false;
+    }
+    value = value * 10 + (text[pos] - '0');
+  }
+  return true;
+}
+
+inline bool skip_char(std::string_view text, size_t& pos, char c) {
+  if (pos < text.size() && text[pos] == c) {
+    pos++;
+    return true;
+  }
+  return false;
+}
+
+// days since 1970-01-01 of a date of the proleptic Gregorian calendar
+inline int64_t days_from_civil(int64_t year, int64_t month, int64_t day) {
+  year -= month <= 2;
+  int64_t era = (year >= 0 ? year : year - 399) / 400;
+  int64_t year_of_era = year - era * 400;
+  int64_t day_of_year =
+      (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+  int64_t day_of_era =
+      year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+  return era * 146097 + day_of_era - 719468;
+}
+
+}  // namespace property_index_impl
+
+// the microseconds since the epoch of the text of a TIMESTAMP value, in the
+// form of "YYYY-MM-DD[ T]HH:MM:SS[.ffffff][Z|+HH[:MM]|-HH[:MM]]" (UTC without
+// a zone), or an integer taken as it is (e.g., the epoch micros of Debezium).
+// Return false for other forms.
+inline bool parse_timestamp_micros(std::string_view text, int64_t& micros) {
+  using namespace property_index_impl;  // NOLINT(build/namespaces)
+  size_t pos = 0;
+  if (text.find('-', 1) == std::string_view::npos) {
+    bool negative = skip_char(text, pos, '-');
+    int64_t value;
+    if (pos == text.size() || text.size() - pos > 18 ||
+        !parse_digits(text, pos, text.size() - pos, value)) {
+      return false;
+    }
+    micros = negative ? -value : value;
+    return true;
+  }
+
+  int64_t year, month, day, hour, minute, second;
+  if (!parse_digits(text, pos, 4, year) || !skip_char(text, pos, '-') ||
+      !parse_digits(text, pos, 2, month) || !skip_char(text, pos, '-') ||
+      !parse_digits(text, pos, 2, day) ||
+      !(skip_char(text, pos, ' ') || skip_char(text, pos, 'T')) ||
+      !parse_digits(text, pos, 2, hour) || !skip_char(text, pos, ':') ||
+      !parse_digits(text, pos, 2, minute) || !skip_char(text, pos, ':') ||
+      !parse_digits(text, pos, 2, second) || month < 1 || month > 12 ||
+      day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60) {
+    return false;
+  }
+  int64_t fraction = 0;
+  if (skip_char(text, pos, '.')) {
+    int64_t scale = 100000;
+    size_t begin = pos;
+    for (; pos < text.size() && text[pos] >= '0' && text[pos] <= '9'; pos++) {
+      fraction += (text[pos] - '0') * scale;  // digits beyond micros drop
+      scale /= 10;
+    }
+    if (pos == begin) {
+      return false;
+    }
+  }
+  int64_t offset_minutes = 0;
+  if (pos < text.size() && (text[pos] == '+' || text[pos] == '-')) {
+    int64_t sign = text[pos++] == '-' ? -1 : 1;
+    int64_t offset_hours, offset_mins = 0;
+    if (!parse_digits(text, pos, 2, offset_hours)) {
+      return false;
+    }
+    if (pos < text.size()) {
+      skip_char(text, pos, ':');
+      if (!parse_digits(text, pos, 2, offset_mins)) {
+        return false;
+      }
+    }
+    offset_minutes = sign * (offset_hours * 60 + offset_mins);
+  } else {
+    skip_char(text, pos, 'Z');
+  }
+  if (pos != text.size()) {
+    return false;
+  }
+  int64_t seconds = days_from_civil(year, month, day) * 86400 + hour * 3600 +
+                    (minute - offset_minutes) * 60 + second;
+  micros = seconds * 1000000 + fraction;
+  return true;
+}
+
+/**
+ * Shared layout of a property index, written by the writer (see
+ * src/property/property_index.h) and read by GartFragment.
+ *
+ * An index is a set of nodes (key, vertex offset, [begin_epoch, end_epoch))
+ * in chunks (vineyard blobs) allocated on demand, referred to by offsets
+ * over the chunks as the blocks of SegGraph (see seggraph::BlockArenas). The
+ * header is at the start of the first chunk, so offset 0 is never a node,
+ * and it holds the object ids of all the chunks. Readers only need the
+ * object id of the first chunk, and map the other chunks on first use.
+ *
+ * - A hash index is an array of buckets (a blob of its own), each the head
+ *   of a chain of nodes, newest first.
+ * - An ordered index is a skip list ordered by (key, vertex).
+ *
+ * A node is visible at epoch e if begin_epoch <= e < end_epoch, so readers
+ * see the index as of their epochs. There is a single writer per index, it
+ * publishes a node by a release store of the offset linking it, and readers
+ * follow offsets with acquire loads. Superseded nodes are unlinked once no
+ * reader can see them, and reused once no reader can stand on them.
+ */
+struct PropertyIndexNode {
+  static constexpr int MAX_LEVEL = 16;
+  static constexpr int64_t MAX_EPOCH = std::numeric_limits<int64_t>::max();
+
+  static size_t size_of(uint64_t level) {
+    return offsetof(PropertyIndexNode, next) + level * sizeof(uint64_t);
+  }
+
+  uint64_t get_next(int level) const {
+    return __atomic_load_n(&next[level], __ATOMIC_ACQUIRE);
+  }
+
+  void set_next(int level, uint64_t offset) {
+    __atomic_store_n(&next[level], offset, __ATOMIC_RELEASE);
+  }
+
+  int64_t get_end_epoch() const {
+    return __atomic_load_n(&end_epoch, __ATOMIC_ACQUIRE);
+  }
+
+  void set_end_epoch(int64_t epoch) {
+    __atomic_store_n(&end_epoch, epoch, __ATOMIC_RELEASE);
+  }
+
+  bool visible(int64_t epoch) const {
+    return begin_epoch <= epoch && epoch < get_end_epoch();
+  }
+
+  // the order of an ordered index
+  bool less(uint64_t k, uint64_t v) const {
+    return key < k || (key == k && vertex < v);
+  }
+
+  uint64_t key;
+  uint64_t vertex;  // offset of an inner vertex
+  int64_t begin_epoch;
+  int64_t end_epoch;
+  uint64_t level;  // number of next offsets, 1 for hash chains
+  uint64_t next[1];
+};
+
+struct PropertyIndexHeader {
+  static constexpr size_t MAX_CHUNK_NUM = 4096;
+
+  uint64_t type;
+  uint64_t chunk_bits;
+  uint64_t bucket_bits;           // hash index
+  vineyard::ObjectID bucket_oid;  // hash index
+  uint64_t head;                  // ordered index, of MAX_LEVEL
+  vineyard::ObjectID chunk_oids[MAX_CHUNK_NUM];
+};
+
+class PropertyIndexReader {
+ public:
+  // return false if the index cannot be mapped
+  bool init(vineyard::Client* client, vineyard::ObjectID header_oid) {
+    client_ = client;
+    std::shared_ptr<vineyard::Blob> blob;
+    if (!client_->GetBlob(header_oid, true, blob).ok()) {
+      return false;
+    }
+    header_ = reinterpret_cast<const PropertyIndexHeader*>(blob->data());
+    chunks_.init(header_->chunk_bits, PropertyIndexHeader::MAX_CHUNK_NUM);
+    chunks_.set_arena(0, const_cast<char*>(blob->data()));
+    if (header_->type == HASH_INDEX) {
+      if (!client_->GetBlob(header_->bucket_oid, true, blob).ok()) {
+        return false;
+      }
+      buckets_ = reinterpret_cast<const uint64_t*>(blob->data());
+      bucket_mask_ = (1ul << header_->bucket_bits) - 1;
+    }
+    return true;
+  }
+
+  PropertyIndexType type() const {
+    return static_cast<PropertyIndexType>(header_->type);
+  }
+
+  // call func(vertex offset) for the vertices with the key at epoch
+  template <typename FUNC>
+  void find(uint64_t key, int64_t epoch, const FUNC& func) const {
+    if (type() == ORDERED_INDEX) {
+      find_range(key, key, epoch, func);
+      return;
+    }
+    uint64_t offset =
+        __atomic_load_n(&buckets_[key & bucket_mask_], __ATOMIC_ACQUIRE);
+    while (offset != 0) {
+      const PropertyIndexNode* node = node_(offset);
+      if (node->key == key && node->visible(epoch)) {
+        func(node->vertex);
+      }
+      offset = node->get_next(0);
+    }
+  }
+
+  // call func(vertex offset) for the vertices with keys in [lo, hi] at
+  // epoch, in the order of keys, only for ordered indexes
+  template <typename FUNC>
+  void find_range(uint64_t lo, uint64_t hi, int64_t epoch,
+                  const FUNC& func) const {
+    if (type() != ORDERED_INDEX || lo > hi) {
+      return;
+    }
+    const PropertyIndexNode* pred = node_(header_->head);
+    for (int level = PropertyIndexNode::MAX_LEVEL - 1; level >= 0; level--) {
+      uint64_t next = pred->get_next(level);
+      while (next != 0 && node_(next)->key < lo) {
+        pred = node_(next);
+        next = pred->get_next(level);
+      }
+    }
+    uint64_t offset = pred->get_next(0);
+    while (offset != 0) {
+      const PropertyIndexNode* node = node_(offset);
+      if (node->key > hi) {
+        break;
+      }
+      if (node->visible(epoch)) {
+        func(node->vertex);
+      }
+      offset = node->get_next(0);
+    }
+  }
+
+ private:
+  const PropertyIndexNode* node_(uint64_t offset) const {
+    size_t idx = chunks_.get_arena_idx(offset);
+    if (chunks_.get_arena(idx) == nullptr) {
+      map_chunk_(idx);
+    }
+    return chunks_.convert<PropertyIndexNode>(offset);
+  }
+
+  // chunks allocated after init, their object ids are published in the
+  // header before any of their nodes are linked
+  void map_chunk_(size_t idx) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (chunks_.get_arena(idx) != nullptr) {
+      return;
+    }
+    vineyard::ObjectID oid =
+        __atomic_load_n(&header_->chunk_oids[idx], __ATOMIC_ACQUIRE);
+    std::shared_ptr<vineyard::Blob> blob;
+    VINEYARD_CHECK_OK(client_->GetBlob(oid, true, blob));
+    chunks_.set_arena(idx, const_cast<char*>(blob->data()));
+  }
+
+  vineyard::Client* client_ = nullptr;
+  const PropertyIndexHeader* header_ = nullptr;
+  const uint64_t* buckets_ = nullptr;
+  uint64_t bucket_mask_ = 0;
+  mutable seggraph::BlockArenas chunks_;
+  mutable std::mutex mutex_;
+};
+
+}  // namespace gart
+
+#endif  // VEGITO_INCLUDE_UTIL_PROPERTY_INDEX_H_
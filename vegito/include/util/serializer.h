@@ -206,4 +206,28 @@ struct serializer<int32_t, true> {
   }
 };
 
+template <>
+struct serializer<uint64_t, true> {
+  typedef uint64_t obj_type;
+
+  static inline uint8_t* write(uint8_t* buf, uint64_t obj) {
+    return write_uvint64(buf, obj);
+  }
+
+  static inline const uint8_t* read(const uint8_t* buf, uint64_t* obj) {
+    return read_uvint64(buf, obj);
+  }
+
+  static inline const uint8_t* failsafe_read(const uint8_t* buf, size_t nbytes,
+                                             uint64_t* obj) {
+    return failsafe_read_uvint64(buf, nbytes, obj);
+  }
+
+  static inline size_t nbytes(const uint64_t* obj) {
+    return size_uvint64(*obj);
+  }
+
+  static inline constexpr size_t max_nbytes() { return 10; }
+};
+
 #endif  // VEGITO_INCLUDE_UTIL_SERIALIZER_H_
@@ -0,0 +1,168 @@
+/** Copyright 2020-2023 Alibaba Group Holding Limited.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef VEGITO_INCLUDE_UTIL_STRING_CHUNKS_H_
+#define VEGITO_INCLUDE_UTIL_STRING_CHUNKS_H_
+
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+namespace gart {
+
+// a packed array of T in the string heap (INT_LIST, LONG_LIST, FLOAT_LIST
+// and DOUBLE_LIST values), elements are not aligned
+template <typename T>
+class ListView {
+ public:
+  ListView() = default;
+
+  explicit ListView(std::string_view bytes)
+      : data_(bytes.data()), size_(bytes.size() / sizeof(T)) {}
+
+  size_t size() const { return size_; }
+
+  bool empty() const { return size_ == 0; }
+
+  T operator[](size_t idx) const {
+    T val;
+    memcpy(&val, data_ + idx * sizeof(T), sizeof(T));
+    return val;
+  }
+
+ private:
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+};
+
+// a STRING_LIST value: the element number, the end offset of each element,
+// and then the elements
+class StringListView {
+ public:
+  StringListView() = default;
+
+  explicit StringListView(std::string_view bytes) : data_(bytes.data()) {
+    if (bytes.size() >= sizeof(uint32_t)) {
+      memcpy(&size_, data_, sizeof(uint32_t));
+    }
+  }
+
+  size_t size() const { return size_; }
+
+  bool empty() const { return size_ == 0; }
+
+  std::string_view operator[](size_t idx) const {
+    uint32_t begin = idx == 0 ? 0 : end_of(idx - 1);
+    const char* elements = data_ + sizeof(uint32_t) * (size_ + 1);
+    return std::string_view(elements + begin, end_of(idx) - begin);
+  }
+
+ private:
+  uint32_t end_of(size_t idx) const {
+    uint32_t end;
+    memcpy(&end, data_ + sizeof(uint32_t) * (idx + 1), sizeof(uint32_t));
+    return end;
+  }
+
+  const char* data_ = nullptr;
+  uint32_t size_ = 0;
+};
+
+/**
+ * Address the strings of the string heap (see src/memory/string_heap.h),
+ * shared by the writer and the readers (GartFragment, EdgeIterator).
+ *
+ * A string is referred to by a key (offset << 16 | length). The offset is
+ * global over the chunks (vineyard blobs) of the heap: the chunk of an
+ * offset is offset >> chunk_bits. A heap published with a single
+ * "string_buffer_object_id" is one chunk covering all offsets.
+ *
+ * Values of LONG_STR_LEN bytes or more have LONG_STR_LEN as the length in
+ * their keys, and their real length is a uint64_t stored before them. A
+ * value larger than a chunk has a blob of its own, which takes consecutive
+ * chunk indexes so its bytes are contiguous in the offset space.
+ *
+ * BYTES and list values are stored as strings, see ListView and
+ * StringListView for the layouts of lists.
+ */
+class StringChunks {
+ public:
+  static constexpr int STR_LEN_BITS = 16;
+  static constexpr int MAX_CHUNK_BITS = 48;
+  static constexpr uint64_t LONG_STR_LEN = (1ul << STR_LEN_BITS) - 1;
+
+  static uint64_t make_key(uint64_t offset, uint64_t len) {
+    return (offset << STR_LEN_BITS) | len;
+  }
+
+  static uint64_t key_offset(uint64_t key) { return key >> STR_LEN_BITS; }
+
+  // LONG_STR_LEN for long values, see get_view for their lengths
+  static uint64_t key_len(uint64_t key) { return key & LONG_STR_LEN; }
+
+  static bool is_long(uint64_t key) { return key_len(key) == LONG_STR_LEN; }
+
+  void set_chunk_bits(int chunk_bits) {
+    chunk_bits_ = chunk_bits;
+    chunk_mask_ = (1ul << chunk_bits) - 1;
+  }
+
+  int get_chunk_bits() const { return chunk_bits_; }
+
+  void reserve(size_t num_chunks) { chunks_.reserve(num_chunks); }
+
+  void add_chunk(char* chunk) { chunks_.push_back(chunk); }
+
+  // for a blob of a large value that is freed
+  void reset_chunk(size_t idx) { chunks_[idx] = nullptr; }
+
+  size_t get_chunk_num() const { return chunks_.size(); }
+
+  char* get(uint64_t offset) const {
+    return chunks_[offset >> chunk_bits_] + (offset & chunk_mask_);
+  }
+
+  std::string_view get_view(uint64_t key) const {
+    const char* data = get(key_offset(key));
+    uint64_t len = key_len(key);
+    if (len == LONG_STR_LEN) {
+      memcpy(&len, data, sizeof(uint64_t));
+      data += sizeof(uint64_t);
+    }
+    return std::string_view(data, len);
+  }
+
+  // the value as a C string (ended by '\0')
+  const char* get_data(uint64_t key) const { return get_view(key).data(); }
+
+  template <typename T>
+  ListView<T> get_list(uint64_t key) const {
+    return ListView<T>(get_view(key));
+  }
+
+  StringListView get_string_list(uint64_t key) const {
+    return StringListView(get_view(key));
+  }
+
+ private:
+  std::vector<char*> chunks_;
+  int chunk_bits_ = MAX_CHUNK_BITS;
+  uint64_t chunk_mask_ = (1ul << MAX_CHUNK_BITS) - 1;
+};
+
+}  // namespace gart
+
+#endif  // VEGITO_INCLUDE_UTIL_STRING_CHUNKS_H_
@@ -0,0 +1,242 @@
+/** Copyright 2020-2023 Alibaba Group Holding Limited.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef VEGITO_INCLUDE_UTIL_UNIFIED_LOG_H_
+#define VEGITO_INCLUDE_UTIL_UNIFIED_LOG_H_
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#include "util/serializer.h"
+
+/**
+ * Binary format of unified logs, shared by the converter (writer) and vegito
+ * (reader). It is used instead of the '|'-separated text format when
+ * --binary_unified_log is set on both sides.
+ *
+ * All integers are unsigned varints, strings are a varint length followed by
+ * the raw bytes:
+ *   op (1 byte) | epoch | binlog offset | body
+ * vertex body: gid | external id | #props | props
+ * edge body:   elabel | src gid | dst gid | src external id | dst external id
+ *              | #props | props
+ * bulkload_end and epoch_begin have no body. A property is a type tag (1 byte,
+ * see UnifiedLogValueType) followed by the value: nothing for null, a zigzag
+ * varint for an integer, 8 little-endian bytes for a double, and a string
+ * for the others, kept as their text. Numbers are thus decoded by vegito
+ * without parsing their text.
+ *
+ * epoch_begin is broadcast to all partitions of the log topic when a new
+ * epoch starts, so a reader merging the partitions knows a partition has no
+ * more logs of the previous epoch.
+ *
+ * The binlog offset is placed in the head (it is the tail of a text log), so
+ * it can be recovered on restart without decoding the body.
+ */
+
+namespace gart {
+
+enum class UnifiedLogOp : uint8_t {
+  ADD_VERTEX = 1,
+  UPDATE_VERTEX = 2,
+  DELETE_VERTEX = 3,
+  ADD_EDGE = 4,
+  DELETE_EDGE = 5,
+  BULKLOAD_END = 6,
+  EPOCH_BEGIN = 7,
+};
+
+inline bool is_vertex_op(UnifiedLogOp op) {
+  return op == UnifiedLogOp::ADD_VERTEX || op == UnifiedLogOp::UPDATE_VERTEX ||
+         op == UnifiedLogOp::DELETE_VERTEX;
+}
+
+inline bool is_edge_op(UnifiedLogOp op) {
+  return op == UnifiedLogOp::ADD_EDGE || op == UnifiedLogOp::DELETE_EDGE;
+}
+
+enum class UnifiedLogValueType : uint8_t {
+  NULL_VALUE = 0,
+  INT = 1,
+  DOUBLE = 2,
+  TEXT = 3,
+};
+
+// a property of a unified log, the text of a TEXT value points into the
+// buffer of the raw log (a text log only has TEXT values)
+struct UnifiedLogValue {
+  UnifiedLogValueType type = UnifiedLogValueType::NULL_VALUE;
+  union {
+    int64_t i = 0;
+    double d;
+  };
+  std::string_view text;
+
+  UnifiedLogValue() = default;
+  explicit UnifiedLogValue(std::string_view t)
+      : type(UnifiedLogValueType::TEXT), text(t) {}
+};
+
+// append fields of a binary unified log to a string
+class UnifiedLogEncoder {
+ public:
+  explicit UnifiedLogEncoder(std::string& buf) : buf_(buf) {}
+
+  void put_op(UnifiedLogOp op) { buf_.push_back(static_cast<char>(op)); }
+
+  void put_uint(uint64_t value) {
+    uint8_t tmp[serializer<uint64_t, true>::max_nbytes()];
+    uint8_t* end = serializer<uint64_t, true>::write(tmp, value);
+    buf_.append(reinterpret_cast<const char*>(tmp), end - tmp);
+  }
+
+  void put_bytes(const char* data, size_t size) {
+    put_uint(size);
+    buf_.append(data, size);
+  }
+
+  void put_bytes(const std::string& str) { put_bytes(str.data(), str.size()); }
+
+  void put_null_value() { put_type_(UnifiedLogValueType::NULL_VALUE); }
+
+  void put_int_value(int64_t value) {
+    put_type_(UnifiedLogValueType::INT);
+    // zigzag, so that small negative values are short
+    put_uint((static_cast<uint64_t>(value) << 1) ^
+             static_cast<uint64_t>(value >> 63));
+  }
+
+  void put_double_value(double value) {
+    put_type_(UnifiedLogValueType::DOUBLE);
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    char tmp[sizeof(bits)];
+    for (size_t idx = 0; idx < sizeof(bits); idx++) {
+      tmp[idx] = static_cast<char>(bits >> (idx * 8));
+    }
+    buf_.append(tmp, sizeof(tmp));
+  }
+
+  void put_text_value(const std::string& str) {
+    put_type_(UnifiedLogValueType::TEXT);
+    put_bytes(str);
+  }
+
+ private:
+  void put_type_(UnifiedLogValueType type) {
+    buf_.push_back(static_cast<char>(type));
+  }
+
+  std::string& buf_;
+};
+
+// read fields of a binary unified log, every getter returns false on a
+// truncated or malformed buffer
+class UnifiedLogDecoder {
+ public:
+  UnifiedLogDecoder(const char* data, size_t size)
+      : cur_(reinterpret_cast<const uint8_t*>(data)), end_(cur_ + size) {}
+
+  bool get_op(UnifiedLogOp* op) {
+    if (unlikely(cur_ == end_)) {
+      return false;
+    }
+    uint8_t raw = *cur_++;
+    if (unlikely(raw < static_cast<uint8_t>(UnifiedLogOp::ADD_VERTEX) ||
+                 raw > static_cast<uint8_t>(UnifiedLogOp::EPOCH_BEGIN))) {
+      return false;
+    }
+    *op = static_cast<UnifiedLogOp>(raw);
+    return true;
+  }
+
+  bool get_uint(uint64_t* value) {
+    const uint8_t* next =
+        serializer<uint64_t, true>::failsafe_read(cur_, end_ - cur_, value);
+    if (unlikely(next == nullptr)) {
+      return false;
+    }
+    cur_ = next;
+    return true;
+  }
+
+  bool get_bytes(const char** data, size_t* size) {
+    uint64_t len;
+    if (unlikely(!get_uint(&len) || len > static_cast<size_t>(end_ - cur_))) {
+      return false;
+    }
+    *data = reinterpret_cast<const char*>(cur_);
+    *size = len;
+    cur_ += len;
+    return true;
+  }
+
+  bool get_value(UnifiedLogValue* value) {
+    if (unlikely(cur_ == end_)) {
+      return false;
+    }
+    uint8_t raw = *cur_++;
+    value->type = static_cast<UnifiedLogValueType>(raw);
+    value->text = std::string_view();
+    switch (value->type) {
+    case UnifiedLogValueType::NULL_VALUE:
+      value->i = 0;
+      return true;
+    case UnifiedLogValueType::INT: {
+      uint64_t zigzag;
+      if (unlikely(!get_uint(&zigzag))) {
+        return false;
+      }
+      value->i = static_cast<int64_t>((zigzag >> 1) ^ (0 - (zigzag & 1)));
+      return true;
+    }
+    case UnifiedLogValueType::DOUBLE: {
+      if (unlikely(end_ - cur_ < static_cast<ptrdiff_t>(sizeof(uint64_t)))) {
+        return false;
+      }
+      uint64_t bits = 0;
+      for (size_t idx = 0; idx < sizeof(bits); idx++) {
+        bits |= static_cast<uint64_t>(cur_[idx]) << (idx * 8);
+      }
+      cur_ += sizeof(bits);
+      memcpy(&value->d, &bits, sizeof(bits));
+      return true;
+    }
+    case UnifiedLogValueType::TEXT: {
+      const char* data;
+      size_t size;
+      if (unlikely(!get_bytes(&data, &size))) {
+        return false;
+      }
+      value->text = std::string_view(data, size);
+      return true;
+    }
+    default:
+      return false;
+    }
+  }
+
+  bool done() const { return cur_ == end_; }
+
+ private:
+  const uint8_t* cur_;
+  const uint8_t* end_;
+};
+
+}  // namespace gart
+
+#endif  // VEGITO_INCLUDE_UTIL_UNIFIED_LOG_H_
@@ -240,4 +240,57 @@ inline size_t size_uvint32(uint32_t value) {
   return 5;
 }
 
+/**
+ * 64-bit variants of the functions above, an encoded uint64_t takes at most
+ * 10 bytes
+ */
+inline uint8_t* write_uvint64(uint8_t* buf, uint64_t value) {
+  while (value > 0x7F) {
+    *buf++ = (((uint8_t) value) & 0x7F) | 0x80;
+    value >>= 7;
+  }
+  *buf++ = ((uint8_t) value) & 0x7F;
+  return buf;
+}
+
+inline ALWAYS_INLINE const uint8_t* read_uvint64(const uint8_t* buf,
+                                                 uint64_t* value) {
+  uint64_t result = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    uint64_t b = *buf++;
+    result |= (b & 0x7F) << shift;
+    if (likely(b < 0x80)) {
+      *value = result;
+      return buf;
+    }
+  }
+  ALWAYS_ASSERT(false);  // should not reach here (improper encoding)
+  return buf;
+}
+
+inline const uint8_t* failsafe_read_uvint64(const uint8_t* buf, size_t nbytes,
+                                            uint64_t* value) {
+  uint64_t result = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    if (unlikely(!nbytes--))
+      return nullptr;
+    uint64_t b = *buf++;
+    result |= (b & 0x7F) << shift;
+    if (likely(b < 0x80)) {
+      *value = result;
+      return buf;
+    }
+  }
+  return nullptr;
+}
+
+inline size_t size_uvint64(uint64_t value) {
+  size_t size = 1;
+  while (value > 0x7F) {
+    value >>= 7;
+    size++;
+  }
+  return size;
+}
+
 #endif  // VEGITO_INCLUDE_UTIL_VARINT_H_
@@ -15,10 +15,15 @@
 #include <stdio.h>
 #include <unistd.h>
 
+#include <chrono>
 #include <cstdint>
 #include <fstream>
+#include <iterator>
+#include <map>
+#include <shared_mutex>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -26,9 +31,11 @@
 #include "yaml-cpp/yaml.h"
 
 #include "framework/bench_runner.h"
+#include "framework/log_merger.h"
 #include "graph/graph_ops.h"
 #include "system_flags.h"
 #include "util/bitset.h"
+#include "util/memory_accounting.h"
 
 using std::ifstream;
 using std::map;
@@ -62,6 +69,80 @@ inline vector<string_view> splitString(const string_view& str, char delimiter) {
   return result;
 }
 
+// max time to wait for a partition in one fetch of unified logs
+constexpr int kConsumeTimeoutMs = 100;
+
+// epoch and binlog offset of a unified log, return false if it is malformed
+inline bool getLogPosition(const string_view& log, int& epoch,
+                           int64_t& offset) {
+  return FLAGS_binary_unified_log
+             ? gart::graph::parse_binary_log_position(log, epoch, offset)
+             : gart::graph::parse_text_log_position(log, epoch, offset);
+}
+
+// call func on each log of a unified log file, text logs are one per line
+// and binary logs are prefixed by their varint length
+template <typename Func>
+void forEachLogInFile(const string& path, Func&& func) {
+  ifstream infile(path);
+  if (!infile) {
+    LOG(ERROR) << "Failed to open unified log file " << path;
+    return;
+  }
+  if (!FLAGS_binary_unified_log) {
+    string line;
+    while (getline(infile, line)) {
+      func(string_view(line));
+    }
+    return;
+  }
+
+  string content((std::istreambuf_iterator<char>(infile)),
+                 std::istreambuf_iterator<char>());
+  const uint8_t* cur = reinterpret_cast<const uint8_t*>(content.data());
+  const uint8_t* end = cur + content.size();
+  while (cur != end) {
+    uint32_t len;
+    cur = failsafe_read_uvint32(cur, end - cur, &len);
+    if (cur == nullptr || len > static_cast<size_t>(end - cur)) {
+      LOG(ERROR) << "Truncated unified log file " << path;
+      return;
+    }
+    func(string_view(reinterpret_cast<const char*>(cur), len));
+    cur += len;
+  }
+}
+
+// copy consumed messages into the merger, a batch of messages is consumed by
+// one consume_callback call
+class MergerConsumeCb : public RdKafka::ConsumeCb {
+ public:
+  explicit MergerConsumeCb(gart::framework::EpochLogMerger& merger)
+      : merger_(merger) {}
+
+  void consume_cb(RdKafka::Message& msg, void* opaque) override {
+    if (msg.err() != RdKafka::ERR_NO_ERROR || msg.len() == 0) {
+      if (msg.err() != RdKafka::ERR_NO_ERROR &&
+          msg.err() != RdKafka::ERR__PARTITION_EOF &&
+          msg.err() != RdKafka::ERR__TIMED_OUT) {
+        LOG(WARNING) << "Failed to consume unified log: " << msg.errstr();
+      }
+      return;
+    }
+    string log(static_cast<const char*>(msg.payload()), msg.len());
+    int epoch;
+    int64_t offset;
+    if (!getLogPosition(log, epoch, offset)) {
+      LOG(ERROR) << "Malformed unified log in partition " << msg.partition();
+      return;
+    }
+    merger_.push(msg.partition(), epoch, offset, std::move(log));
+  }
+
+ private:
+  gart::framework::EpochLogMerger& merger_;
+};
+
 inline string toLowerCase(const string& input) {
   string output = input;
   for (char& c : output) {
@@ -158,8 +239,8 @@ Status init_graph_schema(string etcd_endpoint, string etcd_prefix,
 
   // alloc string buffer
   // TODO(wanglei): hard code
-  graph_store->add_string_buffer((1ul << 30) * 30);  // 30GB
-  graph_store->add_vprop_buffer((1ul << 30) * 30);   // 30GB
+  graph_store->init_string_heap(1ul << 30);         // 1GB per chunk
+  graph_store->add_vprop_buffer((1ul << 30) * 30);  // 30GB
 
   // Parse vertex
   for (int idx = 0; idx < vlabel_num; ++idx) {
@@ -203,6 +284,7 @@ Status init_graph_schema(string etcd_endpoint, string etcd_prefix,
   }
 
   graph_store->init_edge_bitmap_size(elabel_num);
+  graph_store->init_edge_nums(elabel_num);
 
   for (auto idx = 0; idx < vlabel_num; ++idx) {
     graph_store->set_max_vertex_num(idx, FLAGS_default_max_vertex_number);
@@ -325,8 +407,35 @@ Status init_graph_schema(string etcd_endpoint, string etcd_prefix,
             prop_dtype = "DOUBLE";
           } else if (prop_dtype_str.rfind("varchar", 0) == 0 ||
                      prop_dtype_str == "character varying" ||
-                     prop_dtype_str == "text") {
+                     prop_dtype_str == "text" ||
+                     prop_dtype_str == "mediumtext" ||
+                     prop_dtype_str == "longtext" || prop_dtype_str == "json" ||
+                     prop_dtype_str == "jsonb") {
             prop_dtype = "STRING";
+          } else if (prop_dtype_str == "bytea" || prop_dtype_str == "blob" ||
+                     prop_dtype_str == "mediumblob" ||
+                     prop_dtype_str == "longblob" ||
+                     prop_dtype_str.rfind("binary", 0) == 0 ||
+                     prop_dtype_str.rfind("varbinary", 0) == 0) {
+            prop_dtype = "BYTES";
+          } else if (prop_dtype_str == "integer[]" ||
+                     prop_dtype_str == "int[]" || prop_dtype_str == "_int4") {
+            prop_dtype = "INT_LIST";
+          } else if (prop_dtype_str == "bigint[]" ||
+                     prop_dtype_str == "_int8") {
+            prop_dtype = "LONG_LIST";
+          } else if (prop_dtype_str == "real[]" ||
+                     prop_dtype_str == "float[]" ||
+                     prop_dtype_str == "_float4") {
+            prop_dtype = "FLOAT_LIST";
+          } else if (prop_dtype_str == "double precision[]" ||
+                     prop_dtype_str == "_float8") {
+            prop_dtype = "DOUBLE_LIST";
+          } else if (prop_dtype_str == "text[]" ||
+                     prop_dtype_str == "character varying[]" ||
+                     prop_dtype_str == "_text" ||
+                     prop_dtype_str == "_varchar") {
+            prop_dtype = "STRING_LIST";
           } else if (prop_dtype_str == "timestamp" ||
                      prop_dtype_str.rfind("timestamp(", 0) == 0 ||
                      prop_dtype_str == "timestamp with time zone") {
@@ -419,6 +528,27 @@ Status init_graph_schema(string etcd_endpoint, string etcd_prefix,
                                                      edge_prop_prefix_bytes);
           edge_prop_prefix_bytes += sizeof(int64_t);
         }
+      } else if (prop_dtype == "BYTES" || prop_dtype == "INT_LIST" ||
+                 prop_dtype == "LONG_LIST" || prop_dtype == "FLOAT_LIST" ||
+                 prop_dtype == "DOUBLE_LIST" || prop_dtype == "STRING_LIST") {
+        // stored in the string heap like strings
+        static const std::map<string, PropertyDataType> heap_dtypes = {
+            {"BYTES", BYTES},
+            {"INT_LIST", INT_LIST},
+            {"LONG_LIST", LONG_LIST},
+            {"FLOAT_LIST", FLOAT_LIST},
+            {"DOUBLE_LIST", DOUBLE_LIST},
+            {"STRING_LIST", STRING_LIST}};
+        PropertyDataType dtype = heap_dtypes.at(prop_dtype);
+        graph_schema.dtype_map[{id, prop_id}] = dtype;
+        if (is_vertex) {
+          column_family_info[column_family_id].vlen += sizeof(uint64_t);
+        } else {
+          graph_store->insert_edge_property_dtypes(id, prop_id, dtype);
+          graph_store->insert_edge_prop_prefix_bytes(id, prop_id,
+                                                     edge_prop_prefix_bytes);
+          edge_prop_prefix_bytes += sizeof(uint64_t);
+        }
       } else if (prop_dtype == "DATE") {
         graph_schema.dtype_map[{id, prop_id}] = DATE;
         if (is_vertex) {
@@ -467,6 +597,20 @@ Status init_graph_schema(string etcd_endpoint, string etcd_prefix,
         return Status::TypeError();
       }
 
+      // optional secondary index, e.g., "index: hash"
+      if (is_vertex && prop_info[prop_idx]["index"]) {
+        string index_name = prop_info[prop_idx]["index"].as<string>();
+        PropertyIndexType index_type = parse_property_index_type(index_name);
+        if (index_type == NO_INDEX ||
+            !graph_store->add_vprop_index(
+                id, prop_id, graph_schema.dtype_map[{id, prop_id}],
+                index_type)) {
+          LOG(ERROR) << "Unsupported index " << index_name << " on property "
+                     << prop_name << " (" << prop_dtype << ") of "
+                     << table_name;
+        }
+      }
+
       graph_schema.property_id_map[std::make_pair(prop_name, idx)] =
           prop_offset;
       prop_offset++;
@@ -519,86 +663,205 @@ Status init_graph_schema(string etcd_endpoint, string etcd_prefix,
 
 #ifdef USE_MULTI_THREADS
 void Runner::process_log_thread(int pid, int thread_id) {
-  std::string log_str;
+  auto& logs = *worker_logs_[thread_id];
+  std::unique_ptr<WorkerLog> worker_log;
+  // consecutive add_edge logs, only counted as applied once flushed. The
+  // batch is flushed before the worker may block, so no other worker waits
+  // for it forever
+  graph::AddEdgeBatch edge_batch(graph_stores_[pid]);
+  auto flush_edges = [&]() {
+    if (edge_batch.size() > 0) {
+      int64_t num = edge_batch.size();
+      edge_batch.flush();
+      log_applied_(thread_id, num);
+    }
+  };
   while (true) {
-    while (!logs_.try_pop(log_str)) {
-      working_state_mutex_[thread_id]->lock_shared();
-      bool is_working = is_working_[thread_id];
-      working_state_mutex_[thread_id]->unlock_shared();
-      if (is_working) {
-        working_state_mutex_[thread_id]->lock();
-        is_working_[thread_id] = false;
-        working_state_mutex_[thread_id]->unlock();
+    if (edge_batch.size() == 0) {
+      logs.wait_dequeue(worker_log);
+    } else if (!logs.try_dequeue(worker_log)) {
+      flush_edges();
+      continue;
+    }
+    if (worker_log->wait_worker >= 0 &&
+        applied_logs_[worker_log->wait_worker].num.load(
+            std::memory_order_acquire) < worker_log->wait_applied) {
+      flush_edges();
+      wait_applied_(worker_log->wait_worker, worker_log->wait_applied);
+    }
+    const graph::LogRecord& record = worker_log->record;
+    if (record.op == UnifiedLogOp::ADD_EDGE) {
+      edge_batch.add(record);
+      worker_log.reset();
+      if (edge_batch.size() >= static_cast<size_t>(FLAGS_edge_batch_size)) {
+        flush_edges();
       }
-      std::this_thread::yield();
+      continue;
     }
-    working_state_mutex_[thread_id]->lock_shared();
-    bool is_working = is_working_[thread_id];
-    working_state_mutex_[thread_id]->unlock_shared();
-    if (!is_working) {
-      working_state_mutex_[thread_id]->lock();
-      is_working_[thread_id] = true;
-      working_state_mutex_[thread_id]->unlock();
+    flush_edges();
+    switch (record.op) {
+    case UnifiedLogOp::ADD_VERTEX:
+      process_add_vertex(record, graph_stores_[pid]);
+      break;
+    case UnifiedLogOp::DELETE_EDGE:
+      process_del_edge(record, graph_stores_[pid]);
+      break;
+    case UnifiedLogOp::UPDATE_VERTEX:
+      process_update_vertex(record, graph_stores_[pid]);
+      break;
+    default:
+      LOG(ERROR) << "Unsupported operator " << static_cast<int>(record.op);
     }
-    std::string_view log(log_str);
-    auto sv_vec = splitString(log, '|');
-    string_view op(sv_vec[0]);
-    int cur_epoch = stoi(string(sv_vec[1]));
-    sv_vec.erase(sv_vec.begin(), sv_vec.begin() + 1);
-    sv_vec.pop_back();
-    if (op == "add_vertex") {
-      process_add_vertex(sv_vec, graph_stores_[pid]);
-    } else if (op == "add_edge") {
-      process_add_edge(sv_vec, graph_stores_[pid]);
-    } else if (op == "delete_vertex") {
-      process_del_vertex(sv_vec, graph_stores_[pid]);
-    } else if (op == "delete_edge") {
-      process_del_edge(sv_vec, graph_stores_[pid]);
-    } else if (op == "update_vertex") {
-      process_update_vertex(sv_vec, graph_stores_[pid]);
-    } else {
-      LOG(ERROR) << "Unsupported operator " << op;
+    worker_log.reset();
+    log_applied_(thread_id, 1);
+  }
+}
+
+void Runner::log_applied_(int thread_id, int64_t num) {
+  AppliedLogs& applied = applied_logs_[thread_id];
+  // sequentially consistent with the waiters, so either a waiter sees the
+  // new number or it is seen here and notified
+  applied.num.fetch_add(num);
+  if (applied.waiters.load() > 0) {
+    std::lock_guard<std::mutex> lock(applied.mutex);
+    applied.cv.notify_all();
+  }
+  if (pending_logs_.fetch_sub(num) == num) {
+    std::lock_guard<std::mutex> lock(barrier_mutex_);
+    barrier_cv_.notify_all();
+  }
+}
+
+void Runner::wait_applied_(int thread_id, uint64_t num) {
+  AppliedLogs& applied = applied_logs_[thread_id];
+  std::unique_lock<std::mutex> lock(applied.mutex);
+  applied.waiters.fetch_add(1);
+  applied.cv.wait(lock, [&applied, num] { return applied.num.load() >= num; });
+  applied.waiters.fetch_sub(1);
+}
+
+void Runner::dispatch_log_(std::unique_ptr<WorkerLog> worker_log, int p_id) {
+  const graph::LogRecord& record = worker_log->record;
+  const auto& id_parser = graph_stores_[p_id]->id_parser;
+  int local_pid = graph_stores_[p_id]->get_local_pid();
+  size_t num_workers = worker_logs_.size();
+  int owner = record.vid % num_workers;
+  if (record.op == UnifiedLogOp::ADD_EDGE ||
+      record.op == UnifiedLogOp::DELETE_EDGE) {
+    int dst_owner = record.dst_vid % num_workers;
+    if (id_parser.GetFid(record.vid) != local_pid) {
+      owner = dst_owner;
+    } else if (id_parser.GetFid(record.dst_vid) == local_pid &&
+               dst_owner != owner) {
+      // the in-edges of the destination need its logs before, which are
+      // dispatched to dst_owner, and the dependencies always point to earlier
+      // logs, so workers never wait for each other in a cycle
+      worker_log->wait_worker = dst_owner;
+      worker_log->wait_applied = dispatched_logs_[dst_owner];
     }
   }
+  dispatched_logs_[owner]++;
+  pending_logs_.fetch_add(1);
+  worker_logs_[owner]->enqueue(std::move(worker_log));
 }
+
+void Runner::wait_for_workers_() {
+  std::unique_lock<std::mutex> lock(barrier_mutex_);
+  barrier_cv_.wait(lock, [this] { return pending_logs_.load() == 0; });
+}
+#endif
+
+bool Runner::parse_log_(const string_view& log, graph::LogRecord& record) {
+  if (FLAGS_binary_unified_log) {
+    return parse_binary_log(log, record);
+  }
+  return parse_text_log(log, record);
+}
+
+void Runner::reserve_vertex_(const graph::LogRecord& record, int p_id) {
+  graph::GraphStore* graph_store = graph_stores_[p_id];
+  const auto& id_parser = graph_store->id_parser;
+  int local_pid = graph_store->get_local_pid();
+  uint64_t vid;
+  bool outer;
+  if (record.op == UnifiedLogOp::ADD_VERTEX) {
+    if (id_parser.GetFid(record.vid) != local_pid) {
+      return;
+    }
+    vid = record.vid;
+    outer = false;
+  } else if (record.op == UnifiedLogOp::ADD_EDGE) {
+    bool src_local = id_parser.GetFid(record.vid) == local_pid;
+    bool dst_local = id_parser.GetFid(record.dst_vid) == local_pid;
+    if (src_local == dst_local) {
+      return;
+    }
+    vid = src_local ? record.dst_vid : record.vid;
+    outer = true;
+  } else {
+    return;
+  }
+
+  uint64_t vlabel = id_parser.GetLabelId(vid);
+  uint64_t voffset = id_parser.GetOffset(vid);
+  auto outer_exists = [&]() {
+#ifdef USE_MULTI_THREADS
+    auto mutex = graph_store->get_outer_vertex_label_mutex(vlabel);
+    std::shared_lock<std::shared_timed_mutex> lock(*mutex);
+#endif
+    return graph_store->get_lid(vlabel, vid) != uint64_t(-1);
+  };
+  if (outer && outer_exists()) {
+    return;
+  }
+  if (likely(graph_store->reserve_vertex(vlabel, outer, voffset))) {
+    return;
+  }
+#ifdef USE_MULTI_THREADS
+  // the arrays are replaced, no worker may write them meanwhile
+  wait_for_workers_();
 #endif
+  if (outer && outer_exists()) {
+    return;
+  }
+  graph_store->grow_vertex_arrays(vlabel, outer, voffset, record.epoch);
+}
 
 void Runner::apply_log_to_store_(const string_view& log, int p_id) {
-#ifndef USE_MULTI_THREADS
-  auto sv_vec = splitString(log, '|');
-  string_view op(sv_vec[0]);
-  int cur_epoch = stoi(string(sv_vec[1]));
+#ifdef USE_MULTI_THREADS
+  // parsed once, in the buffer handed over to a worker
+  auto worker_log = std::make_unique<WorkerLog>();
+  worker_log->log.assign(log.data(), log.size());
+  graph::LogRecord& record = worker_log->record;
+  if (unlikely(!parse_log_(worker_log->log, record))) {
 #else
-  size_t firstDelim = log.find('|');
-  size_t secondDelim = log.find('|', firstDelim + 1);
-  std::string_view op = log.substr(0, firstDelim);
-  int cur_epoch = stoi(
-      std::string(log.substr(firstDelim + 1, secondDelim - firstDelim - 1)));
+  graph::LogRecord& record = log_record_;
+  if (unlikely(!parse_log_(log, record))) {
 #endif
+    if (FLAGS_binary_unified_log) {
+      LOG(ERROR) << "Malformed unified log of " << log.size() << " bytes";
+    } else {
+      LOG(ERROR) << "Malformed unified log: " << log;
+    }
+    return;
+  }
+  int cur_epoch = record.epoch;
 
 #ifdef USE_MULTI_THREADS
   if (cur_epoch > latest_epoch_) {
-    while (!logs_.empty()) {
-      std::this_thread::yield();
-    }
-
-    for (auto idx = 0; idx < FLAGS_num_threads; idx++) {
-      while (true) {
-        working_state_mutex_[idx]->lock_shared();
-        bool is_working = is_working_[idx];
-        working_state_mutex_[idx]->unlock_shared();
-        if (is_working) {
-          std::this_thread::yield();
-        } else {
-          break;
-        }
-      }
-    }
+    wait_for_workers_();
 
     graph_stores_[p_id]->update_blob(latest_epoch_);
     graph_stores_[p_id]->insert_blob_schema(latest_epoch_);
     // put schema to etcd
     graph_stores_[p_id]->put_blob_json_etcd(latest_epoch_);
+    // compact anyway if memory is short, deleted edges are the cheapest
+    // memory to give back
+    if (FLAGS_enable_compaction ||
+        graph_stores_[p_id]->check_memory_pressure()) {
+      graph_stores_[p_id]->compact_graphs(cur_epoch);
+    }
+    graph_stores_[p_id]->recycle_graphs(cur_epoch);
     auto endTime = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
                         endTime - start_time_)
@@ -611,12 +874,26 @@ void Runner::apply_log_to_store_(const string_view& log, int p_id) {
     latest_epoch_ = cur_epoch;
   }
 #else
+  if (!edge_batch_) {
+    edge_batch_ = std::make_unique<graph::AddEdgeBatch>(graph_stores_[p_id]);
+  }
+  // the batched edges are of the last epoch and do not move over other logs
+  if (record.op != UnifiedLogOp::ADD_EDGE || cur_epoch > latest_epoch_) {
+    edge_batch_->flush();
+  }
 
   if (cur_epoch > latest_epoch_) {
     graph_stores_[p_id]->update_blob(latest_epoch_);
     graph_stores_[p_id]->insert_blob_schema(latest_epoch_);
     // put schema to etcd
     graph_stores_[p_id]->put_blob_json_etcd(latest_epoch_);
+    // compact anyway if memory is short, deleted edges are the cheapest
+    // memory to give back
+    if (FLAGS_enable_compaction ||
+        graph_stores_[p_id]->check_memory_pressure()) {
+      graph_stores_[p_id]->compact_graphs(cur_epoch);
+    }
+    graph_stores_[p_id]->recycle_graphs(cur_epoch);
 
     auto endTime = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
@@ -631,7 +908,7 @@ void Runner::apply_log_to_store_(const string_view& log, int p_id) {
   }
 #endif
 
-  if (unlikely(op == "bulkload_end")) {
+  if (unlikely(record.op == UnifiedLogOp::BULKLOAD_END)) {
     cout << "Completion of bulkload and transition to epoch " << cur_epoch
          << endl;
     for (int i = 0; i < graph_stores_[p_id]->get_total_vertex_label_num();
@@ -666,80 +943,79 @@ void Runner::apply_log_to_store_(const string_view& log, int p_id) {
     }
     return;
   }
-#ifndef USE_MULTI_THREADS
-  sv_vec.erase(sv_vec.begin(), sv_vec.begin() + 1);
-  // remove the last element of sv_vec, since the last element of sv_vec is
-  // offset of binlog
-  sv_vec.pop_back();
-#endif
-
+  if (record.op == UnifiedLogOp::EPOCH_BEGIN) {
+    // only marks the start of an epoch in one partition
+    return;
+  }
+  reserve_vertex_(record, p_id);
 #ifdef USE_MULTI_THREADS
-  if (op == "add_vertex" || op == "add_edge") {
-    if (parallel_state_) {
-      logs_.push(std::string(log));
-    } else {
-      while (!logs_.empty()) {
-        std::this_thread::yield();
-      }
-
-      for (auto idx = 0; idx < FLAGS_num_threads; idx++) {
-        while (true) {
-          working_state_mutex_[idx]->lock_shared();
-          bool is_working = is_working_[idx];
-          working_state_mutex_[idx]->unlock_shared();
-          if (is_working) {
-            std::this_thread::yield();
-          } else {
-            break;
-          }
-        }
-      }
-
-      logs_.push(std::string(log));
-      parallel_state_ = true;
-    }
-  } else if (op == "delete_vertex" || op == "delete_edge" ||
-             op == "update_vertex") {
-    parallel_state_ = false;
-    while (!logs_.empty()) {
-      std::this_thread::yield();
-    }
-
-    for (auto idx = 0; idx < FLAGS_num_threads; idx++) {
-      while (true) {
-        working_state_mutex_[idx]->lock_shared();
-        bool is_working = is_working_[idx];
-        working_state_mutex_[idx]->unlock_shared();
-        if (is_working) {
-          std::this_thread::yield();
-        } else {
-          break;
-        }
-      }
+  switch (record.op) {
+  case UnifiedLogOp::ADD_VERTEX:
+  case UnifiedLogOp::UPDATE_VERTEX:
+  case UnifiedLogOp::ADD_EDGE:
+  case UnifiedLogOp::DELETE_EDGE:
+    dispatch_log_(std::move(worker_log), p_id);
+    break;
+  case UnifiedLogOp::DELETE_VERTEX:
+    // deleting a vertex touches the edges of all its neighbors, which may be
+    // owned by any worker
+    wait_for_workers_();
+    process_del_vertex(record, graph_stores_[p_id]);
+    break;
+  default:
+    LOG(ERROR) << "Unsupported operator " << static_cast<int>(record.op);
+  }
+#else
+  switch (record.op) {
+  case UnifiedLogOp::ADD_VERTEX:
+    process_add_vertex(record, graph_stores_[p_id]);
+    break;
+  case UnifiedLogOp::ADD_EDGE:
+    edge_batch_->add(record);
+    if (edge_batch_->size() >= static_cast<size_t>(FLAGS_edge_batch_size)) {
+      edge_batch_->flush();
     }
-
-    logs_.push(std::string(log));
-  } else {
-    LOG(ERROR) << "Unsupported operator " << op;
+    break;
+  case UnifiedLogOp::DELETE_VERTEX:
+    process_del_vertex(record, graph_stores_[p_id]);
+    break;
+  case UnifiedLogOp::DELETE_EDGE:
+    process_del_edge(record, graph_stores_[p_id]);
+    break;
+  case UnifiedLogOp::UPDATE_VERTEX:
+    process_update_vertex(record, graph_stores_[p_id]);
+    break;
+  default:
+    LOG(ERROR) << "Unsupported operator " << static_cast<int>(record.op);
   }
-  return;
 #endif
+}
 
-#ifndef USE_MULTI_THREADS
-  if (op == "add_vertex") {
-    process_add_vertex(sv_vec, graph_stores_[p_id]);
-  } else if (op == "add_edge") {
-    process_add_edge(sv_vec, graph_stores_[p_id]);
-  } else if (op == "delete_vertex") {
-    process_del_vertex(sv_vec, graph_stores_[p_id]);
-  } else if (op == "delete_edge") {
-    process_del_edge(sv_vec, graph_stores_[p_id]);
-  } else if (op == "update_vertex") {
-    process_update_vertex(sv_vec, graph_stores_[p_id]);
-  } else {
-    LOG(ERROR) << "Unsupported operator " << op;
+void Runner::relieve_memory_pressure_(int p_id) {
+  // checked once per refresh interval of the accounting, or after each
+  // backoff while under pressure
+  auto now = std::chrono::steady_clock::now();
+  if (now < next_pressure_check_) {
+    return;
   }
-#endif
+  if (!graph_stores_[p_id]->check_memory_pressure()) {
+    next_pressure_check_ = now + std::chrono::milliseconds(
+                                     FLAGS_memory_status_refresh_interval_ms);
+    return;
+  }
+
+  static auto last_warning = std::chrono::steady_clock::time_point();
+  if (now - last_warning > std::chrono::seconds(10)) {
+    LOG(WARNING) << "Memory pressure in subgraph " << p_id << ", slow down "
+                 << "consuming logs: "
+                 << MemoryAccounting::instance().to_string();
+    last_warning = now;
+  }
+  // no lock is held here, the workers go on with the logs dispatched to
+  // them, and the memory retired by readers is recycled at the next epoch
+  // boundary (recycling in the middle of an epoch would race with them)
+  std::this_thread::sleep_for(
+      std::chrono::milliseconds(FLAGS_memory_pressure_backoff_ms));
 }
 
 Status Runner::start_kafka_to_process_(int p_id) {
@@ -773,35 +1049,68 @@ Status Runner::start_kafka_to_process_(int p_id) {
 
   RdKafka::Topic* topic = RdKafka::Topic::create(
       consumer, FLAGS_kafka_unified_log_topic, tconf, rdkafka_err);
-  int32_t partition = 0;
+  int num_partitions = FLAGS_kafka_unified_log_partition_num;
   int64_t start_offset = RdKafka::Topic::OFFSET_BEGINNING;
 
-  RdKafka::ErrorCode resp = consumer->start(topic, partition, start_offset);
-  if (resp != RdKafka::ERR_NO_ERROR) {
-    LOG(WARNING) << "Failed to start consumer: " << RdKafka::err2str(resp);
-    exit(1);
+  for (int32_t partition = 0; partition < num_partitions; partition++) {
+    RdKafka::ErrorCode resp = consumer->start(topic, partition, start_offset);
+    if (resp != RdKafka::ERR_NO_ERROR) {
+      LOG(WARNING) << "Failed to start consumer of partition " << partition
+                   << ": " << RdKafka::err2str(resp);
+      exit(1);
+    }
   }
 
-  printf("Start main loop for subgraph %d ...\n", p_id);
+  printf("Start main loop for subgraph %d with %d partitions ...\n", p_id,
+         num_partitions);
   start_time_ = std::chrono::high_resolution_clock::now();
+  EpochLogMerger merger(num_partitions);
+  MergerConsumeCb consume_cb(merger);
+  std::string log;
   while (1) {
-    RdKafka::Message* msg = consumer->consume(topic, partition, 1000);
-    const char* log_base = static_cast<const char*>(msg->payload());
-    size_t log_bytes = msg->len();
-    if (log_bytes == 0) {
-      continue;
+    relieve_memory_pressure_(p_id);
+    // only fetch partitions without buffered logs, the merger waits for them
+    for (int32_t partition = 0; partition < num_partitions; partition++) {
+      if (merger.empty(partition)) {
+        consumer->consume_callback(topic, partition, kConsumeTimeoutMs,
+                                   &consume_cb, nullptr);
+      }
+    }
+    while (merger.pop(log)) {
+      apply_log_to_store_(log, p_id);
     }
-    string_view log(log_base, log_bytes);
-    apply_log_to_store_(log, p_id);
-    delete msg;
   }
 }
 
 void Runner::start_file_stream_to_process_(int p_id) {
-  ifstream infile(FLAGS_kafka_unified_log_file);
-  string line;
-  while (getline(infile, line)) {
-    apply_log_to_store_(line, p_id);
+  int num_partitions = FLAGS_kafka_unified_log_partition_num;
+  if (num_partitions == 1) {
+    forEachLogInFile(FLAGS_kafka_unified_log_file,
+                     [&](const string_view& log) {
+                       apply_log_to_store_(log, p_id);
+                     });
+    return;
+  }
+
+  // partition i is stored in <kafka_unified_log_file>.i
+  EpochLogMerger merger(num_partitions);
+  for (int partition = 0; partition < num_partitions; partition++) {
+    forEachLogInFile(
+        FLAGS_kafka_unified_log_file + "." + std::to_string(partition),
+        [&](const string_view& log) {
+          int epoch;
+          int64_t offset;
+          if (!getLogPosition(log, epoch, offset)) {
+            LOG(ERROR) << "Malformed unified log in partition " << partition;
+            return;
+          }
+          merger.push(partition, epoch, offset, string(log));
+        });
+    merger.finish(partition);
+  }
+  std::string log;
+  while (merger.pop(log)) {
+    apply_log_to_store_(log, p_id);
   }
 }
 
@@ -844,15 +1153,21 @@ void Runner::load_graph_partitions_from_logs_(int mac_id,
 }
 
 void Runner::run() {
+  auto& accounting = MemoryAccounting::instance();
+  accounting.set_soft_limit_ratio(FLAGS_v6d_memory_soft_limit_ratio);
+  accounting.set_refresh_interval_ms(FLAGS_memory_status_refresh_interval_ms);
+
   /*************** Load Data ****************/
   int mac_id = gart::framework::config.getServerID();
   int total_partitions = gart::framework::config.getNumServers();
 #ifdef USE_MULTI_THREADS
-  working_state_mutex_.resize(FLAGS_num_threads);
   for (auto idx = 0; idx < FLAGS_num_threads; idx++) {
-    is_working_.push_back(true);
-    working_state_mutex_[idx] = std::make_shared<std::shared_timed_mutex>();
+    worker_logs_.emplace_back(
+        std::make_unique<moodycamel::BlockingReaderWriterQueue<
+            std::unique_ptr<WorkerLog>>>());
   }
+  dispatched_logs_.resize(FLAGS_num_threads, 0);
+  applied_logs_ = std::make_unique<AppliedLogs[]>(FLAGS_num_threads);
 #endif
 
   load_graph_partitions_from_logs_(mac_id, total_partitions);
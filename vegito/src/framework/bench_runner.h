@@ -16,15 +16,21 @@
 #ifndef VEGITO_SRC_FRAMEWORK_BENCH_RUNNER_H_
 #define VEGITO_SRC_FRAMEWORK_BENCH_RUNNER_H_
 
+#include <memory>
 #include <shared_mutex>
 #include <vector>
 
 #ifdef USE_MULTI_THREADS
-#include <tbb/concurrent_queue.h>
+#include <readerwriterqueue/readerwriterqueue.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
 #include <thread>
 #endif
 
 #include "graph/ddl.h"
+#include "graph/graph_ops.h"
 #include "graph/graph_store.h"
 #include "util/status.h"
 
@@ -44,23 +50,70 @@ class Runner {
   std::vector<graph::RGMapping*> rg_maps_;
 
 #ifdef USE_MULTI_THREADS
-  tbb::concurrent_queue<std::string> logs_;
-  bool parallel_state_ = true;
-  std::vector<bool> is_working_;
-  std::vector<std::shared_ptr<std::shared_timed_mutex>> working_state_mutex_;
+  // a log handed over to a worker, parsed once by the dispatcher (the views
+  // of record point into log)
+  struct WorkerLog {
+    std::string log;
+    graph::LogRecord record;
+    // applied after worker wait_worker has applied wait_applied logs
+    int wait_worker = -1;
+    uint64_t wait_applied = 0;
+  };
+
+  struct alignas(64) AppliedLogs {
+    std::atomic<uint64_t> num{0};
+    // the workers blocked on num, notified only if there are any
+    std::atomic<int> waiters{0};
+    std::mutex mutex;
+    std::condition_variable cv;
+  };
+
+  // logs are routed to workers by the owner vertex (the source vertex of
+  // edges, or the destination if the source is remote), so the logs of a
+  // vertex are applied in order by one worker. An edge whose destination is
+  // owned by another worker waits for the logs dispatched to that worker
+  // before it, e.g., the add_vertex of the destination.
+  std::vector<std::unique_ptr<
+      moodycamel::BlockingReaderWriterQueue<std::unique_ptr<WorkerLog>>>>
+      worker_logs_;
+  std::vector<uint64_t> dispatched_logs_;  // by the dispatcher only
+  std::unique_ptr<AppliedLogs[]> applied_logs_;
+  // number of dispatched logs not applied yet, for epoch barriers
+  std::atomic<int64_t> pending_logs_{0};
+  std::mutex barrier_mutex_;
+  std::condition_variable barrier_cv_;
+#endif
+
+  // reused by apply_log_to_store_ to avoid allocations
+  graph::LogRecord log_record_;
+#ifndef USE_MULTI_THREADS
+  // consecutive add_edge logs, see graph::AddEdgeBatch
+  std::unique_ptr<graph::AddEdgeBatch> edge_batch_;
 #endif
 
   uint64_t latest_epoch_ = 0;
   std::chrono::high_resolution_clock::time_point start_time_;
+  // see relieve_memory_pressure_
+  std::chrono::steady_clock::time_point next_pressure_check_;
 
  private:
   void load_graph_partitions_(int mac_id, int total_partitions);
   void load_graph_partitions_from_logs_(int mac_id, int total_partitions);
+  bool parse_log_(const std::string_view& log, graph::LogRecord& record);
   void apply_log_to_store_(const std::string_view& log, int p_id);
+  // make room in the vertex arrays for the vertex the log may add
+  void reserve_vertex_(const graph::LogRecord& record, int p_id);
   Status start_kafka_to_process_(int p_id);
+  // pause consuming logs if the store is close to its memory limits
+  void relieve_memory_pressure_(int p_id);
   void start_file_stream_to_process_(int p_id);
 #ifdef USE_MULTI_THREADS
   void process_log_thread(int p_id, int thread_id);
+  void dispatch_log_(std::unique_ptr<WorkerLog> worker_log, int p_id);
+  void log_applied_(int thread_id, int64_t num);
+  // block until worker thread_id has applied num logs
+  void wait_applied_(int thread_id, uint64_t num);
+  void wait_for_workers_();
 #endif
 };
 
@@ -0,0 +1,97 @@
+/** Copyright 2020-2023 Alibaba Group Holding Limited.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef VEGITO_SRC_FRAMEWORK_LOG_MERGER_H_
+#define VEGITO_SRC_FRAMEWORK_LOG_MERGER_H_
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace gart {
+namespace framework {
+
+/**
+ * Merge unified logs read from several partitions of the log topic.
+ *
+ * Logs are released in the order the converter wrote them, i.e. by epoch and
+ * then by binlog offset, which increase in every partition. A log is
+ * released only when every unfinished partition has a buffered log, so no
+ * partition can still have an earlier one. This keeps snapshots consistent
+ * (a snapshot never misses the logs of a slower partition), and keeps logs
+ * of different owners in order, e.g. delete_vertex(b) (sharded by b) and
+ * add_edge(a -> b) (sharded by a).
+ *
+ * A partition without logs in an epoch is unblocked by the epoch_begin
+ * marker of the next epoch.
+ */
+class EpochLogMerger {
+ public:
+  explicit EpochLogMerger(int num_partitions)
+      : queues_(num_partitions), finished_(num_partitions, false) {}
+
+  void push(int partition, int epoch, int64_t offset, std::string&& log) {
+    queues_[partition].push_back(Entry{epoch, offset, std::move(log)});
+  }
+
+  // no more logs from the partition
+  void finish(int partition) { finished_[partition] = true; }
+
+  bool empty(int partition) const { return queues_[partition].empty(); }
+
+  // return false if no log can be released until more logs are pushed
+  bool pop(std::string& log) {
+    int min_p = -1;
+    for (size_t p = 0; p < queues_.size(); p++) {
+      if (queues_[p].empty()) {
+        if (!finished_[p]) {
+          return false;
+        }
+        continue;
+      }
+      if (min_p < 0 || queues_[p].front() < queues_[min_p].front()) {
+        min_p = p;
+      }
+    }
+    if (min_p < 0) {
+      return false;
+    }
+    log = std::move(queues_[min_p].front().log);
+    queues_[min_p].pop_front();
+    return true;
+  }
+
+ private:
+  struct Entry {
+    int epoch;
+    int64_t offset;
+    std::string log;
+
+    bool operator<(const Entry& other) const {
+      return epoch != other.epoch ? epoch < other.epoch
+                                  : offset < other.offset;
+    }
+  };
+
+  std::vector<std::deque<Entry>> queues_;
+  std::vector<bool> finished_;
+};
+
+}  // namespace framework
+}  // namespace gart
+
+#endif  // VEGITO_SRC_FRAMEWORK_LOG_MERGER_H_
@@ -0,0 +1,252 @@
+/** Copyright 2020-2023 Alibaba Group Holding Limited.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "graph/dest_fid_table.h"
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+#include "glog/logging.h"
+
+namespace gart {
+namespace graph {
+
+DestFidTable::DestFidTable(vineyard::Client* v6d_client, int vlabel)
+    : array_allocator_(v6d_client), vlabel_(vlabel) {
+  array_allocator_.set_accounting(MemoryComponent::OTHERS, vlabel);
+}
+
+DestFidTable::~DestFidTable() {
+  for (auto& pair : tables_) {
+    for (const Chunk& chunk : pair.second) {
+      if (chunk.oid != 0) {
+        array_allocator_.deallocate_v6d(chunk.oid);
+      }
+    }
+  }
+  for (const auto& retired : retired_) {
+    array_allocator_.deallocate_v6d(retired.oid);
+  }
+}
+
+void DestFidTable::add(int elabel, uint64_t voffset, uint64_t fid,
+                       seggraph::dir_t dir) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  LabelTable& table = tables_[elabel];
+  uint64_t chunk_id = voffset >> CHUNK_BITS;
+  uint64_t idx = voffset & (CHUNK_SIZE - 1);
+  if (chunk_id >= table.size()) {
+    table.resize(chunk_id + 1);
+  }
+  Chunk& chunk = table[chunk_id];
+  if (idx >= chunk.vertices.size()) {
+    chunk.vertices.resize(idx + 1);
+  }
+  chunk.max_vertex = std::max(chunk.max_vertex, idx + 1);
+  auto& fids = chunk.vertices[idx];
+  auto iter = std::lower_bound(
+      fids.begin(), fids.end(), fid,
+      [](const FidCount& count, uint64_t fid) { return count.fid < fid; });
+  if (iter == fids.end() || iter->fid != fid) {
+    iter = fids.insert(iter, FidCount{fid, 0, 0});
+    chunk.dirty = true;
+  }
+  if (dir == seggraph::EIN) {
+    chunk.dirty |= iter->in_num++ == 0;
+  } else {
+    chunk.dirty |= iter->out_num++ == 0;
+  }
+}
+
+std::vector<DestFidTable::FidCount>* DestFidTable::find_(int elabel,
+                                                        uint64_t voffset,
+                                                        Chunk*& chunk) {
+  auto table_iter = tables_.find(elabel);
+  if (table_iter == tables_.end()) {
+    return nullptr;
+  }
+  LabelTable& table = table_iter->second;
+  uint64_t chunk_id = voffset >> CHUNK_BITS;
+  uint64_t idx = voffset & (CHUNK_SIZE - 1);
+  if (chunk_id >= table.size() || idx >= table[chunk_id].vertices.size()) {
+    return nullptr;
+  }
+  chunk = &table[chunk_id];
+  return &chunk->vertices[idx];
+}
+
+void DestFidTable::remove(int elabel, uint64_t voffset, uint64_t fid,
+                          seggraph::dir_t dir) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Chunk* chunk;
+  auto fids = find_(elabel, voffset, chunk);
+  if (fids == nullptr) {
+    return;
+  }
+  auto iter = std::lower_bound(
+      fids->begin(), fids->end(), fid,
+      [](const FidCount& count, uint64_t fid) { return count.fid < fid; });
+  if (iter == fids->end() || iter->fid != fid) {
+    return;
+  }
+  uint32_t& num = dir == seggraph::EIN ? iter->in_num : iter->out_num;
+  if (num == 0) {
+    return;
+  }
+  chunk->dirty |= --num == 0;
+  if (iter->in_num == 0 && iter->out_num == 0) {
+    fids->erase(iter);
+  }
+}
+
+void DestFidTable::remove_vertex(uint64_t voffset) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto& pair : tables_) {
+    Chunk* chunk;
+    auto fids = find_(pair.first, voffset, chunk);
+    if (fids != nullptr && !fids->empty()) {
+      fids->clear();
+      chunk->dirty = true;
+    }
+  }
+}
+
+bool DestFidTable::publish(uint64_t vertex_num, int64_t epoch) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  bool ok = true;
+  for (auto& pair : tables_) {
+    LabelTable& table = pair.second;
+    for (uint64_t chunk_id = 0; chunk_id < table.size(); chunk_id++) {
+      Chunk& chunk = table[chunk_id];
+      uint64_t begin = chunk_id << CHUNK_BITS;
+      uint64_t chunk_vertex_num =
+          vertex_num > begin ? std::min(vertex_num - begin, CHUNK_SIZE) : 0;
+      // vertices beyond the published list may have fids since
+      bool grown =
+          chunk.vertex_num < std::min(chunk_vertex_num, chunk.max_vertex);
+      if (!chunk.dirty && !grown) {
+        continue;
+      }
+      vineyard::ObjectID old_oid = chunk.oid;
+      if (!build_(pair.first, chunk, chunk_vertex_num)) {
+        ok = false;
+        continue;
+      }
+      if (old_oid != 0) {
+        // still read by snapshots before epoch
+        retired_.push_back(RetiredList{old_oid, epoch});
+        retired_lists_++;
+      }
+      chunk.dirty = false;
+    }
+  }
+  return ok;
+}
+
+bool DestFidTable::build_(int elabel, Chunk& chunk, uint64_t vertex_num) {
+  uint64_t listed_num = std::min<uint64_t>(vertex_num, chunk.vertices.size());
+  uint64_t fid_num = 0;
+  for (uint64_t v = 0; v < listed_num; v++) {
+    fid_num += chunk.vertices[v].size();
+  }
+  if (fid_num == 0) {
+    chunk.oid = 0;
+    chunk.vertex_num = vertex_num;
+    return true;
+  }
+
+  vineyard::ObjectID oid;
+  char* data = array_allocator_.allocate_v6d(
+      DestFidList::size_of(vertex_num, fid_num), oid);
+  if (data == nullptr) {
+    LOG(ERROR) << "DestFidTable: out of memory, the lists of vlabel "
+               << vlabel_ << " elabel " << elabel << " are not published";
+    return false;
+  }
+  DestFidList* list = reinterpret_cast<DestFidList*>(data);
+  list->vertex_num = vertex_num;
+  list->fid_num = fid_num;
+  DestFidList::fid_t* fids = list->get_fids();
+
+  uint64_t cursor = 0;
+  for (uint64_t v = 0; v < vertex_num; v++) {
+    if (v >= listed_num) {
+      list->offsets[3 * v] = list->offsets[3 * v + 1] =
+          list->offsets[3 * v + 2] = cursor;
+      continue;
+    }
+    const auto& counts = chunk.vertices[v];
+    list->offsets[3 * v] = cursor;
+    for (const auto& count : counts) {
+      if (count.out_num == 0) {
+        fids[cursor++] = count.fid;
+      }
+    }
+    list->offsets[3 * v + 1] = cursor;
+    for (const auto& count : counts) {
+      if (count.in_num != 0 && count.out_num != 0) {
+        fids[cursor++] = count.fid;
+      }
+    }
+    list->offsets[3 * v + 2] = cursor;
+    for (const auto& count : counts) {
+      if (count.in_num == 0) {
+        fids[cursor++] = count.fid;
+      }
+    }
+  }
+  list->offsets[3 * vertex_num] = cursor;
+  assert(cursor == fid_num);
+
+  chunk.oid = oid;
+  chunk.vertex_num = vertex_num;
+  return true;
+}
+
+std::vector<DestFidListMeta> DestFidTable::get_meta() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<DestFidListMeta> meta;
+  for (const auto& pair : tables_) {
+    std::vector<vineyard::ObjectID> oids;
+    bool published = false;
+    for (const Chunk& chunk : pair.second) {
+      oids.push_back(chunk.oid);
+      published |= chunk.oid != 0;
+    }
+    if (published) {
+      meta.emplace_back(pair.first, CHUNK_BITS, std::move(oids));
+    }
+  }
+  return meta;
+}
+
+void DestFidTable::recycle(int64_t write_epoch, int64_t safe_epoch) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  size_t kept = 0;
+  for (const auto& retired : retired_) {
+    if (retired.epoch <= safe_epoch &&
+        retired.epoch + LAG_EPOCH_NUMBER < write_epoch) {
+      array_allocator_.deallocate_v6d(retired.oid);
+      retired_lists_--;
+    } else {
+      retired_[kept++] = retired;
+    }
+  }
+  retired_.resize(kept);
+}
+
+}  // namespace graph
+}  // namespace gart
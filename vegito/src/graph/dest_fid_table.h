@@ -0,0 +1,123 @@
+/** Copyright 2020-2023 Alibaba Group Holding Limited.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef VEGITO_SRC_GRAPH_DEST_FID_TABLE_H_
+#define VEGITO_SRC_GRAPH_DEST_FID_TABLE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include "fragment/dest_fid_list.h"
+#include "fragment/shared_storage.h"
+#include "seggraph/blocks.hpp"
+#include "util/allocator.hpp"
+
+namespace gart {
+namespace graph {
+
+/**
+ * Remote fragments adjacent to the inner vertices of a vertex label,
+ * maintained by the writer as edges to (or from) outer vertices are added
+ * and deleted, and published as DestFidChunks (see fragment/dest_fid_list.h)
+ * per edge label, so readers get the DestLists of grape without scanning
+ * the edges.
+ *
+ * Each (vertex, edge label, fid) keeps the number of incoming and outgoing
+ * edges with the fragment. publish only rebuilds the list of a chunk of
+ * 1 << CHUNK_BITS vertices if it is changed during the epoch, the other
+ * chunks are shared with the earlier snapshots. The lists superseded at
+ * epoch e are deleted once no reader pins an epoch before e, with the same
+ * lag as the blocks of SegGraph.
+ *
+ * All the methods are thread-safe.
+ */
+class DestFidTable {
+ public:
+  DestFidTable(vineyard::Client* v6d_client, int vlabel);
+
+  ~DestFidTable();
+
+  // an edge between the inner vertex voffset and a vertex of fragment fid,
+  // dir is the direction of the edge from the inner vertex
+  void add(int elabel, uint64_t voffset, uint64_t fid, seggraph::dir_t dir);
+
+  void remove(int elabel, uint64_t voffset, uint64_t fid, seggraph::dir_t dir);
+
+  // the inner vertex is deleted with all its edges
+  void remove_vertex(uint64_t voffset);
+
+  // rebuild the lists of the chunks changed since the last publish, for
+  // inner vertices below vertex_num, return false if the memory is exhausted
+  // (the changed chunks are retried at the next publish)
+  bool publish(uint64_t vertex_num, int64_t epoch);
+
+  // lists of the edge labels published
+  std::vector<DestFidListMeta> get_meta() const;
+
+  // delete the lists superseded before safe_epoch
+  void recycle(int64_t write_epoch, int64_t safe_epoch);
+
+  size_t get_retired_lists() const { return retired_lists_; }
+
+ private:
+  static constexpr int64_t LAG_EPOCH_NUMBER = 2;
+  static constexpr int CHUNK_BITS = 12;
+  static constexpr uint64_t CHUNK_SIZE = 1ul << CHUNK_BITS;
+
+  struct FidCount {
+    uint64_t fid;
+    uint32_t in_num;
+    uint32_t out_num;
+  };
+
+  struct RetiredList {
+    vineyard::ObjectID oid;
+    int64_t epoch;
+  };
+
+  struct Chunk {
+    // index in the chunk -> fids sorted, with edges in either direction
+    std::vector<std::vector<FidCount>> vertices;
+    vineyard::ObjectID oid = 0;  // 0 if there are no fids published
+    uint64_t vertex_num = 0;     // of the published list
+    uint64_t max_vertex = 0;     // 1 + the largest index added
+    bool dirty = false;
+  };
+
+  // chunk i holds the vertices [i * CHUNK_SIZE, (i + 1) * CHUNK_SIZE)
+  using LabelTable = std::vector<Chunk>;
+
+  // must hold mutex_
+  std::vector<FidCount>* find_(int elabel, uint64_t voffset, Chunk*& chunk);
+
+  // must hold mutex_
+  bool build_(int elabel, Chunk& chunk, uint64_t vertex_num);
+
+  SparseArrayAllocator array_allocator_;
+  const int vlabel_;
+
+  std::map<int, LabelTable> tables_;  // elabel -> lists
+  std::vector<RetiredList> retired_;
+  std::atomic<size_t> retired_lists_{0};
+  mutable std::mutex mutex_;
+};
+
+}  // namespace graph
+}  // namespace gart
+
+#endif  // VEGITO_SRC_GRAPH_DEST_FID_TABLE_H_
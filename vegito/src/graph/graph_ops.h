@@ -16,23 +16,115 @@
 #ifndef VEGITO_SRC_GRAPH_GRAPH_OPS_H_
 #define VEGITO_SRC_GRAPH_GRAPH_OPS_H_
 
+#include <deque>
+#include <map>
+#include <queue>
 #include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
 
 #include "graph/graph_store.h"
+#include "seggraph/epoch_graph_writer.hpp"
 #include "graph/type_def.h"
+#include "util/unified_log.h"
 
 namespace gart {
 namespace graph {
 
-void process_add_vertex(const property::StringViewList& cmd,
-                        graph::GraphStore* graph_store);
-void process_add_edge(const property::StringViewList& cmd,
-                      graph::GraphStore* graph_store);
-void process_del_vertex(const property::StringViewList& cmd,
-                        graph::GraphStore* graph_store);
-void process_del_edge(const property::StringViewList& cmd,
-                      graph::GraphStore* graph_store);
-void process_update_vertex(const property::StringViewList& cmd,
+// a decoded unified log, string fields point into the buffer of the raw log
+struct LogRecord {
+  UnifiedLogOp op;
+  int epoch;
+  int elabel;                        // edge logs only
+  uint64_t vid;                      // vertex id, or src vertex id of an edge
+  uint64_t dst_vid;                  // edge logs only
+  std::string_view external_id;      // or src external id of an edge
+  std::string_view dst_external_id;  // edge logs only
+  property::LogValueList props;
+};
+
+// the edges hidden by delete markers, met while scanning the edge entries of a
+// vertex from the newest to the oldest, so that a delete marker is put for a
+// live edge only, and each delete marker hides exactly one edge
+class DeletedEdges {
+ public:
+  // return true if the entry at the location is a delete marker or is
+  // deleted, locations must be decreasing
+  bool skip(seggraph::vertex_t dst, uint64_t loc) {
+    const seggraph::vertex_t delete_mask = ((seggraph::vertex_t) 1)
+                                           << (sizeof(seggraph::vertex_t) * 8 -
+                                               1);
+    if (dst & delete_mask) {
+      victims_.push(dst & ~delete_mask);
+      return true;
+    }
+    if (!victims_.empty() && victims_.top() == loc) {
+      victims_.pop();
+      return true;
+    }
+    return false;
+  }
+
+ private:
+  std::priority_queue<uint64_t> victims_;
+};
+
+// decode a '|'-separated text log, return false if it is malformed
+bool parse_text_log(std::string_view log, LogRecord& record);
+
+// decode a binary log (see util/unified_log.h), return false if it is
+// malformed
+bool parse_binary_log(std::string_view log, LogRecord& record);
+
+// only decode the epoch and the binlog offset of a log, for merging logs from
+// several partitions
+bool parse_text_log_position(std::string_view log, int& epoch,
+                             int64_t& offset);
+bool parse_binary_log_position(std::string_view log, int& epoch,
+                               int64_t& offset);
+
+// add_edge logs applied together: add() applies a log but its edge entries,
+// which flush() appends with one put_edges per graph, edge label and
+// direction, so that each vertex is locked and its edge block grown once for
+// all its edges in the batch. The logs must be flushed before a log of
+// another kind touches their vertices.
+class AddEdgeBatch {
+ public:
+  explicit AddEdgeBatch(GraphStore* graph_store) : graph_store_(graph_store) {}
+
+  // flushes first if the log is of another epoch
+  void add(const LogRecord& log);
+
+  void flush();
+
+  size_t size() const { return num_logs_; }
+
+ private:
+  using EdgeToPut = seggraph::EpochGraphWriter::EdgeToPut;
+  using EdgeList = std::tuple<seggraph::SegGraph*, int, seggraph::dir_t>;
+
+  void put_edge(seggraph::SegGraph* graph, int elabel, seggraph::dir_t dir,
+                seggraph::vertex_t src, seggraph::vertex_t dst,
+                std::string_view edge_data) {
+    edges_[EdgeList(graph, elabel, dir)].push_back(
+        EdgeToPut{src, dst, edge_data});
+  }
+
+  GraphStore* graph_store_;
+  int epoch_ = 0;
+  size_t num_logs_ = 0;
+  // kept with their capacity between flushes
+  std::map<EdgeList, std::vector<EdgeToPut>> edges_;
+  // edge properties of the logs, a deque never moves them
+  std::deque<std::string> edge_data_;
+};
+
+void process_add_vertex(const LogRecord& log, graph::GraphStore* graph_store);
+void process_add_edge(const LogRecord& log, graph::GraphStore* graph_store);
+void process_del_vertex(const LogRecord& log, graph::GraphStore* graph_store);
+void process_del_edge(const LogRecord& log, graph::GraphStore* graph_store);
+void process_update_vertex(const LogRecord& log,
                            graph::GraphStore* graph_store);
 }  // namespace graph
 }  // namespace gart
@@ -24,17 +24,39 @@ using std::string;
 using std::string_view;
 
 using gart::property::PropertyDataType;
-using gart::property::StringViewList;
 
 namespace gart {
 namespace graph {
 
-void process_add_edge(const StringViewList& cmd,
-                      graph::GraphStore* graph_store) {
-  int write_epoch = stoi(string(cmd[0]));
-  int elabel = stoi(string(cmd[1]));
-  uint64_t src_vid = static_cast<uint64_t>(stoll(string(cmd[2])));
-  uint64_t dst_vid = static_cast<uint64_t>(stoll(string(cmd[3])));
+namespace {
+
+// the value of a new outer vertex in the external id store, strings are put
+// before taking the label mutex, as put_cstring may wait for memory. Return
+// true if a string is put
+bool make_outer_external_id(GraphStore* graph_store, uint64_t vlabel,
+                            string_view external_id, uint64_t& value) {
+  if (graph_store->get_external_id_dtype(vlabel) != PropertyDataType::STRING) {
+    value = stoll(string(external_id));
+    return false;
+  }
+  graph_store->put_cstring(external_id, value);
+  return true;
+}
+
+}  // namespace
+
+void AddEdgeBatch::add(const LogRecord& log) {
+  GraphStore* graph_store = graph_store_;
+  if (num_logs_ > 0 && log.epoch != epoch_) {
+    flush();
+  }
+  epoch_ = log.epoch;
+  num_logs_++;
+
+  int write_epoch = log.epoch;
+  int elabel = log.elabel;
+  uint64_t src_vid = log.vid;
+  uint64_t dst_vid = log.dst_vid;
   auto max_outer_id_offset =
       (((vertex_t) 1) << graph_store->id_parser.GetOffsetWidth()) -
       (seggraph::vertex_t) 1;
@@ -51,24 +73,17 @@ void process_add_edge(const StringViewList& cmd,
       graph_store->get_graph<seggraph::SegGraph>(src_label);
   seggraph::SegGraph* dst_graph =
       graph_store->get_graph<seggraph::SegGraph>(dst_label);
-  // this `auto` is necessary, the p_write may Transaction or EpochGraphWriter
-  auto src_writer = src_graph->create_graph_writer(write_epoch);  // write epoch
-  auto dst_writer = dst_graph->create_graph_writer(write_epoch);  // write epoch
 
   // process edge properties
-
-  // remove first 6 elements (epoch, elabel, src_vid, dst_vid, src_external_id,
-  // dst_external_id)
-  StringViewList eprop(cmd.begin() + 6, cmd.end());
-  string buf;
-  graph_store->construct_eprop(elabel, eprop, buf);
-  string_view edge_data(buf);
+  edge_data_.emplace_back();
+  graph_store->construct_eprop(elabel, log.props, edge_data_.back());
+  string_view edge_data(edge_data_.back());
 
   if (src_fid == graph_store->get_local_pid() &&
       dst_fid != graph_store->get_local_pid()) {
     seggraph::SegGraph* ov_graph = graph_store->get_ov_graph(dst_label);
     auto ov_writer = ov_graph->create_graph_writer(write_epoch);
-    graph_store->add_total_edge_num_by_one();
+    graph_store->add_edge_num_by_one(elabel);
 #ifdef USE_MULTI_THREADS
     auto outer_vertex_label_mutex =
         graph_store->get_outer_vertex_label_mutex(dst_label);
@@ -79,6 +94,9 @@ void process_add_edge(const StringViewList& cmd,
     outer_vertex_label_mutex->unlock_shared();
 #endif
     if (ov == uint64_t(-1)) {
+      uint64_t external_id;
+      [[maybe_unused]] bool string_put = make_outer_external_id(
+          graph_store, dst_label, log.dst_external_id, external_id);
 #ifdef USE_MULTI_THREADS
       outer_vertex_label_mutex->lock();
       ov = graph_store->get_lid(dst_label, dst_vid);
@@ -96,22 +114,21 @@ void process_add_edge(const StringViewList& cmd,
 
         uint64_t* outer_external_id_store_addr =
             graph_store->get_outer_external_id_store(dst_label);
-        if (graph_store->get_external_id_dtype(dst_label) ==
-            PropertyDataType::STRING) {
-          std::string dst_external_id = string(cmd[5]);
-          uint64_t value = graph_store->put_cstring(dst_external_id);
-          outer_external_id_store_addr[ov] = value;
-        } else {
-          int64_t dst_external_id = stoll(string(cmd[5]));
-          outer_external_id_store_addr[ov] = dst_external_id;
+        outer_external_id_store_addr[ov] = external_id;
 #ifndef USE_GLOBAL_VERTEX_MAP
+        if (graph_store->get_external_id_dtype(dst_label) !=
+            PropertyDataType::STRING) {
           // local vertex map
           std::shared_ptr<hashmap_t> hmap;
-          graph_store->set_vertex_map(hmap, dst_label, dst_external_id,
+          graph_store->set_vertex_map(hmap, dst_label,
+                                      static_cast<int64_t>(external_id),
                                       (int64_t) dst_vid);
-#endif
         }
+#endif
 #ifdef USE_MULTI_THREADS
+      } else if (string_put) {
+        // added by another worker meanwhile, never read
+        graph_store->retire_cstring(external_id, write_epoch);
       }
       outer_vertex_label_mutex->unlock();
 #endif
@@ -120,8 +137,10 @@ void process_add_edge(const StringViewList& cmd,
     auto src_lid = graph_store->id_parser.GenerateId(0, src_label, src_offset);
     auto dst_lid = graph_store->id_parser.GenerateId(0, dst_label,
                                                      max_outer_id_offset - ov);
-    src_writer.put_edge(src_offset, elabel, seggraph::EOUT, dst_lid, edge_data);
-    ov_writer.put_edge(ov, elabel, seggraph::EIN, src_lid, edge_data);
+    put_edge(src_graph, elabel, seggraph::EOUT, src_offset, dst_lid, edge_data);
+    put_edge(ov_graph, elabel, seggraph::EIN, ov, src_lid, edge_data);
+    graph_store->add_dest_fid(src_label, elabel, src_offset, dst_fid,
+                              seggraph::EOUT);
   } else if (src_fid != graph_store->get_local_pid() &&
              dst_fid == graph_store->get_local_pid()) {
     SegGraph* ov_graph = graph_store->get_ov_graph(src_label);
@@ -136,6 +155,9 @@ void process_add_edge(const StringViewList& cmd,
     outer_vertex_label_mutex->unlock_shared();
 #endif
     if (ov == uint64_t(-1)) {
+      uint64_t external_id;
+      [[maybe_unused]] bool string_put = make_outer_external_id(
+          graph_store, src_label, log.external_id, external_id);
 #ifdef USE_MULTI_THREADS
       outer_vertex_label_mutex->lock();
       ov = graph_store->get_lid(src_label, src_vid);
@@ -152,22 +174,21 @@ void process_add_edge(const StringViewList& cmd,
 
         uint64_t* outer_external_id_store_addr =
             graph_store->get_outer_external_id_store(src_label);
-        if (graph_store->get_external_id_dtype(src_label) ==
-            PropertyDataType::STRING) {
-          std::string src_external_id = string(cmd[4]);
-          uint64_t value = graph_store->put_cstring(src_external_id);
-          outer_external_id_store_addr[ov] = value;
-        } else {
-          int64_t src_external_id = stoll(string(cmd[4]));
-          outer_external_id_store_addr[ov] = src_external_id;
+        outer_external_id_store_addr[ov] = external_id;
 #ifndef USE_GLOBAL_VERTEX_MAP
+        if (graph_store->get_external_id_dtype(src_label) !=
+            PropertyDataType::STRING) {
           // local vertex map
           std::shared_ptr<hashmap_t> hmap;
-          graph_store->set_vertex_map(hmap, src_label, src_external_id,
+          graph_store->set_vertex_map(hmap, src_label,
+                                      static_cast<int64_t>(external_id),
                                       (int64_t) src_vid);
-#endif
         }
+#endif
 #ifdef USE_MULTI_THREADS
+      } else if (string_put) {
+        // added by another worker meanwhile, never read
+        graph_store->retire_cstring(external_id, write_epoch);
       }
       outer_vertex_label_mutex->unlock();
 #endif
@@ -176,8 +197,10 @@ void process_add_edge(const StringViewList& cmd,
     auto src_lid = graph_store->id_parser.GenerateId(0, src_label,
                                                      max_outer_id_offset - ov);
     auto dst_lid = graph_store->id_parser.GenerateId(0, dst_label, dst_offset);
-    ov_writer.put_edge(ov, elabel, seggraph::EOUT, dst_lid, edge_data);
-    dst_writer.put_edge(dst_offset, elabel, seggraph::EIN, src_lid, edge_data);
+    put_edge(ov_graph, elabel, seggraph::EOUT, ov, dst_lid, edge_data);
+    put_edge(dst_graph, elabel, seggraph::EIN, dst_offset, src_lid, edge_data);
+    graph_store->add_dest_fid(dst_label, elabel, dst_offset, src_fid,
+                              seggraph::EIN);
   } else {
     auto src_offset = graph_store->id_parser.GetOffset(src_vid);
     auto dst_offset = graph_store->id_parser.GetOffset(dst_vid);
@@ -186,13 +209,34 @@ void process_add_edge(const StringViewList& cmd,
     vertex_t dst_lid =
         graph_store->id_parser.GenerateId(0, dst_label, dst_offset);
 
-    graph_store->add_total_edge_num_by_one();
+    graph_store->add_edge_num_by_one(elabel);
 
     // inner edges
-    src_writer.put_edge(src_offset, elabel, seggraph::EOUT, dst_lid, edge_data);
-    dst_writer.put_edge(dst_offset, elabel, seggraph::EIN, src_lid, edge_data);
+    put_edge(src_graph, elabel, seggraph::EOUT, src_offset, dst_lid, edge_data);
+    put_edge(dst_graph, elabel, seggraph::EIN, dst_offset, src_lid, edge_data);
   }
 }
 
+void AddEdgeBatch::flush() {
+  for (auto& pair : edges_) {
+    if (pair.second.empty()) {
+      continue;
+    }
+    seggraph::SegGraph* graph = std::get<0>(pair.first);
+    auto writer = graph->create_graph_writer(epoch_);
+    writer.put_edges(std::get<1>(pair.first), std::get<2>(pair.first),
+                     pair.second);
+    pair.second.clear();
+  }
+  edge_data_.clear();
+  num_logs_ = 0;
+}
+
+void process_add_edge(const LogRecord& log, graph::GraphStore* graph_store) {
+  AddEdgeBatch batch(graph_store);
+  batch.add(log);
+  batch.flush();
+}
+
 }  // namespace graph
 }  // namespace gart
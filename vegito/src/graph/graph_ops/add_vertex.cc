@@ -19,10 +19,6 @@
 #include "graph/type_def.h"
 #include "property/property.h"
 
-using std::string;
-
-using gart::property::StringViewList;
-
 namespace {
 
 template <typename T>
@@ -35,14 +31,10 @@ inline void assign(void* ptr, T val) {
 namespace gart {
 namespace graph {
 
-void process_add_vertex(const StringViewList& cmd,
-                        graph::GraphStore* graph_store) {
-  int write_epoch = stoi(string(cmd[0]));
-  uint64_t vid = static_cast<uint64_t>(stoll(string(cmd[1])));
-  std::string external_id = string(cmd[2]);
-  assert(!external_id.empty());
-  StringViewList props(cmd.begin() + 3, cmd.end());
-  graph_store->insert_inner_vertex(write_epoch, vid, external_id, props);
+void process_add_vertex(const LogRecord& log, graph::GraphStore* graph_store) {
+  assert(!log.external_id.empty());
+  graph_store->insert_inner_vertex(log.epoch, log.vid, log.external_id,
+                                   log.props);
 }
 
 }  // namespace graph
@@ -17,18 +17,15 @@
 
 using std::string;
 
-using gart::property::StringViewList;
-
 namespace gart {
 namespace graph {
 using SegGraph = seggraph::SegGraph;
 using vertex_t = seggraph::vertex_t;
-void process_del_edge(const StringViewList& cmd,
-                      graph::GraphStore* graph_store) {
-  int write_epoch = stoi(string(cmd[0]));
-  int elabel = stoi(string(cmd[1]));
-  uint64_t src_vid = static_cast<uint64_t>(stoll(string(cmd[2])));
-  uint64_t dst_vid = static_cast<uint64_t>(stoll(string(cmd[3])));
+void process_del_edge(const LogRecord& log, graph::GraphStore* graph_store) {
+  int write_epoch = log.epoch;
+  int elabel = log.elabel;
+  uint64_t src_vid = log.vid;
+  uint64_t dst_vid = log.dst_vid;
   auto max_outer_id_offset =
       (((vertex_t) 1) << graph_store->id_parser.GetOffsetWidth()) -
       (vertex_t) 1;
@@ -60,15 +57,32 @@ void process_del_edge(const StringViewList& cmd,
       dst_fid != graph_store->get_local_pid()) {
     src_offset = graph_store->id_parser.GetOffset(src_vid);
     src_offset_reverse = src_offset;
+#ifdef USE_MULTI_THREADS
+    // outer vertices may be added by add_edge in other workers
+    auto outer_vertex_label_mutex =
+        graph_store->get_outer_vertex_label_mutex(dst_label);
+    outer_vertex_label_mutex->lock_shared();
+#endif
     dst_offset_reverse = graph_store->get_lid(dst_label, dst_vid);
+#ifdef USE_MULTI_THREADS
+    outer_vertex_label_mutex->unlock_shared();
+#endif
     assert(dst_offset_reverse != -1);
     dst_offset = max_outer_id_offset - dst_offset_reverse;
     src_graph = graph_store->get_graph<seggraph::SegGraph>(src_label);
     dst_graph = graph_store->get_ov_graph(dst_label);
-    graph_store->del_total_edge_num_by_one();
   } else if (src_fid != graph_store->get_local_pid() &&
              dst_fid == graph_store->get_local_pid()) {
+#ifdef USE_MULTI_THREADS
+    // outer vertices may be added by add_edge in other workers
+    auto outer_vertex_label_mutex =
+        graph_store->get_outer_vertex_label_mutex(src_label);
+    outer_vertex_label_mutex->lock_shared();
+#endif
     src_offset_reverse = graph_store->get_lid(src_label, src_vid);
+#ifdef USE_MULTI_THREADS
+    outer_vertex_label_mutex->unlock_shared();
+#endif
     assert(src_offset_reverse != -1);
     src_offset = max_outer_id_offset - src_offset_reverse;
     dst_offset = graph_store->id_parser.GetOffset(dst_vid);
@@ -83,7 +97,6 @@ void process_del_edge(const StringViewList& cmd,
     dst_offset_reverse = dst_offset;
     src_graph = graph_store->get_graph<seggraph::SegGraph>(src_label);
     dst_graph = graph_store->get_graph<seggraph::SegGraph>(dst_label);
-    graph_store->del_total_edge_num_by_one();
   }
 
   {
@@ -130,16 +143,15 @@ void process_del_edge(const StringViewList& cmd,
     int src_segment_idx = 0;
     bool is_founded = false;
 
+    DeletedEdges src_deleted_edges;
     while (true) {
       while (src_entries_cursor != src_entries) {
         seggraph::vertex_t vid = src_entries_cursor->get_dst();
-
-        auto delete_flag = vid >> (sizeof(seggraph::vertex_t) * 8 - 1);
-        if (graph_store->id_parser.GetOffset(vid) == dst_offset &&
-            delete_flag != 1) {
+        auto del_loc = src_entries - src_entries_cursor - 1 +
+                       src_prefix_sum[src_segment_idx];
+        if (!src_deleted_edges.skip(vid, del_loc) &&
+            graph_store->id_parser.GetOffset(vid) == dst_offset) {
           is_founded = true;
-          auto del_loc = src_entries - src_entries_cursor - 1 +
-                         src_prefix_sum[src_segment_idx];
 
           auto mask = ((seggraph::vertex_t) 1)
                       << (sizeof(seggraph::vertex_t) * 8 - 1);
@@ -167,6 +179,15 @@ void process_del_edge(const StringViewList& cmd,
     }
     if (is_founded == false) {
       LOG(ERROR) << "delete edge error";
+    } else {
+      // edges are counted as out-edges of inner vertices, only once found
+      if (src_fid == graph_store->get_local_pid()) {
+        graph_store->del_edge_num_by_one(elabel);
+      }
+      if (dst_fid != graph_store->get_local_pid()) {
+        graph_store->del_dest_fid(src_label, elabel, src_offset, dst_fid,
+                                  seggraph::EOUT);
+      }
     }
 
     is_founded = false;
@@ -207,15 +228,15 @@ void process_del_edge(const StringViewList& cmd,
     dst_prefix_sum[dst_prefix_sum.size() - 1] = 0;
     int dst_segment_idx = 0;
 
+    DeletedEdges dst_deleted_edges;
     while (true) {
       while (dst_entries_cursor != dst_entries) {
         seggraph::vertex_t vid = dst_entries_cursor->get_dst();
-        auto delete_flag = vid >> (sizeof(seggraph::vertex_t) * 8 - 1);
-        if (graph_store->id_parser.GetOffset(vid) == src_offset &&
-            delete_flag != 1) {
+        auto del_loc = dst_entries - dst_entries_cursor - 1 +
+                       dst_prefix_sum[dst_segment_idx];
+        if (!dst_deleted_edges.skip(vid, del_loc) &&
+            graph_store->id_parser.GetOffset(vid) == src_offset) {
           is_founded = true;
-          auto del_loc = dst_entries - dst_entries_cursor - 1 +
-                         dst_prefix_sum[dst_segment_idx];
 
           auto mask = ((seggraph::vertex_t) 1)
                       << (sizeof(seggraph::vertex_t) * 8 - 1);
@@ -243,6 +264,9 @@ void process_del_edge(const StringViewList& cmd,
     }
     if (is_founded == false) {
       LOG(ERROR) << "delete edge error";
+    } else if (src_fid != graph_store->get_local_pid()) {
+      graph_store->del_dest_fid(dst_label, elabel, dst_offset, src_fid,
+                                seggraph::EIN);
     }
   }
 }
@@ -17,8 +17,6 @@
 
 using std::string;
 
-using gart::property::StringViewList;
-
 namespace gart {
 namespace graph {
 using VegitoEdgeEntry = seggraph::VegitoEdgeEntry;
@@ -28,18 +26,19 @@ using EpochBlockHeader = seggraph::EpochBlockHeader;
 using segid_t = seggraph::segid_t;
 using vertex_t = seggraph::vertex_t;
 using SegGraph = seggraph::SegGraph;
-void process_del_vertex(const StringViewList& cmd,
-                        graph::GraphStore* graph_store) {
-  int write_epoch = stoi(string(cmd[0]));
-  uint64_t vid = static_cast<uint64_t>(stoll(string(cmd[1])));
+void process_del_vertex(const LogRecord& log, graph::GraphStore* graph_store) {
+  int write_epoch = log.epoch;
+  uint64_t vid = log.vid;
   auto fid = graph_store->id_parser.GetFid(vid);
   if (fid == graph_store->get_local_pid()) {  // is a inner vertex
     auto v_offset = graph_store->id_parser.GetOffset(vid);
     auto v_label = graph_store->id_parser.GetLabelId(vid);
     seggraph::SegGraph* src_graph =
         graph_store->get_graph<seggraph::SegGraph>(v_label);
-    graph_store->delete_inner(v_label,
-                              v_offset);  // delete vertex from vertex table
+    graph_store->delete_inner(v_label, v_offset,
+                              write_epoch);  // delete vertex from vertex table
+    graph_store->unindex_inner_vertex(write_epoch, v_label, v_offset);
+    graph_store->del_dest_fids(v_label, v_offset);
     src_graph->add_deleted_inner_num(1);
     graph_store->del_total_vertex_num_by_one();
 
@@ -141,18 +140,22 @@ void process_del_vertex(const StringViewList& cmd,
       std::string buf(prop_buffer, edge_prop_bytes);
       std::string_view edge_data(buf);
       free(prop_buffer);
+      // delete markers of the vertex, appended in one pass
+      std::vector<seggraph::EpochGraphWriter::EdgeToPut> markers;
+      markers.reserve(delete_loc.size());
+      for (auto idx = 0; idx < delete_loc.size(); idx++) {
+        auto mask = ((seggraph::vertex_t) 1)
+                    << (sizeof(seggraph::vertex_t) * 8 - 1);
+        markers.push_back({v_offset, delete_loc[idx] | mask, edge_data});
+      }
+      src_writer.put_edges(elabel, seggraph::EOUT, markers);
+
       for (auto idx = 0; idx < delete_loc.size(); idx++) {
         auto dst_offset =
             graph_store->id_parser.GetOffset(delete_vertices[idx]);
         auto dst_label =
             graph_store->id_parser.GetLabelId(delete_vertices[idx]);
-        auto mask = ((seggraph::vertex_t) 1)
-                    << (sizeof(seggraph::vertex_t) * 8 - 1);
-        auto dst_loc = delete_loc[idx] | mask;
-
-        src_writer.put_edge(v_offset, elabel, seggraph::EOUT, dst_loc,
-                            edge_data);
-        graph_store->del_total_edge_num_by_one();
+        graph_store->del_edge_num_by_one(elabel);
 
         if (dst_offset < graph_store->get_vtable_max_inner(
                              dst_label)) {  // dst is an inner vertex
@@ -190,17 +193,15 @@ void process_del_vertex(const StringViewList& cmd,
           VegitoEdgeEntry* dst_entries = dst_edge_block->get_entries();
           VegitoEdgeEntry* dst_entries_cursor = dst_entries - dst_num_entries;
           bool is_founded = false;
+          DeletedEdges dst_deleted_edges;
           while (true) {
             while (dst_entries_cursor != dst_entries) {
               seggraph::vertex_t vid = dst_entries_cursor->get_dst();
-
-              auto dst_delete_flag =
-                  vid >> (sizeof(seggraph::vertex_t) * 8 - 1);
-              if (graph_store->id_parser.GetOffset(vid) == v_offset &&
-                  dst_delete_flag != 1) {
+              auto del_loc = dst_entries - dst_entries_cursor - 1 +
+                             dst_prefix_sum[dst_segment_idx];
+              if (!dst_deleted_edges.skip(vid, del_loc) &&
+                  graph_store->id_parser.GetOffset(vid) == v_offset) {
                 is_founded = true;
-                auto del_loc = dst_entries - dst_entries_cursor - 1 +
-                               dst_prefix_sum[dst_segment_idx];
                 auto mask = ((seggraph::vertex_t) 1)
                             << (sizeof(seggraph::vertex_t) * 8 - 1);
 
@@ -269,17 +270,15 @@ void process_del_vertex(const StringViewList& cmd,
           VegitoEdgeEntry* dst_entries_cursor = dst_entries - dst_num_entries;
           bool is_founded = false;
 
+          DeletedEdges dst_deleted_edges;
           while (true) {
             while (dst_entries_cursor != dst_entries) {
               seggraph::vertex_t vid = dst_entries_cursor->get_dst();
-
-              auto dst_delete_flag =
-                  vid >> (sizeof(seggraph::vertex_t) * 8 - 1);
-              if (graph_store->id_parser.GetOffset(vid) == v_offset &&
-                  dst_delete_flag != 1) {
+              auto del_loc = dst_entries - dst_entries_cursor - 1 +
+                             dst_prefix_sum[dst_segment_idx];
+              if (!dst_deleted_edges.skip(vid, del_loc) &&
+                  graph_store->id_parser.GetOffset(vid) == v_offset) {
                 is_founded = true;
-                auto del_loc = dst_entries - dst_entries_cursor - 1 +
-                               dst_prefix_sum[dst_segment_idx];
                 auto mask = ((seggraph::vertex_t) 1)
                             << (sizeof(seggraph::vertex_t) * 8 - 1);
                 del_loc = del_loc | mask;
@@ -399,19 +398,24 @@ void process_del_vertex(const StringViewList& cmd,
       std::string buf(prop_buffer, edge_prop_bytes);
       std::string_view edge_data(buf);
       free(prop_buffer);
+      // delete markers of the vertex, appended in one pass
+      std::vector<seggraph::EpochGraphWriter::EdgeToPut> markers;
+      markers.reserve(delete_loc.size());
+      for (auto idx = 0; idx < delete_loc.size(); idx++) {
+        auto mask = ((seggraph::vertex_t) 1)
+                    << (sizeof(seggraph::vertex_t) * 8 - 1);
+        markers.push_back({v_offset, delete_loc[idx] | mask, edge_data});
+      }
+      src_writer.put_edges(elabel, seggraph::EIN, markers);
+
       for (auto idx = 0; idx < delete_loc.size(); idx++) {
         auto dst_offset =
             graph_store->id_parser.GetOffset(delete_vertices[idx]);
         auto dst_label =
             graph_store->id_parser.GetLabelId(delete_vertices[idx]);
-        auto mask = ((seggraph::vertex_t) 1)
-                    << (sizeof(seggraph::vertex_t) * 8 - 1);
-
-        auto dst_loc = delete_loc[idx] | mask;
-        src_writer.put_edge(v_offset, elabel, seggraph::EIN, dst_loc,
-                            edge_data);
-
         if (dst_offset < graph_store->get_vtable_max_inner(dst_label)) {
+          // an out-edge of an inner vertex
+          graph_store->del_edge_num_by_one(elabel);
           seggraph::SegGraph* dst_graph =
               graph_store->get_graph<seggraph::SegGraph>(dst_label);
           auto dst_writer = dst_graph->create_graph_writer(write_epoch);
@@ -446,16 +450,15 @@ void process_del_vertex(const StringViewList& cmd,
           VegitoEdgeEntry* dst_entries = dst_edge_block->get_entries();
           VegitoEdgeEntry* dst_entries_cursor = dst_entries - dst_num_entries;
           bool is_founded = false;
+          DeletedEdges dst_deleted_edges;
           while (true) {
             while (dst_entries_cursor != dst_entries) {
               seggraph::vertex_t vid = dst_entries_cursor->get_dst();
-              auto dst_delete_flag =
-                  vid >> (sizeof(seggraph::vertex_t) * 8 - 1);
-              if (graph_store->id_parser.GetOffset(vid) == v_offset &&
-                  dst_delete_flag != 1) {
+              auto del_loc = dst_entries - dst_entries_cursor - 1 +
+                             dst_prefix_sum[dst_segment_idx];
+              if (!dst_deleted_edges.skip(vid, del_loc) &&
+                  graph_store->id_parser.GetOffset(vid) == v_offset) {
                 is_founded = true;
-                auto del_loc = dst_entries - dst_entries_cursor - 1 +
-                               dst_prefix_sum[dst_segment_idx];
                 auto mask = ((seggraph::vertex_t) 1)
                             << (sizeof(seggraph::vertex_t) * 8 - 1);
                 del_loc = del_loc | mask;
@@ -523,16 +526,15 @@ void process_del_vertex(const StringViewList& cmd,
           VegitoEdgeEntry* dst_entries = dst_edge_block->get_entries();
           VegitoEdgeEntry* dst_entries_cursor = dst_entries - dst_num_entries;
           bool is_founded = false;
+          DeletedEdges dst_deleted_edges;
           while (true) {
             while (dst_entries_cursor != dst_entries) {
               seggraph::vertex_t vid = dst_entries_cursor->get_dst();
-              auto dst_delete_flag =
-                  vid >> (sizeof(seggraph::vertex_t) * 8 - 1);
-              if (graph_store->id_parser.GetOffset(vid) == v_offset &&
-                  dst_delete_flag != 1) {
+              auto del_loc = dst_entries - dst_entries_cursor - 1 +
+                             dst_prefix_sum[dst_segment_idx];
+              if (!dst_deleted_edges.skip(vid, del_loc) &&
+                  graph_store->id_parser.GetOffset(vid) == v_offset) {
                 is_founded = true;
-                auto del_loc = dst_entries - dst_entries_cursor - 1 +
-                               dst_prefix_sum[dst_segment_idx];
                 auto mask = ((seggraph::vertex_t) 1)
                             << (sizeof(seggraph::vertex_t) * 8 - 1);
                 del_loc = del_loc | mask;
@@ -578,8 +580,8 @@ void process_del_vertex(const StringViewList& cmd,
     seggraph::SegGraph* src_graph = graph_store->get_ov_graph(v_label);
     auto real_lid =
         graph_store->id_parser.GenerateId(0, v_label, max_outer_id_offset - ov);
-    graph_store->delete_outer(v_label,
-                              real_lid);  // delete vertex from vertex table
+    graph_store->delete_outer(v_label, real_lid,
+                              write_epoch);  // delete vertex from vertex table
     src_graph->add_deleted_outer_num(1);
 
     // delete ralated edges
@@ -685,18 +687,25 @@ void process_del_vertex(const StringViewList& cmd,
       std::string buf(prop_buffer, edge_prop_bytes);
       std::string_view edge_data(buf);
       free(prop_buffer);
+      // delete markers of the vertex, appended in one pass
+      std::vector<seggraph::EpochGraphWriter::EdgeToPut> markers;
+      markers.reserve(delete_loc.size());
+      for (auto idx = 0; idx < delete_loc.size(); idx++) {
+        auto mask = ((seggraph::vertex_t) 1)
+                    << (sizeof(seggraph::vertex_t) * 8 - 1);
+        markers.push_back({v_offset, delete_loc[idx] | mask, edge_data});
+      }
+      src_writer.put_edges(elabel, seggraph::EOUT, markers);
+
       for (auto idx = 0; idx < delete_loc.size(); idx++) {
         auto dst_offset =
             graph_store->id_parser.GetOffset(delete_vertices[idx]);
         auto dst_label =
             graph_store->id_parser.GetLabelId(delete_vertices[idx]);
-        auto mask = ((seggraph::vertex_t) 1)
-                    << (sizeof(seggraph::vertex_t) * 8 - 1);
-        auto dst_loc = delete_loc[idx] | mask;
-        src_writer.put_edge(v_offset, elabel, seggraph::EOUT, dst_loc,
-                            edge_data);
         // we does not need process edges between outer vertices
         if (dst_offset < graph_store->get_vtable_max_inner(dst_label)) {
+          graph_store->del_dest_fid(dst_label, elabel, dst_offset, fid,
+                                    seggraph::EIN);
           seggraph::SegGraph* dst_graph =
               graph_store->get_graph<seggraph::SegGraph>(dst_label);
           auto dst_writer = dst_graph->create_graph_writer(write_epoch);
@@ -734,18 +743,16 @@ void process_del_vertex(const StringViewList& cmd,
           VegitoEdgeEntry* dst_entries_cursor = dst_entries - dst_num_entries;
           bool is_founded = false;
 
+          DeletedEdges dst_deleted_edges;
           while (true) {
             while (dst_entries_cursor != dst_entries) {
               seggraph::vertex_t vid = dst_entries_cursor->get_dst();
-
-              auto dst_delete_flag =
-                  vid >> (sizeof(seggraph::vertex_t) * 8 - 1);
-              if ((max_outer_id_offset -
-                   graph_store->id_parser.GetOffset(vid)) == ov &&
-                  dst_delete_flag != 1) {
+              auto del_loc = dst_entries - dst_entries_cursor - 1 +
+                             dst_prefix_sum[dst_segment_idx];
+              if (!dst_deleted_edges.skip(vid, del_loc) &&
+                  (max_outer_id_offset -
+                   graph_store->id_parser.GetOffset(vid)) == ov) {
                 is_founded = true;
-                auto del_loc = dst_entries - dst_entries_cursor - 1 +
-                               dst_prefix_sum[dst_segment_idx];
                 auto mask = ((seggraph::vertex_t) 1)
                             << (sizeof(seggraph::vertex_t) * 8 - 1);
                 del_loc = del_loc | mask;
@@ -872,19 +879,28 @@ void process_del_vertex(const StringViewList& cmd,
       std::string buf(prop_buffer, edge_prop_bytes);
       std::string_view edge_data(buf);
       free(prop_buffer);
+      // delete markers of the vertex, appended in one pass
+      std::vector<seggraph::EpochGraphWriter::EdgeToPut> markers;
+      markers.reserve(delete_loc.size());
+      for (auto idx = 0; idx < delete_loc.size(); idx++) {
+        auto mask = ((seggraph::vertex_t) 1)
+                    << (sizeof(seggraph::vertex_t) * 8 - 1);
+        markers.push_back({v_offset, delete_loc[idx] | mask, edge_data});
+      }
+      src_writer.put_edges(elabel, seggraph::EIN, markers);
+
       for (auto idx = 0; idx < delete_loc.size(); idx++) {
         auto dst_offset =
             graph_store->id_parser.GetOffset(delete_vertices[idx]);
         auto dst_label =
             graph_store->id_parser.GetLabelId(delete_vertices[idx]);
-        auto mask = ((seggraph::vertex_t) 1)
-                    << (sizeof(seggraph::vertex_t) * 8 - 1);
-        auto dst_loc = delete_loc[idx] | mask;
-        src_writer.put_edge(v_offset, elabel, seggraph::EIN, dst_loc,
-                            edge_data);
         assert(dst_offset < graph_store->get_vtable_max_inner(dst_label));
 
         if (dst_offset < graph_store->get_vtable_max_inner(dst_label)) {
+          // an out-edge of an inner vertex
+          graph_store->del_edge_num_by_one(elabel);
+          graph_store->del_dest_fid(dst_label, elabel, dst_offset, fid,
+                                    seggraph::EOUT);
           seggraph::SegGraph* dst_graph =
               graph_store->get_graph<seggraph::SegGraph>(dst_label);
           auto dst_writer = dst_graph->create_graph_writer(write_epoch);
@@ -923,17 +939,16 @@ void process_del_vertex(const StringViewList& cmd,
           VegitoEdgeEntry* dst_entries_cursor = dst_entries - dst_num_entries;
           bool is_founded = false;
 
+          DeletedEdges dst_deleted_edges;
           while (true) {
             while (dst_entries_cursor != dst_entries) {
               seggraph::vertex_t vid = dst_entries_cursor->get_dst();
-              auto dst_delete_flag =
-                  vid >> (sizeof(seggraph::vertex_t) * 8 - 1);
-              if ((max_outer_id_offset -
-                   graph_store->id_parser.GetOffset(vid)) == ov &&
-                  dst_delete_flag != 1) {
+              auto del_loc = dst_entries - dst_entries_cursor - 1 +
+                             dst_prefix_sum[dst_segment_idx];
+              if (!dst_deleted_edges.skip(vid, del_loc) &&
+                  (max_outer_id_offset -
+                   graph_store->id_parser.GetOffset(vid)) == ov) {
                 is_founded = true;
-                auto del_loc = dst_entries - dst_entries_cursor - 1 +
-                               dst_prefix_sum[dst_segment_idx];
 
                 auto mask = ((seggraph::vertex_t) 1)
                             << (sizeof(seggraph::vertex_t) * 8 - 1);
@@ -0,0 +1,189 @@
+/** Copyright 2020-2023 Alibaba Group Holding Limited.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <charconv>
+
+#include "graph/graph_ops.h"
+
+using std::string_view;
+
+namespace {
+
+// split the next '|'-separated field off the front of a text log
+inline bool next_field(string_view& log, string_view& field) {
+  if (log.data() == nullptr) {
+    return false;
+  }
+  size_t pos = log.find('|');
+  if (pos == string_view::npos) {
+    field = log;
+    log = string_view();
+  } else {
+    field = log.substr(0, pos);
+    log.remove_prefix(pos + 1);
+  }
+  return true;
+}
+
+template <typename T>
+inline bool parse_int(string_view field, T& value) {
+  auto res = std::from_chars(field.data(), field.data() + field.size(), value);
+  return res.ec == std::errc() && res.ptr == field.data() + field.size();
+}
+
+inline bool parse_op(string_view op_str, gart::UnifiedLogOp& op) {
+  using gart::UnifiedLogOp;
+  if (op_str == "add_vertex") {
+    op = UnifiedLogOp::ADD_VERTEX;
+  } else if (op_str == "add_edge") {
+    op = UnifiedLogOp::ADD_EDGE;
+  } else if (op_str == "update_vertex") {
+    op = UnifiedLogOp::UPDATE_VERTEX;
+  } else if (op_str == "delete_vertex") {
+    op = UnifiedLogOp::DELETE_VERTEX;
+  } else if (op_str == "delete_edge") {
+    op = UnifiedLogOp::DELETE_EDGE;
+  } else if (op_str == "bulkload_end") {
+    op = UnifiedLogOp::BULKLOAD_END;
+  } else if (op_str == "epoch_begin") {
+    op = UnifiedLogOp::EPOCH_BEGIN;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+namespace gart {
+namespace graph {
+
+// op | epoch | vertex body or edge body | binlog offset, see LogEntry in
+// converter/parser.h
+bool parse_text_log(string_view log, LogRecord& record) {
+  string_view field;
+  record.props.clear();
+  if (!next_field(log, field) || !parse_op(field, record.op)) {
+    return false;
+  }
+  if (!next_field(log, field) || !parse_int(field, record.epoch)) {
+    return false;
+  }
+
+  if (is_vertex_op(record.op)) {
+    if (!next_field(log, field) || !parse_int(field, record.vid) ||
+        !next_field(log, record.external_id)) {
+      return false;
+    }
+  } else if (is_edge_op(record.op)) {
+    if (!next_field(log, field) || !parse_int(field, record.elabel) ||
+        !next_field(log, field) || !parse_int(field, record.vid) ||
+        !next_field(log, field) || !parse_int(field, record.dst_vid) ||
+        !next_field(log, record.external_id) ||
+        !next_field(log, record.dst_external_id)) {
+      return false;
+    }
+  }
+
+  // the remaining fields are properties followed by the binlog offset
+  while (next_field(log, field)) {
+    record.props.emplace_back(field);
+  }
+  if (record.props.empty()) {
+    return false;
+  }
+  record.props.pop_back();
+  return true;
+}
+
+bool parse_text_log_position(string_view log, int& epoch, int64_t& offset) {
+  size_t pos = log.rfind('|');
+  if (pos == string_view::npos || !parse_int(log.substr(pos + 1), offset)) {
+    return false;
+  }
+  string_view field;
+  return next_field(log, field) && next_field(log, field) &&
+         parse_int(field, epoch);
+}
+
+bool parse_binary_log_position(string_view log, int& epoch,
+                               int64_t& offset) {
+  UnifiedLogDecoder decoder(log.data(), log.size());
+  UnifiedLogOp op;
+  uint64_t value, binlog_offset;
+  if (!decoder.get_op(&op) || !decoder.get_uint(&value) ||
+      !decoder.get_uint(&binlog_offset)) {
+    return false;
+  }
+  epoch = static_cast<int>(value);
+  offset = static_cast<int64_t>(binlog_offset);
+  return true;
+}
+
+bool parse_binary_log(string_view log, LogRecord& record) {
+  UnifiedLogDecoder decoder(log.data(), log.size());
+  uint64_t value, binlog_offset;
+  const char* data;
+  size_t size;
+  record.props.clear();
+  if (!decoder.get_op(&record.op) || !decoder.get_uint(&value) ||
+      !decoder.get_uint(&binlog_offset)) {
+    return false;
+  }
+  record.epoch = static_cast<int>(value);
+  if (record.op == UnifiedLogOp::BULKLOAD_END ||
+      record.op == UnifiedLogOp::EPOCH_BEGIN) {
+    return decoder.done();
+  }
+
+  if (is_vertex_op(record.op)) {
+    if (!decoder.get_uint(&record.vid) || !decoder.get_bytes(&data, &size)) {
+      return false;
+    }
+    record.external_id = string_view(data, size);
+  } else {
+    if (!decoder.get_uint(&value) || !decoder.get_uint(&record.vid) ||
+        !decoder.get_uint(&record.dst_vid)) {
+      return false;
+    }
+    record.elabel = static_cast<int>(value);
+    if (!decoder.get_bytes(&data, &size)) {
+      return false;
+    }
+    record.external_id = string_view(data, size);
+    if (!decoder.get_bytes(&data, &size)) {
+      return false;
+    }
+    record.dst_external_id = string_view(data, size);
+  }
+
+  uint64_t num_props;
+  if (!decoder.get_uint(&num_props)) {
+    return false;
+  }
+  if (num_props > log.size()) {
+    return false;  // at least one byte per property
+  }
+  record.props.resize(num_props);
+  for (auto& prop : record.props) {
+    if (!decoder.get_value(&prop)) {
+      return false;
+    }
+  }
+  return decoder.done();
+}
+
+}  // namespace graph
+}  // namespace gart
@@ -18,19 +18,12 @@
 #include "graph/graph_ops.h"
 #include "graph/type_def.h"
 
-using std::string;
-
-using gart::property::StringViewList;
-
 namespace gart {
 namespace graph {
 
-void process_update_vertex(const StringViewList& cmd,
+void process_update_vertex(const LogRecord& log,
                            graph::GraphStore* graph_store) {
-  int write_epoch = stoi(string(cmd[0]));
-  uint64_t vid = static_cast<uint64_t>(stoll(string(cmd[1])));
-  StringViewList props(cmd.begin() + 3, cmd.end());
-  graph_store->update_inner_vertex(write_epoch, vid, props);
+  graph_store->update_inner_vertex(log.epoch, log.vid, log.props);
 }
 
 }  // namespace graph
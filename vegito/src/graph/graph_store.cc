@@ -12,10 +12,15 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include <algorithm>
+#include <charconv>
 #include <cstdint>
 #include <fstream>
+#include <thread>
 
 #include "graph/graph_store.h"
+#include "fragment/blob_schema_etcd.h"
+#include "fragment/epoch_pin_etcd.h"
 #include "property/property.h"
 #include "util/bitset.h"
 
@@ -177,6 +182,15 @@ struct SchemaJson {
   vector<TypeDef> types;
 };
 
+// the external id of a vertex with a LONG external id
+inline int64_t parse_oid(std::string_view external_id) {
+  int64_t oid = 0;
+  auto res = std::from_chars(
+      external_id.data(), external_id.data() + external_id.size(), oid);
+  CHECK(res.ec == std::errc()) << "Invalid external id: " << external_id;
+  return oid;
+}
+
 }  // namespace
 
 namespace gart {
@@ -231,8 +245,8 @@ void GraphStore::put_schema4gie() {
   assert(response_task.is_ok());
 }
 
-void GraphStore::add_string_buffer(size_t size) {
-  string_buffer_manager_.init_capacity(size);
+void GraphStore::init_string_heap(size_t chunk_size) {
+  string_heap_.init(chunk_size);
 }
 
 void GraphStore::add_vprop_buffer(size_t size) {
@@ -255,49 +269,63 @@ void GraphStore::add_vgraph(uint64_t vlabel, RGMapping* rg_map) {
 #else
   uint64_t block_size = get_max_memory_usage(vlabel);
   uint64_t num_vertex = get_max_vertex_num(vlabel);
-  seg_graphs_[vlabel] =
-      new seggraph::SegGraph(rg_map, vlabel, block_size, num_vertex);
+  // block_size is a bound, blocks are allocated in arenas on demand
+  seg_graphs_[vlabel] = new seggraph::SegGraph(
+      rg_map, vlabel, block_size, num_vertex, FLAGS_seggraph_arena_size);
 
   // add outer CSR and its schema
-  ov_seg_graphs_[vlabel] = new seggraph::SegGraph(rg_map, vlabel, block_size,
-                                                  num_vertex);
+  ov_seg_graphs_[vlabel] = new seggraph::SegGraph(
+      rg_map, vlabel, block_size, num_vertex, FLAGS_seggraph_arena_size);
 #endif
 
   auto& blob_schema = seg_graphs_[vlabel]->get_blob_schema();
   auto& ov_schema = ov_seg_graphs_[vlabel]->get_blob_schema();
-  blob_schema.set_ov_block_oid(ov_schema.get_block_oid());
+  blob_schema.set_ov_block_oids(ov_schema.get_block_oids(),
+                                ov_schema.get_block_arena_bits());
   blob_schema.set_ov_elabel2segs(ov_schema.get_elabel2segs());
 
   // add common information
   blob_schema.set_vlabel(vlabel);
 
+  // the vertex arrays grow on demand, see reserve_vertex
+  auto& arrays = vertex_arrays_[vlabel];
+  uint64_t initial_capacity =
+      std::max<uint64_t>(FLAGS_initial_vertex_capacity, 1);
+  arrays.inner_capacity = std::min<uint64_t>(
+      initial_capacity, seg_graphs_[vlabel]->get_vertex_capacity());
+  arrays.outer_capacity = std::min<uint64_t>(
+      initial_capacity, ov_seg_graphs_[vlabel]->get_vertex_capacity());
+  array_allocator_.set_accounting(MemoryComponent::VERTEX_TABLES, vlabel);
+
   // vertex_table
   {
-    vineyard::ObjectID oid;
-    uint64_t max_v = seg_graphs_[vlabel]->get_vertex_capacity() +
-                     ov_seg_graphs_[vlabel]->get_vertex_capacity();
+    uint64_t max_v = arrays.inner_capacity + arrays.outer_capacity;
     auto& vtable = vertex_tables_[vlabel];
-    vtable.table =
-        array_allocator_.allocate_v6d<seggraph::vertex_t>(max_v, oid);
+    vtable.table = array_allocator_.allocate_v6d_or_die<seggraph::vertex_t>(
+        max_v, vtable.oid);
     vtable.max_inner = 0;
     vtable.min_outer = max_v;
     vtable.max_inner_location = 0;
     vtable.min_outer_location = max_v;
+    vtable.inner_num = 0;
+    vtable.outer_num = 0;
     vtable.size = max_v;
 
-    gart::VTableMeta meta(oid, max_v);
+    gart::VTableMeta meta(vtable.oid, max_v);
     blob_schema.set_vtable_meta(meta);
   }
 
   // ovl2g
   {
-    vineyard::ObjectID oid;
-    uint64_t max_v = ov_seg_graphs_[vlabel]->get_vertex_capacity();
-    ovl2gs_[vlabel] = array_allocator_.allocate_v6d<uint64_t>(max_v, oid);
-    gart::ArrayMeta meta(oid, max_v);
+    ovl2gs_[vlabel] = array_allocator_.allocate_v6d_or_die<uint64_t>(
+        arrays.outer_capacity, arrays.ovl2g_oid);
+    gart::ArrayMeta meta(arrays.ovl2g_oid, arrays.outer_capacity);
     blob_schema.set_ovl2g_meta(meta);
   }
 
+  dest_fid_tables_[vlabel] = std::make_unique<DestFidTable>(
+      array_allocator_.get_client(), vlabel);
+
   blob_schemas_[vlabel] = blob_schema;
 }
 
@@ -328,18 +356,171 @@ void GraphStore::add_vprop(uint64_t vlabel, const Property::Schema& schema) {
   }
 }
 
+bool GraphStore::add_vprop_index(uint64_t vlabel, int prop_id, int dtype,
+                                 PropertyIndexType type) {
+  if (!property::PropertyIndex::supports(type, dtype)) {
+    return false;
+  }
+  auto index = std::make_unique<property::PropertyIndex>(
+      array_allocator_.get_client(), type, dtype, vlabel);
+  index->init(FLAGS_property_index_chunk_size,
+              FLAGS_property_index_bucket_bits);
+  blob_schemas_[vlabel].add_prop_index_meta(
+      gart::VPropIndexMeta(prop_id, type, index->get_oid()));
+  vprop_indexes_[vlabel][prop_id] = std::move(index);
+  return true;
+}
+
+void GraphStore::index_vprop(int epoch, uint64_t vlabel, uint64_t voffset,
+                             const PropValueList& values) {
+  auto iter = vprop_indexes_.find(vlabel);
+  if (iter == vprop_indexes_.end()) {
+    return;
+  }
+  for (auto& pair : iter->second) {
+    if (pair.first < values.size()) {
+      pair.second->put(voffset, values[pair.first], epoch);
+    }
+  }
+}
+
+void GraphStore::unindex_inner_vertex(int epoch, uint64_t vlabel,
+                                      uint64_t voffset) {
+  auto iter = vprop_indexes_.find(vlabel);
+  if (iter == vprop_indexes_.end()) {
+    return;
+  }
+  for (auto& pair : iter->second) {
+    pair.second->remove(voffset, epoch);
+  }
+}
+
 void GraphStore::init_external_id_storage(uint64_t vlabel) {
-  vineyard::ObjectID object_id = 0;
-  uint64_t v_capacity = seg_graphs_[vlabel]->get_vertex_capacity();
-  external_id_stores_[vlabel] =
-      array_allocator_.allocate_v6d<uint64_t>(v_capacity, object_id);
-  blob_schemas_[vlabel].set_external_id_oid(object_id);
+  auto& arrays = vertex_arrays_[vlabel];
+  array_allocator_.set_accounting(MemoryComponent::VERTEX_TABLES, vlabel);
+  external_id_stores_[vlabel] = array_allocator_.allocate_v6d_or_die<uint64_t>(
+      arrays.inner_capacity, arrays.external_id_oid);
+  blob_schemas_[vlabel].set_external_id_oid(arrays.external_id_oid);
   blob_schemas_[vlabel].set_external_id_dtype(external_id_dtype_[vlabel]);
 
-  uint64_t outer_v_capacity = ov_seg_graphs_[vlabel]->get_vertex_capacity();
   outer_external_id_stores_[vlabel] =
-      array_allocator_.allocate_v6d<uint64_t>(outer_v_capacity, object_id);
-  blob_schemas_[vlabel].set_outer_external_id_oid(object_id);
+      array_allocator_.allocate_v6d_or_die<uint64_t>(
+          arrays.outer_capacity, arrays.outer_external_id_oid);
+  blob_schemas_[vlabel].set_outer_external_id_oid(
+      arrays.outer_external_id_oid);
+}
+
+bool GraphStore::reserve_vertex(uint64_t vlabel, bool outer,
+                                uint64_t voffset) {
+  VertexArrays& arrays = vertex_arrays_[vlabel];
+  if (arrays.reserved_slots >= vertex_tables_[vlabel].size) {
+    return false;
+  }
+  if (outer) {
+    if (arrays.reserved_outer >= arrays.outer_capacity) {
+      return false;
+    }
+    arrays.reserved_outer++;
+  } else if (voffset >= arrays.inner_capacity) {
+    return false;
+  }
+  arrays.reserved_slots++;
+  return true;
+}
+
+void GraphStore::grow_vertex_arrays(uint64_t vlabel, bool outer,
+                                    uint64_t voffset, int epoch) {
+  VTable& vtable = vertex_tables_[vlabel];
+  VertexArrays& arrays = vertex_arrays_[vlabel];
+  // no log is being applied, so the reservations are what is taken
+  arrays.reserved_slots =
+      vtable.max_inner_location + vtable.size - vtable.min_outer_location;
+  arrays.reserved_outer = ov_seg_graphs_[vlabel]->get_max_vertex_id();
+
+  array_allocator_.set_accounting(MemoryComponent::VERTEX_TABLES, vlabel);
+  if (arrays.reserved_slots >= vtable.size) {
+    grow_vtable_(vlabel, arrays.reserved_slots + 1, epoch);
+  }
+  if (outer && arrays.reserved_outer >= arrays.outer_capacity) {
+    uint64_t capacity = std::min<uint64_t>(
+        std::max(arrays.outer_capacity * 2, arrays.reserved_outer + 1),
+        ov_seg_graphs_[vlabel]->get_vertex_capacity());
+    ovl2gs_[vlabel] = grow_array_(ovl2gs_[vlabel], arrays.outer_capacity,
+                                  capacity, arrays.ovl2g_oid, epoch);
+    outer_external_id_stores_[vlabel] = grow_array_(
+        outer_external_id_stores_[vlabel], arrays.outer_capacity, capacity,
+        arrays.outer_external_id_oid, epoch);
+    arrays.outer_capacity = capacity;
+    blob_schemas_[vlabel].set_ovl2g_meta(
+        gart::ArrayMeta(arrays.ovl2g_oid, capacity));
+    blob_schemas_[vlabel].set_outer_external_id_oid(
+        arrays.outer_external_id_oid);
+  }
+  if (!outer && voffset >= arrays.inner_capacity) {
+    uint64_t capacity = std::min<uint64_t>(
+        std::max(arrays.inner_capacity * 2, voffset + 1),
+        seg_graphs_[vlabel]->get_vertex_capacity());
+    external_id_stores_[vlabel] =
+        grow_array_(external_id_stores_[vlabel], arrays.inner_capacity,
+                    capacity, arrays.external_id_oid, epoch);
+    arrays.inner_capacity = capacity;
+    blob_schemas_[vlabel].set_external_id_oid(arrays.external_id_oid);
+  }
+  CHECK(reserve_vertex(vlabel, outer, voffset))
+      << "Too many " << (outer ? "outer" : "inner")
+      << " vertices of vertex label " << vlabel;
+}
+
+void GraphStore::reserve_marker_slot_(uint64_t vlabel, int epoch) {
+  VTable& vtable = vertex_tables_[vlabel];
+  VertexArrays& arrays = vertex_arrays_[vlabel];
+  if (arrays.reserved_slots >= vtable.size) {
+    array_allocator_.set_accounting(MemoryComponent::VERTEX_TABLES, vlabel);
+    grow_vtable_(vlabel, arrays.reserved_slots + 1, epoch);
+  }
+  arrays.reserved_slots++;
+}
+
+void GraphStore::grow_vtable_(uint64_t vlabel, uint64_t size, int epoch) {
+  VTable& vtable = vertex_tables_[vlabel];
+  size = std::max(vtable.size * 2, size);
+  vineyard::ObjectID oid;
+  auto table =
+      array_allocator_.allocate_v6d_or_die<seggraph::vertex_t>(size, oid);
+  memcpy(table, vtable.table,
+         vtable.max_inner_location * sizeof(seggraph::vertex_t));
+  // delete markers of outer vertices refer to their slots, which move
+  uint64_t delta = size - vtable.size;
+  uint64_t delete_mask = ((uint64_t) 1) << (sizeof(uint64_t) * 8 - 1);
+  for (uint64_t loc = vtable.min_outer_location; loc < vtable.size; loc++) {
+    seggraph::vertex_t v = vtable.table[loc];
+    table[loc + delta] = (v & delete_mask) ? v + delta : v;
+  }
+  for (uint64_t& slot : vtable.outer_slots) {
+    if (slot != NO_SLOT) {
+      slot += delta;
+    }
+  }
+  retired_vertex_arrays_.push_back(RetiredArray{vtable.oid, epoch});
+
+  vtable.table = table;
+  vtable.oid = oid;
+  vtable.size = size;
+  vtable.min_outer += delta;
+  vtable.min_outer_location += delta;
+  // the bounds and locations are set by update_blob
+  blob_schemas_[vlabel].set_vtable_meta(gart::VTableMeta(oid, size));
+}
+
+template <typename T>
+T* GraphStore::grow_array_(T* array, uint64_t len, uint64_t new_len,
+                           vineyard::ObjectID& oid, int epoch) {
+  vineyard::ObjectID new_oid;
+  T* new_array = array_allocator_.allocate_v6d_or_die<T>(new_len, new_oid);
+  memcpy(new_array, array, len * sizeof(T));
+  retired_vertex_arrays_.push_back(RetiredArray{oid, epoch});
+  oid = new_oid;
+  return new_array;
 }
 
 void GraphStore::update_blob(uint64_t blob_epoch) {
@@ -348,11 +529,24 @@ void GraphStore::update_blob(uint64_t blob_epoch) {
     gart::BlobSchema& schema = pair.second;
     seggraph::SegGraph* graph = seg_graphs_[vlabel];
     seggraph::SegGraph* ov_graph = ov_seg_graphs_[vlabel];
+    // arenas of blocks allocated during the epoch
+    graph->update_block_oids();
+    ov_graph->update_block_oids();
+    const auto& ov_schema = ov_graph->get_blob_schema();
+    schema.set_block_oids(graph->get_blob_schema().get_block_oids(),
+                          graph->get_blob_schema().get_block_arena_bits());
+    schema.set_ov_block_oids(ov_schema.get_block_oids(),
+                             ov_schema.get_block_arena_bits());
     schema.set_vtable_bound(graph->get_max_vertex_id(),
                             ov_graph->get_max_vertex_id());
     schema.set_vtable_location(
         graph->get_max_vertex_id() + graph->get_deleted_inner_num(),
         ov_graph->get_max_vertex_id() + ov_graph->get_deleted_outer_num());
+    const VTable& vtable = vertex_tables_[vlabel];
+    schema.set_vertex_nums(vtable.inner_num, vtable.outer_num);
+    DestFidTable* dest_fid_table = dest_fid_tables_[vlabel].get();
+    dest_fid_table->publish(graph->get_max_vertex_id(), blob_epoch);
+    schema.set_dest_fid_list_meta(dest_fid_table->get_meta());
     schema.set_ovg2l_oid(ovg2ls_[vlabel]->id());
     schema.set_vertex_map_oid(vertex_maps_[vlabel]->id());
     history_vertex_maps_[vlabel] = vertex_maps_[vlabel];
@@ -495,40 +689,352 @@ void GraphStore::put_blob_json_etcd(uint64_t write_epoch) {
       total_vertex_num_.load(std::memory_order_relaxed);
   blob_schema["total_edge_num"] =
       total_edge_num_.load(std::memory_order_relaxed);
-  blob_schema["string_buffer_object_id"] =
-      string_buffer_manager_.get_buffer_oid();
-  auto blob_schemas = fetch_blob_schema(write_epoch);
-  json blob_array = json::array();
-  for (const auto& pair : blob_schemas) {
-    uint64_t vlabel = pair.first;
-    auto val = pair.second.json();
-    blob_array.push_back(val);
+  std::vector<size_t> edge_nums;
+  for (const auto& edge_num : edge_nums_) {
+    edge_nums.push_back(edge_num.load(std::memory_order_relaxed));
+  }
+  blob_schema["edge_nums"] = edge_nums;
+  // string_buffer_object_id is the first chunk, for readers of one chunk
+  auto string_chunk_oids = string_heap_.get_chunk_oids();
+  blob_schema["string_buffer_object_id"] = string_chunk_oids[0];
+  blob_schema["string_buffer_object_ids"] = string_chunk_oids;
+  blob_schema["string_buffer_chunk_bits"] = string_heap_.get_chunk_bits();
+  const auto& blob_schemas = fetch_blob_schema(write_epoch);
+
+  // a delta from the fields changed since the checkpoint, a checkpoint every
+  // few epochs, for new labels, or when a delta would not save much
+  string blob_schema_str;
+  uint64_t checkpoint_epoch = blob_schema_checkpoint_epoch_;
+  if (!blob_schema_checkpoint_.is_null() &&
+      write_epoch - blob_schema_checkpoint_epoch_ <
+          static_cast<uint64_t>(FLAGS_blob_schema_checkpoint_interval) &&
+      blob_schema["vertex_label_num"] ==
+          blob_schema_checkpoint_["vertex_label_num"]) {
+    json patch = json::array();
+    for (auto iter = blob_schema.begin(); iter != blob_schema.end(); ++iter) {
+      auto old = blob_schema_checkpoint_.find(iter.key());
+      if (old == blob_schema_checkpoint_.end() || *old != iter.value()) {
+        patch.push_back({{"op", "add"},
+                         {"path", "/" + iter.key()},
+                         {"value", iter.value()}});
+      }
+    }
+    size_t idx = 0;
+    for (const auto& pair : blob_schemas) {
+      pair.second.append_patch("/blob/" + to_string(idx++), patch);
+    }
+    blob_schema_str =
+        make_blob_schema_delta(blob_schema, checkpoint_epoch, std::move(patch))
+            .dump();
+    if (blob_schema_str.size() * 2 >= blob_schema_checkpoint_size_) {
+      blob_schema_str.clear();
+    }
+  }
+  if (blob_schema_str.empty()) {
+    checkpoint_epoch = write_epoch;
+    json full_schema = blob_schema;
+    json blob_array = json::array();
+    for (const auto& pair : blob_schemas) {
+      blob_array.push_back(pair.second.json());
+    }
+    full_schema["blob"] = std::move(blob_array);
+    blob_schema_str = full_schema.dump();
+
+    blob_schema_checkpoint_ = std::move(blob_schema);
+    blob_schema_checkpoint_epoch_ = write_epoch;
+    blob_schema_checkpoint_size_ = blob_schema_str.size();
+    for (auto& pair : blob_schemas_) {
+      pair.second.clear_dirty();
+    }
   }
-  blob_schema["blob"] = blob_array;
-
-  string blob_schema_str = blob_schema.dump();
-  string blob_json_key = FLAGS_meta_prefix + "gart_blob_m" + to_string(0) +
-                         "_p" + to_string(local_pid_) + "_e" +
-                         to_string(write_epoch);
 
+  string blob_json_key =
+      get_blob_schema_key(FLAGS_meta_prefix, local_pid_, write_epoch);
   auto response_task = etcd_client_->put(blob_json_key, blob_schema_str).get();
   assert(response_task.is_ok());
+  published_blob_epochs_[write_epoch] = checkpoint_epoch;
 
   string latest_epoch =
       FLAGS_meta_prefix + "gart_latest_epoch_p" + to_string(local_pid_);
   response_task = etcd_client_->put(latest_epoch, to_string(write_epoch)).get();
   assert(response_task.is_ok());
+
+  prune_blob_schemas(write_epoch);
+}
+
+void GraphStore::prune_blob_schemas(uint64_t write_epoch) {
+  uint64_t retained = FLAGS_blob_schema_retained_epochs;
+  if (write_epoch <= retained) {
+    return;
+  }
+  uint64_t floor = write_epoch - retained;
+  // only the schema of the latest epoch is put to etcd
+  history_blob_schemas_.erase(history_blob_schemas_.begin(),
+                              history_blob_schemas_.lower_bound(floor));
+
+  if (published_blob_epochs_.empty() ||
+      published_blob_epochs_.begin()->first >= floor) {
+    return;
+  }
+  // pinned snapshots must stay readable, safe_epoch_ is advanced by
+  // recycle_graphs, so that the pins are not listed every epoch
+  if (safe_epoch_ < 0) {
+    return;
+  }
+  floor = std::min<uint64_t>(floor, safe_epoch_);
+  auto first_kept = published_blob_epochs_.lower_bound(floor);
+  if (first_kept == published_blob_epochs_.end()) {
+    return;
+  }
+  // the checkpoint of the oldest epoch kept is needed by all the epochs kept
+  uint64_t checkpoint_epoch = first_kept->second;
+  for (auto iter = published_blob_epochs_.begin(); iter != first_kept;) {
+    if (iter->first == checkpoint_epoch) {
+      ++iter;
+      continue;
+    }
+    auto response = etcd_client_
+                        ->rm(get_blob_schema_key(FLAGS_meta_prefix, local_pid_,
+                                                 iter->first))
+                        .get();
+    if (!response.is_ok()) {
+      LOG(ERROR) << "Failed to prune the blob schema of epoch " << iter->first
+                 << ": " << response.error_message();
+      break;
+    }
+    iter = published_blob_epochs_.erase(iter);
+  }
+}
+
+void GraphStore::compact_graphs(uint64_t write_epoch) {
+  std::vector<size_t> edge_prop_sizes(edge_bitmap_size_.size());
+  for (size_t elabel = 0; elabel < edge_prop_sizes.size(); elabel++) {
+    edge_prop_sizes[elabel] =
+        get_edge_prop_total_bytes(elabel + total_vertex_label_num_) +
+        edge_bitmap_size_[elabel];
+  }
+  // pinned snapshots must stay exact, the safe epoch is refreshed by
+  // recycle_graphs
+  int64_t horizon = std::min(static_cast<int64_t>(write_epoch) -
+                                 FLAGS_compaction_retained_epochs,
+                             safe_epoch_);
+  for (auto* graphs : {&seg_graphs_, &ov_seg_graphs_}) {
+    for (auto& pair : *graphs) {
+      pair.second->compact_segments(write_epoch, horizon,
+                                    FLAGS_compaction_tombstone_ratio,
+                                    FLAGS_compaction_segments_per_epoch,
+                                    edge_prop_sizes);
+    }
+  }
+}
+
+int64_t GraphStore::get_min_pinned_epoch() {
+  auto response =
+      etcd_client_->ls(get_pinned_epoch_prefix(FLAGS_meta_prefix, local_pid_))
+          .get();
+  if (!response.is_ok()) {
+    // be conservative: treat every epoch as pinned
+    LOG(ERROR) << "Failed to list pinned epochs: " << response.error_message();
+    return -1;
+  }
+  int64_t min_epoch = numeric_limits<int64_t>::max();
+  for (size_t i = 0; i < response.keys().size(); i++) {
+    int64_t epoch;
+    if (!parse_epoch(response.value(i).as_string(), epoch)) {
+      LOG(ERROR) << "Malformed pinned epoch " << response.key(i) << ": "
+                 << response.value(i).as_string();
+      return -1;
+    }
+    min_epoch = std::min(min_epoch, epoch);
+  }
+  return min_epoch;
+}
+
+int64_t GraphStore::advance_safe_epoch(uint64_t write_epoch) {
+  // nothing retired within LAG_EPOCH_NUMBER epochs is reclaimed anyway
+  int64_t floor =
+      std::min(static_cast<int64_t>(write_epoch) - LAG_EPOCH_NUMBER - 1,
+               get_min_pinned_epoch());
+  if (floor > reclaim_floor_) {
+    // readers pinning from now on refuse epochs before the floor, and the
+    // readers pinned before are listed again
+    auto response = etcd_client_
+                        ->put(get_reclaim_floor_key(FLAGS_meta_prefix,
+                                                    local_pid_),
+                              to_string(floor))
+                        .get();
+    if (!response.is_ok()) {
+      LOG(ERROR) << "Failed to publish the reclaim floor: "
+                 << response.error_message();
+      return safe_epoch_;
+    }
+    reclaim_floor_ = floor;
+    floor = std::min(floor, get_min_pinned_epoch());
+  }
+  // readers pinning meanwhile have seen a floor at least as high
+  if (floor >= 0) {
+    safe_epoch_ = std::max(safe_epoch_, floor);
+  }
+  return safe_epoch_;
+}
+
+void GraphStore::recycle_graphs(uint64_t write_epoch) {
+  if (write_epoch < next_reclaim_epoch_) {
+    return;
+  }
+  next_reclaim_epoch_ =
+      write_epoch + std::max(FLAGS_reclaim_interval_epochs, 1);
+
+  int64_t safe_epoch = advance_safe_epoch(write_epoch);
+  bool has_reclaimable = false;
+  for (auto* graphs : {&seg_graphs_, &ov_seg_graphs_}) {
+    for (auto& pair : *graphs) {
+      has_reclaimable |= pair.second->get_reclaimable_bytes() > 0;
+    }
+  }
+  has_reclaimable |= string_heap_.get_reclaimable_bytes() > 0;
+  for (auto& pair : vprop_indexes_) {
+    for (auto& index : pair.second) {
+      has_reclaimable |= index.second->get_reclaimable_nodes() > 0;
+    }
+  }
+  for (auto& pair : dest_fid_tables_) {
+    has_reclaimable |= pair.second->get_retired_lists() > 0;
+  }
+  has_reclaimable |= !retired_vertex_arrays_.empty();
+  // the string heap (including large values), property indexes, destination
+  // fid tables and vertex arrays follow the same rule as the blocks
+  if (has_reclaimable && safe_epoch >= 0) {
+    for (auto* graphs : {&seg_graphs_, &ov_seg_graphs_}) {
+      for (auto& pair : *graphs) {
+        pair.second->recycle_segments(write_epoch, safe_epoch);
+      }
+    }
+    string_heap_.recycle(write_epoch, safe_epoch);
+    for (auto& pair : vprop_indexes_) {
+      for (auto& index : pair.second) {
+        index.second->recycle(write_epoch, safe_epoch);
+      }
+    }
+    for (auto& pair : dest_fid_tables_) {
+      pair.second->recycle(write_epoch, safe_epoch);
+    }
+    size_t kept = 0;
+    for (const auto& retired : retired_vertex_arrays_) {
+      if (retired.epoch <= safe_epoch &&
+          retired.epoch + LAG_EPOCH_NUMBER < write_epoch) {
+        array_allocator_.deallocate_v6d(retired.oid);
+      } else {
+        retired_vertex_arrays_[kept++] = retired;
+      }
+    }
+    retired_vertex_arrays_.resize(kept);
+  }
+
+  using json = vineyard::json;
+  json stats;
+  stats["epoch"] = write_epoch;
+  json label_stats = json::array();
+  for (auto& pair : seg_graphs_) {
+    size_t reclaimable, reclaimed;
+    get_reclaim_stats(pair.first, reclaimable, reclaimed);
+    json label_stat;
+    label_stat["vlabel"] = pair.first;
+    label_stat["reclaimable_bytes"] = reclaimable;
+    label_stat["reclaimed_bytes"] = reclaimed;
+    label_stats.push_back(label_stat);
+  }
+  stats["vertex_labels"] = label_stats;
+  json string_stats;
+  string_stats["used_bytes"] = string_heap_.get_used_bytes();
+  string_stats["deduplicated_bytes"] = string_heap_.get_deduplicated_bytes();
+  string_stats["reclaimable_bytes"] = string_heap_.get_reclaimable_bytes();
+  string_stats["reclaimed_bytes"] = string_heap_.get_reclaimed_bytes();
+  string_stats["large_values"] = string_heap_.get_large_value_num();
+  stats["string_heap"] = string_stats;
+  string stats_key =
+      FLAGS_meta_prefix + "gart_reclaim_stats_p" + to_string(local_pid_);
+  auto response = etcd_client_->put(stats_key, stats.dump()).get();
+  if (!response.is_ok()) {
+    LOG(ERROR) << "Failed to publish the reclaim stats: "
+               << response.error_message();
+  }
+}
+
+bool GraphStore::check_memory_pressure() {
+  auto& accounting = MemoryAccounting::instance();
+  for (auto& pair : seg_graphs_) {
+    uint64_t vlabel = pair.first;
+    uint64_t used = pair.second->get_block_usage();
+    uint64_t capacity = pair.second->get_block_capacity();
+    auto iter = ov_seg_graphs_.find(vlabel);
+    if (iter != ov_seg_graphs_.end()) {
+      used += iter->second->get_block_usage();
+      capacity += iter->second->get_block_capacity();
+    }
+    accounting.set(MemoryComponent::BLOCKS_USED, vlabel, used);
+    accounting.set_block_capacity(vlabel, capacity);
+  }
+  accounting.refresh(array_allocator_.get_client());
+  return accounting.under_pressure();
+}
+
+void GraphStore::put_cstring(std::string_view sv, uint64_t& key,
+                             int64_t column) {
+  for (int retry = 1;; retry++) {
+    key = string_heap_.put(sv, column);
+    if (likely(key != static_cast<uint64_t>(-1))) {
+      return;
+    }
+    // the value is never dropped: the epoch fails rather than being applied
+    // with a wrong value
+    if (FLAGS_string_put_retries > 0 && retry > FLAGS_string_put_retries) {
+      LOG(FATAL) << "Failed to put a string of " << sv.size()
+                 << " bytes after " << FLAGS_string_put_retries
+                 << " retries: " << MemoryAccounting::instance().to_string();
+    }
+    if (retry % 10 == 0) {
+      LOG(WARNING) << "Waiting to put a string of " << sv.size()
+                   << " bytes for " << retry << " retries: "
+                   << MemoryAccounting::instance().to_string();
+    }
+    // wait for the memory freed by readers and other processes
+    std::this_thread::sleep_for(
+        std::chrono::milliseconds(FLAGS_memory_pressure_backoff_ms));
+  }
+}
+
+void GraphStore::get_reclaim_stats(uint64_t vlabel, size_t& reclaimable,
+                                   size_t& reclaimed) {
+  reclaimable = 0;
+  reclaimed = 0;
+  for (auto* graphs : {&seg_graphs_, &ov_seg_graphs_}) {
+    auto iter = graphs->find(vlabel);
+    if (iter != graphs->end()) {
+      reclaimable += iter->second->get_reclaimable_bytes();
+      reclaimed += iter->second->get_reclaimed_bytes();
+    }
+  }
+}
+
+void GraphStore::decode_vprop(uint64_t vlabel, const LogValueList& vprop,
+                              PropValueList& values) const {
+  values.resize(vprop.size());
+  for (size_t idx = 0; idx < vprop.size(); ++idx) {
+    Property::decode_prop(schema_.dtype_map.at({vlabel, idx}), vprop[idx],
+                          values[idx]);
+  }
 }
 
 bool GraphStore::insert_inner_vertex(int epoch, uint64_t gid,
-                                     std::string external_id,
-                                     StringViewList& vprop) {
+                                     std::string_view external_id,
+                                     const LogValueList& vprop) {
   auto vlabel = id_parser.GetLabelId(gid);
 #ifdef USE_GLOBAL_VERTEX_MAP
   // global vertex map
   if (external_id_dtype_[vlabel] == PropertyDataType::LONG) {
     std::shared_ptr<hashmap_t> hmap;
-    set_vertex_map(hmap, vlabel, std::stoll(external_id), (int64_t) gid);
+    set_vertex_map(hmap, vlabel, parse_oid(external_id), (int64_t) gid);
   }
 #endif
 
@@ -543,10 +1049,18 @@ bool GraphStore::insert_inner_vertex(int epoch, uint64_t gid,
   // local vertex map
   if (external_id_dtype_[vlabel] == PropertyDataType::LONG) {
     std::shared_ptr<hashmap_t> hmap;
-    set_vertex_map(hmap, vlabel, std::stoll(external_id), (int64_t) gid);
+    set_vertex_map(hmap, vlabel, parse_oid(external_id), (int64_t) gid);
   }
 #endif
 
+  // put before taking the label mutex, as it may wait for memory
+  uint64_t external_id_value;
+  if (external_id_dtype_[vlabel] == PropertyDataType::STRING) {
+    put_cstring(external_id, external_id_value);
+  } else {
+    external_id_value = parse_oid(external_id);
+  }
+
   uint64_t voffset = id_parser.GetOffset(gid);
   auto lid = id_parser.GenerateId(0, vlabel, voffset);
 
@@ -571,37 +1085,23 @@ bool GraphStore::insert_inner_vertex(int epoch, uint64_t gid,
 
   add_inner(vlabel, lid);
 
-  if (external_id_dtype_[vlabel] == PropertyDataType::STRING) {
-    uint64_t value = put_cstring(external_id);
-    external_id_stores_[vlabel][v] = value;
-  } else {
-    external_id_stores_[vlabel][v] = std::stoll(external_id);
-  }
+  external_id_stores_[vlabel][v] = external_id_value;
 
 #ifdef USE_MULTI_THREADS
   inner_vertex_label_mutexes_[vlabel]->unlock();
 #endif
 
-  // deal with string
-  // allocate space for string_view
-  vector<string> tmp_str(vprop.size());
-  for (size_t idx = 0; idx < vprop.size(); ++idx) {
-    auto dtype = schema_.dtype_map.at({vlabel, idx});
-    if (dtype == STRING) {
-      uint64_t value = put_cstring(vprop[idx]);
-      tmp_str[idx] = to_string(value);
-      vprop[idx] = tmp_str[idx];
-    }
-  }
-
-  // insert properties
-  property->insert(v, gid, vprop, epoch, this, vlabel);
+  // insert properties, strings are put into the string heap by the store
+  PropValueList values;
+  decode_vprop(vlabel, vprop, values);
+  property->insert(v, gid, values, epoch, this, vlabel);
+  index_vprop(epoch, vlabel, v, values);
 
   return true;
 }
 
 bool GraphStore::update_inner_vertex(int epoch, uint64_t gid,
-                                     StringViewList& vprop) {
+                                     const LogValueList& vprop) {
   auto fid = id_parser.GetFid(gid);
   if (fid != local_pid_) {
     return false;  // not in this partition
@@ -611,7 +1111,10 @@ bool GraphStore::update_inner_vertex(int epoch, uint64_t gid,
   auto voffset = id_parser.GetOffset(gid);
   Property* property = get_property(vlabel);
 
-  property->update(voffset, gid, vprop, epoch, this);
+  PropValueList values;
+  decode_vprop(vlabel, vprop, values);
+  property->update(voffset, gid, values, epoch, this);
+  index_vprop(epoch, vlabel, voffset, values);
   return true;
 }
 
@@ -649,7 +1152,7 @@ void GraphStore::set_ovg2l(std::shared_ptr<hashmap_t>& hmap, uint64_t v_label,
   }
 }
 
-void GraphStore::construct_eprop(int elabel, const StringViewList& eprop,
+void GraphStore::construct_eprop(int elabel, const LogValueList& eprop,
                                  std::string& out) {
   out.clear();
   out.resize(get_edge_prop_total_bytes(elabel + total_vertex_label_num_) +
@@ -660,33 +1163,25 @@ void GraphStore::construct_eprop(int elabel, const StringViewList& eprop,
   uint8_t* bitmap = reinterpret_cast<uint8_t*>(prop_buffer);
   memset(bitmap, 0, edge_bitmap_size_[elabel]);
 
-  string tmp_str;  // for store string_view
+  PropValue value;
   for (size_t idx = 0; idx < eprop.size(); idx++) {
-    if (eprop[idx].size() == 0) {
+    auto dtype =
+        get_edge_property_dtypes(elabel + total_vertex_label_num_, idx);
+    Property::decode_prop(dtype, eprop[idx], value);
+    if (value.is_null) {
       set_bit(bitmap, idx);
+      continue;
     }
 
-    auto dtype =
-        get_edge_property_dtypes(elabel + total_vertex_label_num_, idx);
     uint64_t property_offset =
         get_edge_prop_prefix_bytes(elabel + total_vertex_label_num_, idx);
-
     // bitmap allocated before properties
     void* prop_ptr = prop_buffer + edge_bitmap_size_[elabel] + property_offset;
-    std::string_view sv = eprop[idx];
-    if (dtype == STRING) {
-      auto str_len = eprop[idx].length();
-      if (str_len == 0) {
-        set_bit(bitmap, idx);
-      }
-      uint64_t value = put_cstring(eprop[idx]);
-      tmp_str = to_string(value);
-      sv = tmp_str;
-    }
-
-    if (eprop[idx].size() != 0) {
-      Property::assign_prop(dtype, prop_ptr, sv);
+    if (Property::is_heap_type(dtype)) {
+      put_cstring(value.bytes(), value.str_key,
+                  string_column(elabel + total_vertex_label_num_, idx));
     }
+    Property::assign_prop(dtype, prop_ptr, value);
   }
 }
 
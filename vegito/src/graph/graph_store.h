@@ -16,6 +16,7 @@
 #ifndef VEGITO_SRC_GRAPH_GRAPH_STORE_H_
 #define VEGITO_SRC_GRAPH_GRAPH_STORE_H_
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <ctime>
@@ -36,9 +37,12 @@
 #include "vineyard/basic/ds/hashmap_mvcc.h"
 
 #include "fragment/id_parser.h"
+#include "graph/dest_fid_table.h"
 #include "memory/buffer_manager.h"
+#include "memory/string_heap.h"
 #include "property/property_col_array.h"
 #include "property/property_col_paged.h"
+#include "property/property_index.h"
 #include "seggraph/seggraph.hpp"
 #include "system_flags.h"  // NOLINT(build/include_subdir)
 
@@ -77,11 +81,37 @@ class GraphStore {
   struct VTable {
     seggraph::vertex_t* table;
     uint64_t size;
+    vineyard::ObjectID oid;
 
     uint64_t max_inner;
     uint64_t min_outer;
     uint64_t max_inner_location;
     uint64_t min_outer_location;
+
+    // live vertices, published as the vertex numbers of each epoch
+    uint64_t inner_num;
+    uint64_t outer_num;
+
+    // slots of live vertices in table, so deletes need not scan the table:
+    // offset of an inner vertex -> slot, and index of an outer vertex (see
+    // outer_index_) -> slot, NO_SLOT if absent
+    std::vector<uint64_t> inner_slots;
+    std::vector<uint64_t> outer_slots;
+  };
+
+  // the other arrays indexed by vertex of a label: external ids of inner
+  // vertices, and ovl2g and external ids of outer vertices
+  struct VertexArrays {
+    uint64_t inner_capacity = 0;
+    uint64_t outer_capacity = 0;
+    vineyard::ObjectID external_id_oid = 0;
+    vineyard::ObjectID outer_external_id_oid = 0;
+    vineyard::ObjectID ovl2g_oid = 0;
+
+    // vertex table slots and outer vertices taken by the logs applied or
+    // dispatched, by the dispatcher only (see reserve_vertex)
+    uint64_t reserved_slots = 0;
+    uint64_t reserved_outer = 0;
   };
 
   GraphStore(int local_pid, int mid, int total_partitions)
@@ -94,7 +124,7 @@ class GraphStore {
         key_off_map_(INIT_VEC_SZ),
         pid_off_map_(INIT_VEC_SZ),
         total_vertex_label_num_(0),
-        string_buffer_manager_(array_allocator_.get_client()),
+        string_heap_(array_allocator_.get_client()),
         vprop_buffer_manager_(array_allocator_.get_client()),
         etcd_client_(std::make_shared<etcd::Client>(FLAGS_etcd_endpoint)) {}
 
@@ -117,7 +147,7 @@ class GraphStore {
 
   inline void set_schema(SchemaImpl schema) { this->schema_ = schema; }
 
-  inline SchemaImpl get_schema() { return this->schema_; }
+  inline const SchemaImpl& get_schema() const { return this->schema_; }
 
   inline uint64_t get_local_pid() const { return local_pid_; }
   inline int get_total_partitions() const { return total_partitions_; }
@@ -133,6 +163,10 @@ class GraphStore {
     id_parser.Init(total_partitions_, vlabel_num);
   }
 
+  inline const VTable& get_vertex_table(uint64_t vlabel) {
+    return vertex_tables_[vlabel];
+  }
+
   inline uint64_t get_vtable_max_inner(uint64_t vlabel) {
     return vertex_tables_[vlabel].max_inner;
   }
@@ -145,16 +179,19 @@ class GraphStore {
   }
 
   // return true if the vertex is in the local partition, else false
-  bool insert_inner_vertex(int epoch, uint64_t gid, std::string external_id,
-                           property::StringViewList& vprop);
+  // properties are decoded once here (see Property::decode_prop)
+  bool insert_inner_vertex(int epoch, uint64_t gid,
+                           std::string_view external_id,
+                           const property::LogValueList& vprop);
 
   bool update_inner_vertex(int epoch, uint64_t gid,
-                           property::StringViewList& vprop);
+                           const property::LogValueList& vprop);
 
-  void construct_eprop(int elabel, const property::StringViewList& eprop,
+  void construct_eprop(int elabel, const property::LogValueList& eprop,
                        std::string& out);
 
-  void add_string_buffer(size_t size);
+  // the string heap grows by chunks of chunk_size bytes
+  void init_string_heap(size_t chunk_size);
 
   void add_vprop_buffer(size_t size);
 
@@ -162,10 +199,78 @@ class GraphStore {
 
   void add_vprop(uint64_t vlabel, const property::Property::Schema& schema);
 
+  // a secondary index on a vertex property, declared by "index" ("hash" or
+  // "ordered") in the RGMapping, return false if the data type of the
+  // property is not supported
+  bool add_vprop_index(uint64_t vlabel, int prop_id, int dtype,
+                       PropertyIndexType type);
+
+  // the inner vertex is deleted at epoch
+  void unindex_inner_vertex(int epoch, uint64_t vlabel, uint64_t voffset);
+
+  // an edge between the inner vertex (vlabel, voffset) and a vertex of the
+  // remote fragment fid is added (or deleted), dir is the direction of the
+  // edge from the inner vertex, see DestFidTable
+  void add_dest_fid(uint64_t vlabel, int elabel, uint64_t voffset,
+                    uint64_t fid, seggraph::dir_t dir) {
+    dest_fid_tables_[vlabel]->add(elabel, voffset, fid, dir);
+  }
+
+  void del_dest_fid(uint64_t vlabel, int elabel, uint64_t voffset,
+                    uint64_t fid, seggraph::dir_t dir) {
+    dest_fid_tables_[vlabel]->remove(elabel, voffset, fid, dir);
+  }
+
+  void del_dest_fids(uint64_t vlabel, uint64_t voffset) {
+    dest_fid_tables_[vlabel]->remove_vertex(voffset);
+  }
+
+  // The vertex table, ovl2g and external ids of a label are vineyard arrays
+  // of initial_vertex_capacity vertices at first, doubled on demand up to
+  // the vertex capacity of its SegGraphs. Replaced arrays are kept for the
+  // readers of earlier epochs and freed with the retired blocks.
+  //
+  // Reserve room for the vertex a log may add, an inner vertex at voffset
+  // or an outer vertex, before the log is applied. Return false if the
+  // arrays must be grown by grow_vertex_arrays first.
+  bool reserve_vertex(uint64_t vlabel, bool outer, uint64_t voffset);
+
+  // grow the arrays and reserve the room, no log may be applied meanwhile
+  void grow_vertex_arrays(uint64_t vlabel, bool outer, uint64_t voffset,
+                          int epoch);
+
   void update_blob(uint64_t blob_epoch);
 
+  // put the blob schema of the epoch to etcd, as a checkpoint or as a delta
+  // against the last checkpoint, and prune the schemas of old epochs
   void put_blob_json_etcd(uint64_t write_epoch);
 
+  // compact edge segments of all vertex labels with many delete markers
+  void compact_graphs(uint64_t write_epoch);
+
+  // every FLAGS_reclaim_interval_epochs epochs, free the blocks, strings,
+  // index nodes and destination fid lists retired before the oldest epoch
+  // pinned by readers, and publish the reclaimable/reclaimed bytes of each
+  // vertex label and of the string heap to etcd
+  void recycle_graphs(uint64_t write_epoch);
+
+  // refresh the memory accounting (see util/memory_accounting.h) with the
+  // block usage of each vertex label, return true if the store is close to
+  // its memory limits
+  bool check_memory_pressure();
+
+  // the oldest epoch pinned by readers of this partition (see EpochPin),
+  // INT64_MAX if there is none, -1 if the pins cannot be listed
+  int64_t get_min_pinned_epoch();
+
+  // move the epoch before which memory may be reclaimed towards
+  // write_epoch, publishing the reclaim floor for readers pinning meanwhile
+  // (see EpochPin), and return it
+  int64_t advance_safe_epoch(uint64_t write_epoch);
+
+  void get_reclaim_stats(uint64_t vlabel, size_t& reclaimable,
+                         size_t& reclaimed);
+
   void put_schema();
 
   void put_schema4gie();
@@ -177,26 +282,27 @@ class GraphStore {
   inline void add_inner(uint64_t vlabel, seggraph::vertex_t lid) {
     VTable& vtable = vertex_tables_[vlabel];
     assert(vtable.max_inner_location != vtable.min_outer_location);
+    set_slot_(vtable.inner_slots, id_parser.GetOffset(lid),
+              vtable.max_inner_location);
     vtable.table[vtable.max_inner_location] = lid;
     ++vtable.max_inner_location;
     ++vtable.max_inner;
+    ++vtable.inner_num;
   }
 
-  inline void delete_inner(uint64_t vlabel, seggraph::vertex_t offset) {
+  // deletes are applied when no other log is, see reserve_marker_slot_
+  inline void delete_inner(uint64_t vlabel, seggraph::vertex_t offset,
+                           int epoch) {
     VTable& vtable = vertex_tables_[vlabel];
-    for (auto i = 0; i < vtable.max_inner_location; i++) {
-      auto value = vtable.table[i];
-      auto delete_flag = value >> (sizeof(seggraph::vertex_t) * 8 - 1);
-      if (delete_flag == 1) {
-        continue;
-      }
-      if (id_parser.GetOffset(value) == offset) {
-        uint64_t delete_mask = ((uint64_t) 1) << (sizeof(uint64_t) * 8 - 1);
-        vtable.table[vtable.max_inner_location] = (i | delete_mask);
-        ++vtable.max_inner_location;
-        break;
-      }
+    uint64_t slot = take_slot_(vtable.inner_slots, offset);
+    if (slot == NO_SLOT) {
+      return;
     }
+    reserve_marker_slot_(vlabel, epoch);
+    uint64_t delete_mask = ((uint64_t) 1) << (sizeof(uint64_t) * 8 - 1);
+    vtable.table[vtable.max_inner_location] = (slot | delete_mask);
+    ++vtable.max_inner_location;
+    --vtable.inner_num;
   }
 
   inline void add_outer(uint64_t vlabel, seggraph::vertex_t lid) {
@@ -205,34 +311,37 @@ class GraphStore {
       LOG(ERROR) << "Not enough space for outer vertex for vlabel " << vlabel;
       assert(false);
     }
+    set_slot_(vtable.outer_slots, outer_index_(lid),
+              vtable.min_outer_location - 1);
     vtable.table[vtable.min_outer_location - 1] = lid;
     --vtable.min_outer;
     --vtable.min_outer_location;
+    ++vtable.outer_num;
   }
 
-  inline void delete_outer(uint64_t vlabel, seggraph::vertex_t lid) {
+  inline void delete_outer(uint64_t vlabel, seggraph::vertex_t lid,
+                           int epoch) {
     VTable& vtable = vertex_tables_[vlabel];
-    for (auto i = vtable.size - 1; i >= vtable.min_outer_location; i--) {
-      auto value = vtable.table[i];
-      auto delete_flag = value >> (sizeof(seggraph::vertex_t) * 8 - 1);
-      if (delete_flag == 1) {
-        continue;
-      }
-      if (value == lid) {
-        uint64_t delete_mask = ((uint64_t) 1) << (sizeof(uint64_t) * 8 - 1);
-        vtable.table[vtable.min_outer_location - 1] = i | delete_mask;
-        --vtable.min_outer_location;
-        return;
-      }
+    uint64_t slot = take_slot_(vtable.outer_slots, outer_index_(lid));
+    if (slot == NO_SLOT) {
+      LOG(ERROR) << "delete outer error ######";
+      return;
     }
-    LOG(ERROR) << "delete outer error ######";
+    // growing the table moves the outer slots, the slot taken included
+    uint64_t size = vtable.size;
+    reserve_marker_slot_(vlabel, epoch);
+    slot += vtable.size - size;
+    uint64_t delete_mask = ((uint64_t) 1) << (sizeof(uint64_t) * 8 - 1);
+    vtable.table[vtable.min_outer_location - 1] = slot | delete_mask;
+    --vtable.min_outer_location;
+    --vtable.outer_num;
   }
 
   inline void insert_blob_schema(uint64_t write_epoch) {
     history_blob_schemas_[write_epoch] = blob_schemas_;
   }
 
-  std::map<uint64_t, gart::BlobSchema> fetch_blob_schema(
+  const std::map<uint64_t, gart::BlobSchema>& fetch_blob_schema(
       uint64_t write_epoch) const {
     auto iter = history_blob_schemas_.find(write_epoch);
     assert(iter != history_blob_schemas_.end());
@@ -385,27 +494,44 @@ class GraphStore {
     return edge_table_maps_[name];
   }
 
-  // Return the offset and length of the string in the string buffer
-  inline uint64_t put_cstring(const std::string_view& sv) {
-    size_t str_len = sv.length();
-    size_t str_offset = string_buffer_manager_.put_cstring(sv);
-    return (str_offset << 16) | str_len;
+  // Put a string into the string heap and set key to its offset and length
+  // (offset << 16 | length). Values of the same column (see string_column)
+  // are deduplicated if the column has few distinct values.
+  //
+  // If vineyard is out of memory, the writer backs off and retries, and the
+  // process fails after string_put_retries. It may sleep, so it must not be
+  // called under the label mutexes.
+  void put_cstring(std::string_view sv, uint64_t& key,
+                   int64_t column = memory::StringHeap::NO_COLUMN);
+
+  inline void get_string(uint64_t key, std::string& output) const {
+    string_heap_.get(key, output);
   }
 
-  inline uint64_t put_cstring(const std::string& str) {
-    return put_cstring(std::string_view(str));
+  // valid until the string is reclaimed
+  inline std::string_view get_string_view(uint64_t key) const {
+    return string_heap_.get_view(key);
   }
 
-  inline void get_string(uint64_t key, std::string& output) const {
-    size_t str_offset = key >> 16;
-    size_t str_len = key & 0xffff;
-    string_buffer_manager_.get_string(str_offset, str_len, output);
+  // a string superseded at epoch, reclaimed by recycle_graphs
+  inline void retire_cstring(uint64_t key, int epoch) {
+    string_heap_.retire(key, epoch);
+  }
+
+  // the column of a vertex/edge property, label is the vertex label or
+  // elabel + total_vertex_label_num_ for edges
+  static int64_t string_column(uint64_t label, uint64_t prop_idx) {
+    return (label << 16) | prop_idx;
   }
 
   void init_edge_bitmap_size(uint64_t elabel_num) {
     edge_bitmap_size_.resize(elabel_num);
   }
 
+  void init_edge_nums(uint64_t elabel_num) {
+    edge_nums_ = std::vector<std::atomic<size_t>>(elabel_num);
+  }
+
   size_t get_edge_bitmap_size(uint64_t elabel) const {
     return edge_bitmap_size_[elabel];
   }
@@ -499,11 +625,18 @@ class GraphStore {
 
   void add_total_vertex_num_by_one() { total_vertex_num_++; }
 
-  void add_total_edge_num_by_one() { total_edge_num_++; }
+  // edges are counted as out-edges of inner vertices, by edge label
+  void add_edge_num_by_one(uint64_t elabel) {
+    total_edge_num_++;
+    edge_nums_[elabel]++;
+  }
 
   void del_total_vertex_num_by_one() { total_vertex_num_--; }
 
-  void del_total_edge_num_by_one() { total_edge_num_--; }
+  void del_edge_num_by_one(uint64_t elabel) {
+    total_edge_num_--;
+    edge_nums_[elabel]--;
+  }
 
 #ifdef USE_MULTI_THREADS
   std::shared_timed_mutex* get_vertex_label_mutex(uint64_t vlabel) {
@@ -535,6 +668,31 @@ class GraphStore {
 
  private:
   static const int INIT_VEC_SZ = 128;
+  // as SegGraph::LAG_EPOCH_NUMBER
+  static constexpr int64_t LAG_EPOCH_NUMBER = 2;
+
+  void decode_vprop(uint64_t vlabel, const property::LogValueList& vprop,
+                    property::PropValueList& values) const;
+
+  // a slot of the vertex table for a delete marker, grown if it is full
+  void reserve_marker_slot_(uint64_t vlabel, int epoch);
+
+  // double the vertex table (at least to size), moving the outer vertices
+  // to its end
+  void grow_vtable_(uint64_t vlabel, uint64_t size, int epoch);
+
+  // a copy of len elements of array in a new blob of new_len elements, the
+  // old blob (oid) is retired at epoch and oid is set to the new one
+  template <typename T>
+  T* grow_array_(T* array, uint64_t len, uint64_t new_len,
+                 vineyard::ObjectID& oid, int epoch);
+
+  void index_vprop(int epoch, uint64_t vlabel, uint64_t voffset,
+                   const property::PropValueList& values);
+
+  // remove the blob schemas older than the retained epochs from memory and
+  // etcd, except the epochs pinned by readers and their checkpoints
+  void prune_blob_schemas(uint64_t write_epoch);
 
   const int local_pid_;         // from 0 in each machine
   const int mid_;               // machine id
@@ -543,6 +701,7 @@ class GraphStore {
   int total_vertex_label_num_;
   std::atomic<size_t> total_vertex_num_{0};
   std::atomic<size_t> total_edge_num_{0};
+  std::vector<std::atomic<size_t>> edge_nums_;  // elabel -> edge number
 
   SparseArrayAllocator array_allocator_;
 
@@ -557,12 +716,48 @@ class GraphStore {
   std::unordered_map<uint64_t, property::Property*> property_stores_;
   std::unordered_map<uint64_t, property::Property::Schema> property_schemas_;
 
+  static constexpr uint64_t NO_SLOT = std::numeric_limits<uint64_t>::max();
+
+  // outer vertices take offsets downwards from the largest one
+  uint64_t outer_index_(seggraph::vertex_t lid) const {
+    uint64_t max_outer_offset = (1ul << id_parser.GetOffsetWidth()) - 1;
+    return max_outer_offset - id_parser.GetOffset(lid);
+  }
+
+  static void set_slot_(std::vector<uint64_t>& slots, uint64_t idx,
+                        uint64_t slot) {
+    if (idx >= slots.size()) {
+      slots.resize(std::max<size_t>(idx + 1, slots.size() * 2), NO_SLOT);
+    }
+    slots[idx] = slot;
+  }
+
+  // return the slot and remove it, NO_SLOT if absent
+  static uint64_t take_slot_(std::vector<uint64_t>& slots, uint64_t idx) {
+    if (idx >= slots.size()) {
+      return NO_SLOT;
+    }
+    uint64_t slot = slots[idx];
+    slots[idx] = NO_SLOT;
+    return slot;
+  }
+
   // vlabel -> vertex table
   std::unordered_map<uint64_t, VTable> vertex_tables_;
 
   // outer v: vlabel, offset -> gid
   std::unordered_map<uint64_t, uint64_t*> ovl2gs_;
 
+  std::unordered_map<uint64_t, VertexArrays> vertex_arrays_;
+
+  // vertex arrays replaced by larger ones, freed when no reader of an epoch
+  // before the replacement is left
+  struct RetiredArray {
+    vineyard::ObjectID oid;
+    int64_t epoch;
+  };
+  std::vector<RetiredArray> retired_vertex_arrays_;
+
   // outer v: vlabel -> pointer of lid hashmap
   std::vector<std::shared_ptr<hashmap_t>> ovg2ls_;
   // label -> pointer of lid hashmap of latest stable version
@@ -594,12 +789,21 @@ class GraphStore {
   std::vector<std::unordered_map<uint64_t, uint64_t>>
       key_lid_map_;  // vlabel -> <key, local id>
 
-  // for string buffer
-  memory::BufferManager string_buffer_manager_;
+  // for string properties and external ids
+  memory::StringHeap string_heap_;
 
   // for vertex property page buffer
   memory::BufferManager vprop_buffer_manager_;
 
+  // vlabel -> prop id -> secondary index
+  std::unordered_map<uint64_t,
+                     std::map<int, std::unique_ptr<property::PropertyIndex>>>
+      vprop_indexes_;
+
+  // vlabel -> remote fragments adjacent to inner vertices
+  std::unordered_map<uint64_t, std::unique_ptr<DestFidTable>>
+      dest_fid_tables_;
+
   // for bitmap
   std::vector<size_t> edge_bitmap_size_;
 
@@ -621,6 +825,21 @@ class GraphStore {
   std::map<uint64_t, std::map<uint64_t, gart::BlobSchema>>
       history_blob_schemas_;  // version --> map<vlabel, schema>
 
+  // the fields of the last full blob schema put to etcd but the per-label
+  // schemas, whose changes are tracked by blob_schemas_, and the size of the
+  // full schema, see fragment/blob_schema_etcd.h
+  vineyard::json blob_schema_checkpoint_;
+  uint64_t blob_schema_checkpoint_epoch_ = 0;
+  size_t blob_schema_checkpoint_size_ = 0;
+  // epochs put to etcd -> their checkpoint epochs
+  std::map<uint64_t, uint64_t> published_blob_epochs_;
+
+  // readers refuse epochs before the published reclaim floor, and no reader
+  // reads an epoch before safe_epoch_ (-1 if unknown yet)
+  int64_t reclaim_floor_ = -1;
+  int64_t safe_epoch_ = -1;
+  uint64_t next_reclaim_epoch_ = 0;
+
   uint64_t blob_epoch_;
 
   std::shared_ptr<etcd::Client> etcd_client_;
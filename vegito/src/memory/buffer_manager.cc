@@ -56,7 +56,8 @@ BufferManager::~BufferManager() {
 
 void BufferManager::init_() {
   vineyard::ObjectID object_id;
-  buffer_ = array_allocator_.allocate_v6d(capacity_, object_id);
+  array_allocator_.set_accounting(MemoryComponent::PROPERTIES);
+  buffer_ = array_allocator_.allocate_v6d_or_die(capacity_, object_id);
   buffer_oid_ = object_id;
   inited_ = true;
 }
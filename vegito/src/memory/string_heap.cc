@@ -0,0 +1,202 @@
+/** Copyright 2020-2023 Alibaba Group Holding Limited.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "memory/string_heap.h"
+
+#include "glog/logging.h"
+
+namespace gart {
+namespace memory {
+
+StringHeap::StringHeap(vineyard::Client* v6d_client)
+    : array_allocator_(v6d_client) {
+  array_allocator_.set_accounting(MemoryComponent::STRINGS);
+}
+
+StringHeap::~StringHeap() {
+  for (size_t idx = 0; idx < chunk_oids_.size(); idx++) {
+    // a large value takes several chunks of one blob
+    if (chunk_oids_[idx] != FREED_CHUNK &&
+        (idx == 0 || chunk_oids_[idx] != chunk_oids_[idx - 1])) {
+      array_allocator_.deallocate_v6d(chunk_oids_[idx]);
+    }
+  }
+}
+
+void StringHeap::init(uint64_t chunk_size) {
+  // a chunk holds at least one string of the max length
+  int chunk_bits = StringChunks::STR_LEN_BITS + 1;
+  while ((1ul << chunk_bits) < chunk_size &&
+         chunk_bits < StringChunks::MAX_CHUNK_BITS) {
+    chunk_bits++;
+  }
+  chunk_size_ = 1ul << chunk_bits;
+  chunks_.set_chunk_bits(chunk_bits);
+  // readers of the writer process index the chunks without locking
+  chunks_.reserve(MAX_CHUNK_NUM);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  // the first chunk is published in blob schemas even if there is no string
+  add_chunk_();
+}
+
+uint64_t StringHeap::put(std::string_view sv, int64_t column) {
+  uint64_t size = stored_size_(sv.length());
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  InternedColumn* interned = nullptr;
+  if (column != NO_COLUMN && sv.length() <= MAX_INTERNED_LENGTH) {
+    InternedColumn& col = interned_columns_[column];
+    if (!col.disabled) {
+      auto iter = col.values.find(std::string(sv));
+      if (iter != col.values.end()) {
+        deduplicated_bytes_ += size;
+        return iter->second;
+      }
+      if (col.values.size() < MAX_INTERNED_VALUES) {
+        interned = &col;
+      } else {
+        // not a low-cardinality column, values interned so far stay
+        col.disabled = true;
+        col.values.clear();
+      }
+    }
+  }
+
+  uint64_t offset = allocate_(size);
+  if (offset == (uint64_t) -1) {
+    return -1;
+  }
+  if (interned) {
+    // copy before other threads can find the value
+    uint64_t key = copy_(offset, sv);
+    interned->values.emplace(std::string(sv), key);
+    interned_offsets_.insert(offset);
+    return key;
+  }
+  lock.unlock();
+  return copy_(offset, sv);
+}
+
+uint64_t StringHeap::allocate_(uint64_t size) {
+  if (size > chunk_size_) {
+    return allocate_large_(size);
+  }
+
+  auto iter = free_lists_.find(size);
+  if (iter != free_lists_.end() && !iter->second.empty()) {
+    uint64_t offset = iter->second.back();
+    iter->second.pop_back();
+    used_bytes_ += size;
+    return offset;
+  }
+
+  if (chunk_used_ + size > chunk_size_ && !add_chunk_()) {
+    return -1;
+  }
+  uint64_t offset = (cur_chunk_ << chunks_.get_chunk_bits()) + chunk_used_;
+  chunk_used_ += size;
+  used_bytes_ += size;
+  return offset;
+}
+
+uint64_t StringHeap::allocate_large_(uint64_t size) {
+  size_t chunk_num = (size + chunk_size_ - 1) / chunk_size_;
+  size_t first_chunk = chunks_.get_chunk_num();
+  if (first_chunk + chunk_num > MAX_CHUNK_NUM) {
+    LOG(ERROR) << "StringHeap: out of chunks for a value of " << size
+               << " bytes";
+    return -1;
+  }
+  vineyard::ObjectID oid;
+  char* blob = array_allocator_.allocate_v6d(chunk_num * chunk_size_, oid);
+  if (blob == nullptr) {
+    return -1;
+  }
+  for (size_t idx = 0; idx < chunk_num; idx++) {
+    chunks_.add_chunk(blob + idx * chunk_size_);
+    chunk_oids_.push_back(oid);
+  }
+  uint64_t offset = first_chunk << chunks_.get_chunk_bits();
+  large_values_.emplace(offset, LargeValue{oid, first_chunk, chunk_num});
+  used_bytes_ += size;
+  large_value_num_++;
+  return offset;
+}
+
+bool StringHeap::add_chunk_() {
+  if (chunks_.get_chunk_num() == MAX_CHUNK_NUM) {
+    LOG(ERROR) << "StringHeap: out of memory (" << MAX_CHUNK_NUM
+               << " chunks of " << chunk_size_ << " bytes)";
+    return false;
+  }
+  vineyard::ObjectID oid;
+  char* chunk = array_allocator_.allocate_v6d(chunk_size_, oid);
+  if (chunk == nullptr) {
+    return false;
+  }
+  cur_chunk_ = chunks_.get_chunk_num();
+  chunks_.add_chunk(chunk);
+  chunk_oids_.push_back(oid);
+  chunk_used_ = 0;
+  return true;
+}
+
+void StringHeap::retire(uint64_t key, int64_t epoch) {
+  uint64_t offset = StringChunks::key_offset(key);
+  uint64_t size = stored_size_(chunks_.get_view(key).length());
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (interned_offsets_.count(offset)) {
+    return;  // shared by other values
+  }
+  retired_.push_back(RetiredString{offset, size, epoch});
+  reclaimable_bytes_ += size;
+}
+
+void StringHeap::recycle(int64_t write_epoch, int64_t safe_epoch) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<RetiredString> new_retired;
+  for (const RetiredString& str : retired_) {
+    if (str.epoch <= safe_epoch && str.epoch + LAG_EPOCH_NUMBER < write_epoch) {
+      auto iter = large_values_.find(str.offset);
+      if (iter != large_values_.end()) {
+        const LargeValue& value = iter->second;
+        array_allocator_.deallocate_v6d(value.oid);
+        for (size_t idx = 0; idx < value.chunk_num; idx++) {
+          chunks_.reset_chunk(value.first_chunk + idx);
+          chunk_oids_[value.first_chunk + idx] = FREED_CHUNK;
+        }
+        large_values_.erase(iter);
+        large_value_num_--;
+      } else {
+        free_lists_[str.size].push_back(str.offset);
+      }
+      used_bytes_ -= str.size;
+      reclaimable_bytes_ -= str.size;
+      reclaimed_bytes_ += str.size;
+    } else {
+      new_retired.push_back(str);
+    }
+  }
+  retired_.swap(new_retired);
+}
+
+std::vector<vineyard::ObjectID> StringHeap::get_chunk_oids() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return chunk_oids_;
+}
+
+}  // namespace memory
+}  // namespace gart
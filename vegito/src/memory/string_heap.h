@@ -0,0 +1,189 @@
+/** Copyright 2020-2023 Alibaba Group Holding Limited.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef VEGITO_SRC_MEMORY_STRING_HEAP_H_
+#define VEGITO_SRC_MEMORY_STRING_HEAP_H_
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "util/allocator.hpp"
+#include "util/string_chunks.h"
+#include "vineyard/client/ds/blob.h"
+
+namespace gart {
+namespace memory {
+
+/**
+ * Storage of string properties and string external ids on vineyard.
+ *
+ * Strings are kept as C strings (ended by '\0') in chunks (vineyard blobs)
+ * allocated on demand, and referred to by keys (offset << 16 | length), see
+ * util/string_chunks.h for how readers resolve them.
+ *
+ * - Interning: values of a column are deduplicated until the column has more
+ *   than MAX_INTERNED_VALUES distinct values, so low-cardinality columns
+ *   (country, type, tag, ...) store each value once. Interned values are
+ *   never freed.
+ * - Reclamation: a value superseded at epoch e is retired, and its bytes are
+ *   reused for strings of the same size once no reader pins an epoch before
+ *   e and e + LAG_EPOCH_NUMBER is behind the write epoch, as for the blocks
+ *   of SegGraph.
+ * - Large values: values larger than a chunk get blobs of their own (see
+ *   StringChunks), which are deleted when the values are reclaimed. The
+ *   chunk ids of deleted blobs are published as FREED_CHUNK.
+ *
+ * All the methods are thread-safe.
+ */
+class StringHeap {
+ public:
+  // no interning for the string
+  static constexpr int64_t NO_COLUMN = -1;
+
+  // the object id of a chunk whose large value is freed
+  static constexpr vineyard::ObjectID FREED_CHUNK = 0;
+
+  explicit StringHeap(vineyard::Client* v6d_client);
+
+  ~StringHeap();
+
+  // allocate the first chunk, chunk_size is rounded up to a power of 2
+  void init(uint64_t chunk_size);
+
+  // return the key of the string (or bytes), (uint64_t) -1 if the memory is
+  // exhausted
+  uint64_t put(std::string_view sv, int64_t column = NO_COLUMN);
+
+  void get(uint64_t key, std::string& output) const {
+    output.assign(chunks_.get_view(key));
+  }
+
+  std::string_view get_view(uint64_t key) const {
+    return chunks_.get_view(key);
+  }
+
+  // number of values in blobs of their own
+  size_t get_large_value_num() const { return large_value_num_; }
+
+  // the value of key is replaced at epoch, its space can be reused after
+  // readers move on
+  void retire(uint64_t key, int64_t epoch);
+
+  // reuse the space of values retired before safe_epoch (see the class
+  // comment), called at epoch boundaries
+  void recycle(int64_t write_epoch, int64_t safe_epoch);
+
+  // for blob schemas
+  int get_chunk_bits() const { return chunks_.get_chunk_bits(); }
+
+  std::vector<vineyard::ObjectID> get_chunk_oids() const;
+
+  // bytes handed out and not freed
+  size_t get_used_bytes() const { return used_bytes_; }
+
+  // bytes saved by interning
+  size_t get_deduplicated_bytes() const { return deduplicated_bytes_; }
+
+  size_t get_reclaimable_bytes() const { return reclaimable_bytes_; }
+
+  size_t get_reclaimed_bytes() const { return reclaimed_bytes_; }
+
+ private:
+  static constexpr size_t MAX_INTERNED_VALUES = 1024;
+  static constexpr size_t MAX_INTERNED_LENGTH = 64;
+  static constexpr size_t MAX_CHUNK_NUM = 4096;
+  static constexpr int64_t LAG_EPOCH_NUMBER = 2;
+
+  struct InternedColumn {
+    std::unordered_map<std::string, uint64_t> values;
+    bool disabled = false;  // too many distinct values
+  };
+
+  struct RetiredString {
+    uint64_t offset;
+    uint64_t size;
+    int64_t epoch;
+  };
+
+  struct LargeValue {
+    vineyard::ObjectID oid;
+    size_t first_chunk;
+    size_t chunk_num;
+  };
+
+  // bytes taken by a value, including the length of a long value and '\0'
+  static uint64_t stored_size_(uint64_t len) {
+    return len + 1 +
+           (len >= StringChunks::LONG_STR_LEN ? sizeof(uint64_t) : 0);
+  }
+
+  // return (uint64_t) -1 if failed, must hold mutex_
+  uint64_t allocate_(uint64_t size);
+
+  // a blob of its own for a value larger than a chunk, must hold mutex_
+  uint64_t allocate_large_(uint64_t size);
+
+  // must hold mutex_
+  bool add_chunk_();
+
+  uint64_t copy_(uint64_t offset, std::string_view sv) {
+    char* dst = chunks_.get(offset);
+    uint64_t len = sv.length();
+    if (len >= StringChunks::LONG_STR_LEN) {
+      memcpy(dst, &len, sizeof(uint64_t));
+      dst += sizeof(uint64_t);
+      len = StringChunks::LONG_STR_LEN;
+    }
+    memcpy(dst, sv.data(), sv.length());
+    dst[sv.length()] = '\0';
+    return StringChunks::make_key(offset, len);
+  }
+
+  SparseArrayAllocator array_allocator_;
+  uint64_t chunk_size_ = 0;
+  StringChunks chunks_;
+  std::vector<vineyard::ObjectID> chunk_oids_;
+  size_t cur_chunk_ = 0;     // the chunk to allocate small values from
+  uint64_t chunk_used_ = 0;  // bytes allocated in cur_chunk_
+  // offset -> blob of a large value
+  std::unordered_map<uint64_t, LargeValue> large_values_;
+
+  std::unordered_map<int64_t, InternedColumn> interned_columns_;
+  std::unordered_set<uint64_t> interned_offsets_;
+  std::vector<RetiredString> retired_;
+  // size (including '\0') -> offsets of reclaimed strings
+  std::unordered_map<uint64_t, std::vector<uint64_t>> free_lists_;
+
+  std::atomic<size_t> used_bytes_{0};
+  std::atomic<size_t> deduplicated_bytes_{0};
+  std::atomic<size_t> reclaimable_bytes_{0};
+  std::atomic<size_t> reclaimed_bytes_{0};
+  std::atomic<size_t> large_value_num_{0};
+
+  mutable std::mutex mutex_;
+};
+
+}  // namespace memory
+}  // namespace gart
+
+#endif  // VEGITO_SRC_MEMORY_STRING_HEAP_H_
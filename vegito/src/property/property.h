@@ -28,9 +28,15 @@
 #define VEGITO_SRC_PROPERTY_PROPERTY_H_
 
 #include <algorithm>
+#include <cctype>
+#include <charconv>
 #include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <vector>
 
 #include "glog/logging.h"
@@ -39,6 +45,7 @@
 #include "graph/type_def.h"
 #include "memory/buffer_manager.h"
 #include "util/macros.h"
+#include "util/unified_log.h"
 #include "util/util.h"
 
 namespace gart {
@@ -49,7 +56,36 @@ class GraphStore;
 
 namespace property {
 
-typedef std::vector<std::string_view> StringViewList;
+// the properties of a unified log, see util/unified_log.h
+typedef std::vector<UnifiedLogValue> LogValueList;
+
+// a property value decoded once from a unified log by Property::decode_prop
+struct PropValue {
+  bool is_null = true;
+  union {
+    char c;
+    int16_t s;
+    int32_t i;
+    int64_t l;
+    float f;
+    double d;
+    // key of a value in the string heap (see is_heap_type), filled by the
+    // owner of the heap (GraphStore) from bytes()
+    uint64_t str_key;
+  };
+  // text of STRING, BYTES and TIMESTAMP values
+  std::string_view str;
+  // lists packed by decode_prop, see util/string_chunks.h for the layouts
+  std::string packed;
+  bool is_packed = false;
+
+  // the bytes to put into the string heap
+  std::string_view bytes() const {
+    return is_packed ? std::string_view(packed) : str;
+  }
+};
+
+typedef std::vector<PropValue> PropValueList;
 
 enum PropertyStoreType { /* PROP_KV, PROP_ROW, */
                          PROP_COLUMN = 2,
@@ -100,13 +136,15 @@ class Property {  // NOLINT(build/class)
     assert(false);
   }
 
-  virtual void insert(uint64_t off, uint64_t k, const StringViewList& v_list,
+  // values are decoded by decode_prop, strings are put into the string heap
+  // of graph_store by the property store
+  virtual void insert(uint64_t off, uint64_t k, const PropValueList& v_list,
                       uint64_t ver, gart::graph::GraphStore* graph_store,
                       int vlabel) {
     assert(false);
   }
 
-  virtual void update(uint64_t off, uint64_t k, const StringViewList& v_list,
+  virtual void update(uint64_t off, uint64_t k, const PropValueList& v_list,
                       uint64_t ver, gart::graph::GraphStore* graph_store) {
     assert(false);
   }
@@ -215,54 +253,148 @@ class Property {  // NOLINT(build/class)
     return nullptr;
   }
 
-  static inline void assign_prop(int data_type, void* prop_ptr,
-                                 const std::string_view& val) {
-    if (unlikely(val.size() == 0)) {
-      LOG(ERROR) << "Empty value for data type: " << data_type;
+  // values stored in the string heap, and referred to by their keys
+  static inline bool is_heap_type(int data_type) {
+    return data_type == STRING || data_type == BYTES ||
+           (data_type >= INT_LIST && data_type <= STRING_LIST);
+  }
+
+  // parse the text of a value, an empty text is null, return false (and a
+  // null value) if the text is malformed
+  //
+  // BYTES values are base64 encoded (as in the JSON of the binlogs), and
+  // lists are JSON arrays ("[e1, e2, ...]") or PostgreSQL arrays
+  // ("{e1,e2,...}"), see for_each_element_
+  static inline bool decode_prop(int data_type, const std::string_view& text,
+                                 PropValue& out) {
+    out.is_null = text.empty();
+    out.str = text;
+    out.l = 0;
+    out.is_packed = false;
+    if (out.is_null) {
+      return true;
     }
 
-    try {
-      switch (data_type) {
-      case CHAR:
-        assign(prop_ptr, val.at(0));
-        break;
-      case SHORT:
-        assign(prop_ptr, int16_t(stoi(std::string(val))));
-        break;
-      case INT:
-        assign(prop_ptr, stoi(std::string(val)));
-        break;
-      case LONG:
-        assign(prop_ptr, stoll(std::string(val)));
-        break;
-      case FLOAT:
-        assign(prop_ptr, stof(std::string(val)));
-        break;
-      case DOUBLE:
-        assign(prop_ptr, stod(std::string(val)));
-        break;
-      case STRING:
-        // use string id (str_offset << 16 | str_len) instead of itself
-        assign(prop_ptr, stoull(std::string(val)));
-        break;
-      case DATE:
-        assign(prop_ptr, stoi(std::string(val)));
-        break;
-      case DATETIME:
-        assign(prop_ptr, stoll(std::string(val)));
-        break;
-      case TIME:
-        assign(prop_ptr, stoll(std::string(val)));
-        break;
-      case TIMESTAMP:
-        assign_inline_str<gart::graph::TimeStamp>(prop_ptr, val);
-        break;
-      default:
-        LOG(ERROR) << "Unsupported data type: " << data_type;
+    bool ok = true;
+    switch (data_type) {
+    case CHAR:
+      out.c = text[0];
+      break;
+    case SHORT:
+      ok = parse_int_(text, out.s);
+      break;
+    case INT:
+    case DATE:
+      ok = parse_int_(text, out.i);
+      break;
+    case LONG:
+    case DATETIME:
+    case TIME:
+      ok = parse_int_(text, out.l);
+      break;
+    case FLOAT:
+      ok = parse_float_(text, out.f);
+      break;
+    case DOUBLE:
+      ok = parse_float_(text, out.d);
+      break;
+    case STRING:
+    case TIMESTAMP:
+      break;
+    case BYTES:
+      ok = decode_base64_(text, out.packed);
+      out.is_packed = ok;
+      break;
+    case INT_LIST:
+      ok = pack_list_<int32_t>(text, out);
+      break;
+    case LONG_LIST:
+      ok = pack_list_<int64_t>(text, out);
+      break;
+    case FLOAT_LIST:
+      ok = pack_list_<float>(text, out);
+      break;
+    case DOUBLE_LIST:
+      ok = pack_list_<double>(text, out);
+      break;
+    case STRING_LIST:
+      ok = pack_string_list_(text, out);
+      break;
+    default:
+      LOG(ERROR) << "Unsupported data type: " << data_type;
+      ok = false;
+    }
+
+    if (unlikely(!ok)) {
+      LOG(ERROR) << "Failed to decode property, data type: " << data_type
+                 << ", value: " << text;
+      out.is_null = true;
+    }
+    return ok;
+  }
+
+  // decode a property of a unified log, numbers of a binary log are taken
+  // as they are, and texts are parsed as above
+  static inline bool decode_prop(int data_type, const UnifiedLogValue& value,
+                                 PropValue& out) {
+    switch (value.type) {
+    case UnifiedLogValueType::TEXT:
+      return decode_prop(data_type, value.text, out);
+    case UnifiedLogValueType::INT:
+      if (assign_number_(data_type, value.i, out)) {
+        return true;
       }
-    } catch (std::exception& e) {
-      LOG(ERROR) << "Failed to assign property: " << e.what()
-                 << ", data type: " << data_type << ", value: " << val;
+      return decode_number_text_(data_type, std::to_string(value.i), out);
+    case UnifiedLogValueType::DOUBLE:
+      if (assign_number_(data_type, value.d, out)) {
+        return true;
+      }
+      return decode_number_text_(data_type, std::to_string(value.d), out);
+    default:
+      return decode_prop(data_type, std::string_view(), out);
+    }
+  }
+
+  // write a non-null value, the str_key of a STRING value must be filled
+  static inline void assign_prop(int data_type, void* prop_ptr,
+                                 const PropValue& val) {
+    switch (data_type) {
+    case CHAR:
+      assign(prop_ptr, val.c);
+      break;
+    case SHORT:
+      assign(prop_ptr, val.s);
+      break;
+    case INT:
+    case DATE:
+      assign(prop_ptr, val.i);
+      break;
+    case LONG:
+    case DATETIME:
+    case TIME:
+      assign(prop_ptr, val.l);
+      break;
+    case FLOAT:
+      assign(prop_ptr, val.f);
+      break;
+    case DOUBLE:
+      assign(prop_ptr, val.d);
+      break;
+    case STRING:
+    case BYTES:
+    case INT_LIST:
+    case LONG_LIST:
+    case FLOAT_LIST:
+    case DOUBLE_LIST:
+    case STRING_LIST:
+      // use string id (str_offset << 16 | str_len) instead of itself
+      assign(prop_ptr, val.str_key);
+      break;
+    case TIMESTAMP:
+      assign_inline_str<gart::graph::TimeStamp>(prop_ptr, val.str);
+      break;
+    default:
+      LOG(ERROR) << "Unsupported data type: " << data_type;
     }
   }
 
@@ -322,6 +454,326 @@ class Property {  // NOLINT(build/class)
   static inline void assign_inline_str(void* ptr, const std::string_view& val) {
     reinterpret_cast<T*>(ptr)->assign(val);
   }
+
+  // take a number of a binary log as a value of a numeric type, return false
+  // for the other types
+  template <typename T>
+  static inline bool assign_number_(int data_type, T num, PropValue& out) {
+    out.is_null = false;
+    out.str = std::string_view();
+    out.l = 0;
+    out.is_packed = false;
+    switch (data_type) {
+    case CHAR:
+      out.c = static_cast<char>(num);
+      return true;
+    case SHORT:
+      out.s = static_cast<int16_t>(num);
+      return true;
+    case INT:
+    case DATE:
+      out.i = static_cast<int32_t>(num);
+      return true;
+    case LONG:
+    case DATETIME:
+    case TIME:
+      out.l = static_cast<int64_t>(num);
+      return true;
+    case FLOAT:
+      out.f = static_cast<float>(num);
+      return true;
+    case DOUBLE:
+      out.d = static_cast<double>(num);
+      return true;
+    default:
+      return false;
+    }
+  }
+
+  // a number of a binary log for a string or list property (rare), the text
+  // is kept in out.packed, as out must not refer to a temporary
+  static inline bool decode_number_text_(int data_type, std::string text,
+                                         PropValue& out) {
+    bool ok = decode_prop(data_type, std::string_view(text), out);
+    if (ok && !out.is_packed) {
+      out.packed = std::move(text);
+      out.str = out.packed;
+      out.is_packed = true;
+    }
+    return ok;
+  }
+  template <typename T>
+  static inline bool parse_int_(const std::string_view& text, T& out) {
+    const char* first = text.data();
+    const char* last = first + text.size();
+    if (first != last && *first == '+') {
+      ++first;
+    }
+    auto [ptr, ec] = std::from_chars(first, last, out);
+    return ec == std::errc() && ptr != first;
+  }
+
+  template <typename T>
+  static inline bool parse_float_(const std::string_view& text, T& out) {
+    // strtod needs a terminated string, values are short
+    char buf[64];
+    if (text.size() >= sizeof(buf)) {
+      return false;
+    }
+    memcpy(buf, text.data(), text.size());
+    buf[text.size()] = '\0';
+    char* end = nullptr;
+    if constexpr (std::is_same_v<T, float>) {
+      out = strtof(buf, &end);
+    } else {
+      out = strtod(buf, &end);
+    }
+    return end != buf;
+  }
+
+  static inline std::string_view trim_(std::string_view sv) {
+    while (!sv.empty() && isspace(sv.front())) {
+      sv.remove_prefix(1);
+    }
+    while (!sv.empty() && isspace(sv.back())) {
+      sv.remove_suffix(1);
+    }
+    return sv;
+  }
+
+  // call func on each element of a list, the brackets may be omitted
+  //
+  // elements quoted by '"' may contain ',' and are passed to func unquoted
+  // and unescaped: "\uXXXX" (and its surrogate pairs) becomes UTF-8, the
+  // other escapes of JSON become their characters, and any other escaped
+  // character is taken as it is (as PostgreSQL does). Return false if the
+  // list is malformed or func fails
+  template <typename FUNC_T>
+  static inline bool for_each_element_(std::string_view text, FUNC_T&& func) {
+    text = trim_(text);
+    if (text.size() >= 2 && ((text.front() == '[' && text.back() == ']') ||
+                             (text.front() == '{' && text.back() == '}'))) {
+      text = trim_(text.substr(1, text.size() - 2));
+    }
+    if (text.empty()) {
+      return true;
+    }
+    std::string unescaped;
+    while (true) {
+      std::string_view elem;
+      size_t pos;
+      if (!text.empty() && text.front() == '"') {
+        size_t end = 1;
+        bool escaped = false;
+        while (end < text.size() && text[end] != '"') {
+          if (text[end] == '\\') {
+            escaped = true;
+            end++;
+          }
+          end++;
+        }
+        if (end >= text.size()) {
+          return false;
+        }
+        elem = text.substr(1, end - 1);
+        if (escaped) {
+          if (!unescape_(elem, unescaped)) {
+            return false;
+          }
+          elem = unescaped;
+        }
+        text = trim_(text.substr(end + 1));
+        if (!text.empty() && text.front() != ',') {
+          return false;
+        }
+        pos = text.empty() ? std::string_view::npos : 0;
+      } else {
+        pos = text.find(',');
+        elem = trim_(text.substr(0, pos));
+      }
+      if (!func(elem)) {
+        return false;
+      }
+      if (pos == std::string_view::npos) {
+        return true;
+      }
+      text = trim_(text.substr(pos + 1));
+    }
+  }
+
+  static inline int hex_value_(char c) {
+    if (c >= '0' && c <= '9') {
+      return c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+      return c - 'a' + 10;
+    } else if (c >= 'A' && c <= 'F') {
+      return c - 'A' + 10;
+    }
+    return -1;
+  }
+
+  // the code unit of "\uXXXX" at text[pos], or -1 if it is not one
+  static inline int32_t code_unit_(std::string_view text, size_t pos) {
+    if (pos + 6 > text.size() || text[pos] != '\\' || text[pos + 1] != 'u') {
+      return -1;
+    }
+    int32_t unit = 0;
+    for (size_t i = pos + 2; i < pos + 6; i++) {
+      int digit = hex_value_(text[i]);
+      if (digit < 0) {
+        return -1;
+      }
+      unit = unit << 4 | digit;
+    }
+    return unit;
+  }
+
+  static inline void append_utf8_(uint32_t cp, std::string& out) {
+    if (cp < 0x80) {
+      out.push_back(static_cast<char>(cp));
+    } else if (cp < 0x800) {
+      out.push_back(static_cast<char>(0xc0 | cp >> 6));
+      out.push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+    } else if (cp < 0x10000) {
+      out.push_back(static_cast<char>(0xe0 | cp >> 12));
+      out.push_back(static_cast<char>(0x80 | (cp >> 6 & 0x3f)));
+      out.push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+    } else {
+      out.push_back(static_cast<char>(0xf0 | cp >> 18));
+      out.push_back(static_cast<char>(0x80 | (cp >> 12 & 0x3f)));
+      out.push_back(static_cast<char>(0x80 | (cp >> 6 & 0x3f)));
+      out.push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+    }
+  }
+
+  // unescape a quoted element (without its quotes), see for_each_element_
+  static inline bool unescape_(std::string_view text, std::string& out) {
+    out.clear();
+    for (size_t pos = 0; pos < text.size(); pos++) {
+      if (text[pos] != '\\') {
+        out.push_back(text[pos]);
+        continue;
+      }
+      if (++pos == text.size()) {
+        return false;
+      }
+      switch (text[pos]) {
+      case 'b':
+        out.push_back('\b');
+        break;
+      case 'f':
+        out.push_back('\f');
+        break;
+      case 'n':
+        out.push_back('\n');
+        break;
+      case 'r':
+        out.push_back('\r');
+        break;
+      case 't':
+        out.push_back('\t');
+        break;
+      case 'u': {
+        int32_t unit = code_unit_(text, pos - 1);
+        if (unit < 0) {
+          return false;
+        }
+        pos += 4;
+        uint32_t cp = unit;
+        if (unit >= 0xd800 && unit < 0xdc00) {
+          int32_t low = code_unit_(text, pos + 1);
+          if (low < 0xdc00 || low >= 0xe000) {
+            return false;
+          }
+          pos += 6;
+          cp = 0x10000 + ((unit - 0xd800) << 10) + (low - 0xdc00);
+        }
+        append_utf8_(cp, out);
+        break;
+      }
+      default:
+        out.push_back(text[pos]);
+      }
+    }
+    return true;
+  }
+
+  // decode base64 (standard or URL-safe), the padding may be omitted
+  static inline bool decode_base64_(std::string_view text, std::string& out) {
+    out.clear();
+    for (int i = 0; i < 2 && !text.empty() && text.back() == '='; i++) {
+      text.remove_suffix(1);
+    }
+    out.reserve(text.size() / 4 * 3 + 2);
+    uint32_t bits = 0;
+    int num_bits = 0;
+    for (char c : text) {
+      int value;
+      if (c >= 'A' && c <= 'Z') {
+        value = c - 'A';
+      } else if (c >= 'a' && c <= 'z') {
+        value = c - 'a' + 26;
+      } else if (c >= '0' && c <= '9') {
+        value = c - '0' + 52;
+      } else if (c == '+' || c == '-') {
+        value = 62;
+      } else if (c == '/' || c == '_') {
+        value = 63;
+      } else {
+        return false;
+      }
+      bits = bits << 6 | value;
+      num_bits += 6;
+      if (num_bits >= 8) {
+        num_bits -= 8;
+        out.push_back(static_cast<char>(bits >> num_bits & 0xff));
+      }
+    }
+    // a single character left cannot be a byte
+    return num_bits < 6;
+  }
+
+  template <typename T>
+  static inline bool pack_list_(std::string_view text, PropValue& out) {
+    out.packed.clear();
+    out.is_packed = true;
+    return for_each_element_(text, [&out](std::string_view elem) {
+      T val;
+      bool ok;
+      if constexpr (std::is_floating_point_v<T>) {
+        ok = parse_float_(elem, val);
+      } else {
+        ok = parse_int_(elem, val);
+      }
+      if (ok) {
+        out.packed.append(reinterpret_cast<const char*>(&val), sizeof(T));
+      }
+      return ok;
+    });
+  }
+
+  static inline bool pack_string_list_(std::string_view text, PropValue& out) {
+    // elements may be unescaped into a temporary, so they are copied
+    std::string elems;
+    std::vector<uint32_t> ends;
+    bool ok = for_each_element_(text, [&elems, &ends](std::string_view elem) {
+      elems.append(elem.data(), elem.size());
+      ends.push_back(elems.size());
+      return true;
+    });
+    if (!ok) {
+      return false;
+    }
+    // the element number, the end offset of each element, and the elements
+    uint32_t num = ends.size();
+    out.packed.clear();
+    out.is_packed = true;
+    out.packed.append(reinterpret_cast<const char*>(&num), sizeof(uint32_t));
+    out.packed.append(reinterpret_cast<const char*>(ends.data()),
+                      sizeof(uint32_t) * num);
+    out.packed.append(elems);
+    return true;
+  }
 };  // NOLINT(readability/braces)
 
 }  // namespace property
@@ -269,12 +269,12 @@ void PropertyColPaged::insert(uint64_t off, uint64_t k, char* v, uint64_t ver) {
 }
 
 void PropertyColPaged::insert(uint64_t off, uint64_t k,
-                              const StringViewList& v_list, uint64_t ver,
+                              const PropValueList& v_list, uint64_t ver,
                               gart::graph::GraphStore* graph_store,
                               int vlabel) {
   GART_ASSERT(off < max_items_);
 
-  auto graph_schema = graph_store->get_schema();
+  const auto& graph_schema = graph_store->get_schema();
 
   std::vector<char*> prop_buffer(cols_.size(), nullptr);
   std::vector<std::vector<bool>> prop_value_is_null(cols_.size());
@@ -288,36 +288,23 @@ void PropertyColPaged::insert(uint64_t off, uint64_t k,
     size_t col_family_offset =
         graph_store->get_vertex_prop_offset_in_column_family(table_id_,
                                                              prop_idx);
-    auto dtype = graph_schema.dtype_map[std::make_pair(table_id_, prop_idx)];
-    if (dtype != STRING && v_list[prop_idx].size() == 0) {
-      prop_value_is_null[col_family_id].push_back(true);
-      continue;
-    } else if (dtype == STRING &&
-               (std::stoll(std::string(v_list[prop_idx])) & 0xffff) == 0) {
+    auto dtype = graph_schema.dtype_map.at(std::make_pair(table_id_, prop_idx));
+    const PropValue& value = v_list[prop_idx];
+    if (value.is_null) {
       prop_value_is_null[col_family_id].push_back(true);
       continue;
     }
-    prop_value_is_null[col_family_id].push_back(false);
-    if (dtype == INT) {
-      *((int*) (prop_buffer[col_family_id] + col_family_offset)) =
-          std::stoi(std::string(v_list[prop_idx]));
-    } else if (dtype == LONG) {
-      *((int64_t*) (prop_buffer[col_family_id] + col_family_offset)) =
-          std::stoll(std::string(v_list[prop_idx]));
-    } else if (dtype == DOUBLE) {
-      *((double*) (prop_buffer[col_family_id] + col_family_offset)) =
-          std::stod(std::string(v_list[prop_idx]));
-    } else if (dtype == FLOAT) {
-      *((float*) (prop_buffer[col_family_id] + col_family_offset)) =
-          std::stof(std::string(v_list[prop_idx]));
-    } else if (dtype == STRING) {
-      int64_t value = std::stoll(std::string(v_list[prop_idx]));
-      *((int64_t*) (prop_buffer[col_family_id] + col_family_offset)) =
-          std::stoll(std::string(v_list[prop_idx]));
+    char* prop_ptr = prop_buffer[col_family_id] + col_family_offset;
+    if (is_heap_type(dtype)) {
+      uint64_t str_key;
+      graph_store->put_cstring(
+          value.bytes(), str_key,
+          gart::graph::GraphStore::string_column(table_id_, prop_idx));
+      memcpy(prop_ptr, &str_key, sizeof(uint64_t));
     } else {
-      LOG(ERROR) << "Unsupported data type: " << dtype;
-      assert(false);
+      assign_prop(dtype, prop_ptr, value);
     }
+    prop_value_is_null[col_family_id].push_back(false);
   }
 
   for (auto idx = 0; idx < cols_.size(); idx++) {
@@ -358,7 +345,7 @@ void PropertyColPaged::insert(uint64_t off, uint64_t k,
 }
 
 void PropertyColPaged::update(uint64_t off, uint64_t k,
-                              const StringViewList& v_list, uint64_t ver,
+                              const PropValueList& v_list, uint64_t ver,
                               gart::graph::GraphStore* graph_store) {
   std::vector<char*> prop_buffer(cols_.size(), nullptr);
   std::vector<bool> col_family_updated(cols_.size(), false);
@@ -367,7 +354,7 @@ void PropertyColPaged::update(uint64_t off, uint64_t k,
     prop_buffer[col_family_id] = (char*) malloc(cols_[col_family_id].vlen);
   }
 
-  auto graph_schema = graph_store->get_schema();
+  const auto& graph_schema = graph_store->get_schema();
 
   for (auto prop_idx = 0; prop_idx < v_list.size(); prop_idx++) {
     auto col_family_id =
@@ -391,53 +378,54 @@ void PropertyColPaged::update(uint64_t off, uint64_t k,
       old_value_is_null = true;
     }
 
-    if (v_list[prop_idx].size() == 0) {
+    auto dtype = graph_schema.dtype_map.at(std::make_pair(table_id_, prop_idx));
+    char* dst = page->content + BYTE_SIZE(col.page_size * col.column_num) +
+                (off % col.page_size) * vlen + col_family_offset;
+    const PropValue& value = v_list[prop_idx];
+    if (value.is_null) {
       is_null_value = true;
       prop_value_is_null[col_family_id].push_back(true);
       if (!old_value_is_null) {
         col_family_updated[col_family_id] = true;
+        if (is_heap_type(dtype)) {
+          graph_store->retire_cstring(*(int64_t*) dst, ver);
+        }
       }
       continue;
     }
     prop_value_is_null[col_family_id].push_back(false);
 
-    auto dtype = graph_schema.dtype_map[std::make_pair(table_id_, prop_idx)];
-    char* dst = page->content + BYTE_SIZE(col.page_size * col.column_num) +
-                (off % col.page_size) * vlen + col_family_offset;
     if (dtype == INT) {
-      int new_value = std::stoi(std::string(v_list[prop_idx]));
-      *((int*) (prop_buffer[col_family_id] + col_family_offset)) = new_value;
-      if (old_value_is_null || new_value != *((int*) dst)) {
+      *((int*) (prop_buffer[col_family_id] + col_family_offset)) = value.i;
+      if (old_value_is_null || value.i != *((int*) dst)) {
         col_family_updated[col_family_id] = true;
       }
     } else if (dtype == LONG) {
-      int64_t new_value = std::stoll(std::string(v_list[prop_idx]));
-      *((int64_t*) (prop_buffer[col_family_id] + col_family_offset)) =
-          new_value;
-      if (old_value_is_null || new_value != *((int64_t*) dst)) {
+      *((int64_t*) (prop_buffer[col_family_id] + col_family_offset)) = value.l;
+      if (old_value_is_null || value.l != *((int64_t*) dst)) {
         col_family_updated[col_family_id] = true;
       }
     } else if (dtype == DOUBLE) {
-      double new_value = std::stod(std::string(v_list[prop_idx]));
-      *((double*) (prop_buffer[col_family_id] + col_family_offset)) = new_value;
-      if (old_value_is_null || new_value != *((double*) dst)) {
+      *((double*) (prop_buffer[col_family_id] + col_family_offset)) = value.d;
+      if (old_value_is_null || value.d != *((double*) dst)) {
         col_family_updated[col_family_id] = true;
       }
     } else if (dtype == FLOAT) {
-      float new_value = std::stof(std::string(v_list[prop_idx]));
-      *((float*) (prop_buffer[col_family_id] + col_family_offset)) = new_value;
-      if (old_value_is_null || new_value != *((float*) dst)) {
+      *((float*) (prop_buffer[col_family_id] + col_family_offset)) = value.f;
+      if (old_value_is_null || value.f != *((float*) dst)) {
         col_family_updated[col_family_id] = true;
       }
-    } else if (dtype == STRING) {
-      std::string old_value;
-      if (!old_value_is_null) {
-        int64_t old_str_key = *(int64_t*) dst;
-        graph_store->get_string(old_str_key, old_value);
-      }
-      std::string new_value = std::string(v_list[prop_idx]);
-      if (old_value_is_null || old_value != new_value) {
-        uint64_t new_str_key = graph_store->put_cstring(new_value);
+    } else if (is_heap_type(dtype)) {
+      if (old_value_is_null ||
+          graph_store->get_string_view(*(int64_t*) dst) != value.bytes()) {
+        uint64_t new_str_key;
+        graph_store->put_cstring(
+            value.bytes(), new_str_key,
+            gart::graph::GraphStore::string_column(table_id_, prop_idx));
+        if (!old_value_is_null) {
+          // still read by snapshots before ver
+          graph_store->retire_cstring(*(int64_t*) dst, ver);
+        }
         *((int64_t*) (prop_buffer[col_family_id] + col_family_offset)) =
             new_str_key;
         col_family_updated[col_family_id] = true;
@@ -451,6 +439,13 @@ void PropertyColPaged::update(uint64_t off, uint64_t k,
     }
   }
 
+#ifdef USE_MULTI_THREADS
+  // updates of other vertices may run in parallel, and they share the pages
+  // and the null bitmaps
+  auto inner_vertex_label_mutex =
+      graph_store->get_inner_vertex_label_mutex(table_id_);
+  inner_vertex_label_mutex->lock();
+#endif
   for (auto col_family_id = 0; col_family_id < cols_.size(); col_family_id++) {
     if (col_family_updated[col_family_id]) {
       const Property::ColumnFamily& col = cols_[col_family_id];
@@ -474,6 +469,9 @@ void PropertyColPaged::update(uint64_t off, uint64_t k,
     }
     free(prop_buffer[col_family_id]);
   }
+#ifdef USE_MULTI_THREADS
+  inner_vertex_label_mutex->unlock();
+#endif
 }
 
 void PropertyColPaged::update(uint64_t off, const vector<int>& cids, char* v,
@@ -44,7 +44,7 @@ class PropertyColPaged : public Property {
   // for insert
   void insert(uint64_t off, uint64_t k, char* v, uint64_t ver) override;
 
-  void insert(uint64_t off, uint64_t k, const StringViewList& v_list,
+  void insert(uint64_t off, uint64_t k, const PropValueList& v_list,
               uint64_t ver, gart::graph::GraphStore* graph_store,
               int vlabel) override;
 
@@ -67,7 +67,7 @@ class PropertyColPaged : public Property {
     return fixCols_[col_id];
   }
 
-  void update(uint64_t off, uint64_t k, const StringViewList& v_list,
+  void update(uint64_t off, uint64_t k, const PropValueList& v_list,
               uint64_t ver, gart::graph::GraphStore* graph_store) override;
 
   void update(uint64_t off, const std::vector<int>& cids, char* v, uint64_t seq,
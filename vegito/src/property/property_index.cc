@@ -0,0 +1,346 @@
+/** Copyright 2020-2023 Alibaba Group Holding Limited.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "property/property_index.h"
+
+#include <algorithm>
+
+#include "glog/logging.h"
+
+namespace gart {
+namespace property {
+
+PropertyIndex::PropertyIndex(vineyard::Client* v6d_client,
+                             PropertyIndexType type, int dtype, int vlabel)
+    : array_allocator_(v6d_client),
+      type_(type),
+      dtype_(dtype),
+      vlabel_(vlabel),
+      rand_(vlabel) {
+  array_allocator_.set_accounting(MemoryComponent::INDEXES, vlabel);
+}
+
+PropertyIndex::~PropertyIndex() {
+  for (auto oid : chunk_oids_) {
+    array_allocator_.deallocate_v6d(oid);
+  }
+  if (buckets_ != nullptr) {
+    array_allocator_.deallocate_v6d(bucket_oid_);
+  }
+}
+
+bool PropertyIndex::supports(PropertyIndexType type, int dtype) {
+  switch (dtype) {
+  case CHAR:
+  case SHORT:
+  case INT:
+  case LONG:
+  case FLOAT:
+  case DOUBLE:
+  case DATE:
+  case DATETIME:
+  case TIME:
+  case TIMESTAMP:
+    return type == HASH_INDEX || type == ORDERED_INDEX;
+  case STRING:
+    return type == HASH_INDEX;
+  default:
+    return false;
+  }
+}
+
+void PropertyIndex::init(uint64_t chunk_size, int bucket_bits) {
+  int chunk_bits = MIN_CHUNK_BITS;
+  while ((1ul << chunk_bits) < chunk_size) {
+    chunk_bits++;
+  }
+  chunk_size_ = 1ul << chunk_bits;
+  chunks_.init(chunk_bits, PropertyIndexHeader::MAX_CHUNK_NUM);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!add_chunk_()) {
+    LOG(FATAL) << "Failed to allocate the property index of vlabel " << vlabel_;
+  }
+  header_ = chunks_.convert<PropertyIndexHeader>(0);
+  memset(header_, 0, sizeof(PropertyIndexHeader));
+  header_->type = type_;
+  header_->chunk_bits = chunk_bits;
+  header_->chunk_oids[0] = chunk_oids_[0];
+  alloc_offset_ = sizeof(PropertyIndexHeader);
+
+  if (type_ == HASH_INDEX) {
+    buckets_ =
+        array_allocator_.allocate_v6d_or_die<uint64_t>(1ul << bucket_bits,
+                                                       bucket_oid_);
+    memset(buckets_, 0, sizeof(uint64_t) << bucket_bits);
+    bucket_mask_ = (1ul << bucket_bits) - 1;
+    header_->bucket_bits = bucket_bits;
+    header_->bucket_oid = bucket_oid_;
+  } else {
+    uint64_t head = allocate_(PropertyIndexNode::MAX_LEVEL);
+    PropertyIndexNode* node = node_(head);
+    memset(node, 0, PropertyIndexNode::size_of(PropertyIndexNode::MAX_LEVEL));
+    node->level = PropertyIndexNode::MAX_LEVEL;
+    header_->head = head;
+  }
+}
+
+bool PropertyIndex::key_of_(const PropValue& value, uint64_t& key) const {
+  switch (dtype_) {
+  case CHAR:
+    key = property_index_key(static_cast<int64_t>(value.c));
+    break;
+  case SHORT:
+    key = property_index_key(static_cast<int64_t>(value.s));
+    break;
+  case INT:
+  case DATE:
+    key = property_index_key(static_cast<int64_t>(value.i));
+    break;
+  case LONG:
+  case DATETIME:
+  case TIME:
+    key = property_index_key(value.l);
+    break;
+  case FLOAT:
+    key = property_index_key(static_cast<double>(value.f));
+    break;
+  case DOUBLE:
+    key = property_index_key(value.d);
+    break;
+  case TIMESTAMP: {
+    int64_t micros;
+    if (!parse_timestamp_micros(value.str, micros)) {
+      return false;
+    }
+    key = property_index_key(micros);
+    break;
+  }
+  default:
+    key = property_index_key(value.str);
+  }
+  return true;
+}
+
+int PropertyIndex::random_level_() {
+  // a quarter of the nodes of each level go up
+  int level = 1;
+  while (level < PropertyIndexNode::MAX_LEVEL && (rand_() & 3) == 0) {
+    level++;
+  }
+  return level;
+}
+
+void PropertyIndex::put(uint64_t vertex, const PropValue& value,
+                        int64_t epoch) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  uint64_t live = vertex < live_.size() ? live_[vertex] : 0;
+  uint64_t key;
+  if (value.is_null || !key_of_(value, key)) {
+    if (!value.is_null) {
+      LOG(ERROR) << "PropertyIndex: unknown timestamp " << value.str
+                 << ", vertex " << vertex << " of vlabel " << vlabel_
+                 << " is not indexed";
+    }
+    if (live != 0) {
+      end_(vertex, epoch);
+    }
+    return;
+  }
+
+  if (live != 0) {
+    if (node_(live)->key == key) {
+      return;  // unchanged
+    }
+    end_(vertex, epoch);
+  }
+
+  uint64_t level = type_ == ORDERED_INDEX ? random_level_() : 1;
+  uint64_t offset = allocate_(level);
+  if (offset == 0) {
+    LOG(ERROR) << "PropertyIndex: out of memory, vertex " << vertex
+               << " of vlabel " << vlabel_ << " is not indexed";
+    return;
+  }
+  PropertyIndexNode* node = node_(offset);
+  node->key = key;
+  node->vertex = vertex;
+  node->begin_epoch = epoch;
+  node->set_end_epoch(PropertyIndexNode::MAX_EPOCH);
+  node->level = level;
+  link_(offset);
+
+  if (vertex >= live_.size()) {
+    live_.resize(std::max<size_t>(vertex + 1, live_.size() * 2), 0);
+  }
+  live_[vertex] = offset;
+}
+
+void PropertyIndex::remove(uint64_t vertex, int64_t epoch) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (vertex < live_.size() && live_[vertex] != 0) {
+    end_(vertex, epoch);
+  }
+}
+
+void PropertyIndex::end_(uint64_t vertex, int64_t epoch) {
+  uint64_t offset = live_[vertex];
+  // still read by snapshots before epoch
+  node_(offset)->set_end_epoch(epoch);
+  ended_.push_back(RetiredNode{offset, epoch});
+  live_[vertex] = 0;
+  reclaimable_nodes_++;
+}
+
+void PropertyIndex::recycle(int64_t write_epoch, int64_t safe_epoch) {
+  auto reclaimable = [&](int64_t epoch) {
+    return epoch <= safe_epoch && epoch + LAG_EPOCH_NUMBER < write_epoch;
+  };
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  // nodes unlinked before the oldest reader cannot be stood on any more
+  size_t kept = 0;
+  for (const auto& retired : unlinked_) {
+    if (reclaimable(retired.epoch)) {
+      free_lists_[node_(retired.offset)->level].push_back(retired.offset);
+      reclaimable_nodes_--;
+    } else {
+      unlinked_[kept++] = retired;
+    }
+  }
+  unlinked_.resize(kept);
+
+  // nodes ended before the oldest reader are invisible to all readers, but
+  // readers may be traversing them, so they are reused later
+  kept = 0;
+  for (const auto& retired : ended_) {
+    if (reclaimable(retired.epoch)) {
+      unlink_(retired.offset);
+      unlinked_.push_back(RetiredNode{retired.offset, write_epoch});
+    } else {
+      ended_[kept++] = retired;
+    }
+  }
+  ended_.resize(kept);
+}
+
+uint64_t PropertyIndex::allocate_(uint64_t level) {
+  auto& free_list = free_lists_[level];
+  if (!free_list.empty()) {
+    uint64_t offset = free_list.back();
+    free_list.pop_back();
+    return offset;
+  }
+
+  uint64_t size = PropertyIndexNode::size_of(level);
+  if (chunks_.get_arena_idx(alloc_offset_) !=
+          chunks_.get_arena_idx(alloc_offset_ + size - 1) ||
+      alloc_offset_ == chunk_oids_.size() * chunk_size_) {
+    if (!add_chunk_()) {
+      return 0;
+    }
+  }
+  uint64_t offset = alloc_offset_;
+  alloc_offset_ += size;
+  return offset;
+}
+
+bool PropertyIndex::add_chunk_() {
+  size_t idx = chunk_oids_.size();
+  if (idx == PropertyIndexHeader::MAX_CHUNK_NUM) {
+    LOG(ERROR) << "PropertyIndex: out of memory ("
+               << PropertyIndexHeader::MAX_CHUNK_NUM << " chunks of "
+               << chunk_size_ << " bytes)";
+    return false;
+  }
+  vineyard::ObjectID oid;
+  char* chunk = array_allocator_.allocate_v6d(chunk_size_, oid);
+  if (chunk == nullptr) {
+    return false;
+  }
+  chunks_.set_arena(idx, chunk);
+  chunk_oids_.push_back(oid);
+  if (header_ != nullptr) {
+    // published before any node of the chunk is linked
+    __atomic_store_n(&header_->chunk_oids[idx], oid, __ATOMIC_RELEASE);
+  }
+  alloc_offset_ = idx * chunk_size_;
+  return true;
+}
+
+void PropertyIndex::link_(uint64_t offset) {
+  PropertyIndexNode* node = node_(offset);
+  if (type_ == HASH_INDEX) {
+    uint64_t* bucket = &buckets_[node->key & bucket_mask_];
+    node->set_next(0, *bucket);
+    __atomic_store_n(bucket, offset, __ATOMIC_RELEASE);
+    return;
+  }
+
+  uint64_t preds[PropertyIndexNode::MAX_LEVEL];
+  find_preds_(node->key, node->vertex, 0, preds);
+  for (uint64_t level = 0; level < node->level; level++) {
+    node->set_next(level, node_(preds[level])->get_next(level));
+  }
+  // bottom-up, so a node reachable at a level is reachable below it
+  for (uint64_t level = 0; level < node->level; level++) {
+    node_(preds[level])->set_next(level, offset);
+  }
+}
+
+void PropertyIndex::unlink_(uint64_t offset) {
+  PropertyIndexNode* node = node_(offset);
+  if (type_ == HASH_INDEX) {
+    uint64_t* prev = &buckets_[node->key & bucket_mask_];
+    while (*prev != 0 && *prev != offset) {
+      prev = &node_(*prev)->next[0];
+    }
+    if (*prev == offset) {
+      __atomic_store_n(prev, node->get_next(0), __ATOMIC_RELEASE);
+    }
+    return;
+  }
+
+  uint64_t preds[PropertyIndexNode::MAX_LEVEL];
+  find_preds_(node->key, node->vertex, offset, preds);
+  // top-down, the node keeps its next offsets for readers standing on it
+  for (int level = node->level - 1; level >= 0; level--) {
+    PropertyIndexNode* pred = node_(preds[level]);
+    if (pred->get_next(level) == offset) {
+      pred->set_next(level, node->get_next(level));
+    }
+  }
+}
+
+void PropertyIndex::find_preds_(uint64_t key, uint64_t vertex, uint64_t offset,
+                                uint64_t* preds) const {
+  uint64_t pred = header_->head;
+  for (int level = PropertyIndexNode::MAX_LEVEL - 1; level >= 0; level--) {
+    uint64_t next = node_(pred)->get_next(level);
+    // nodes with the same key and vertex are kept before the node to find,
+    // so stop at it or at the first node after (key, vertex)
+    while (next != 0 && next != offset &&
+           (node_(next)->less(key, vertex) ||
+            (offset != 0 && !node_(offset)->less(node_(next)->key,
+                                                 node_(next)->vertex)))) {
+      pred = next;
+      next = node_(pred)->get_next(level);
+    }
+    preds[level] = pred;
+  }
+}
+
+}  // namespace property
+}  // namespace gart
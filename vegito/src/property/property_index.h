@@ -0,0 +1,144 @@
+/** Copyright 2020-2023 Alibaba Group Holding Limited.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef VEGITO_SRC_PROPERTY_PROPERTY_INDEX_H_
+#define VEGITO_SRC_PROPERTY_PROPERTY_INDEX_H_
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <random>
+#include <vector>
+
+#include "property/property.h"
+#include "seggraph/block_arenas.hpp"
+#include "util/allocator.hpp"
+#include "util/property_index.h"
+
+namespace gart {
+namespace property {
+
+/**
+ * A secondary index on a vertex property (column), maintained by the writer
+ * when vertices are inserted, updated and deleted. See util/property_index.h
+ * for the layout shared with readers.
+ *
+ * Hash indexes take CHAR, SHORT, INT, LONG, FLOAT, DOUBLE, DATE, DATETIME,
+ * TIME, STRING and TIMESTAMP columns, ordered indexes take the same columns
+ * except STRING, whose keys are hashes. Null values, and timestamps that
+ * cannot be parsed, are not indexed.
+ *
+ * All the methods are thread-safe.
+ */
+class PropertyIndex {
+ public:
+  PropertyIndex(vineyard::Client* v6d_client, PropertyIndexType type,
+                int dtype, int vlabel);
+
+  ~PropertyIndex();
+
+  static bool supports(PropertyIndexType type, int dtype);
+
+  // chunk_size is rounded up to a power of 2, a hash index has 2^bucket_bits
+  // buckets
+  void init(uint64_t chunk_size, int bucket_bits);
+
+  // the value of the vertex is set at epoch, a null value unindexes it
+  void put(uint64_t vertex, const PropValue& value, int64_t epoch);
+
+  // the vertex is deleted at epoch
+  void remove(uint64_t vertex, int64_t epoch);
+
+  // unlink nodes ended before safe_epoch, and reuse nodes unlinked before
+  // it, with the same lag as the blocks of SegGraph
+  void recycle(int64_t write_epoch, int64_t safe_epoch);
+
+  PropertyIndexType get_type() const { return type_; }
+
+  // the first chunk, with the header of the index
+  vineyard::ObjectID get_oid() const { return chunk_oids_[0]; }
+
+  // nodes ended or unlinked, but not reused yet
+  size_t get_reclaimable_nodes() const { return reclaimable_nodes_; }
+
+ private:
+  static constexpr int64_t LAG_EPOCH_NUMBER = 2;
+  static constexpr int MIN_CHUNK_BITS = 20;
+
+  struct RetiredNode {
+    uint64_t offset;
+    int64_t epoch;
+  };
+
+  PropertyIndexNode* node_(uint64_t offset) const {
+    return chunks_.convert<PropertyIndexNode>(offset);
+  }
+
+  // false if the value has no key, i.e., a TIMESTAMP of an unknown form
+  bool key_of_(const PropValue& value, uint64_t& key) const;
+
+  int random_level_();
+
+  // return 0 if the memory is exhausted, must hold mutex_
+  uint64_t allocate_(uint64_t level);
+
+  // must hold mutex_
+  bool add_chunk_();
+
+  // must hold mutex_
+  void end_(uint64_t vertex, int64_t epoch);
+
+  // must hold mutex_
+  void link_(uint64_t offset);
+
+  // must hold mutex_
+  void unlink_(uint64_t offset);
+
+  // the last node of each level before offset (or before (key, vertex) if
+  // offset is 0) in an ordered index
+  void find_preds_(uint64_t key, uint64_t vertex, uint64_t offset,
+                   uint64_t* preds) const;
+
+  SparseArrayAllocator array_allocator_;
+  const PropertyIndexType type_;
+  const int dtype_;
+  const int vlabel_;
+
+  uint64_t chunk_size_ = 0;
+  seggraph::BlockArenas chunks_;
+  std::vector<vineyard::ObjectID> chunk_oids_;
+  uint64_t alloc_offset_ = 0;  // the next free byte in the last chunk
+  PropertyIndexHeader* header_ = nullptr;
+
+  vineyard::ObjectID bucket_oid_ = 0;
+  uint64_t* buckets_ = nullptr;
+  uint64_t bucket_mask_ = 0;
+
+  // vertex offset -> current node, 0 if not indexed
+  std::vector<uint64_t> live_;
+  std::vector<RetiredNode> ended_;     // still linked
+  std::vector<RetiredNode> unlinked_;  // may be read by readers
+  // level -> nodes to reuse
+  std::vector<uint64_t> free_lists_[PropertyIndexNode::MAX_LEVEL + 1];
+  std::atomic<size_t> reclaimable_nodes_{0};
+
+  std::minstd_rand rand_;
+  mutable std::mutex mutex_;
+};
+
+}  // namespace property
+}  // namespace gart
+
+#endif  // VEGITO_SRC_PROPERTY_PROPERTY_INDEX_H_
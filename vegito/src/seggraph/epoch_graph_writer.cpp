@@ -145,11 +145,40 @@ void EpochGraphWriter::update_edge_label_block(segid_t segid, label_t label,
     new_edge_label_block->append(label_entry);
 
     graph.edge_label_ptrs[segid] = new_pointer;
+    if (edge_label_block) {
+      graph.retire_block(pointer, edge_label_block->get_order(),
+                         write_epoch_id);
+    }
   }
 }
 
 void EpochGraphWriter::put_edge(vertex_t src, label_t label, dir_t dir,
                                 vertex_t dst, std::string_view edge_data) {
+  EdgeToPut edge{src, dst, edge_data};
+  put_vertex_edges(src, label, dir, &edge, 1);
+}
+
+void EpochGraphWriter::put_edges(label_t label, dir_t dir,
+                                 std::vector<EdgeToPut>& edges) {
+  // sorting by source also groups the edges by segment
+  std::stable_sort(edges.begin(), edges.end(),
+                   [](const EdgeToPut& a, const EdgeToPut& b) {
+                     return a.src < b.src;
+                   });
+  size_t begin = 0;
+  while (begin < edges.size()) {
+    size_t end = begin + 1;
+    while (end < edges.size() && edges[end].src == edges[begin].src) {
+      end++;
+    }
+    put_vertex_edges(edges[begin].src, label, dir, edges.data() + begin,
+                     end - begin);
+    begin = end;
+  }
+}
+
+void EpochGraphWriter::put_vertex_edges(vertex_t src, label_t label, dir_t dir,
+                                        const EdgeToPut* edges, size_t num) {
   check_vertex_id(src);
   // we don't need to check dst id
   // check_vertex_id(dst);
@@ -157,8 +186,9 @@ void EpochGraphWriter::put_edge(vertex_t src, label_t label, dir_t dir,
   segid_t segid = graph.get_vertex_seg_id(src);
   uint32_t segidx = graph.get_vertex_seg_idx(src);
 
-  auto edge_prop_value = edge_data.data();
-  size_t edge_prop_size = edge_data.size();
+  // edges of a label have properties of the same size
+  size_t edge_prop_size = edges[0].edge_data.size();
+  size_t num_put = 0;
 
   VegitoSegmentHeader *segment, *test_segment;
 
@@ -167,7 +197,7 @@ void EpochGraphWriter::put_edge(vertex_t src, label_t label, dir_t dir,
 start:
   // 同样要获取segment的lock，因为此时依然有读事务在做AP任务
   graph.seg_mutexes[segid]->lock_shared();
-  // 就算是batch_add的话也可以有cache？每次都要locate的overhead太大了
+  // located once for all the edges of the vertex, unless the segment is full
   segment = locate_segment(segid, label, dir);
   test_segment = segment;
 
@@ -187,8 +217,11 @@ start:
         order++;
 
       auto new_seg_pointer = graph.block_manager.alloc(order);
-      if (new_seg_pointer == BlockManager::NULLPOINTER)
+      if (new_seg_pointer == BlockManager::NULLPOINTER) {
+        graph.seg_mutexes[segid]->unlock();
+        graph.vertex_futexes[src].unlock();
         return;
+      }
       auto new_segment =
           graph.block_manager.convert<VegitoSegmentHeader>(new_seg_pointer);
       new_segment->fill(new_seg_pointer, order, segid);
@@ -210,9 +243,6 @@ start:
   VegitoEdgeBlockHeader* edge_block =
       graph.block_manager.convert<VegitoEdgeBlockHeader>(edge_block_pointer);
 
-  VegitoEdgeEntry entry;
-  entry.set_dst(dst);
-
   if (!edge_block || !edge_block->has_space()) {
     size_t size;
     order_t order;
@@ -224,6 +254,16 @@ start:
       // default init value
       order = DEFAULT_INIT_ORDER;
     }
+    // room for all the remaining edges at once, a block of order
+    // COPY_THRESHOLD_ORDER or more is chained to the old one instead of
+    // holding a copy of its entries
+    size_t num_copied = edge_block ? edge_block->get_num_entries() : 0;
+    size_t num_remaining = num - num_put;
+    while ((1ul << order) <
+           (order >= SegGraph::COPY_THRESHOLD_ORDER ? 0 : num_copied) +
+               num_remaining) {
+      order++;
+    }
 
     auto new_edge_block_pointer = segment->alloc(order, edge_prop_size);
 
@@ -239,8 +279,11 @@ start:
         // allocate a new segment
         order_t new_order = segment->get_order() + 1;
         auto new_seg_pointer = graph.block_manager.alloc(new_order);
-        if (new_seg_pointer == BlockManager::NULLPOINTER)
+        if (new_seg_pointer == BlockManager::NULLPOINTER) {
+          graph.seg_mutexes[segid]->unlock();
+          graph.vertex_futexes[src].unlock();
           return;
+        }
         auto new_segment =
             graph.block_manager.convert<VegitoSegmentHeader>(new_seg_pointer);
         new_segment->fill(new_seg_pointer, new_order, segid);
@@ -249,9 +292,8 @@ start:
         merge_segment(segment, new_segment, segidx, &edge_block_pointer,
                       &edge_block, edge_prop_size);
 
-        graph.segments_to_recycle.local().push_back(
-            std::make_tuple(graph.block_manager.revert((uintptr_t) segment),
-                            segment->get_order(), write_epoch_id));
+        graph.retire_block(segment->get_head(), segment->get_order(),
+                           write_epoch_id);
         update_edge_label_block(segid, label, dir, new_seg_pointer);
         graph.seg_mutexes[segid]->unlock();
         graph.seg_mutexes[segid]->lock_shared();
@@ -267,10 +309,14 @@ start:
           new_edge_block_pointer);
       if (order >= SegGraph::COPY_THRESHOLD_ORDER) {
         size_t prev_num_entries = 0;
-        if (edge_block)
+        size_t prev_num_tombstones = 0;
+        if (edge_block) {
           prev_num_entries = edge_block->get_prev_num_entries() +
                              edge_block->get_num_entries();
-        new_edge_block->fill(order, edge_block_pointer, prev_num_entries);
+          prev_num_tombstones = edge_block->get_num_tombstones();
+        }
+        new_edge_block->fill(order, edge_block_pointer, prev_num_entries,
+                             prev_num_tombstones);
       } else {
         new_edge_block->fill(order, 0, 0);
 
@@ -312,14 +358,18 @@ start:
     size_t size = sizeof(EpochBlockHeader) + sizeof(VegitoEpochEntry);
     order_t order = size_to_order(size);
     auto new_epoch_table_pointer = graph.block_manager.alloc(order);
-    if (new_epoch_table_pointer == BlockManager::NULLPOINTER)
+    if (new_epoch_table_pointer == BlockManager::NULLPOINTER) {
+      graph.seg_mutexes[segid]->unlock_shared();
+      graph.vertex_futexes[src].unlock();
       return;
+    }
     auto new_epoch_table =
         graph.block_manager.convert<EpochBlockHeader>(new_epoch_table_pointer);
 
     // append the initial epoch entry
     VegitoEpochEntry epoch_entry;
     epoch_entry.set_offset(0);
+    epoch_entry.set_degree(0);
     epoch_entry.set_epoch(write_epoch_id);
 
     new_epoch_table->fill(order, 0, write_epoch_id);
@@ -339,8 +389,11 @@ start:
       // create new epoch table
       order_t order = epoch_table->get_order() + 1;
       auto new_epoch_table_pointer = graph.block_manager.alloc(order);
-      if (new_epoch_table_pointer == BlockManager::NULLPOINTER)
+      if (new_epoch_table_pointer == BlockManager::NULLPOINTER) {
+        graph.seg_mutexes[segid]->unlock_shared();
+        graph.vertex_futexes[src].unlock();
         return;
+      }
       auto new_epoch_table = graph.block_manager.convert<EpochBlockHeader>(
           new_epoch_table_pointer);
       new_epoch_table->fill(order, epoch_table_pointer, latest_epoch);
@@ -356,6 +409,8 @@ start:
 
       // update epoch table
       segment->set_epoch_table(segidx, new_epoch_table_pointer);
+      graph.retire_block(epoch_table_pointer, epoch_table->get_order(),
+                         write_epoch_id);
 
       epoch_table_pointer = new_epoch_table_pointer;
       epoch_table = new_epoch_table;
@@ -364,6 +419,7 @@ start:
     VegitoEpochEntry epoch_entry;
     epoch_entry.set_offset(edge_block->get_prev_num_entries() +
                            edge_block->get_num_entries());
+    epoch_entry.set_degree(edge_block->get_degree());
     epoch_entry.set_epoch(write_epoch_id);
     epoch_table->set_latest_epoch(write_epoch_id);
     epoch_table->append(epoch_entry);
@@ -373,15 +429,23 @@ start:
       segment->get_allocated_edge_num((uintptr_t) edge_block) +
       edge_block->get_num_entries();
 
-  // insert edge
-  auto edge = edge_block->append(entry);
+  // insert edges, and their properties, as many as the block holds
+  for (; num_put < num && edge_block->has_space(); num_put++) {
+    VegitoEdgeEntry entry;
+    entry.set_dst(edges[num_put].dst);
+    edge_block->append(entry);
 
-  // insert edge property
-  if (edge_prop_size > 0) {
-    segment->append_property(allocated_edge_num, edge_prop_value,
-                             edge_prop_size);
+    if (edge_prop_size > 0) {
+      segment->append_property(allocated_edge_num++,
+                               edges[num_put].edge_data.data(),
+                               edge_prop_size);
+    }
   }
   graph.seg_mutexes[segid]->unlock_shared();
+  if (num_put < num) {
+    // the segment could not hold a large enough block
+    goto start;
+  }
   graph.vertex_futexes[src].unlock();
 }
 
@@ -469,8 +533,207 @@ void EpochGraphWriter::merge_segments(label_t label, dir_t dir) {
 
       merge_segment(segment, new_segment, -1, nullptr, nullptr, edge_prop_size);
 
-      // graph.block_manager.free(segment, segment->get_order());
+      graph.retire_block(segment->get_head(), segment->get_order(),
+                         write_epoch_id);
       update_edge_label_block(segid, label, dir, new_seg_pointer);
     }
   }
 }
+
+bool EpochGraphWriter::compact_segment(segid_t segid, label_t label, dir_t dir,
+                                       timestamp_t horizon,
+                                       double tombstone_ratio,
+                                       size_t edge_prop_size) {
+  graph.seg_mutexes[segid]->lock();
+  auto segment = locate_segment(segid, label, dir);
+  if (!segment) {
+    graph.seg_mutexes[segid]->unlock();
+    return false;
+  }
+
+  // each delete marker hides one edge as well
+  size_t num_entries = 0, num_tombstones = 0;
+  for (int i = 0; i < VERTEX_PER_SEG; i++) {
+    auto edge_block = graph.block_manager.convert<VegitoEdgeBlockHeader>(
+        segment->get_region_ptr(i));
+    if (edge_block) {
+      num_entries +=
+          edge_block->get_prev_num_entries() + edge_block->get_num_entries();
+      num_tombstones += edge_block->get_num_tombstones();
+    }
+  }
+  if (num_entries == 0 ||
+      2 * num_tombstones < tombstone_ratio * num_entries) {
+    graph.seg_mutexes[segid]->unlock();
+    return false;
+  }
+
+  auto new_seg_pointer = graph.block_manager.alloc(segment->get_order());
+  if (new_seg_pointer == BlockManager::NULLPOINTER) {
+    graph.seg_mutexes[segid]->unlock();
+    return false;
+  }
+  auto new_segment =
+      graph.block_manager.convert<VegitoSegmentHeader>(new_seg_pointer);
+  new_segment->fill(new_seg_pointer, segment->get_order(), segid);
+
+  std::vector<std::pair<uintptr_t, order_t>> new_tables, old_tables;
+  for (int i = 0; i < VERTEX_PER_SEG; i++) {
+    if (!compact_edges(segment, new_segment, i, horizon, edge_prop_size,
+                       new_tables, old_tables)) {
+      // roll back, the old segment is untouched
+      for (auto& table : new_tables) {
+        graph.block_manager.free(table.first, table.second);
+      }
+      graph.block_manager.free(new_seg_pointer, new_segment->get_order());
+      graph.seg_mutexes[segid]->unlock();
+      return false;
+    }
+  }
+
+  // readers may still hold the old segment and epoch tables
+  graph.retire_block(segment->get_head(), segment->get_order(),
+                     write_epoch_id);
+  for (auto& table : old_tables) {
+    graph.retire_block(table.first, table.second, write_epoch_id);
+  }
+  update_edge_label_block(segid, label, dir, new_seg_pointer);
+  graph.seg_mutexes[segid]->unlock();
+  return true;
+}
+
+bool EpochGraphWriter::compact_edges(
+    VegitoSegmentHeader* old_seg, VegitoSegmentHeader* new_seg,
+    vertex_t segidx, timestamp_t horizon, size_t edge_prop_size,
+    std::vector<std::pair<uintptr_t, order_t>>& new_tables,
+    std::vector<std::pair<uintptr_t, order_t>>& old_tables) {
+  uintptr_t epoch_table_pointer = old_seg->get_epoch_table(segidx);
+  auto epoch_table =
+      graph.block_manager.convert<EpochBlockHeader>(epoch_table_pointer);
+  auto edge_block = graph.block_manager.convert<VegitoEdgeBlockHeader>(
+      old_seg->get_region_ptr(segidx));
+  new_seg->set_epoch_table(segidx, epoch_table_pointer);
+  if (!edge_block) {
+    return true;
+  }
+
+  // 1. flatten the edge blocks, from the oldest entry to the latest one
+  std::vector<VegitoEdgeBlockHeader*> blocks;
+  while (edge_block) {
+    blocks.push_back(edge_block);
+    edge_block = graph.block_manager.convert<VegitoEdgeBlockHeader>(
+        edge_block->get_prev_pointer());
+  }
+  std::vector<VegitoEdgeEntry> entries;
+  std::vector<const void*> props;
+  for (int j = blocks.size() - 1; j >= 0; j--) {
+    auto block = blocks[j];
+    auto block_entries = block->get_entries();
+    auto prop_offset = old_seg->get_allocated_edge_num((uintptr_t) block);
+    for (size_t k = 0; k < block->get_num_entries(); k++) {
+      block_entries--;
+      entries.push_back(*block_entries);
+      props.push_back(edge_prop_size > 0 ? old_seg->get_property(
+                                               prop_offset + k, edge_prop_size)
+                                         : nullptr);
+    }
+  }
+  size_t num_entries = entries.size();
+
+  // 2. drop delete markers (and their victims) not newer than horizon
+  std::vector<VegitoEpochEntry> epochs;  // from the oldest to the latest
+  if (epoch_table) {
+    auto epoch_entries = epoch_table->get_entries();
+    for (size_t k = 0; k < epoch_table->get_num_entries(); k++) {
+      epoch_entries--;
+      epochs.push_back(*epoch_entries);
+    }
+  }
+  const vertex_t delete_mask = ((vertex_t) 1) << (sizeof(vertex_t) * 8 - 1);
+  std::vector<bool> dropped(num_entries, false);
+  size_t epoch_idx = 0;
+  for (size_t k = 0; k < num_entries; k++) {
+    while (epoch_idx + 1 < epochs.size() &&
+           epochs[epoch_idx + 1].get_offset() <= k) {
+      epoch_idx++;
+    }
+    vertex_t dst = entries[k].get_dst();
+    if (!(dst & delete_mask)) {
+      continue;
+    }
+    size_t victim = dst & ~delete_mask;
+    if (victim >= k) {
+      continue;
+    }
+    if (dropped[victim]) {
+      // duplicated delete marker
+      dropped[k] = true;
+    } else if (epoch_idx < epochs.size() &&
+               epochs[epoch_idx].get_epoch() <= horizon) {
+      dropped[victim] = true;
+      dropped[k] = true;
+    }
+  }
+
+  // prefix count of dropped entries, to remap offsets
+  std::vector<size_t> dropped_before(num_entries + 1, 0);
+  for (size_t k = 0; k < num_entries; k++) {
+    dropped_before[k + 1] = dropped_before[k] + (dropped[k] ? 1 : 0);
+  }
+  size_t num_kept = num_entries - dropped_before[num_entries];
+
+  // 3. write the kept entries into a single edge block
+  auto order = size_to_order(num_kept);
+  auto new_edge_block_pointer = new_seg->alloc(order, edge_prop_size);
+  if (!new_edge_block_pointer) {
+    return false;
+  }
+  auto new_edge_block = graph.block_manager.convert<VegitoEdgeBlockHeader>(
+      new_edge_block_pointer);
+  new_edge_block->fill(order, 0, 0);
+  auto new_prop_offset =
+      new_seg->get_allocated_edge_num((uintptr_t) new_edge_block);
+  for (size_t k = 0; k < num_entries; k++) {
+    if (dropped[k]) {
+      continue;
+    }
+    VegitoEdgeEntry entry = entries[k];
+    vertex_t dst = entry.get_dst();
+    if (dst & delete_mask) {
+      size_t victim = dst & ~delete_mask;
+      if (victim < num_entries) {
+        entry.set_dst((victim - dropped_before[victim]) | delete_mask);
+      }
+    }
+    new_edge_block->append(entry);
+    if (edge_prop_size > 0) {
+      new_seg->append_property(
+          new_prop_offset + new_edge_block->get_num_entries() - 1, props[k],
+          edge_prop_size);
+    }
+  }
+  new_seg->set_region_ptr(segidx, new_edge_block_pointer);
+
+  // 4. remap the epoch table if some entries are dropped, degrees are kept
+  // since entries are dropped in pairs of delete markers and their victims
+  if (num_kept == num_entries || !epoch_table) {
+    return true;
+  }
+  order_t table_order = epoch_table->get_order();
+  auto new_epoch_table_pointer = graph.block_manager.alloc(table_order);
+  if (new_epoch_table_pointer == BlockManager::NULLPOINTER) {
+    return false;
+  }
+  new_tables.emplace_back(new_epoch_table_pointer, table_order);
+  auto new_epoch_table =
+      graph.block_manager.convert<EpochBlockHeader>(new_epoch_table_pointer);
+  new_epoch_table->fill(table_order, 0, epoch_table->get_latest_epoch());
+  for (auto epoch_entry : epochs) {
+    size_t offset = std::min(epoch_entry.get_offset(), num_entries);
+    epoch_entry.set_offset(offset - dropped_before[offset]);
+    new_epoch_table->append(epoch_entry);
+  }
+  new_seg->set_epoch_table(segidx, new_epoch_table_pointer);
+  old_tables.emplace_back(epoch_table_pointer, table_order);
+  return true;
+}
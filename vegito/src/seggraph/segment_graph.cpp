@@ -36,25 +36,62 @@ EpochGraphReader SegGraph::create_graph_reader(timestamp_t read_epoch) {
 }
 
 EpochGraphWriter SegGraph::create_graph_writer(timestamp_t write_epoch) {
-#ifndef USE_MULTI_THREADS
-  if (rand() % RECYCLE_FREQ == 0) {  // NOLINT(runtime/threadsafe_fn)
-    recycle_segments(write_epoch);
-  }
-#endif
   return EpochGraphWriter(*this, write_epoch);
 }
 
-void SegGraph::recycle_segments(timestamp_t epoch_id) {
-  std::vector<std::tuple<uintptr_t, order_t, timestamp_t>>
-      new_segments_to_recycle;
-  for (std::tuple<uintptr_t, order_t, timestamp_t> segment :
-       segments_to_recycle.local()) {
-    timestamp_t epoch = std::get<2>(segment);
-    if (epoch + LAG_EPOCH_NUMBER < epoch_id) {
-      block_manager.free(std::get<0>(segment), std::get<1>(segment));
-    } else {
-      new_segments_to_recycle.push_back(segment);
+void SegGraph::recycle_segments(timestamp_t write_epoch,
+                                timestamp_t safe_epoch) {
+  for (auto& retired_blocks : segments_to_recycle) {
+    std::vector<std::tuple<uintptr_t, order_t, timestamp_t>>
+        new_segments_to_recycle;
+    for (std::tuple<uintptr_t, order_t, timestamp_t> segment :
+         retired_blocks) {
+      timestamp_t epoch = std::get<2>(segment);
+      if (epoch <= safe_epoch && epoch + LAG_EPOCH_NUMBER < write_epoch) {
+        size_t bytes = 1ul << std::get<1>(segment);
+        block_manager.recycle(std::get<0>(segment), std::get<1>(segment));
+        reclaimable_bytes -= bytes;
+        reclaimed_bytes += bytes;
+      } else {
+        new_segments_to_recycle.push_back(segment);
+      }
+    }
+    retired_blocks.swap(new_segments_to_recycle);
+  }
+}
+
+size_t SegGraph::compact_segments(timestamp_t write_epoch, timestamp_t horizon,
+                                  double tombstone_ratio, size_t max_segments,
+                                  const std::vector<size_t>& edge_prop_sizes) {
+  // readers within LAG_EPOCH_NUMBER epochs must always see exact snapshots
+  horizon = std::min<timestamp_t>(horizon, write_epoch - LAG_EPOCH_NUMBER - 1);
+  EpochGraphWriter writer(*this, write_epoch);
+  size_t compacted = 0;
+  for (segid_t scanned = 0; scanned <= max_seg_id && compacted < max_segments;
+       scanned++) {
+    segid_t segid = compact_cursor;
+    compact_cursor = (compact_cursor + 1) % (max_seg_id + 1);
+    if (!seg_mutexes[segid] ||
+        edge_label_ptrs[segid] == BlockManager::NULLPOINTER) {
+      continue;
+    }
+    auto edge_label_block =
+        block_manager.convert<EdgeLabelBlockHeader>(edge_label_ptrs[segid]);
+    for (size_t i = 0; i < edge_label_block->get_num_entries(); i++) {
+      label_t label = edge_label_block->get_entries()[i].get_label();
+      size_t edge_prop_size =
+          label < edge_prop_sizes.size() ? edge_prop_sizes[label] : 0;
+      // both directions share one segment for undirected edges
+      for (dir_t dir : {EOUT, EIN}) {
+        if (dir == EIN && is_edge_undirected(label)) {
+          continue;
+        }
+        if (writer.compact_segment(segid, label, dir, horizon, tombstone_ratio,
+                                   edge_prop_size)) {
+          compacted++;
+        }
+      }
     }
   }
-  segments_to_recycle.local().swap(new_segments_to_recycle);
+  return compacted;
 }
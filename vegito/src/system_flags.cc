@@ -21,6 +21,10 @@ DEFINE_string(kafka_unified_log_topic, "unified_log",
               "Kafka topic for unified logs.");
 DEFINE_string(kafka_unified_log_file, "test_graph.txt",
               "The file to record unified logs.");  // for tests
+DEFINE_int32(kafka_unified_log_partition_num, 1,
+             "Number of partitions of the unified log topic.");
+DEFINE_bool(binary_unified_log, false,
+            "Unified logs are in the binary format (util/unified_log.h).");
 
 DEFINE_string(etcd_endpoint, "http://127.0.0.1:2379",
               "etcd endpoint for schema.");
@@ -34,8 +38,54 @@ DEFINE_int64(default_max_vertex_number, 1 * (1ul << 26),
              "default max vertex number.");
 DEFINE_int64(default_max_memory_usage_for_each_type_vertex, 10 * (1ul << 30),
              "default max memory usage for each type vertex.");  // in bytes
+DEFINE_int64(seggraph_arena_size, 1 * (1ul << 26),
+             "size of the vineyard blobs allocated on demand for the edges of "
+             "each type vertex, up to its max memory usage.");  // in bytes
+DEFINE_int64(initial_vertex_capacity, 1 << 16,
+             "initial number of vertices of the vertex tables and external "
+             "ids of each type vertex, doubled on demand up to its max "
+             "vertex number.");
 DEFINE_string(customized_vertex_number_memory_usage_config,
               "",  // format: "type1:100:10000,type2:100:10000"
               "customized vertex number memory usage config.");
 
-DEFINE_int32(num_threads, 2, "number of threads");
\ No newline at end of file
+DEFINE_int32(num_threads, 2, "number of threads");
+DEFINE_bool(enable_compaction, false,
+            "compact segments with many deleted edges at epoch boundaries.");
+DEFINE_double(compaction_tombstone_ratio, 0.2,
+              "min ratio of deleted edges for a segment to be compacted.");
+DEFINE_int32(compaction_segments_per_epoch, 16,
+             "max segments compacted per vertex label per epoch.");
+DEFINE_int32(compaction_retained_epochs, 8,
+             "number of recent epochs whose snapshots stay exact.");
+DEFINE_int32(reclaim_interval_epochs, 4,
+             "epochs between checking the pinned epochs in etcd and "
+             "reclaiming the memory retired before them.");
+
+DEFINE_int32(blob_schema_checkpoint_interval, 16,
+             "epochs between full blob schemas put to etcd, deltas against "
+             "the last full schema are put in between.");
+DEFINE_int32(blob_schema_retained_epochs, 1024,
+             "number of recent epochs whose blob schemas stay in etcd, "
+             "besides the epochs pinned by readers.");
+
+DEFINE_double(v6d_memory_soft_limit_ratio, 0.9,
+              "ratio of the vineyard memory limit (and of the block buffer "
+              "of each vertex label) above which logs are consumed slower.");
+DEFINE_int32(memory_status_refresh_interval_ms, 1000,
+             "interval of refreshing the memory status of vineyard.");
+DEFINE_int32(memory_pressure_backoff_ms, 100,
+             "pause of consuming logs when the memory is under pressure, "
+             "and between retries of putting a string.");
+DEFINE_int32(string_put_retries, 600,
+             "times of retrying to put a string when vineyard is out of "
+             "memory, before the process fails (0 for no limit).");
+DEFINE_int32(edge_batch_size, 256,
+             "max number of consecutive add_edge logs whose edges are "
+             "appended together.");
+
+DEFINE_int64(property_index_chunk_size, 1 * (1ul << 22),
+             "size of the vineyard blobs allocated on demand for the nodes "
+             "of each property index.");  // in bytes
+DEFINE_int32(property_index_bucket_bits, 20,
+             "log2 of the number of buckets of each hash property index.");
@@ -21,6 +21,8 @@
 DECLARE_string(kafka_broker_list);
 DECLARE_string(kafka_unified_log_topic);
 DECLARE_string(kafka_unified_log_file);  // for tests
+DECLARE_int32(kafka_unified_log_partition_num);
+DECLARE_bool(binary_unified_log);
 
 DECLARE_string(etcd_endpoint);
 DECLARE_string(meta_prefix);
@@ -31,9 +33,29 @@ DECLARE_int32(subgraph_id);
 
 DECLARE_int64(default_max_vertex_number);
 DECLARE_int64(default_max_memory_usage_for_each_type_vertex);  // in bytes
+DECLARE_int64(seggraph_arena_size);                             // in bytes
+DECLARE_int64(initial_vertex_capacity);
 DECLARE_string(
     customized_vertex_number_memory_usage_config);  // format:
                                                     // "type1:100:10000,type2:100:10000"
 
 DECLARE_int32(num_threads);  // number of threads
-#endif                       // VEGITO_SRC_SYSTEM_FLAGS_H_
+
+DECLARE_bool(enable_compaction);
+DECLARE_double(compaction_tombstone_ratio);
+DECLARE_int32(compaction_segments_per_epoch);
+DECLARE_int32(compaction_retained_epochs);
+DECLARE_int32(reclaim_interval_epochs);
+
+DECLARE_int32(blob_schema_checkpoint_interval);
+DECLARE_int32(blob_schema_retained_epochs);
+
+DECLARE_double(v6d_memory_soft_limit_ratio);
+DECLARE_int32(memory_status_refresh_interval_ms);
+DECLARE_int32(memory_pressure_backoff_ms);
+DECLARE_int32(string_put_retries);
+DECLARE_int32(edge_batch_size);
+
+DECLARE_int64(property_index_chunk_size);  // in bytes
+DECLARE_int32(property_index_bucket_bits);
+#endif  // VEGITO_SRC_SYSTEM_FLAGS_H_
@@ -0,0 +1,141 @@
+/** Copyright 2020-2023 Alibaba Group Holding Limited.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Tombstone compaction must keep the snapshots after the horizon exact: the
+// edges, the degrees from the epoch tables and the delete offsets of later
+// markers.
+
+#include <gflags/gflags.h>
+
+#include "framework/config.h"
+#include "seggraph_test_util.h"
+
+using seggraph::vertex_t;
+
+namespace {
+
+constexpr vertex_t kVertexNum = 16;
+constexpr vertex_t kInitDegree = 10;
+
+// epoch 0: v -> 0..9, epoch 1: delete the even ones,
+// epoch 2: v -> 10, 11, and delete 1 (a marker pointing into the part
+// rewritten by compaction)
+std::vector<vertex_t> expected(seggraph::timestamp_t epoch) {
+  std::vector<vertex_t> dsts;
+  for (vertex_t d = 0; d < kInitDegree; d++) {
+    if (epoch >= 1 && d % 2 == 0) {
+      continue;
+    }
+    if (epoch >= 2 && d == 1) {
+      continue;
+    }
+    dsts.push_back(d);
+  }
+  if (epoch >= 2) {
+    dsts.push_back(kInitDegree);
+    dsts.push_back(kInitDegree + 1);
+  }
+  return dsts;
+}
+
+void build(seggraph::SegGraph& graph) {
+  {
+    auto writer = graph.create_graph_writer(0);
+    for (vertex_t v = 0; v < kVertexNum; v++) {
+      writer.new_vertex();
+    }
+    for (vertex_t v = 0; v < kVertexNum; v++) {
+      for (vertex_t d = 0; d < kInitDegree; d++) {
+        writer.put_edge(v, 0, d);
+      }
+    }
+  }
+  {
+    auto writer = graph.create_graph_writer(1);
+    for (vertex_t v = 0; v < kVertexNum; v++) {
+      for (vertex_t d = 0; d < kInitDegree; d += 2) {
+        writer.put_edge(v, 0, gart::test::delete_marker(d));
+      }
+    }
+  }
+  {
+    auto writer = graph.create_graph_writer(2);
+    for (vertex_t v = 0; v < kVertexNum; v++) {
+      writer.put_edge(v, 0, kInitDegree);
+      writer.put_edge(v, 0, kInitDegree + 1);
+      // the edge at position 1 moves when the pairs deleted at epoch 1 are
+      // dropped
+      writer.put_edge(v, 0, gart::test::delete_marker(1));
+    }
+  }
+}
+
+void check(seggraph::SegGraph& graph,
+           seggraph::timestamp_t epoch) {
+  for (vertex_t v = 0; v < kVertexNum; v++) {
+    CHECK(gart::test::out_neighbors(graph, v, epoch) == expected(epoch))
+        << "vertex " << v << " at epoch " << epoch;
+  }
+}
+
+}  // anonymous namespace
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  gart::framework::config.parse_sys_args(argc, argv);
+
+  gart::graph::RGMapping rg_map(0);
+  gart::test::define_single_label(rg_map);
+  seggraph::SegGraph graph(&rg_map, 0, 1ul << 28, 1 << 16, 1 << 20);
+
+  build(graph);
+  for (seggraph::timestamp_t epoch = 0; epoch <= 2; epoch++) {
+    check(graph, epoch);
+  }
+
+  size_t entries_before = gart::test::out_entries(graph, 0, 2);
+  CHECK_EQ(entries_before, kInitDegree + kInitDegree / 2 + 3);
+
+  // readers before the horizon are gone, the markers at epoch 1 (and their
+  // victims) are dropped
+  size_t compacted = graph.compact_segments(5, 1, 0.1, 16, {0});
+  CHECK_GE(compacted, 1);
+
+  for (seggraph::timestamp_t epoch = 1; epoch <= 2; epoch++) {
+    check(graph, epoch);
+  }
+  for (vertex_t v = 0; v < kVertexNum; v++) {
+    CHECK_EQ(gart::test::out_entries(graph, v, 2),
+             entries_before - kInitDegree)
+        << "vertex " << v;
+  }
+
+  // appends after compaction still see the remapped offsets
+  {
+    auto writer = graph.create_graph_writer(5);
+    for (vertex_t v = 0; v < kVertexNum; v++) {
+      writer.put_edge(v, 0, kInitDegree + 2);
+    }
+  }
+  for (vertex_t v = 0; v < kVertexNum; v++) {
+    auto dsts = expected(2);
+    dsts.push_back(kInitDegree + 2);
+    CHECK(gart::test::out_neighbors(graph, v, 5) == dsts) << "vertex " << v;
+  }
+
+  LOG(INFO) << "compaction_test passed";
+  return 0;
+}
@@ -0,0 +1,204 @@
+/** Copyright 2020-2023 Alibaba Group Holding Limited.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// EdgeIterator::size() comes from the degrees kept in the epoch tables, it
+// must be the number of edges the iterator yields at every read epoch, with
+// edges deleted in later epochs or in the epoch they are added, in copied
+// and in chained edge blocks, and for edges put one by one or in batches.
+
+#include <algorithm>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include <gflags/gflags.h>
+
+#include "framework/config.h"
+#include "seggraph_test_util.h"
+
+using seggraph::vertex_t;
+using EdgeToPut = seggraph::EpochGraphWriter::EdgeToPut;
+
+namespace {
+
+constexpr vertex_t kVertexNum = 8;
+constexpr seggraph::timestamp_t kLastEpoch = 5;
+
+// the entries put for each vertex, oldest first, with their epochs
+class Model {
+ public:
+  void put(vertex_t v, seggraph::timestamp_t epoch, vertex_t dst) {
+    entries_[v].emplace_back(epoch, dst);
+  }
+
+  size_t num_entries(vertex_t v) { return entries_[v].size(); }
+
+  // the sorted neighbors of v at epoch, a delete marker hides the entry at
+  // its position
+  std::vector<vertex_t> neighbors(vertex_t v, seggraph::timestamp_t epoch) {
+    std::vector<vertex_t> dsts;
+    for (size_t pos : live(v, epoch)) {
+      dsts.push_back(entries_[v][pos].second);
+    }
+    std::sort(dsts.begin(), dsts.end());
+    return dsts;
+  }
+
+  // positions of the live edges of v at epoch
+  std::vector<size_t> live(vertex_t v, seggraph::timestamp_t epoch) {
+    std::vector<bool> deleted = deleted_(v, epoch);
+    std::vector<size_t> positions;
+    for (size_t pos = 0; pos < deleted.size(); pos++) {
+      if (entries_[v][pos].first <= epoch && !deleted[pos]) {
+        positions.push_back(pos);
+      }
+    }
+    return positions;
+  }
+
+ private:
+  // markers up to epoch and the entries they hide
+  std::vector<bool> deleted_(vertex_t v, seggraph::timestamp_t epoch) {
+    const auto& entries = entries_[v];
+    std::vector<bool> deleted(entries.size(), false);
+    for (size_t pos = 0; pos < entries.size(); pos++) {
+      if (entries[pos].first <= epoch && is_marker(entries[pos].second)) {
+        deleted[pos] = true;
+        deleted[entries[pos].second & ~marker_bit()] = true;
+      }
+    }
+    return deleted;
+  }
+
+  static vertex_t marker_bit() {
+    return ((vertex_t) 1) << (sizeof(vertex_t) * 8 - 1);
+  }
+  static bool is_marker(vertex_t dst) { return dst & marker_bit(); }
+
+  std::map<vertex_t, std::vector<std::pair<seggraph::timestamp_t, vertex_t>>>
+      entries_;
+};
+
+// odd vertices get their edges one by one, even ones in batches
+void put(seggraph::SegGraph& graph, Model& model,
+         seggraph::timestamp_t epoch,
+         const std::vector<std::pair<vertex_t, vertex_t>>& edges) {
+  auto writer = graph.create_graph_writer(epoch);
+  std::vector<EdgeToPut> batch;
+  for (const auto& edge : edges) {
+    model.put(edge.first, epoch, edge.second);
+    if (edge.first % 2 == 1) {
+      writer.put_edge(edge.first, 0, edge.second);
+    } else {
+      batch.push_back(EdgeToPut{edge.first, edge.second, ""});
+    }
+  }
+  writer.put_edges(0, seggraph::EOUT, batch);
+}
+
+// delete the edges at the positions
+void del(seggraph::SegGraph& graph, Model& model,
+         seggraph::timestamp_t epoch, vertex_t v,
+         const std::vector<size_t>& positions) {
+  std::vector<std::pair<vertex_t, vertex_t>> markers;
+  for (size_t pos : positions) {
+    markers.emplace_back(v, gart::test::delete_marker(pos));
+  }
+  put(graph, model, epoch, markers);
+}
+
+void build(seggraph::SegGraph& graph, Model& model) {
+  {
+    auto writer = graph.create_graph_writer(0);
+    for (vertex_t v = 0; v < kVertexNum; v++) {
+      writer.new_vertex();
+    }
+  }
+
+  // epoch 0: vertex v has 5 * v edges, so that the blocks of most vertices
+  // are chained
+  std::vector<std::pair<vertex_t, vertex_t>> edges;
+  for (vertex_t v = 1; v < kVertexNum; v++) {
+    for (vertex_t d = 0; d < 5 * v; d++) {
+      edges.emplace_back(v, d);
+    }
+  }
+  put(graph, model, 0, edges);
+
+  // epoch 1: delete every third edge
+  for (vertex_t v = 1; v < kVertexNum; v++) {
+    std::vector<size_t> positions;
+    for (size_t pos = 0; pos < 5 * v; pos += 3) {
+      positions.push_back(pos);
+    }
+    del(graph, model, 1, v, positions);
+  }
+
+  // epoch 2: vertex 0 gets its first edges, and the others more, some of
+  // them deleted in the same epoch
+  edges.clear();
+  for (vertex_t v = 0; v < kVertexNum; v++) {
+    for (vertex_t d = 100; d < 104; d++) {
+      edges.emplace_back(v, d);
+    }
+  }
+  put(graph, model, 2, edges);
+  for (vertex_t v = 0; v < kVertexNum; v++) {
+    del(graph, model, 2, v, {model.num_entries(v) - 1});
+  }
+
+  // epoch 3: nothing
+
+  // epoch 4: delete all the edges of the odd vertices
+  for (vertex_t v = 1; v < kVertexNum; v += 2) {
+    del(graph, model, 4, v, model.live(v, 4));
+  }
+
+  // epoch 5: edges added again
+  edges.clear();
+  for (vertex_t v = 0; v < kVertexNum; v++) {
+    edges.emplace_back(v, 200);
+  }
+  put(graph, model, 5, edges);
+}
+
+}  // anonymous namespace
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  gart::framework::config.parse_sys_args(argc, argv);
+
+  gart::graph::RGMapping rg_map(0);
+  gart::test::define_single_label(rg_map);
+  seggraph::SegGraph graph(&rg_map, 0, 1ul << 28, 1 << 16, 1 << 20);
+
+  Model model;
+  build(graph, model);
+  for (seggraph::timestamp_t epoch = 0; epoch <= kLastEpoch; epoch++) {
+    for (vertex_t v = 0; v < kVertexNum; v++) {
+      // out_neighbors checks size() against the edges iterated
+      auto neighbors = gart::test::out_neighbors(graph, v, epoch);
+      CHECK(neighbors == model.neighbors(v, epoch))
+          << "vertex " << v << " at epoch " << epoch;
+      CHECK_EQ(gart::test::out_edges(graph, v, epoch).size(),
+               neighbors.size())
+          << "vertex " << v << " at epoch " << epoch;
+    }
+  }
+
+  LOG(INFO) << "edge_count_test passed";
+  return 0;
+}
@@ -0,0 +1,94 @@
+/** Copyright 2020-2023 Alibaba Group Holding Limited.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// EpochLogMerger must release the logs of several partitions in the order
+// the converter wrote them, and must not release a log while a partition may
+// still have an earlier one.
+
+#include <string>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include "glog/logging.h"
+
+#include "framework/log_merger.h"
+
+using gart::framework::EpochLogMerger;
+
+namespace {
+
+std::vector<std::string> pop_all(EpochLogMerger& merger) {
+  std::vector<std::string> logs;
+  std::string log;
+  while (merger.pop(log)) {
+    logs.push_back(log);
+  }
+  return logs;
+}
+
+// add_edge(a -> b) is sharded by a and delete_vertex(b) by b, the vertex must
+// not be deleted before its edge is added
+void test_cross_partition_order() {
+  EpochLogMerger merger(2);
+  merger.push(0, 1, 1, "add_vertex(a)");
+  merger.push(1, 1, 2, "add_vertex(b)");
+  merger.push(0, 1, 3, "add_edge(a->b)");
+  CHECK(pop_all(merger) ==
+        (std::vector<std::string>{"add_vertex(a)", "add_vertex(b)"}));
+
+  // partition 1 may still have a log before add_edge(a->b)
+  CHECK(!merger.empty(0));
+  merger.push(1, 1, 4, "delete_vertex(b)");
+  CHECK(pop_all(merger) == (std::vector<std::string>{"add_edge(a->b)"}));
+
+  merger.push(0, 2, 4, "epoch_begin(2)");
+  CHECK(pop_all(merger) == (std::vector<std::string>{"delete_vertex(b)"}));
+}
+
+// logs of a later epoch wait for the epoch_begin markers of all partitions
+void test_epoch_barrier() {
+  EpochLogMerger merger(3);
+  merger.push(0, 0, 1, "e0-p0");
+  merger.push(0, 1, 2, "epoch_begin(1)-p0");
+  merger.push(0, 1, 3, "e1-p0");
+  merger.push(1, 1, 2, "epoch_begin(1)-p1");
+  CHECK(pop_all(merger).empty());
+
+  merger.push(2, 0, 0, "e0-p2");
+  CHECK(pop_all(merger) == (std::vector<std::string>{"e0-p2"}));
+
+  merger.push(2, 1, 2, "epoch_begin(1)-p2");
+  merger.finish(1);
+  merger.finish(2);
+  CHECK(pop_all(merger) ==
+        (std::vector<std::string>{"e0-p0", "epoch_begin(1)-p0",
+                                  "epoch_begin(1)-p1", "epoch_begin(1)-p2",
+                                  "e1-p0"}));
+  merger.finish(0);
+  CHECK(pop_all(merger).empty());
+}
+
+}  // anonymous namespace
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+
+  test_cross_partition_order();
+  test_epoch_barrier();
+
+  LOG(INFO) << "log_merger_test passed";
+  return 0;
+}
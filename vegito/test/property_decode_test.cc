@@ -0,0 +1,195 @@
+/** Copyright 2020-2023 Alibaba Group Holding Limited.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// List and BYTES values written by the converter (JSON arrays, PostgreSQL
+// arrays and base64) must come out of a unified log as they went in.
+
+#include <string>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include "glog/logging.h"
+
+#include "property/property.h"
+#include "util/string_chunks.h"
+#include "util/unified_log.h"
+
+using gart::property::Property;
+using gart::property::PropValue;
+
+namespace {
+
+// as the JSON of the binlogs escapes strings
+std::string json_quote(const std::string& str) {
+  static const char kHex[] = "0123456789abcdef";
+  std::string quoted = "\"";
+  for (unsigned char c : str) {
+    if (c == '"' || c == '\\') {
+      quoted.push_back('\\');
+      quoted.push_back(c);
+    } else if (c == '\n') {
+      quoted += "\\n";
+    } else if (c < 0x20) {
+      quoted += "\\u00";
+      quoted.push_back(kHex[c >> 4]);
+      quoted.push_back(kHex[c & 0xf]);
+    } else {
+      quoted.push_back(c);
+    }
+  }
+  return quoted + "\"";
+}
+
+// as PostgreSQL writes the text of a text[] value
+std::string pg_quote(const std::string& str) {
+  std::string quoted = "\"";
+  for (char c : str) {
+    if (c == '"' || c == '\\') {
+      quoted.push_back('\\');
+    }
+    quoted.push_back(c);
+  }
+  return quoted + "\"";
+}
+
+std::string base64(const std::string& bytes) {
+  static const char kChars[] =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  std::string encoded;
+  for (size_t pos = 0; pos < bytes.size(); pos += 3) {
+    uint32_t bits = static_cast<uint8_t>(bytes[pos]) << 16;
+    if (pos + 1 < bytes.size()) {
+      bits |= static_cast<uint8_t>(bytes[pos + 1]) << 8;
+    }
+    if (pos + 2 < bytes.size()) {
+      bits |= static_cast<uint8_t>(bytes[pos + 2]);
+    }
+    encoded.push_back(kChars[bits >> 18 & 0x3f]);
+    encoded.push_back(kChars[bits >> 12 & 0x3f]);
+    encoded.push_back(pos + 1 < bytes.size() ? kChars[bits >> 6 & 0x3f] : '=');
+    encoded.push_back(pos + 2 < bytes.size() ? kChars[bits & 0x3f] : '=');
+  }
+  return encoded;
+}
+
+// write text into a binary unified log, and decode it back as a property
+PropValue round_trip(int data_type, const std::string& text) {
+  std::string buf;
+  gart::UnifiedLogEncoder encoder(buf);
+  encoder.put_text_value(text);
+
+  gart::UnifiedLogDecoder decoder(buf.data(), buf.size());
+  gart::UnifiedLogValue value;
+  CHECK(decoder.get_value(&value));
+  PropValue out;
+  CHECK(Property::decode_prop(data_type, value, out)) << text;
+  CHECK(!out.is_null) << text;
+  return out;
+}
+
+std::vector<std::string> string_list(const PropValue& value) {
+  gart::StringListView view(value.bytes());
+  std::vector<std::string> elems;
+  for (size_t idx = 0; idx < view.size(); idx++) {
+    elems.emplace_back(view[idx]);
+  }
+  return elems;
+}
+
+void test_string_lists() {
+  const std::vector<std::string> elems = {
+      "a,b", "c", "", "say \"hi\"", "back\\slash", "new\nline", "\x01",
+      "{[,]}"};
+
+  std::string json = "[", pg = "{";
+  for (size_t idx = 0; idx < elems.size(); idx++) {
+    json += (idx == 0 ? "" : ", ") + json_quote(elems[idx]);
+    pg += (idx == 0 ? "" : ",") + pg_quote(elems[idx]);
+  }
+  json += "]";
+  pg += "}";
+
+  CHECK(string_list(round_trip(gart::property::STRING_LIST, json)) == elems)
+      << json;
+  CHECK(string_list(round_trip(gart::property::STRING_LIST, pg)) == elems)
+      << pg;
+
+  // unquoted elements of PostgreSQL, and code points out of the BMP
+  CHECK(string_list(round_trip(gart::property::STRING_LIST, "{a b,c}")) ==
+        (std::vector<std::string>{"a b", "c"}));
+  CHECK(string_list(round_trip(gart::property::STRING_LIST,
+                               "[\"\\u00e9\", \"\\ud83d\\ude00\"]")) ==
+        (std::vector<std::string>{"\xc3\xa9", "\xf0\x9f\x98\x80"}));
+  CHECK(string_list(round_trip(gart::property::STRING_LIST, "[]")).empty());
+
+  PropValue out;
+  CHECK(!Property::decode_prop(gart::property::STRING_LIST,
+                               std::string_view("[\"a, b]"), out));
+  CHECK(!Property::decode_prop(gart::property::STRING_LIST,
+                               std::string_view("[\"a\" b]"), out));
+  CHECK(!Property::decode_prop(gart::property::STRING_LIST,
+                               std::string_view("[\"\\u12\"]"), out));
+}
+
+void test_number_lists() {
+  auto longs = round_trip(gart::property::LONG_LIST, "[1, -2, 30000000000]");
+  gart::ListView<int64_t> long_view(longs.bytes());
+  CHECK_EQ(long_view.size(), 3);
+  CHECK_EQ(long_view[0], 1);
+  CHECK_EQ(long_view[1], -2);
+  CHECK_EQ(long_view[2], 30000000000);
+
+  auto doubles = round_trip(gart::property::DOUBLE_LIST, "{0.5,\"-1.25\"}");
+  gart::ListView<double> double_view(doubles.bytes());
+  CHECK_EQ(double_view.size(), 2);
+  CHECK_EQ(double_view[0], 0.5);
+  CHECK_EQ(double_view[1], -1.25);
+}
+
+void test_bytes() {
+  std::string bytes;
+  for (int c = 0; c < 256; c++) {
+    bytes.push_back(static_cast<char>(c));
+  }
+  for (size_t len = 0; len <= 4; len++) {
+    std::string prefix = bytes.substr(0, len);
+    if (prefix.empty()) {
+      continue;  // an empty text is null
+    }
+    CHECK(round_trip(gart::property::BYTES, base64(prefix)).bytes() == prefix)
+        << len << " bytes";
+  }
+  CHECK(round_trip(gart::property::BYTES, base64(bytes)).bytes() == bytes);
+
+  PropValue out;
+  CHECK(!Property::decode_prop(gart::property::BYTES,
+                               std::string_view("not base64!"), out));
+  CHECK(!Property::decode_prop(gart::property::BYTES, std::string_view("QUJDR"),
+                               out));
+}
+
+}  // anonymous namespace
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+
+  test_string_lists();
+  test_number_lists();
+  test_bytes();
+
+  LOG(INFO) << "property_decode_test passed";
+  return 0;
+}
@@ -1,3 +1,15 @@
 #!/bin/bash
 
 ../build/load_graph_test --kafka_unified_log_file ./data/test_graph.txt --v6d_ipc_socket /opt/tmp/tmp.sock
+
+../build/compaction_test --v6d_ipc_socket /opt/tmp/tmp.sock
+
+../build/edge_count_test --v6d_ipc_socket /opt/tmp/tmp.sock
+
+../build/log_merger_test --v6d_ipc_socket /opt/tmp/tmp.sock
+
+../build/property_decode_test --v6d_ipc_socket /opt/tmp/tmp.sock
+
+../build/vertex_split_test --v6d_ipc_socket /opt/tmp/tmp.sock
+
+../build/vertex_table_test --v6d_ipc_socket /opt/tmp/tmp.sock
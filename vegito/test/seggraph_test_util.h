@@ -0,0 +1,110 @@
+/** Copyright 2020-2023 Alibaba Group Holding Limited.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef VEGITO_TEST_SEGGRAPH_TEST_UTIL_H_
+#define VEGITO_TEST_SEGGRAPH_TEST_UTIL_H_
+
+#include <algorithm>
+#include <vector>
+
+#include "glog/logging.h"
+
+#include "interfaces/fragment/iterator.h"
+#include "seggraph/epoch_graph_writer.hpp"
+#include "seggraph/segment_graph.hpp"
+
+#include "graph/ddl.h"
+
+namespace gart {
+namespace test {
+
+// one vertex label and one directed edge label between its vertices, the
+// edge label is 0 for the writers
+inline void define_single_label(graph::RGMapping& rg_map) {
+  rg_map.define_vertex(0, 0);
+  rg_map.define_nn_edge(1, 0, 0, -1, -1, false, 0);
+}
+
+// the delete marker of the edge at pos (counted from the oldest entry of the
+// vertex)
+inline seggraph::vertex_t delete_marker(size_t pos) {
+  return static_cast<seggraph::vertex_t>(pos) |
+         (((seggraph::vertex_t) 1) << (sizeof(seggraph::vertex_t) * 8 - 1));
+}
+
+// the iterator over the out edges of v read at read_epoch, as GartFragment
+// builds it
+inline EdgeIterator out_edges(seggraph::SegGraph& graph, seggraph::vertex_t v,
+                              seggraph::timestamp_t read_epoch) {
+  auto writer = graph.create_graph_writer(read_epoch);
+  auto segment = writer.locate_segment(graph.get_vertex_seg_id(v), 0);
+  const auto& arenas = graph.get_block_manager().get_arenas();
+  if (segment) {
+    auto idx = graph.get_vertex_seg_idx(v);
+    auto epoch_table = segment->get_epoch_table(idx);
+    auto edge_block = segment->get_region_ptr(idx);
+    if (epoch_table && edge_block) {
+      auto block = arenas.convert<seggraph::VegitoEdgeBlockHeader>(edge_block);
+      if (block->get_num_entries() > 0) {
+        return EdgeIterator(
+            segment, block, arenas.convert<seggraph::EpochBlockHeader>(
+                                epoch_table),
+            &arenas, block->get_num_entries(), 0, read_epoch, nullptr,
+            nullptr, 0);
+      }
+    }
+  }
+  return EdgeIterator(nullptr, nullptr, nullptr, nullptr, 0, 0, read_epoch,
+                      nullptr, nullptr, 0);
+}
+
+// the sorted neighbors of v seen at read_epoch, checked against size()
+inline std::vector<seggraph::vertex_t> out_neighbors(
+    seggraph::SegGraph& graph, seggraph::vertex_t v,
+    seggraph::timestamp_t read_epoch) {
+  auto iter = out_edges(graph, v, read_epoch);
+  std::vector<seggraph::vertex_t> neighbors;
+  while (iter.valid()) {
+    neighbors.push_back(iter.neighbor().GetValue());
+    iter.next();
+  }
+  CHECK_EQ(iter.size(), neighbors.size())
+      << "vertex " << v << " at epoch " << read_epoch;
+  std::sort(neighbors.begin(), neighbors.end());
+  return neighbors;
+}
+
+// the number of entries (edges and delete markers) kept for v
+inline size_t out_entries(seggraph::SegGraph& graph, seggraph::vertex_t v,
+                          seggraph::timestamp_t read_epoch) {
+  auto writer = graph.create_graph_writer(read_epoch);
+  auto segment = writer.locate_segment(graph.get_vertex_seg_id(v), 0);
+  if (!segment) {
+    return 0;
+  }
+  auto edge_block = segment->get_region_ptr(graph.get_vertex_seg_idx(v));
+  if (!edge_block) {
+    return 0;
+  }
+  auto block = graph.get_block_manager()
+                   .get_arenas()
+                   .convert<seggraph::VegitoEdgeBlockHeader>(edge_block);
+  return block->get_prev_num_entries() + block->get_num_entries();
+}
+
+}  // namespace test
+}  // namespace gart
+
+#endif  // VEGITO_TEST_SEGGRAPH_TEST_UTIL_H_
@@ -0,0 +1,153 @@
+/** Copyright 2020-2023 Alibaba Group Holding Limited.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// The chunks of VertexIterator::split, even or weighted, must yield every
+// live vertex exactly once, with delete markers hiding vertices in other
+// chunks, whether the number of markers is known or not.
+
+#include <algorithm>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include "glog/logging.h"
+
+#include "interfaces/fragment/iterator.h"
+
+using gart::vid_t;
+using gart::VertexIterator;
+
+namespace {
+
+constexpr size_t kCapacity = 1024;
+
+// a vertex table as the writer fills it: inner vertices and their delete
+// markers from the beginning, outer ones from the end
+class VertexTable {
+ public:
+  VertexTable() : slots_(kCapacity) {}
+
+  void add_inner(vid_t v) {
+    slots_[inner_end_++] = v;
+    live_.insert(v);
+  }
+
+  void add_outer(vid_t v) {
+    slots_[--outer_begin_] = v;
+    live_.insert(v);
+  }
+
+  // delete the vertex at location loc
+  void del(size_t loc) {
+    CHECK_EQ(live_.erase(slots_[loc]), 1) << "location " << loc;
+    vid_t marker = loc | (((vid_t) 1) << (sizeof(vid_t) * 8 - 1));
+    if (loc < inner_end_) {
+      slots_[inner_end_++] = marker;
+      inner_delete_num_++;
+    } else {
+      slots_[--outer_begin_] = marker;
+      outer_delete_num_++;
+    }
+  }
+
+  size_t inner_end() const { return inner_end_; }
+  size_t outer_begin() const { return outer_begin_; }
+
+  std::vector<vid_t> live() const { return {live_.begin(), live_.end()}; }
+
+  // as GartFragment::Vertices, with unknown numbers of markers if !known
+  VertexIterator vertices(bool known) {
+    vid_t* table = slots_.data();
+    return VertexIterator({{table + inner_end_ - 1, table - 1},
+                           {table + outer_begin_, table + kCapacity}},
+                          {true, false}, table, 0,
+                          known ? std::vector<int64_t>{inner_delete_num_,
+                                                       outer_delete_num_}
+                                : std::vector<int64_t>{});
+  }
+
+ private:
+  std::vector<vid_t> slots_;
+  size_t inner_end_ = 0;
+  size_t outer_begin_ = kCapacity;
+  int64_t inner_delete_num_ = 0;
+  int64_t outer_delete_num_ = 0;
+  std::set<vid_t> live_;
+};
+
+std::vector<vid_t> collect(const std::vector<VertexIterator>& chunks) {
+  std::vector<vid_t> vertices;
+  for (VertexIterator iter : chunks) {
+    while (iter.valid()) {
+      vertices.push_back(iter.vertex().GetValue());
+      iter.next();
+    }
+  }
+  std::sort(vertices.begin(), vertices.end());
+  return vertices;
+}
+
+void check_splits(VertexTable& table) {
+  auto expected = table.live();
+  for (bool known : {true, false}) {
+    CHECK(collect({table.vertices(known)}) == expected);
+    for (size_t chunk_num : {1, 2, 3, 7, 16, 64, 4096}) {
+      CHECK(collect(table.vertices(known).split(chunk_num)) == expected)
+          << chunk_num << " chunks, known: " << known;
+      auto weighted = table.vertices(known).split(
+          chunk_num, [](gart::vertex_t v) { return v.GetValue() % 5 * 10; });
+      CHECK(collect(weighted) == expected)
+          << chunk_num << " weighted chunks, known: " << known;
+    }
+  }
+}
+
+}  // anonymous namespace
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+
+  VertexTable table;
+  vid_t next_vid = 0;
+  for (int i = 0; i < 200; i++) {
+    table.add_inner(next_vid++);
+  }
+  for (int i = 0; i < 50; i++) {
+    table.add_outer(next_vid++);
+  }
+  check_splits(table);
+
+  // markers far from their victims, and markers next to them
+  for (size_t loc = 0; loc < 200; loc += 7) {
+    table.del(loc);
+  }
+  for (size_t loc = kCapacity - 1; loc >= kCapacity - 50; loc -= 9) {
+    table.del(loc);
+  }
+  for (int i = 0; i < 100; i++) {
+    table.add_inner(next_vid++);
+    if (i % 3 == 0) {
+      table.del(table.inner_end() - 1);
+    }
+  }
+  table.add_outer(next_vid++);
+  table.del(table.outer_begin());
+  check_splits(table);
+
+  LOG(INFO) << "vertex_split_test passed";
+  return 0;
+}
@@ -0,0 +1,94 @@
+/** Copyright 2020-2023 Alibaba Group Holding Limited.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// The vertex table grows when a delete marker does not fit, moving the
+// outer vertices to its end: the markers, including the one being written,
+// must still point at their victims.
+
+#include <vector>
+
+#include <gflags/gflags.h>
+#include "glog/logging.h"
+
+#include "framework/config.h"
+#include "graph/graph_store.h"
+#include "seggraph_test_util.h"
+
+using gart::graph::GraphStore;
+using seggraph::vertex_t;
+
+namespace {
+
+constexpr uint64_t kVLabel = 0;
+
+vertex_t marker_bit() { return ((vertex_t) 1) << (sizeof(vertex_t) * 8 - 1); }
+
+// the vertex at the slot a marker points to
+vertex_t victim(const GraphStore::VTable& vtable, uint64_t loc) {
+  vertex_t marker = vtable.table[loc];
+  CHECK(marker & marker_bit()) << "no marker at " << loc;
+  uint64_t slot = marker & ~marker_bit();
+  CHECK_LT(slot, vtable.size);
+  return vtable.table[slot];
+}
+
+}  // anonymous namespace
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  gart::framework::config.parse_sys_args(argc, argv);
+
+  // a table of 2 inner and 2 outer slots at first
+  FLAGS_initial_vertex_capacity = 2;
+  gart::graph::RGMapping rg_map(0);
+  gart::test::define_single_label(rg_map);
+  GraphStore store(0, 0, 1);
+  store.set_vertex_label_num(1);
+  store.init_id_parser(1);
+  store.set_max_vertex_num(kVLabel, 64);
+  store.set_max_memory_usage(kVLabel, 1ul << 24);
+  store.add_vgraph(kVLabel, &rg_map);
+
+  std::vector<vertex_t> inner, outer;
+  for (int i = 0; i < 2; i++) {
+    CHECK(store.reserve_vertex(kVLabel, false, i));
+    inner.push_back(store.id_parser.GenerateId(0, kVLabel, i));
+    store.add_inner(kVLabel, inner.back());
+    CHECK(store.reserve_vertex(kVLabel, true, 0));
+    outer.push_back(store.id_parser.GenerateOuterId(0, kVLabel, i));
+    store.add_outer(kVLabel, outer.back());
+  }
+  const auto& vtable = store.get_vertex_table(kVLabel);
+  CHECK_EQ(vtable.size, 4u);
+  CHECK(!store.reserve_vertex(kVLabel, false, 2));  // full
+
+  // the marker of the first outer vertex grows the table
+  store.delete_outer(kVLabel, outer[0], 1);
+  CHECK_GT(vtable.size, 4u);
+  CHECK_EQ(victim(vtable, vtable.min_outer_location), outer[0]);
+
+  // and later markers are written in the grown table
+  store.delete_outer(kVLabel, outer[1], 1);
+  CHECK_EQ(victim(vtable, vtable.min_outer_location), outer[1]);
+  CHECK_EQ(victim(vtable, vtable.min_outer_location + 1), outer[0]);
+  store.delete_inner(kVLabel, store.id_parser.GetOffset(inner[0]), 1);
+  CHECK_EQ(victim(vtable, vtable.max_inner_location - 1), inner[0]);
+  CHECK_EQ(vtable.inner_num, 1u);
+  CHECK_EQ(vtable.outer_num, 0u);
+
+  LOG(INFO) << "vertex_table_test passed";
+  return 0;
+}